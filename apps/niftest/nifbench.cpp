@@ -0,0 +1,193 @@
+///Program to measure how fast .nif files are parsed, both on the FileSystem and in BSA archives.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+#include <components/nif/niffile.hpp>
+#include <components/files/constrainedfilestream.hpp>
+#include <components/misc/stringops.hpp>
+#include <components/vfs/manager.hpp>
+#include <components/vfs/bsaarchive.hpp>
+#include <components/vfs/filesystemarchive.hpp>
+
+#include <osg/Timer>
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+// Create local aliases for brevity
+namespace bpo = boost::program_options;
+namespace bfs = boost::filesystem;
+
+struct File
+{
+    std::string mName;
+    std::vector<char> mData;
+};
+
+struct Result
+{
+    Result() : mFiles(0), mBytes(0), mErrors(0), mSeconds(0) {}
+
+    size_t mFiles;
+    size_t mBytes;
+    size_t mErrors;
+    double mSeconds;
+};
+
+///See if the file has the "nif" extension.
+bool isNIF(const std::string& filename)
+{
+    size_t dot = filename.find_last_of('.');
+    return dot != std::string::npos && Misc::StringUtils::ciEqual(filename.substr(dot+1), "nif");
+}
+
+void readStream(std::istream& stream, std::vector<char>& data)
+{
+    char chunk[65536];
+    while (stream.read(chunk, sizeof(chunk)) || stream.gcount() > 0)
+        data.insert(data.end(), chunk, chunk + stream.gcount());
+}
+
+/// Load all the nif files in a given VFS::Archive into memory, so that reading them isn't measured
+/// \note Takes ownership!
+void loadVFS(VFS::Archive* anArchive, const std::string& archivePath, std::vector<File>& files)
+{
+    VFS::Manager myManager(true);
+    myManager.addArchive(anArchive);
+    myManager.buildIndex();
+
+    VFS::RecursiveDirectoryRange names = myManager.getRecursiveDirectoryIterator("");
+    for(VFS::RecursiveDirectoryIterator it=names.begin(); it!=names.end(); ++it)
+    {
+        if(!isNIF(*it))
+            continue;
+
+        File file;
+        file.mName = archivePath + *it;
+        readStream(*myManager.get(*it), file.mData);
+        files.push_back(file);
+    }
+}
+
+/// Parse all files \a iterations times.
+/// @param fromStream Parse through an input stream as the engine does, rather than straight from memory.
+Result parse(const std::vector<File>& files, int iterations, bool fromStream)
+{
+    Result result;
+    for (int i=0; i<iterations; ++i)
+    {
+        for (std::vector<File>::const_iterator it = files.begin(); it != files.end(); ++it)
+        {
+            if (it->mData.empty())
+                continue;
+
+            osg::Timer_t start = osg::Timer::instance()->tick();
+            try
+            {
+                if (fromStream)
+                {
+                    Files::IStreamPtr stream (new std::istringstream(std::string(it->mData.begin(), it->mData.end())));
+                    start = osg::Timer::instance()->tick();
+                    Nif::NIFFile nif(stream, it->mName);
+                }
+                else
+                {
+                    Nif::NIFFile nif(&it->mData[0], it->mData.size(), it->mName);
+                }
+            }
+            catch (std::exception& e)
+            {
+                // report errors once
+                if (i == 0)
+                    std::cerr << "ERROR, an exception has occurred:  " << e.what() << std::endl;
+                ++result.mErrors;
+            }
+            result.mSeconds += osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+            result.mBytes += it->mData.size();
+            ++result.mFiles;
+        }
+    }
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    bpo::options_description desc("Measure the NIF parser on the provided NIF and BSA files\n\n"
+        "Usages:\n"
+        "  nifbench <nif files, BSA files, or directories>\n"
+        "      Parse all nif files found and report the throughput.\n\n"
+        "Allowed options");
+    desc.add_options()
+        ("help,h", "print help message.")
+        ("iterations,n", bpo::value<int>()->default_value(5), "number of times to parse each file")
+        ("stream", "parse through an input stream rather than straight from memory")
+        ("input-file", bpo::value< std::vector<std::string> >(), "input file")
+        ;
+
+    bpo::positional_options_description p;
+    p.add("input-file", -1);
+
+    bpo::variables_map variables;
+    try
+    {
+        bpo::store(bpo::command_line_parser(argc, argv).options(desc).positional(p).run(), variables);
+        bpo::notify(variables);
+    }
+    catch(std::exception &e)
+    {
+        std::cout << "ERROR parsing arguments: " << e.what() << "\n\n"
+            << desc << std::endl;
+        return 1;
+    }
+
+    if (variables.count("help") || !variables.count("input-file"))
+    {
+        std::cout << desc << std::endl;
+        return 1;
+    }
+
+    std::vector<File> files;
+    const std::vector<std::string>& inputs = variables["input-file"].as< std::vector<std::string> >();
+    for(std::vector<std::string>::const_iterator it=inputs.begin(); it!=inputs.end(); ++it)
+    {
+        const std::string& name = *it;
+        try
+        {
+            if(isNIF(name))
+            {
+                File file;
+                file.mName = name;
+                readStream(*Files::openConstrainedFileStream(name.c_str()), file.mData);
+                files.push_back(file);
+            }
+            else if(bfs::is_directory(bfs::path(name)))
+                loadVFS(new VFS::FileSystemArchive(name), name + "/", files);
+            else
+                loadVFS(new VFS::BsaArchive(name), name + "/", files);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "ERROR, an exception has occurred:  " << e.what() << std::endl;
+        }
+    }
+
+    if (files.empty())
+    {
+        std::cerr << "No nif files found!" << std::endl;
+        return 1;
+    }
+
+    int iterations = std::max(1, variables["iterations"].as<int>());
+    Result result = parse(files, iterations, variables.count("stream") != 0);
+
+    const double megabytes = result.mBytes / (1024.0 * 1024.0);
+    std::cout << std::fixed << std::setprecision(2)
+              << "Parsed " << result.mFiles / iterations << " files (" << megabytes / iterations << " MB) "
+              << iterations << " times" << (result.mErrors ? " with errors" : "") << std::endl
+              << "Time: " << result.mSeconds << " s" << std::endl
+              << "Throughput: " << (result.mSeconds > 0 ? megabytes / result.mSeconds : 0) << " MB/s" << std::endl;
+    return result.mErrors ? 1 : 0;
+}
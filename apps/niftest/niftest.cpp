@@ -52,10 +52,10 @@ void readVFS(VFS::Archive* anArchive,std::string archivePath = "")
     myManager.addArchive(anArchive);
     myManager.buildIndex();
 
-    std::map<std::string, VFS::File*> files=myManager.getIndex();
-    for(std::map<std::string, VFS::File*>::const_iterator it=files.begin(); it!=files.end(); ++it)
+    VFS::RecursiveDirectoryRange files = myManager.getRecursiveDirectoryIterator("");
+    for(VFS::RecursiveDirectoryIterator it=files.begin(); it!=files.end(); ++it)
     {
-        std::string name = it->first;
+        std::string name = *it;
 
         try{
             if(isNIF(name))
@@ -14,10 +14,10 @@ CSMWorld::Resources::Resources (const VFS::Manager* vfs, const std::string& base
 {
     int baseSize = mBaseDirectory.size();
 
-    const std::map<std::string, VFS::File*>& index = vfs->getIndex();
-    for (std::map<std::string, VFS::File*>::const_iterator it = index.begin(); it != index.end(); ++it)
+    VFS::RecursiveDirectoryRange files = vfs->getRecursiveDirectoryIterator("");
+    for (VFS::RecursiveDirectoryIterator it = files.begin(); it != files.end(); ++it)
     {
-        std::string filepath = it->first;
+        std::string filepath = *it;
         if (static_cast<int> (filepath.size())<baseSize+1 ||
             filepath.substr (0, baseSize)!=mBaseDirectory ||
             (filepath[baseSize]!='/' && filepath[baseSize]!='\\'))
@@ -22,6 +22,7 @@
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/scenemanager.hpp>
 #include <components/resource/stats.hpp>
+#include <components/resource/templatecache.hpp>
 
 #include <components/compiler/extensions0.hpp>
 
@@ -37,6 +38,7 @@
 #include "mwgui/windowmanagerimp.hpp"
 
 #include "mwscript/scriptmanagerimp.hpp"
+#include "mwscript/scriptcache.hpp"
 #include "mwscript/extensions.hpp"
 #include "mwscript/interpretercontext.hpp"
 
@@ -88,6 +90,9 @@ void OMW::Engine::frame(float frametime)
         mStartTick = mViewer->getStartTick();
         mEnvironment.setFrameDuration (frametime);
 
+        // The physics thread may be in the middle of a step
+        mEnvironment.getWorld()->finishPhysics();
+
         // update input
         mEnvironment.getInputManager()->update(frametime, false);
 
@@ -170,6 +175,9 @@ void OMW::Engine::frame(float frametime)
             mEnvironment.getWindowManager()->update();
         }
 
+        // Let the physics thread step the movement while the frame is rendered and until the next frame
+        mEnvironment.getWorld()->startPhysics();
+
         unsigned int frameNumber = mViewer->getFrameStamp()->getFrameNumber();
         osg::Stats* stats = mViewer->getViewerStats();
         stats->setAttribute(frameNumber, "script_time_begin", osg::Timer::instance()->delta_s(mStartTick, beforeScriptTick));
@@ -184,12 +192,13 @@ void OMW::Engine::frame(float frametime)
         stats->setAttribute(frameNumber, "physics_time_taken", osg::Timer::instance()->delta_s(beforePhysicsTick, afterPhysicsTick));
         stats->setAttribute(frameNumber, "physics_time_end", osg::Timer::instance()->delta_s(mStartTick, afterPhysicsTick));
 
+        mEnvironment.getWorld()->reportStats(frameNumber, stats);
+
         if (stats->collectStats("resource"))
         {
             mResourceSystem->reportStats(frameNumber, stats);
 
-            stats->setAttribute(frameNumber, "WorkQueue", mWorkQueue->getNumItems());
-            stats->setAttribute(frameNumber, "WorkThread", mWorkQueue->getNumActiveThreads());
+            mWorkQueue->reportStats(frameNumber, stats);
         }
 
     }
@@ -452,7 +461,8 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
 
     mVFS.reset(new VFS::Manager(mFSStrict));
 
-    VFS::registerArchives(mVFS.get(), mFileCollections, mArchives, true);
+    VFS::registerArchives(mVFS.get(), mFileCollections, mArchives, true,
+                          Settings::Manager::getBool("memory mapped archives", "Content"));
 
     mResourceSystem.reset(new Resource::ResourceSystem(mVFS.get()));
     mResourceSystem->getSceneManager()->setUnRefImageDataAfterApply(false); // keep to Off for now to allow better state sharing
@@ -462,6 +472,9 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
         Settings::Manager::getString("texture mipmap", "General"),
         Settings::Manager::getInt("anisotropy", "General")
     );
+    if (Settings::Manager::getBool("model cache", "Content"))
+        mResourceSystem->getSceneManager()->setTemplateCache(
+            new Resource::TemplateCache(mVFS.get(), (mCfgMgr.getCachePath() / "models").string()));
 
     int numThreads = Settings::Manager::getInt("preload num threads", "Cells");
     if (numThreads <= 0)
@@ -520,7 +533,8 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
     // Create the world
     mEnvironment.setWorld( new MWWorld::World (mViewer, rootNode, mResourceSystem.get(), mWorkQueue.get(),
         mFileCollections, mContentFiles, mEncoder, mFallbackMap,
-        mActivationDistanceOverride, mCellName, mStartupScript, mResDir.string(), mCfgMgr.getUserDataPath().string()));
+        mActivationDistanceOverride, mCellName, mStartupScript, mResDir.string(), mCfgMgr.getUserDataPath().string(),
+        mCfgMgr.getCachePath().string()));
     mEnvironment.getWorld()->setupPlayer();
     input->setPlayer(&mEnvironment.getWorld()->getPlayer());
 
@@ -539,8 +553,24 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
     mScriptContext = new MWScript::CompilerContext (MWScript::CompilerContext::Type_Full);
     mScriptContext->setExtensions (&mExtensions);
 
-    mEnvironment.setScriptManager (new MWScript::ScriptManager (mEnvironment.getWorld()->getStore(), *mScriptContext, mWarningsMode,
-        mScriptBlacklistUse ? mScriptBlacklist : std::vector<std::string>()));
+    MWScript::ScriptManager* scriptManager = new MWScript::ScriptManager (mEnvironment.getWorld()->getStore(),
+        *mScriptContext, mWarningsMode, mScriptBlacklistUse ? mScriptBlacklist : std::vector<std::string>());
+    mEnvironment.setScriptManager (scriptManager);
+
+    if (Settings::Manager::getBool("script cache", "Content"))
+    {
+        std::auto_ptr<MWScript::ScriptCache> scriptCache (new MWScript::ScriptCache (
+            mCfgMgr.getCachePath() / "scripts.cache", mExtensions.getHash()));
+
+        for (std::vector<std::string>::const_iterator it = mContentFiles.begin(); it != mContentFiles.end(); ++it)
+        {
+            const Files::MultiDirCollection& col = mFileCollections.getCollection(boost::filesystem::path(*it).extension().string());
+            scriptCache->addContentFile(col.getPath(*it));
+        }
+
+        scriptCache->read();
+        scriptManager->setCache(scriptCache.release());
+    }
 
     // Create game mechanics system
     MWMechanics::MechanicsManager* mechanics = new MWMechanics::MechanicsManager;
@@ -16,6 +16,7 @@ namespace Compiler
 namespace MWScript
 {
     class GlobalScripts;
+    class ReferenceCache;
 }
 
 namespace MWBase
@@ -50,6 +51,9 @@ namespace MWBase
             ///< Return locals for script \a name.
 
             virtual MWScript::GlobalScripts& getGlobalScripts() = 0;
+
+            virtual MWScript::ReferenceCache& getReferenceCache() = 0;
+            ///< Explicit references resolved by scripts. Must be cleared when the active cells change.
    };
 }
 
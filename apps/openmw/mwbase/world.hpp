@@ -11,12 +11,15 @@
 
 #include "../mwrender/rendermode.hpp"
 
+#include "../mwphysics/raycategory.hpp"
+
 namespace osg
 {
     class Vec3f;
     class Matrixf;
     class Quat;
     class Image;
+    class Stats;
 }
 
 namespace Loading
@@ -52,6 +55,7 @@ namespace MWRender
 namespace MWMechanics
 {
     struct Movement;
+    class PathgridPortals;
 }
 
 namespace MWWorld
@@ -130,6 +134,9 @@ namespace MWBase
 
             virtual const MWWorld::ESMStore& getStore() const = 0;
 
+            /// Graph of the connections between exterior pathgrids, built from the store as it is used.
+            virtual const MWMechanics::PathgridPortals& getPathgridPortals() const = 0;
+
             virtual std::vector<ESM::ESMReader>& getEsmReader() = 0;
 
             virtual MWWorld::LocalScripts& getLocalScripts() = 0;
@@ -159,6 +166,18 @@ namespace MWBase
             virtual float getGlobalFloat (const std::string& name) const = 0;
             ///< Get value independently from real type.
 
+            virtual int getGlobalSlot (const std::string& name) const = 0;
+            ///< Return a slot for faster access to the global variable \a name or -1, if there is no
+            /// global variable with this name.
+
+            virtual void setGlobalInt (int slot, int value) = 0;
+
+            virtual void setGlobalFloat (int slot, float value) = 0;
+
+            virtual int getGlobalInt (int slot) const = 0;
+
+            virtual float getGlobalFloat (int slot) const = 0;
+
             virtual char getGlobalVariableType (const std::string& name) const = 0;
             ///< Return ' ', if there is no global variable with this name.
 
@@ -296,7 +315,19 @@ namespace MWBase
             ///< Queues movement for \a ptr (in local space), to be applied in the next call to
             /// doPhysics.
 
-            virtual bool castRay (float x1, float y1, float z1, float x2, float y2, float z2) = 0;
+            virtual void startPhysics() = 0;
+            ///< Let the physics thread, if enabled, step the movement applied in the last doPhysics on its own clock.
+            /// Call at the end of the frame; nothing may access the world until finishPhysics is called.
+
+            virtual void finishPhysics() = 0;
+            ///< Wait for the step the physics thread is doing, if any, and take over the positions it published since
+            /// startPhysics. They are reported by the next doPhysics.
+            /// Call at the start of the frame; the ray counts reported by reportStats start here.
+
+            virtual void reportStats(unsigned int frameNumber, osg::Stats* stats) const = 0;
+
+            virtual bool castRay (float x1, float y1, float z1, float x2, float y2, float z2,
+                                  MWPhysics::RayCategory category = MWPhysics::RayCategory_Other) = 0;
             ///< cast a Ray and return true if there is an object in the ray path.
 
             virtual bool toggleCollisionMode() = 0;
@@ -426,10 +457,17 @@ namespace MWBase
             virtual void getItemsOwnedBy (const MWWorld::ConstPtr& npc, std::vector<MWWorld::Ptr>& out) = 0;
             ///< get all items in active cells owned by this Npc
 
-            virtual bool getLOS(const MWWorld::ConstPtr& actor,const MWWorld::ConstPtr& targetActor) = 0;
+            virtual bool getLOS(const MWWorld::ConstPtr& actor,const MWWorld::ConstPtr& targetActor,
+                                MWPhysics::RayCategory category = MWPhysics::RayCategory_Other) = 0;
             ///< get Line of Sight (morrowind stupid implementation)
 
-            virtual float getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist, bool includeWater = false) = 0;
+            virtual void getLOS(const MWWorld::ConstPtr& actor, const std::vector<MWWorld::Ptr>& targetActors, std::vector<bool>& out,
+                                MWPhysics::RayCategory category = MWPhysics::RayCategory_Other) = 0;
+            ///< Batched version of getLOS, for all of \a targetActors at once.
+            /// @param out Receives whether \a actor has a line of sight to each of \a targetActors, in the same order.
+
+            virtual float getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist, bool includeWater = false,
+                                                 MWPhysics::RayCategory category = MWPhysics::RayCategory_Other) = 0;
 
             virtual void enableActorCollision(const MWWorld::Ptr& actor, bool enable) = 0;
 
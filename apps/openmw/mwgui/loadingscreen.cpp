@@ -62,23 +62,13 @@ namespace MWGui
 
     void LoadingScreen::findSplashScreens()
     {
-        const std::map<std::string, VFS::File*>& index = mVFS->getIndex();
-        std::string pattern = "Splash/";
-        mVFS->normalizeFilename(pattern);
-
-        std::map<std::string, VFS::File*>::const_iterator found = index.lower_bound(pattern);
-        while (found != index.end())
+        VFS::RecursiveDirectoryRange files = mVFS->getRecursiveDirectoryIterator("Splash/");
+        for (VFS::RecursiveDirectoryIterator it = files.begin(); it != files.end(); ++it)
         {
-            const std::string& name = found->first;
-            if (name.size() >= pattern.size() && name.substr(0, pattern.size()) == pattern)
-            {
-                size_t pos = name.find_last_of('.');
-                if (pos != std::string::npos && name.compare(pos, name.size()-pos, ".tga") == 0)
-                    mSplashScreens.push_back(found->first);
-            }
-            else
-                break;
-            ++found;
+            const std::string& name = *it;
+            size_t pos = name.find_last_of('.');
+            if (pos != std::string::npos && name.compare(pos, name.size()-pos, ".tga") == 0)
+                mSplashScreens.push_back(name);
         }
         if (mSplashScreens.empty())
             std::cerr << "No splash screens found!" << std::endl;
@@ -0,0 +1,70 @@
+#include "actorgrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace MWMechanics
+{
+
+    bool ActorGrid::Entry::operator<(const Entry& other) const
+    {
+        if (mX != other.mX)
+            return mX < other.mX;
+        return mY < other.mY;
+    }
+
+    ActorGrid::ActorGrid(float cellSize)
+        : mCellSize(cellSize)
+    {
+    }
+
+    void ActorGrid::clear()
+    {
+        mEntries.clear();
+    }
+
+    void ActorGrid::insert(const MWWorld::Ptr& ptr, const osg::Vec3f& position)
+    {
+        Entry entry;
+        entry.mX = getCell(position.x());
+        entry.mY = getCell(position.y());
+        entry.mPosition = position;
+        entry.mPtr = ptr;
+        mEntries.push_back(entry);
+    }
+
+    void ActorGrid::sort()
+    {
+        std::sort(mEntries.begin(), mEntries.end());
+    }
+
+    void ActorGrid::query(const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& out) const
+    {
+        const size_t first = out.size();
+        const float sqrRadius = radius*radius;
+        const int minY = getCell(position.y() - radius);
+        const int maxY = getCell(position.y() + radius);
+        const int maxX = getCell(position.x() + radius);
+
+        Entry key;
+        key.mY = minY;
+        for (key.mX = getCell(position.x() - radius); key.mX <= maxX; ++key.mX)
+        {
+            // Entries are sorted by column first, so the cells of one column are adjacent
+            std::vector<Entry>::const_iterator it = std::lower_bound(mEntries.begin(), mEntries.end(), key);
+            for (; it != mEntries.end() && it->mX == key.mX && it->mY <= maxY; ++it)
+            {
+                if ((it->mPosition - position).length2() <= sqrRadius)
+                    out.push_back(it->mPtr);
+            }
+        }
+
+        std::sort(out.begin() + first, out.end());
+    }
+
+    int ActorGrid::getCell(float coord) const
+    {
+        return static_cast<int>(std::floor(coord / mCellSize));
+    }
+
+}
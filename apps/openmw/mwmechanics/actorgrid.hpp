@@ -0,0 +1,50 @@
+#ifndef GAME_MWMECHANICS_ACTORGRID_H
+#define GAME_MWMECHANICS_ACTORGRID_H
+
+#include <vector>
+
+#include <osg/Vec3f>
+
+#include "../mwworld/ptr.hpp"
+
+namespace MWMechanics
+{
+    /// @brief Uniform grid over the horizontal actor positions, to find the actors near a point without
+    /// testing the distance to every actor.
+    /// @note Positions are copied on insertion, so the grid has to be rebuilt when actors move.
+    class ActorGrid
+    {
+    public:
+        /// @param cellSize Edge length of a grid cell in game units.
+        ActorGrid(float cellSize);
+
+        void clear();
+
+        /// Add an actor. Call sort() after the last insertion, before doing any queries.
+        void insert(const MWWorld::Ptr& ptr, const osg::Vec3f& position);
+
+        void sort();
+
+        /// Append the actors within \a radius of \a position to \a out. The appended actors are
+        /// ordered by Ptr, the same order in which Actors::PtrActorMap is iterated.
+        void query(const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& out) const;
+
+    private:
+        struct Entry
+        {
+            int mX;
+            int mY;
+            osg::Vec3f mPosition;
+            MWWorld::Ptr mPtr;
+
+            bool operator<(const Entry& other) const;
+        };
+
+        int getCell(float coord) const;
+
+        float mCellSize;
+        std::vector<Entry> mEntries;
+    };
+}
+
+#endif
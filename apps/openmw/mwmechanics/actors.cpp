@@ -2,6 +2,7 @@
 
 #include <typeinfo>
 #include <iostream>
+#include <algorithm>
 
 #include <components/esm/esmreader.hpp>
 #include <components/esm/esmwriter.hpp>
@@ -119,6 +120,50 @@ void adjustCommandedActor (const MWWorld::Ptr& actor)
     }
 }
 
+// Returns the first package of the actor's AI sequence that is not a combat package. Follow and Escort packages
+// only count when they are the current package or there are only Combat packages before them.
+const MWMechanics::AiPackage* getLeadingAiPackage (const MWWorld::Ptr& actor)
+{
+    const MWMechanics::AiSequence& sequence = actor.getClass().getCreatureStats(actor).getAiSequence();
+    for (std::list<MWMechanics::AiPackage*>::const_iterator it = sequence.begin(); it != sequence.end(); ++it)
+    {
+        if ((*it)->getTypeId() != MWMechanics::AiPackage::TypeIdCombat)
+            return *it;
+    }
+    return NULL;
+}
+
+// Returns the actor that this actor is following or escorting, if any
+MWWorld::Ptr getSideWithTarget (const MWWorld::Ptr& actor)
+{
+    const MWMechanics::AiPackage* package = getLeadingAiPackage(actor);
+    if (package && package->sideWithTarget())
+        return package->getTarget();
+    return MWWorld::Ptr();
+}
+
+// Returns the actor that this actor is following through doors, if any
+MWWorld::Ptr getFollowTarget (const MWWorld::Ptr& actor)
+{
+    const MWMechanics::AiPackage* package = getLeadingAiPackage(actor);
+    if (package && package->followTargetThroughDoors())
+        return package->getTarget();
+    return MWWorld::Ptr();
+}
+
+float getMaxHeadTrackDistance (const MWWorld::Ptr& actor)
+{
+    static const float fMaxHeadTrackDistance = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
+            .find("fMaxHeadTrackDistance")->getFloat();
+    static const float fInteriorHeadTrackMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
+            .find("fInteriorHeadTrackMult")->getFloat();
+    float maxDistance = fMaxHeadTrackDistance;
+    const ESM::Cell* currentCell = actor.getCell()->getCell();
+    if (!currentCell->isExterior() && !(currentCell->mData.mFlags & ESM::Cell::QuasiEx))
+        maxDistance *= fInteriorHeadTrackMult;
+    return maxDistance;
+}
+
 void getRestorationPerHourOfSleep (const MWWorld::Ptr& ptr, float& health, float& magicka)
 {
     MWMechanics::CreatureStats& stats = ptr.getClass().getCreatureStats (ptr);
@@ -145,6 +190,9 @@ namespace MWMechanics
     const float aiProcessingDistance = 7168;
     const float sqrAiProcessingDistance = aiProcessingDistance*aiProcessingDistance;
 
+    // Large enough that a query within aiProcessingDistance only has to look at a few columns of the grid
+    const float actorGridCellSize = 1024;
+
     class SoulTrap : public MWMechanics::EffectSourceVisitor
     {
         MWWorld::Ptr mCreature;
@@ -227,9 +275,14 @@ namespace MWMechanics
     };
 
     void Actors::updateActor (const MWWorld::Ptr& ptr, float duration)
+    {
+        updateActor(ptr, duration, NULL);
+    }
+
+    void Actors::updateActor (const MWWorld::Ptr& ptr, float duration, const ActorThinkResult* thinkResult)
     {
         // magic effects
-        adjustMagicEffects (ptr);
+        adjustMagicEffects (ptr, thinkResult);
         if (ptr.getClass().getCreatureStats(ptr).needToRecalcDynamicStats())
             calculateDynamicStats (ptr);
 
@@ -241,14 +294,7 @@ namespace MWMechanics
     void Actors::updateHeadTracking(const MWWorld::Ptr& actor, const MWWorld::Ptr& targetActor,
                                     MWWorld::Ptr& headTrackTarget, float& sqrHeadTrackDistance)
     {
-        static const float fMaxHeadTrackDistance = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                .find("fMaxHeadTrackDistance")->getFloat();
-        static const float fInteriorHeadTrackMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                .find("fInteriorHeadTrackMult")->getFloat();
-        float maxDistance = fMaxHeadTrackDistance;
-        const ESM::Cell* currentCell = actor.getCell()->getCell();
-        if (!currentCell->isExterior() && !(currentCell->mData.mFlags & ESM::Cell::QuasiEx))
-            maxDistance *= fInteriorHeadTrackMult;
+        float maxDistance = getMaxHeadTrackDistance(actor);
 
         const ESM::Position& actor1Pos = actor.getRefData().getPosition();
         const ESM::Position& actor2Pos = targetActor.getRefData().getPosition();
@@ -272,7 +318,7 @@ namespace MWMechanics
         targetDirection.normalize();
         if (std::acos(actorDirection * targetDirection) < osg::DegreesToRadians(90.f)
             && sqrDist <= sqrHeadTrackDistance
-            && MWBase::Environment::get().getWorld()->getLOS(actor, targetActor) // check LOS and awareness last as it's the most expensive function
+            && MWBase::Environment::get().getWorld()->getLOS(actor, targetActor, MWPhysics::RayCategory_Combat) // check LOS and awareness last as it's the most expensive function
             && MWBase::Environment::get().getMechanicsManager()->awarenessCheck(targetActor, actor))
         {
             sqrHeadTrackDistance = sqrDist;
@@ -414,7 +460,7 @@ namespace MWMechanics
         // If any of the above conditions turned actor1 aggressive towards actor2, do an awareness check. If it passes, start combat with actor2.
         if (aggressive)
         {
-            bool LOS = MWBase::Environment::get().getWorld()->getLOS(actor1, actor2);
+            bool LOS = MWBase::Environment::get().getWorld()->getLOS(actor1, actor2, MWPhysics::RayCategory_Combat);
             LOS &= MWBase::Environment::get().getMechanicsManager()->awarenessCheck(actor2, actor1);
 
             if (LOS)
@@ -428,23 +474,20 @@ namespace MWMechanics
         calculateNpcStatModifiers(ptr, duration);
     }
 
-    void Actors::adjustMagicEffects (const MWWorld::Ptr& creature)
+    void Actors::adjustMagicEffects (const MWWorld::Ptr& creature, const ActorThinkResult* thinkResult)
     {
         CreatureStats& creatureStats =  creature.getClass().getCreatureStats (creature);
         if (creatureStats.isDead())
             return;
 
-        MagicEffects now = creatureStats.getSpells().getMagicEffects();
-
-        if (creature.getTypeName()==typeid (ESM::NPC).name())
+        ActorThinkResult result;
+        if (!thinkResult || !thinkResult->mValid)
         {
-            MWWorld::InventoryStore& store = creature.getClass().getInventoryStore (creature);
-            now += store.getMagicEffects();
+            ParallelActorUpdate::think(creature, result);
+            thinkResult = &result;
         }
 
-        now += creatureStats.getActiveSpells().getMagicEffects();
-
-        creatureStats.modifyMagicEffects(now);
+        creatureStats.modifyMagicEffects(thinkResult->mMagicEffects);
     }
 
     void Actors::calculateDynamicStats (const MWWorld::Ptr& ptr)
@@ -956,7 +999,7 @@ namespace MWMechanics
                 // In vanilla morrowind, the greeting dialogue is scripted to either arrest the player (< 5000 bounty) or attack (>= 5000 bounty)
                 if (   player.getClass().getNpcStats(player).getBounty() >= cutoff
                        // TODO: do not run these two every frame. keep an Aware state for each actor and update it every 0.2 s or so?
-                    && MWBase::Environment::get().getWorld()->getLOS(ptr, player)
+                    && MWBase::Environment::get().getWorld()->getLOS(ptr, player, MWPhysics::RayCategory_Detection)
                     && MWBase::Environment::get().getMechanicsManager()->awarenessCheck(player, ptr))
                 {
                     static const int iCrimeThresholdMultiplier = esmStore.get<ESM::GameSetting>().find("iCrimeThresholdMultiplier")->getInt();
@@ -995,7 +1038,15 @@ namespace MWMechanics
         }
     }
 
-    Actors::Actors() {}
+    Actors::Actors()
+        : mActorIndexValid(false)
+        , mActorGrid(actorGridCellSize)
+        , mFollowerIndexChangeCount(0)
+    {
+        int numThreads = Settings::Manager::getInt("actor update threads", "Game");
+        if (numThreads > 0)
+            mParallelUpdate.reset(new ParallelActorUpdate(numThreads));
+    }
 
     Actors::~Actors()
     {
@@ -1005,6 +1056,7 @@ namespace MWMechanics
     void Actors::addActor (const MWWorld::Ptr& ptr, bool updateImmediately)
     {
         removeActor(ptr);
+        invalidateActorIndex();
 
         MWRender::Animation *anim = MWBase::Environment::get().getWorld()->getAnimation(ptr);
         if (!anim)
@@ -1021,6 +1073,7 @@ namespace MWMechanics
         {
             delete iter->second;
             mActors.erase(iter);
+            invalidateActorIndex();
         }
     }
 
@@ -1034,6 +1087,7 @@ namespace MWMechanics
 
             actor->updatePtr(ptr);
             mActors.insert(std::make_pair(ptr, actor));
+            invalidateActorIndex();
         }
     }
 
@@ -1046,6 +1100,7 @@ namespace MWMechanics
             {
                 delete iter->second;
                 mActors.erase(iter++);
+                invalidateActorIndex();
             }
             else
                 ++iter;
@@ -1070,6 +1125,21 @@ namespace MWMechanics
 
             int hostilesCount = 0; // need to know this to play Battle music
 
+            // Actors don't move until the physics update, so the index stays valid for the rest of the update
+            // unless actors are added or removed
+            buildActorIndex();
+
+            std::vector<MWWorld::Ptr> neighbors;
+
+            // Think phase, see ParallelActorUpdate. The results are committed below, in the same order as without threads.
+            if (mParallelUpdate.get())
+            {
+                mThinkActors.clear();
+                for(PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
+                    mThinkActors.push_back(iter->first);
+                mParallelUpdate->think(mThinkActors, mThinkResults);
+            }
+
             /// \todo move update logic to Actor class where appropriate
 
              // AI and magic effects update
@@ -1106,9 +1176,10 @@ namespace MWMechanics
                 {
                     bool cellChanged = MWBase::Environment::get().getWorld()->hasCellChanged();
                     MWWorld::Ptr actor = iter->first; // make a copy of the map key to avoid it being invalidated when the player teleports
-                    updateActor(actor, duration);
+                    updateActor(actor, duration, getThinkResult(actor));
                     if (!cellChanged && MWBase::Environment::get().getWorld()->hasCellChanged())
                     {
+                        invalidateActorIndex();
                         return; // for now abort update of the old cell when cell changes by teleportation magic effect
                                 // a better solution might be to apply cell changes at the end of the frame
                     }
@@ -1119,11 +1190,16 @@ namespace MWMechanics
                             if (iter->first != player)
                                 adjustCommandedActor(iter->first);
 
-                            for(PtrActorMap::iterator it(mActors.begin()); it != mActors.end(); ++it)
+                            // engageCombat ignores actors beyond the AI processing distance
+                            neighbors.clear();
+                            if (iter->first != player) // player is not AI-controlled
+                                getObjectsInRange(iter->first.getRefData().getPosition().asVec3(), aiProcessingDistance, neighbors);
+
+                            for(std::vector<MWWorld::Ptr>::iterator it(neighbors.begin()); it != neighbors.end(); ++it)
                             {
-                                if (it->first == iter->first || iter->first == player) // player is not AI-controlled
+                                if (*it == iter->first)
                                     continue;
-                                engageCombat(iter->first, it->first, it->first == player);
+                                engageCombat(iter->first, *it, *it == player);
                             }
                         }
                         if (timerUpdateHeadTrack == 0)
@@ -1131,11 +1207,14 @@ namespace MWMechanics
                             float sqrHeadTrackDistance = std::numeric_limits<float>::max();
                             MWWorld::Ptr headTrackTarget;
 
-                            for(PtrActorMap::iterator it(mActors.begin()); it != mActors.end(); ++it)
+                            neighbors.clear();
+                            getObjectsInRange(iter->first.getRefData().getPosition().asVec3(), getMaxHeadTrackDistance(iter->first), neighbors);
+
+                            for(std::vector<MWWorld::Ptr>::iterator it(neighbors.begin()); it != neighbors.end(); ++it)
                             {
-                                if (it->first == iter->first)
+                                if (*it == iter->first)
                                     continue;
-                                updateHeadTracking(iter->first, it->first, headTrackTarget, sqrHeadTrackDistance);
+                                updateHeadTracking(iter->first, *it, headTrackTarget, sqrHeadTrackDistance);
                             }
                             iter->second->getCharacterController()->setHeadTrackTarget(headTrackTarget);
                         }
@@ -1258,19 +1337,31 @@ namespace MWMechanics
 
                     bool detected = false;
 
-                    for (PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
-                    {
-                        MWWorld::Ptr observer = iter->first;
+                    neighbors.clear();
+                    getObjectsInRange(player.getRefData().getPosition().asVec3(), static_cast<float>(radius), neighbors);
 
-                        if (iter->first == player)  // not the player
+                    std::vector<MWWorld::Ptr> observers;
+                    for (std::vector<MWWorld::Ptr>::iterator iter(neighbors.begin()); iter != neighbors.end(); ++iter)
+                    {
+                        if (*iter == player)  // not the player
                             continue;
 
-                        if (observer.getClass().getCreatureStats(observer).isDead())
+                        if (iter->getClass().getCreatureStats(*iter).isDead())
                             continue;
 
+                        observers.push_back(*iter);
+                    }
+
+                    // Cast the rays to all observers at once
+                    std::vector<bool> lineOfSight;
+                    MWBase::Environment::get().getWorld()->getLOS(player, observers, lineOfSight, MWPhysics::RayCategory_Detection);
+
+                    for (size_t i=0; i<observers.size(); ++i)
+                    {
+                        const MWWorld::Ptr& observer = observers[i];
+
                         // is the player in range and can they be detected
-                        if ((observer.getRefData().getPosition().asVec3() - player.getRefData().getPosition().asVec3()).length2() <= radius*radius
-                            && MWBase::Environment::get().getWorld()->getLOS(player, observer))
+                        if (lineOfSight[i])
                         {
                             if (MWBase::Environment::get().getMechanicsManager()->awarenessCheck(player, observer))
                             {
@@ -1301,6 +1392,8 @@ namespace MWMechanics
                 sneakTimer = 0.f;
                 MWBase::Environment::get().getWindowManager()->setSneakVisibility(false);
             }
+
+            invalidateActorIndex();
         }
     }
 
@@ -1505,6 +1598,12 @@ namespace MWMechanics
 
     void Actors::getObjectsInRange(const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& out)
     {
+        if (mActorIndexValid)
+        {
+            mActorGrid.query(position, radius, out);
+            return;
+        }
+
         for (PtrActorMap::iterator iter = mActors.begin(); iter != mActors.end(); ++iter)
         {
             if ((iter->first.getRefData().getPosition().asVec3() - position).length2() <= radius*radius)
@@ -1515,61 +1614,72 @@ namespace MWMechanics
     std::list<MWWorld::Ptr> Actors::getActorsSidingWith(const MWWorld::Ptr& actor)
     {
         std::list<MWWorld::Ptr> list;
-        for(PtrActorMap::iterator iter(mActors.begin());iter != mActors.end();++iter)
+        if (mActorIndexValid)
         {
-            const MWWorld::Class &cls = iter->first.getClass();
-            const CreatureStats &stats = cls.getCreatureStats(iter->first);
-            if (stats.isDead())
-                continue;
+            if (mFollowerIndexChangeCount != AiSequence::getChangeCount())
+                buildFollowerIndex();
 
-            // An actor counts as siding with this actor if Follow or Escort is the current AI package, or there are only Combat packages before the Follow/Escort package
-            for (std::list<MWMechanics::AiPackage*>::const_iterator it = stats.getAiSequence().begin(); it != stats.getAiSequence().end(); ++it)
+            PtrListMap::const_iterator found = mSidingWith.find(actor);
+            if (found != mSidingWith.end())
             {
-                if ((*it)->sideWithTarget() && (*it)->getTarget() == actor)
+                for (std::vector<MWWorld::Ptr>::const_iterator it = found->second.begin(); it != found->second.end(); ++it)
                 {
-                    list.push_back(iter->first);
-                    break;
+                    if (!it->getClass().getCreatureStats(*it).isDead())
+                        list.push_back(*it);
                 }
-                else if ((*it)->getTypeId() != MWMechanics::AiPackage::TypeIdCombat)
-                    break;
             }
-            // Actors that are targeted by this actor's Follow or Escort packages also side with them
-            if (actor != getPlayer())
+        }
+        else
+        {
+            for(PtrActorMap::iterator iter(mActors.begin());iter != mActors.end();++iter)
             {
-                const CreatureStats &stats2 = actor.getClass().getCreatureStats(actor);
-                for (std::list<MWMechanics::AiPackage*>::const_iterator it2 = stats2.getAiSequence().begin(); it2 != stats2.getAiSequence().end(); ++it2)
-                {
-                    if ((*it2)->sideWithTarget() && !(*it2)->getTarget().isEmpty())
-                    {
-                        list.push_back((*it2)->getTarget());
-                        break;
-                    }
-                    else if ((*it2)->getTypeId() != MWMechanics::AiPackage::TypeIdCombat)
-                        break;
-                }
+                if (iter->first.getClass().getCreatureStats(iter->first).isDead())
+                    continue;
+
+                // An actor counts as siding with this actor if Follow or Escort is the current AI package, or there are only Combat packages before the Follow/Escort package
+                if (getSideWithTarget(iter->first) == actor)
+                    list.push_back(iter->first);
             }
         }
+
+        // Actors that are targeted by this actor's Follow or Escort packages also side with them
+        if (actor != getPlayer())
+        {
+            MWWorld::Ptr target = getSideWithTarget(actor);
+            if (!target.isEmpty())
+                list.push_back(target);
+        }
         return list;
     }
 
     std::list<MWWorld::Ptr> Actors::getActorsFollowing(const MWWorld::Ptr& actor)
     {
         std::list<MWWorld::Ptr> list;
+        if (mActorIndexValid)
+        {
+            if (mFollowerIndexChangeCount != AiSequence::getChangeCount())
+                buildFollowerIndex();
+
+            PtrListMap::const_iterator found = mFollowing.find(actor);
+            if (found != mFollowing.end())
+            {
+                for (std::vector<MWWorld::Ptr>::const_iterator it = found->second.begin(); it != found->second.end(); ++it)
+                {
+                    if (!it->getClass().getCreatureStats(*it).isDead())
+                        list.push_back(*it);
+                }
+            }
+            return list;
+        }
+
         for(PtrActorMap::iterator iter(mActors.begin());iter != mActors.end();++iter)
         {
-            const MWWorld::Class &cls = iter->first.getClass();
-            CreatureStats &stats = cls.getCreatureStats(iter->first);
-            if (stats.isDead())
+            if (iter->first.getClass().getCreatureStats(iter->first).isDead())
                 continue;
 
             // An actor counts as following if AiFollow is the current AiPackage, or there are only Combat packages before the AiFollow package
-            for (std::list<MWMechanics::AiPackage*>::const_iterator it = stats.getAiSequence().begin(); it != stats.getAiSequence().end(); ++it)
-            {
-                if ((*it)->followTargetThroughDoors() && (*it)->getTarget() == actor)
-                    list.push_back(iter->first);
-                else if ((*it)->getTypeId() != MWMechanics::AiPackage::TypeIdCombat)
-                    break;
-            }
+            if (getFollowTarget(iter->first) == actor)
+                list.push_back(iter->first);
         }
         return list;
     }
@@ -1690,6 +1800,65 @@ namespace MWMechanics
         }
         mActors.clear();
         mDeathCount.clear();
+        invalidateActorIndex();
+    }
+
+    void Actors::buildActorIndex()
+    {
+        mActorGrid.clear();
+        for (PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
+            mActorGrid.insert(iter->first, iter->first.getRefData().getPosition().asVec3());
+        mActorGrid.sort();
+
+        buildFollowerIndex();
+        mActorIndexValid = true;
+    }
+
+    void Actors::buildFollowerIndex()
+    {
+        mSidingWith.clear();
+        mFollowing.clear();
+        mFollowerIndexChangeCount = AiSequence::getChangeCount();
+
+        for (PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
+        {
+            // Resolving the target is expensive, so do it once per actor rather than for every query
+            const AiPackage* package = getLeadingAiPackage(iter->first);
+            if (!package || !(package->sideWithTarget() || package->followTargetThroughDoors()))
+                continue;
+
+            MWWorld::Ptr target = package->getTarget();
+            if (target.isEmpty())
+                continue;
+
+            if (package->sideWithTarget())
+                mSidingWith[target].push_back(iter->first);
+            if (package->followTargetThroughDoors())
+                mFollowing[target].push_back(iter->first);
+        }
+    }
+
+    const ActorThinkResult* Actors::getThinkResult(const MWWorld::Ptr& ptr) const
+    {
+        // Actors added during the update were not part of the think phase
+        std::vector<MWWorld::Ptr>::const_iterator found = std::lower_bound(mThinkActors.begin(), mThinkActors.end(), ptr);
+        if (found == mThinkActors.end() || *found != ptr)
+            return NULL;
+        return &mThinkResults[found - mThinkActors.begin()];
+    }
+
+    void Actors::invalidateActorIndex()
+    {
+        mThinkActors.clear();
+        mThinkResults.clear();
+
+        if (!mActorIndexValid)
+            return;
+
+        mActorIndexValid = false;
+        mActorGrid.clear();
+        mSidingWith.clear();
+        mFollowing.clear();
     }
 
     void Actors::updateMagicEffects(const MWWorld::Ptr &ptr)
@@ -6,10 +6,13 @@
 #include <string>
 #include <map>
 #include <list>
+#include <memory>
 
 #include "../mwbase/world.hpp"
 
 #include "movement.hpp"
+#include "actorgrid.hpp"
+#include "parallelactorupdate.hpp"
 
 namespace MWWorld
 {
@@ -28,7 +31,8 @@ namespace MWMechanics
 
             void updateNpc(const MWWorld::Ptr &ptr, float duration);
 
-            void adjustMagicEffects (const MWWorld::Ptr& creature);
+            void adjustMagicEffects (const MWWorld::Ptr& creature, const ActorThinkResult* thinkResult = NULL);
+            ///< \param thinkResult Result of the think phase, if it was run for this actor in the current update.
 
             void calculateDynamicStats (const MWWorld::Ptr& ptr);
 
@@ -47,6 +51,23 @@ namespace MWMechanics
 
             void purgeSpellEffects (int casterActorId);
 
+            void updateActor (const MWWorld::Ptr& ptr, float duration, const ActorThinkResult* thinkResult);
+
+            const ActorThinkResult* getThinkResult (const MWWorld::Ptr& ptr) const;
+            ///< Return the result of the think phase of the current update for \a ptr, or NULL if there is none.
+
+            void buildActorIndex();
+            ///< Index the positions of the actors and who they are following or siding with, to
+            /// answer range and follower queries during the update without scanning all actors.
+
+            void buildFollowerIndex();
+            ///< Index who the actors are following or siding with. Called again by the follower queries when
+            /// an AiSequence has changed since, so that packages added or completed during the update are seen.
+
+            void invalidateActorIndex();
+            ///< Fall back to scanning all actors, until the index is built again by the next update. Also drops
+            /// the results of the think phase, which are only valid for the actors they were computed for.
+
         public:
 
             Actors();
@@ -149,6 +170,18 @@ namespace MWMechanics
     private:
         PtrActorMap mActors;
 
+        typedef std::map<MWWorld::Ptr, std::vector<MWWorld::Ptr> > PtrListMap;
+
+        bool mActorIndexValid;
+        ActorGrid mActorGrid;
+        PtrListMap mSidingWith; ///< Actors whose current Follow or Escort package targets the key
+        PtrListMap mFollowing; ///< Actors whose current Follow package targets the key
+        unsigned int mFollowerIndexChangeCount; ///< AiSequence::getChangeCount() when the follower index was built
+
+        std::auto_ptr<ParallelActorUpdate> mParallelUpdate; ///< NULL if the think phase runs on the main thread
+        std::vector<MWWorld::Ptr> mThinkActors; ///< Sorted by Ptr
+        std::vector<ActorThinkResult> mThinkResults;
+
     };
 }
 
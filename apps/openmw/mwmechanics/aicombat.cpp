@@ -330,7 +330,7 @@ namespace MWMechanics
         static const float LOS_UPDATE_DURATION = 0.5f;
         if (storage.mUpdateLOSTimer <= 0.f)
         {
-            storage.mLOS = MWBase::Environment::get().getWorld()->getLOS(actor, target);
+            storage.mLOS = MWBase::Environment::get().getWorld()->getLOS(actor, target, MWPhysics::RayCategory_Combat);
             storage.mUpdateLOSTimer = LOS_UPDATE_DURATION;
         }
         else
@@ -772,7 +772,7 @@ namespace MWMechanics
         if (atDist > getDistanceMinusHalfExtents(actor, enemy)
                 && atDist > std::abs(actorPos.pos[2] - enemyPos.pos[2]))
         {
-            if (MWBase::Environment::get().getWorld()->getLOS(actor, enemy))
+            if (MWBase::Environment::get().getWorld()->getLOS(actor, enemy, MWPhysics::RayCategory_Combat))
                 return true;
         }
 
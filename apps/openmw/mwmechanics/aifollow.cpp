@@ -82,7 +82,7 @@ bool AiFollow::execute (const MWWorld::Ptr& actor, CharacterController& characte
         {
             if ((actor.getRefData().getPosition().asVec3() - target.getRefData().getPosition().asVec3()).length2()
                     < 500*500
-                    && MWBase::Environment::get().getWorld()->getLOS(actor, target))
+                    && MWBase::Environment::get().getWorld()->getLOS(actor, target, MWPhysics::RayCategory_Follow))
                 mActive = true;
             storage.mTimer = 0.5f;
         }
@@ -113,9 +113,7 @@ bool MWMechanics::AiPackage::pathTo(const MWWorld::Ptr& actor, const ESM::Pathgr
                 if (destInLOS && mPathFinder.getPath().size() > 1)
                 {
                     // get point just before dest
-                    std::list<ESM::Pathgrid::Point>::const_iterator pPointBeforeDest = mPathFinder.getPath().end();
-                    --pPointBeforeDest;
-                    --pPointBeforeDest;
+                    std::vector<ESM::Pathgrid::Point>::const_iterator pPointBeforeDest = mPathFinder.getPath().end() - 2;
 
                     // if start point is closer to the target then last point of path (excluding target itself) then go straight on the target
                     if (distance(start, dest) <= distance(dest, *pPointBeforeDest))
@@ -209,7 +207,8 @@ bool MWMechanics::AiPackage::shortcutPath(const ESM::Pathgrid::Point& startPoint
         // check if target is clearly visible
         isPathClear = !MWBase::Environment::get().getWorld()->castRay(
             static_cast<float>(startPoint.mX), static_cast<float>(startPoint.mY), static_cast<float>(startPoint.mZ),
-            static_cast<float>(endPoint.mX), static_cast<float>(endPoint.mY), static_cast<float>(endPoint.mZ));
+            static_cast<float>(endPoint.mX), static_cast<float>(endPoint.mY), static_cast<float>(endPoint.mZ),
+            MWPhysics::RayCategory_Pathfinding);
 
         if (destInLOS != NULL) *destInLOS = isPathClear;
 
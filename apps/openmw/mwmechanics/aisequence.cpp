@@ -22,11 +22,14 @@
 namespace MWMechanics
 {
 
+unsigned int AiSequence::sChangeCount = 0;
+
 void AiSequence::copy (const AiSequence& sequence)
 {
     for (std::list<AiPackage *>::const_iterator iter (sequence.mPackages.begin());
         iter!=sequence.mPackages.end(); ++iter)
         mPackages.push_back ((*iter)->clone());
+    ++sChangeCount;
 }
 
 AiSequence::AiSequence() : mDone (false), mRepeat(false), mLastAiPackage(-1) {}
@@ -57,6 +60,11 @@ AiSequence::~AiSequence()
     clear();
 }
 
+unsigned int AiSequence::getChangeCount()
+{
+    return sChangeCount;
+}
+
 int AiSequence::getTypeId() const
 {
     if (mPackages.empty())
@@ -105,6 +113,7 @@ std::list<AiPackage*>::const_iterator AiSequence::erase(std::list<AiPackage*>::c
         {
             AiPackage* packagePtr = *it;
             delete packagePtr;
+            ++sChangeCount;
             return mPackages.erase(it);
         }
     }
@@ -142,6 +151,7 @@ void AiSequence::stopCombat()
         {
             delete *it;
             it = mPackages.erase(it);
+            ++sChangeCount;
         }
         else
             ++it;
@@ -156,6 +166,7 @@ void AiSequence::stopPursuit()
         {
             delete *it;
             it = mPackages.erase(it);
+            ++sChangeCount;
         }
         else
             ++it;
@@ -209,6 +220,7 @@ void AiSequence::execute (const MWWorld::Ptr& actor, CharacterController& charac
                 {
                     delete *it;
                     it = mPackages.erase(it);
+                    ++sChangeCount;
                 }
                 else
                 {
@@ -257,6 +269,7 @@ void AiSequence::execute (const MWWorld::Ptr& actor, CharacterController& charac
                         std::find(mPackages.begin(), mPackages.end(), package);
                 mPackages.erase(toRemove);
                 delete package;
+                ++sChangeCount;
                 if (isActualAiPackage(packageTypeId))
                     mDone = true;
             }
@@ -277,6 +290,8 @@ void AiSequence::clear()
     for (std::list<AiPackage *>::const_iterator iter (mPackages.begin()); iter!=mPackages.end(); ++iter)
         delete *iter;
 
+    if (!mPackages.empty())
+        ++sChangeCount;
     mPackages.clear();
 }
 
@@ -313,6 +328,7 @@ void AiSequence::stack (const AiPackage& package, const MWWorld::Ptr& actor)
             {
                 delete *it;
                 it = mPackages.erase(it);
+                ++sChangeCount;
             }
             else
                 ++it;
@@ -326,11 +342,13 @@ void AiSequence::stack (const AiPackage& package, const MWWorld::Ptr& actor)
         if((*it)->getPriority() <= package.getPriority())
         {
             mPackages.insert(it,package.clone());
+            ++sChangeCount;
             return;
         }
     }
 
     mPackages.push_back (package.clone());
+    ++sChangeCount;
 }
 
 AiPackage* MWMechanics::AiSequence::getActivePackage()
@@ -381,6 +399,7 @@ void AiSequence::fill(const ESM::AIPackageList &list)
         }
         mPackages.push_back(package);
     }
+    ++sChangeCount;
 }
 
 void AiSequence::writeState(ESM::AiSequence::AiSequence &sequence) const
@@ -459,6 +478,7 @@ void AiSequence::readState(const ESM::AiSequence::AiSequence &sequence)
 
         mPackages.push_back(package.release());
     }
+    ++sChangeCount;
 }
 
 void AiSequence::fastForward(const MWWorld::Ptr& actor, AiState& state)
@@ -48,6 +48,9 @@ namespace MWMechanics
             /// The type of AI package that ran last
             int mLastAiPackage;
 
+            /// Incremented whenever packages are added to or removed from any AiSequence
+            static unsigned int sChangeCount;
+
         public:
             ///Default constructor
             AiSequence();
@@ -60,6 +63,10 @@ namespace MWMechanics
 
             virtual ~AiSequence();
 
+            /// Returns a counter that changes whenever packages are added to or removed from any AiSequence,
+            /// to tell when data derived from the current packages of several actors is out of date.
+            static unsigned int getChangeCount();
+
             /// Iterator may be invalidated by any function calls other than begin() or end().
             std::list<AiPackage*>::const_iterator begin() const;
             std::list<AiPackage*>::const_iterator end() const;
@@ -390,7 +390,8 @@ namespace MWMechanics
      * Returns true if the position provided is above water.
      */
     bool AiWander::destinationIsAtWater(const MWWorld::Ptr &actor, const osg::Vec3f& destination) {
-        float heightToGroundOrWater = MWBase::Environment::get().getWorld()->getDistToNearestRayHit(destination, osg::Vec3f(0,0,-1), 1000.0, true);
+        float heightToGroundOrWater = MWBase::Environment::get().getWorld()->getDistToNearestRayHit(destination, osg::Vec3f(0,0,-1), 1000.0, true,
+                                                                                                            MWPhysics::RayCategory_Wander);
         osg::Vec3f positionBelowSurface = destination;
         positionBelowSurface[2] = positionBelowSurface[2] - heightToGroundOrWater - 1.0f;
         return MWBase::Environment::get().getWorld()->isUnderwater(actor.getCell(), positionBelowSurface);
@@ -401,7 +402,8 @@ namespace MWMechanics
      */
     bool AiWander::destinationThroughGround(const osg::Vec3f& startPoint, const osg::Vec3f& destination) {
         return MWBase::Environment::get().getWorld()->castRay(startPoint.x(), startPoint.y(), startPoint.z(),
-                                                              destination.x(), destination.y(), destination.z());
+                                                              destination.x(), destination.y(), destination.z(),
+                                                              MWPhysics::RayCategory_Wander);
     }
 
     void AiWander::completeManualWalking(const MWWorld::Ptr &actor, AiWanderStorage &storage) {
@@ -569,7 +571,7 @@ namespace MWMechanics
             const ESM::Position& pos = actor.getRefData().getPosition();
             if (roll < x && (player.getRefData().getPosition().asVec3() - pos.asVec3()).length2()
                 < 3000 * 3000 // maybe should be fAudioVoiceDefaultMaxDistance*fAudioMaxDistanceMult instead
-                && MWBase::Environment::get().getWorld()->getLOS(player, actor))
+                && MWBase::Environment::get().getWorld()->getLOS(player, actor, MWPhysics::RayCategory_Wander))
                 MWBase::Environment::get().getDialogueManager()->say(actor, "idle");
         }
     }
@@ -594,7 +596,7 @@ namespace MWMechanics
         if (greetingState == Greet_None)
         {
             if ((playerDistSqr <= helloDistance*helloDistance) &&
-                !player.getClass().getCreatureStats(player).isDead() && MWBase::Environment::get().getWorld()->getLOS(player, actor)
+                !player.getClass().getCreatureStats(player).isDead() && MWBase::Environment::get().getWorld()->getLOS(player, actor, MWPhysics::RayCategory_Wander)
                 && MWBase::Environment::get().getMechanicsManager()->awarenessCheck(player, actor))
                 greetingTimer++;
 
@@ -687,7 +689,7 @@ namespace MWMechanics
         // Every now and then check whether one of the doors is opened. (maybe
         // at the end of playing idle?) If the door is opened then re-calculate
         // allowed nodes starting from the spawn point.
-        std::list<ESM::Pathgrid::Point> paths = pathfinder.getPath();
+        std::vector<ESM::Pathgrid::Point> paths = pathfinder.getPath();
         while(paths.size() >= 2)
         {
             ESM::Pathgrid::Point pt = paths.back();
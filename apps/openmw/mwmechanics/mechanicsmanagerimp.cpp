@@ -999,17 +999,26 @@ namespace MWMechanics
         std::set<MWWorld::Ptr> playerFollowers;
         getActorsSidingWith(player, playerFollowers);
 
-        // Did anyone see it?
-        bool crimeSeen = false;
+        std::vector<MWWorld::Ptr> witnesses;
         for (std::vector<MWWorld::Ptr>::iterator it = neighbors.begin(); it != neighbors.end(); ++it)
         {
             if (*it == player)
                 continue; // skip player
             if (it->getClass().getCreatureStats(*it).isDead())
                 continue;
+            witnesses.push_back(*it);
+        }
+
+        // Cast the rays to all witnesses at once
+        std::vector<bool> lineOfSight;
+        MWBase::Environment::get().getWorld()->getLOS(player, witnesses, lineOfSight, MWPhysics::RayCategory_Detection);
 
+        // Did anyone see it?
+        bool crimeSeen = false;
+        for (std::vector<MWWorld::Ptr>::iterator it = witnesses.begin(); it != witnesses.end(); ++it)
+        {
             if ((*it == victim && victimAware)
-                    || (MWBase::Environment::get().getWorld()->getLOS(player, *it) && awarenessCheck(player, *it) )
+                    || (lineOfSight[it - witnesses.begin()] && awarenessCheck(player, *it) )
                     // Murder crime can be reported even if no one saw it (hearing is enough, I guess).
                     // TODO: Add mod support for stealth executions!
                     || (type == OT_Murder && *it != victim))
@@ -1580,7 +1589,7 @@ namespace MWMechanics
                 if (!it->getClass().isNpc())
                     continue;
 
-                if (MWBase::Environment::get().getWorld()->getLOS(*it, actor) && awarenessCheck(actor, *it))
+                if (MWBase::Environment::get().getWorld()->getLOS(*it, actor, MWPhysics::RayCategory_Detection) && awarenessCheck(actor, *it))
                     detected = true;
                 if (it->getClass().getCreatureStats(*it).getAiSetting(MWMechanics::CreatureStats::AI_Alarm).getModified() > 0)
                     reported = true;
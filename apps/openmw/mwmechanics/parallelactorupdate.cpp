@@ -0,0 +1,109 @@
+#include "parallelactorupdate.hpp"
+
+#include <typeinfo>
+#include <algorithm>
+
+#include <components/esm/loadnpc.hpp>
+
+#include <components/sceneutil/workqueue.hpp>
+
+#include "../mwworld/class.hpp"
+#include "../mwworld/inventorystore.hpp"
+
+#include "creaturestats.hpp"
+
+namespace
+{
+    // Handing out fewer actors than this to a thread costs more than it saves
+    const size_t minActorsPerBatch = 8;
+
+    class ThinkWorkItem : public SceneUtil::WorkItem
+    {
+    public:
+        ThinkWorkItem(const std::vector<MWWorld::Ptr>& actors, std::vector<MWMechanics::ActorThinkResult>& results,
+                      size_t begin, size_t end)
+            : mActors(actors)
+            , mResults(results)
+            , mBegin(begin)
+            , mEnd(end)
+        {
+        }
+
+        virtual void doWork()
+        {
+            for (size_t i=mBegin; i<mEnd; ++i)
+                MWMechanics::ParallelActorUpdate::think(mActors[i], mResults[i]);
+        }
+
+    private:
+        const std::vector<MWWorld::Ptr>& mActors;
+        std::vector<MWMechanics::ActorThinkResult>& mResults;
+        size_t mBegin;
+        size_t mEnd;
+    };
+}
+
+namespace MWMechanics
+{
+
+    ParallelActorUpdate::ParallelActorUpdate(int numThreads)
+        : mWorkQueue(new SceneUtil::WorkQueue(numThreads))
+        , mNumThreads(numThreads)
+    {
+    }
+
+    ParallelActorUpdate::~ParallelActorUpdate()
+    {
+    }
+
+    void ParallelActorUpdate::think(const std::vector<MWWorld::Ptr>& actors, std::vector<ActorThinkResult>& results)
+    {
+        // Sized up front, the work items write to their own range of the results
+        results.clear();
+        results.resize(actors.size());
+
+        size_t numBatches = std::min(static_cast<size_t>(mNumThreads + 1), actors.size() / minActorsPerBatch);
+        if (numBatches <= 1)
+        {
+            for (size_t i=0; i<actors.size(); ++i)
+                think(actors[i], results[i]);
+            return;
+        }
+
+        size_t batchSize = (actors.size() + numBatches - 1) / numBatches;
+
+        // The main thread takes the first batch itself rather than waiting idly
+        std::vector<osg::ref_ptr<ThinkWorkItem> > items;
+        for (size_t begin = batchSize; begin < actors.size(); begin += batchSize)
+        {
+            osg::ref_ptr<ThinkWorkItem> item = new ThinkWorkItem(actors, results, begin, std::min(begin + batchSize, actors.size()));
+            mWorkQueue->addWorkItem(item, SceneUtil::WorkQueue::Priority_High);
+            items.push_back(item);
+        }
+
+        for (size_t i=0; i<batchSize; ++i)
+            think(actors[i], results[i]);
+
+        for (std::vector<osg::ref_ptr<ThinkWorkItem> >::iterator it = items.begin(); it != items.end(); ++it)
+            (*it)->waitTillDone();
+    }
+
+    void ParallelActorUpdate::think(const MWWorld::Ptr& actor, ActorThinkResult& result)
+    {
+        CreatureStats& creatureStats = actor.getClass().getCreatureStats(actor);
+        result.mValid = !creatureStats.isDead();
+        if (!result.mValid)
+            return;
+
+        result.mMagicEffects = creatureStats.getSpells().getMagicEffects();
+
+        if (actor.getTypeName()==typeid (ESM::NPC).name())
+        {
+            MWWorld::InventoryStore& store = actor.getClass().getInventoryStore (actor);
+            result.mMagicEffects += store.getMagicEffects();
+        }
+
+        result.mMagicEffects += creatureStats.getActiveSpells().getMagicEffects();
+    }
+
+}
@@ -0,0 +1,64 @@
+#ifndef GAME_MWMECHANICS_PARALLELACTORUPDATE_H
+#define GAME_MWMECHANICS_PARALLELACTORUPDATE_H
+
+#include <vector>
+
+#include <osg/ref_ptr>
+
+#include "magiceffects.hpp"
+
+namespace MWWorld
+{
+    class Ptr;
+}
+
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
+namespace MWMechanics
+{
+    /// Result of the think phase for one actor, applied in the commit phase of Actors::update.
+    struct ActorThinkResult
+    {
+        bool mValid; ///< False if the actor was dead, in which case there is nothing to apply.
+
+        MagicEffects mMagicEffects; ///< Combined effects of the actor's spells, equipment and active spells.
+
+        ActorThinkResult() : mValid(false) {}
+    };
+
+    /// @brief Runs the think phase of the actor update, the part that only depends on the actor itself, for several
+    /// actors at once on a pool of worker threads.
+    /// @par Thread safety
+    /// The main thread waits while the think phase is running, and nothing else may modify the actors in the meantime.
+    /// The think phase of an actor may access its own MWWorld::Ptr, CreatureStats, Spells, ActiveSpells and InventoryStore
+    /// (some of which update cached data when read), and read the ESMStore and the game time. It must not touch other
+    /// actors, use Misc::Rng, the physics system or the scene graph, or call into the World in any way that modifies it.
+    /// @par Everything else happens in the commit phase on the main thread, which visits the actors in
+    /// Actors::PtrActorMap order, so that the result of an update does not depend on the number of threads. The
+    /// results are computed before the commit phase starts, which is equivalent to computing them at each actor's
+    /// turn since nothing in the commit phase changes another actor's spells, equipment or active spells before
+    /// that actor is committed (spells hit their targets later, during the animation update).
+    class ParallelActorUpdate
+    {
+    public:
+        /// @param numThreads Number of worker threads, in addition to the main thread.
+        ParallelActorUpdate(int numThreads);
+        ~ParallelActorUpdate();
+
+        /// Run the think phase for \a actors and wait until it is done.
+        /// @param results Receives one result for each actor, in the same order.
+        void think(const std::vector<MWWorld::Ptr>& actors, std::vector<ActorThinkResult>& results);
+
+        /// Run the think phase for a single actor on the calling thread.
+        static void think(const MWWorld::Ptr& actor, ActorThinkResult& result);
+
+    private:
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+        int mNumThreads;
+    };
+}
+
+#endif
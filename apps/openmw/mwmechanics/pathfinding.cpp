@@ -114,14 +114,16 @@ namespace MWMechanics
         osg::Vec3f _from = from + dir*offsetXY + osg::Z_AXIS * verticalOffset;
 
         // cast up-down ray and find height of hit in world space
-        float h = _from.z() - MWBase::Environment::get().getWorld()->getDistToNearestRayHit(_from, -osg::Z_AXIS, verticalOffset + PATHFIND_Z_REACH + 1);
+        float h = _from.z() - MWBase::Environment::get().getWorld()->getDistToNearestRayHit(_from, -osg::Z_AXIS, verticalOffset + PATHFIND_Z_REACH + 1,
+                                                                                              false, MWPhysics::RayCategory_Pathfinding);
 
         return (std::abs(from.z() - h) <= PATHFIND_Z_REACH);
     }
 
     PathFinder::PathFinder()
         : mPathgrid(NULL),
-          mCell(NULL)
+          mCell(NULL),
+          mRouteCell(NULL)
     {
     }
 
@@ -179,6 +181,24 @@ namespace MWMechanics
             mPathgrid = MWBase::Environment::get().getWorld()->getStore().get<ESM::Pathgrid>().search(*mCell->getCell());
         }
 
+        // The destination is in another exterior cell. Head for the point where
+        // the route leaves this cell, then for the first point in the next cell;
+        // once the actor gets there the path is rebuilt for the next leg.
+        ESM::Pathgrid::Point exitPoint;
+        ESM::Pathgrid::Point entryPoint;
+        if (getRouteExit(startPoint, endPoint, exitPoint, entryPoint))
+        {
+            buildPathInCell(startPoint, exitPoint);
+            mPath.push_back(entryPoint);
+            return;
+        }
+
+        buildPathInCell(startPoint, endPoint);
+    }
+
+    void PathFinder::buildPathInCell(const ESM::Pathgrid::Point &startPoint,
+                                     const ESM::Pathgrid::Point &endPoint)
+    {
         // Refer to AiWander reseach topic on openmw forums for some background.
         // Maybe there is no pathgrid for this cell.  Just go to destination and let
         // physics take care of any blockages.
@@ -200,7 +220,7 @@ namespace MWMechanics
         int startNode = GetClosestPoint(mPathgrid, startPointInLocalCoords);
 
         osg::Vec3f endPointInLocalCoords(converter.toLocalVec3(endPoint));
-        std::pair<int, bool> endNode = getClosestReachablePoint(mPathgrid, cell,
+        std::pair<int, bool> endNode = getClosestReachablePoint(mPathgrid, mCell,
             endPointInLocalCoords,
                 startNode);
 
@@ -228,10 +248,10 @@ namespace MWMechanics
         }
         else
         {
-            mPath = mCell->aStarSearch(startNode, endNode.first);
+            mCell->aStarSearch(startNode, endNode.first, mPath);
 
             // convert supplied path to world coordinates
-            for (std::list<ESM::Pathgrid::Point>::iterator iter(mPath.begin()); iter != mPath.end(); ++iter)
+            for (std::vector<ESM::Pathgrid::Point>::iterator iter(mPath.begin()); iter != mPath.end(); ++iter)
             {
                 converter.toWorld(*iter);
             }
@@ -253,6 +273,75 @@ namespace MWMechanics
             mPath.push_back(endPoint);
     }
 
+    /*
+     * The route through the exterior cells is planned once with PathgridPortals
+     * and followed for as long as the destination stays in the same cell, so
+     * that e.g. followers don't plan again whenever their leader moves.
+     *
+     * Returns false if the destination is in this cell or there is no route,
+     * in which case the path leads straight towards the destination.
+     */
+    bool PathFinder::getRouteExit(const ESM::Pathgrid::Point &startPoint,
+                                  const ESM::Pathgrid::Point &endPoint,
+                                  ESM::Pathgrid::Point &exitPoint,
+                                  ESM::Pathgrid::Point &entryPoint)
+    {
+        const ESM::Cell* cell = mCell->getCell();
+        MWBase::World* world = MWBase::Environment::get().getWorld();
+
+        int endX, endY;
+        world->positionToIndex(static_cast<float>(endPoint.mX), static_cast<float>(endPoint.mY), endX, endY);
+        if (!cell->isExterior() || (endX == cell->getGridX() && endY == cell->getGridY()))
+        {
+            mRoute.clear();
+            mRouteCell = NULL;
+            return false;
+        }
+
+        int routeEndX, routeEndY;
+        world->positionToIndex(static_cast<float>(mRouteEnd.mX), static_cast<float>(mRouteEnd.mY), routeEndX, routeEndY);
+        bool sameEnd = mRouteCell != NULL && routeEndX == endX && routeEndY == endY;
+
+        // the first route point in this cell that is followed by a point in another cell
+        std::vector<PathgridPortals::RoutePoint>::iterator exit = findRouteExit(cell);
+        if (!sameEnd || exit == mRoute.end())
+        {
+            // there was no route when planning from this cell, don't search again
+            if (sameEnd && mRouteCell == mCell)
+                return false;
+
+            mRouteEnd = endPoint;
+            mRouteCell = mCell;
+            if (!world->getPathgridPortals().findRoute(startPoint, endPoint, mRoute))
+                return false;
+
+            exit = findRouteExit(cell);
+            if (exit == mRoute.end())
+                return false;
+        }
+
+        // the points before the exit have been passed already
+        mRoute.erase(mRoute.begin(), exit);
+        exitPoint = mRoute[0].mPosition;
+        entryPoint = mRoute[1].mPosition;
+        return true;
+    }
+
+    std::vector<PathgridPortals::RoutePoint>::iterator PathFinder::findRouteExit(const ESM::Cell* cell)
+    {
+        for (std::vector<PathgridPortals::RoutePoint>::iterator it = mRoute.begin(); it != mRoute.end(); ++it)
+        {
+            std::vector<PathgridPortals::RoutePoint>::iterator next = it + 1;
+            if (next == mRoute.end())
+                break;
+
+            if (it->mCellX == cell->getGridX() && it->mCellY == cell->getGridY()
+                && (next->mCellX != it->mCellX || next->mCellY != it->mCellY))
+                return it;
+        }
+        return mRoute.end();
+    }
+
     float PathFinder::getZAngleToNext(float x, float y) const
     {
         // This should never happen (programmers should have an if statement checking
@@ -288,7 +377,7 @@ namespace MWMechanics
         const ESM::Pathgrid::Point& nextPoint = *mPath.begin();
         if (sqrDistanceIgnoreZ(nextPoint, x, y) < tolerance*tolerance)
         {
-            mPath.pop_front();
+            mPath.erase(mPath.begin());
             if(mPath.empty())
             {
                 return true;
@@ -317,12 +406,12 @@ namespace MWMechanics
             {
                 // if 2nd waypoint of new path == 1st waypoint of old, 
                 // delete 1st waypoint of new path.
-                std::list<ESM::Pathgrid::Point>::iterator iter = ++mPath.begin();
+                std::vector<ESM::Pathgrid::Point>::iterator iter = mPath.begin() + 1;
                 if (iter->mX == oldStart.mX
                     && iter->mY == oldStart.mY
                     && iter->mZ == oldStart.mZ)
                 {
-                    mPath.pop_front();
+                    mPath.erase(mPath.begin());
                 }
             }
         }
@@ -1,12 +1,19 @@
 #ifndef GAME_MWMECHANICS_PATHFINDING_H
 #define GAME_MWMECHANICS_PATHFINDING_H
 
-#include <list>
+#include <vector>
 #include <cassert>
 
 #include <components/esm/defs.hpp>
 #include <components/esm/loadpgrd.hpp>
 
+#include "pathgridportals.hpp"
+
+namespace ESM
+{
+    struct Cell;
+}
+
 namespace MWWorld
 {
     class CellStore;
@@ -74,7 +81,7 @@ namespace MWMechanics
                 return mPath.size();
             }
 
-            const std::list<ESM::Pathgrid::Point>& getPath() const
+            const std::vector<ESM::Pathgrid::Point>& getPath() const
             {
                 return mPath;
             }
@@ -151,10 +158,23 @@ namespace MWMechanics
             }
 
         private:
-            std::list<ESM::Pathgrid::Point> mPath;
+            // contiguous, paths are short enough that dropping the first point
+            // by moving the rest is cheaper than allocating a node per point
+            std::vector<ESM::Pathgrid::Point> mPath;
 
             const ESM::Pathgrid *mPathgrid;
             const MWWorld::CellStore* mCell;
+
+            // remaining route through the exterior cells towards mRouteEnd, planned in mRouteCell
+            std::vector<PathgridPortals::RoutePoint> mRoute;
+            ESM::Pathgrid::Point mRouteEnd;
+            const MWWorld::CellStore* mRouteCell;
+
+            void buildPathInCell(const ESM::Pathgrid::Point &startPoint, const ESM::Pathgrid::Point &endPoint);
+
+            bool getRouteExit(const ESM::Pathgrid::Point &startPoint, const ESM::Pathgrid::Point &endPoint,
+                              ESM::Pathgrid::Point &exitPoint, ESM::Pathgrid::Point &entryPoint);
+            std::vector<PathgridPortals::RoutePoint>::iterator findRouteExit(const ESM::Cell* cell);
     };
 }
 
@@ -1,5 +1,8 @@
 #include "pathgrid.hpp"
 
+#include <algorithm>
+#include <functional>
+
 #include "../mwbase/world.hpp"
 #include "../mwbase/environment.hpp"
 
@@ -57,6 +60,7 @@ namespace MWMechanics
         , mIsGraphConstructed(false)
         , mSCCId(0)
         , mSCCIndex(0)
+        , mSearchGeneration(0)
     {
     }
 
@@ -106,11 +110,18 @@ namespace MWMechanics
 
         mCell = cell->getCell();
         mIsExterior = cell->getCell()->isExterior();
-        mPathgrid = MWBase::Environment::get().getWorld()->getStore().get<ESM::Pathgrid>().search(*cell->getCell());
+        return load(MWBase::Environment::get().getWorld()->getStore().get<ESM::Pathgrid>().search(*cell->getCell()));
+    }
+
+    bool PathgridGraph::load(const ESM::Pathgrid *pathgrid)
+    {
+        if(mIsGraphConstructed)
+            return true;
+
+        mPathgrid = pathgrid;
         if(!mPathgrid)
             return false;
 
-
         mGraph.resize(mPathgrid->mPoints.size());
         for(int i = 0; i < static_cast<int> (mPathgrid->mEdges.size()); i++)
         {
@@ -126,6 +137,13 @@ namespace MWMechanics
             //mGraph[mPathgrid->mEdges[i].mV1].edges.push_back(neighbour);
         }
         buildConnectedPoints();
+
+        // cached paths are only valid for the pathgrid they were built from
+        mSearchNodes.assign(mGraph.size(), SearchNode());
+        mSearchGeneration = 0;
+        mPathCache.clear();
+        mPathCacheOrder.clear();
+
         mIsGraphConstructed = true;
         return true;
     }
@@ -214,114 +232,137 @@ namespace MWMechanics
         return (mGraph[start].componentId == mGraph[end].componentId);
     }
 
+    /*
+     * Returns the path from the cache if this start/goal pair was searched
+     * recently, otherwise runs search() and caches the result.
+     *
+     * The cached paths are in pathgrid point form (i.e. local coordinates
+     * for interior cells) and copied out, so callers are free to convert
+     * their copy to world coordinates.
+     */
+    void PathgridGraph::aStarSearch(const int start, const int goal,
+                                    std::vector<ESM::Pathgrid::Point>& path) const
+    {
+        path.clear();
+        if(!isPointConnected(start, goal))
+            return; // there is no path, return an empty path
+
+        PathKey key(start, goal);
+        std::map<PathKey, PathCacheOrder::iterator>::iterator found = mPathCache.find(key);
+        if(found != mPathCache.end())
+        {
+            // move to the front, it is now the most recently used
+            mPathCacheOrder.splice(mPathCacheOrder.begin(), mPathCacheOrder, found->second);
+            path = found->second->path;
+            return;
+        }
+
+        search(start, goal, path);
+
+        if(mPathCacheOrder.size() >= sPathCacheSize)
+        {
+            mPathCache.erase(mPathCacheOrder.back().key);
+            mPathCacheOrder.pop_back();
+        }
+        mPathCacheOrder.push_front(CachedPath());
+        mPathCacheOrder.front().key = key;
+        mPathCacheOrder.front().path = path;
+        mPathCache[key] = mPathCacheOrder.begin();
+    }
+
     /*
      * NOTE: Based on buildPath2(), please check git history if interested
      *       Should consider using a 3rd party library version (e.g. boost)
      *
      * Find the shortest path to the target goal using a well known algorithm.
      * Uses mGraph which has pre-computed costs for allowed edges.  It is assumed
-     * that mGraph is already constructed.
+     * that mGraph is already constructed and that start and goal are connected.
      *
-     * Should be possible to make this MT safe.
+     * Not MT safe, the search state is kept in mSearchNodes and mOpenSet so
+     * that repeated searches don't allocate.
      *
-     * Returns path which may be empty.  path contains pathgrid points in local
+     * Fills path, which may be empty.  path contains pathgrid points in local
      * cell coordinates (indoors) or world coordinates (external).
      *
      * Input params:
      *   start, goal - pathgrid point indexes (for this cell)
      *
      * Variables:
-     *   openset - point indexes to be traversed, lowest cost at the front
-     *   closedset - point indexes already traversed
-     *   gScore - past accumulated costs vector indexed by point index
-     *   fScore - future estimated costs vector indexed by point index
-     *
-     * TODO: An intersting exercise might be to cache the paths created for a
-     *       start/goal pair.  To cache the results the paths need to be in
-     *       pathgrid points form (currently they are converted to world
-     *       coordinates).  Essentially trading speed w/ memory.
+     *   mOpenSet - (fScore, point index) heap, lowest cost at the front
+     *   mSearchNodes[i].closed - point index already traversed
+     *   mSearchNodes[i].gScore - past accumulated cost for point index i
+     *   mSearchNodes[i].parent - point index we came from
      */
-    std::list<ESM::Pathgrid::Point> PathgridGraph::aStarSearch(const int start,
-                                                               const int goal) const
+    void PathgridGraph::search(const int start, const int goal,
+                               std::vector<ESM::Pathgrid::Point>& path) const
     {
-        std::list<ESM::Pathgrid::Point> path;
-        if(!isPointConnected(start, goal))
+        // a new generation marks every node unvisited
+        if(++mSearchGeneration == 0)
         {
-            return path; // there is no path, return an empty path
+            for(std::vector<SearchNode>::iterator it = mSearchNodes.begin(); it != mSearchNodes.end(); ++it)
+                it->generation = 0;
+            mSearchGeneration = 1;
         }
 
-        int graphSize = static_cast<int> (mGraph.size());
-        std::vector<float> gScore (graphSize, -1);
-        std::vector<float> fScore (graphSize, -1);
-        std::vector<int> graphParent (graphSize, -1);
+        SearchNode& startNode = mSearchNodes[start];
+        startNode.generation = mSearchGeneration;
+        startNode.gScore = 0;
+        startNode.parent = -1;
+        startNode.closed = false;
 
-        // gScore & fScore keep costs for each pathgrid point in mPoints
-        gScore[start] = 0;
-        fScore[start] = costAStar(mPathgrid->mPoints[start], mPathgrid->mPoints[goal]);
-
-        std::list<int> openset;
-        std::list<int> closedset;
-        openset.push_back(start);
+        std::greater<OpenEntry> lowestFirst;
+        mOpenSet.clear();
+        mOpenSet.push_back(OpenEntry(costAStar(mPathgrid->mPoints[start], mPathgrid->mPoints[goal]), start));
 
         int current = -1;
 
-        while(!openset.empty())
+        while(!mOpenSet.empty())
         {
-            current = openset.front(); // front has the lowest cost
-            openset.pop_front();
+            std::pop_heap(mOpenSet.begin(), mOpenSet.end(), lowestFirst);
+            current = mOpenSet.back().second;
+            mOpenSet.pop_back();
+
+            SearchNode& currentNode = mSearchNodes[current];
+            if(currentNode.closed)
+                continue; // obsolete entry, this point was reached by a cheaper path
 
             if(current == goal)
                 break;
 
-            closedset.push_back(current); // remember we've been here
+            currentNode.closed = true; // remember we've been here
 
             // check all edges for the current point index
             for(int j = 0; j < static_cast<int> (mGraph[current].edges.size()); j++)
             {
-                if(std::find(closedset.begin(), closedset.end(), mGraph[current].edges[j].index) ==
-                   closedset.end())
+                int dest = mGraph[current].edges[j].index;
+                SearchNode& destNode = mSearchNodes[dest];
+                bool visited = destNode.generation == mSearchGeneration;
+                if(visited && destNode.closed)
+                    continue; // traversed this edge destination already, try the next edge
+
+                float tentative_g = currentNode.gScore + mGraph[current].edges[j].cost;
+                if(!visited || tentative_g < destNode.gScore)
                 {
-                    // not in closedset - i.e. have not traversed this edge destination
-                    int dest = mGraph[current].edges[j].index;
-                    float tentative_g = gScore[current] + mGraph[current].edges[j].cost;
-                    bool isInOpenSet = std::find(openset.begin(), openset.end(), dest) != openset.end();
-                    if(!isInOpenSet
-                        || tentative_g < gScore[dest])
-                    {
-                        graphParent[dest] = current;
-                        gScore[dest] = tentative_g;
-                        fScore[dest] = tentative_g + costAStar(mPathgrid->mPoints[dest],
-                                                               mPathgrid->mPoints[goal]);
-                        if(!isInOpenSet)
-                        {
-                            // add this edge to openset, lowest cost goes to the front
-                            // TODO: if this causes performance problems a hash table may help
-                            std::list<int>::iterator it = openset.begin();
-                            for(it = openset.begin(); it!= openset.end(); ++it)
-                            {
-                                if(fScore[*it] > fScore[dest])
-                                    break;
-                            }
-                            openset.insert(it, dest);
-                        }
-                    }
-                } // if in closedset, i.e. traversed this edge already, try the next edge
+                    destNode.generation = mSearchGeneration;
+                    destNode.gScore = tentative_g;
+                    destNode.parent = current;
+                    destNode.closed = false;
+
+                    float fScore = tentative_g + costAStar(mPathgrid->mPoints[dest],
+                                                           mPathgrid->mPoints[goal]);
+                    mOpenSet.push_back(OpenEntry(fScore, dest));
+                    std::push_heap(mOpenSet.begin(), mOpenSet.end(), lowestFirst);
+                }
             }
         }
 
         if(current != goal)
-            return path; // for some reason couldn't build a path
+            return; // for some reason couldn't build a path
 
-        // reconstruct path to return, using local coordinates
-        while(graphParent[current] != -1)
-        {
-            path.push_front(mPathgrid->mPoints[current]);
-            current = graphParent[current];
-        }
-
-        // add first node to path explicitly
-        path.push_front(mPathgrid->mPoints[start]);
-        return path;
+        // reconstruct path to return, using local coordinates, start is the
+        // only point without a parent
+        for(; current != -1; current = mSearchNodes[current].parent)
+            path.push_back(mPathgrid->mPoints[current]);
+        std::reverse(path.begin(), path.end());
     }
 }
-
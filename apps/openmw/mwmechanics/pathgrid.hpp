@@ -2,6 +2,8 @@
 #define GAME_MWMECHANICS_PATHGRID_H
 
 #include <list>
+#include <map>
+#include <vector>
 
 #include <components/esm/loadpgrd.hpp>
 
@@ -24,17 +26,27 @@ namespace MWMechanics
 
             bool load(const MWWorld::CellStore *cell);
 
+            // build the graph for a pathgrid whose cell may not be loaded
+            bool load(const ESM::Pathgrid *pathgrid);
+
             // returns true if end point is strongly connected (i.e. reachable
             // from start point) both start and end are pathgrid point indexes
             bool isPointConnected(const int start, const int end) const;
 
             // the input parameters are pathgrid point indexes
-            // the output list is in local (internal cells) or world (external
-            // cells) coordinates
+            // the output path is in local (internal cells) or world (external
+            // cells) coordinates, any previous contents of path are replaced
             //
             // NOTE: if start equals end an empty path is returned
-            std::list<ESM::Pathgrid::Point> aStarSearch(const int start,
-                                                        const int end) const;
+            //
+            // NOTE: not thread safe, the search state and the path cache are
+            //       shared by all searches in this cell
+            void aStarSearch(const int start, const int end,
+                             std::vector<ESM::Pathgrid::Point>& path) const;
+
+            // number of (start, end) results kept per cell
+            static const size_t sPathCacheSize = 32;
+
         private:
 
             const ESM::Cell *mCell;
@@ -74,6 +86,40 @@ namespace MWMechanics
             // methods used to calculate connected components
             void recursiveStrongConnect(int v);
             void buildConnectedPoints();
+
+            // Search state for each pathgrid point, reused across searches.
+            // Entries whose generation differs from mSearchGeneration are stale
+            // and treated as unvisited, so nothing has to be reset between searches.
+            struct SearchNode
+            {
+                unsigned int generation;
+                float gScore;
+                int parent;
+                bool closed;
+            };
+            mutable std::vector<SearchNode> mSearchNodes;
+            mutable unsigned int mSearchGeneration;
+
+            // open set as a binary heap of (fScore, point index), lowest fScore
+            // at the front; entries made obsolete by a cheaper path are skipped
+            // when popped rather than removed
+            typedef std::pair<float, int> OpenEntry;
+            mutable std::vector<OpenEntry> mOpenSet;
+
+            void search(const int start, const int goal,
+                        std::vector<ESM::Pathgrid::Point>& path) const;
+
+            // least recently used paths are dropped first, the front of
+            // mPathCacheOrder is the most recently used
+            typedef std::pair<int, int> PathKey; // start, end
+            struct CachedPath
+            {
+                PathKey key;
+                std::vector<ESM::Pathgrid::Point> path;
+            };
+            typedef std::list<CachedPath> PathCacheOrder;
+            mutable PathCacheOrder mPathCacheOrder;
+            mutable std::map<PathKey, PathCacheOrder::iterator> mPathCache;
     };
 }
 
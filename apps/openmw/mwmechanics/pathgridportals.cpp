@@ -0,0 +1,292 @@
+#include "pathgridportals.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <cfloat>
+#include <cmath>
+
+#include <components/esm/loadland.hpp>
+
+#include "../mwworld/store.hpp"
+
+#include "pathfinding.hpp"
+
+namespace
+{
+    // pathgrid points closer than this to a cell border are portal candidates
+    const int sPortalBorder = 1024;
+
+    // portals in neighbouring cells further apart than this are not linked
+    const float sMaxLinkDistance = 2048.f;
+
+    std::pair<int, int> getCellIndex(const ESM::Pathgrid::Point& pos)
+    {
+        return std::make_pair(static_cast<int>(std::floor(static_cast<float>(pos.mX) / ESM::Land::REAL_SIZE)),
+                              static_cast<int>(std::floor(static_cast<float>(pos.mY) / ESM::Land::REAL_SIZE)));
+    }
+
+    bool isNearBorder(const ESM::Pathgrid::Point& point)
+    {
+        return point.mX < sPortalBorder || point.mX > ESM::Land::REAL_SIZE - sPortalBorder
+            || point.mY < sPortalBorder || point.mY > ESM::Land::REAL_SIZE - sPortalBorder;
+    }
+}
+
+namespace MWMechanics
+{
+    PathgridPortals::PathgridPortals(const MWWorld::Store<ESM::Pathgrid>& pathgrids)
+        : mPathgrids(pathgrids)
+        , mSearchGeneration(0)
+    {
+    }
+
+    const PathgridPortals::Cell& PathgridPortals::loadCell(const CellIndex& index) const
+    {
+        std::map<CellIndex, Cell>::const_iterator found = mCells.find(index);
+        if (found != mCells.end())
+            return found->second;
+
+        Cell& cell = mCells[index];
+        cell.mPathgrid = mPathgrids.search(index.first, index.second);
+        if (!cell.mPathgrid)
+            return cell;
+
+        cell.mGraph.load(cell.mPathgrid);
+
+        for (int i = 0; i < static_cast<int>(cell.mPathgrid->mPoints.size()); ++i)
+        {
+            const ESM::Pathgrid::Point& point = cell.mPathgrid->mPoints[i];
+            if (!isNearBorder(point))
+                continue;
+
+            Portal portal;
+            portal.mCell = index;
+            portal.mPoint = i;
+            portal.mPosition = point;
+            portal.mPosition.mX += index.first * ESM::Land::REAL_SIZE;
+            portal.mPosition.mY += index.second * ESM::Land::REAL_SIZE;
+            cell.mPortals.push_back(static_cast<int>(mPortals.size()));
+            mPortals.push_back(portal);
+        }
+
+        // the pathgrid search takes care of the way in between
+        for (size_t i = 0; i < cell.mPortals.size(); ++i)
+        {
+            for (size_t j = i + 1; j < cell.mPortals.size(); ++j)
+            {
+                if (cell.mGraph.isPointConnected(mPortals[cell.mPortals[i]].mPoint, mPortals[cell.mPortals[j]].mPoint))
+                {
+                    addLink(cell.mPortals[i], cell.mPortals[j]);
+                    addLink(cell.mPortals[j], cell.mPortals[i]);
+                }
+            }
+        }
+
+        // neighbours added later link themselves to this cell
+        for (int x = index.first - 1; x <= index.first + 1; ++x)
+        {
+            for (int y = index.second - 1; y <= index.second + 1; ++y)
+            {
+                std::map<CellIndex, Cell>::const_iterator neighbour = mCells.find(std::make_pair(x, y));
+                if (neighbour == mCells.end() || &neighbour->second == &cell)
+                    continue;
+
+                linkCells(cell, neighbour->second);
+                linkCells(neighbour->second, cell);
+            }
+        }
+
+        return cell;
+    }
+
+    void PathgridPortals::loadNeighbours(const CellIndex& index) const
+    {
+        for (int x = index.first - 1; x <= index.first + 1; ++x)
+            for (int y = index.second - 1; y <= index.second + 1; ++y)
+                loadCell(std::make_pair(x, y));
+    }
+
+    void PathgridPortals::linkCells(const Cell& from, const Cell& to) const
+    {
+        for (std::vector<int>::const_iterator it = from.mPortals.begin(); it != from.mPortals.end(); ++it)
+        {
+            int closest = -1;
+            float closestDistance = sMaxLinkDistance;
+            for (std::vector<int>::const_iterator other = to.mPortals.begin(); other != to.mPortals.end(); ++other)
+            {
+                float dist = distance(mPortals[*it].mPosition, mPortals[*other].mPosition);
+                if (dist <= closestDistance)
+                {
+                    closest = *other;
+                    closestDistance = dist;
+                }
+            }
+
+            if (closest != -1)
+            {
+                addLink(*it, closest);
+                addLink(closest, *it);
+            }
+        }
+    }
+
+    void PathgridPortals::addLink(int from, int to) const
+    {
+        std::vector<Link>& links = mPortals[from].mLinks;
+        for (std::vector<Link>::const_iterator it = links.begin(); it != links.end(); ++it)
+        {
+            if (it->mPortal == to)
+                return;
+        }
+
+        Link link;
+        link.mPortal = to;
+        link.mCost = distance(mPortals[from].mPosition, mPortals[to].mPosition);
+        links.push_back(link);
+    }
+
+    int PathgridPortals::getClosestPoint(const Cell& cell, const CellIndex& index, const ESM::Pathgrid::Point& pos)
+    {
+        if (!cell.mPathgrid || cell.mPathgrid->mPoints.empty())
+            return -1;
+
+        osg::Vec3f localPos(static_cast<float>(pos.mX - index.first * ESM::Land::REAL_SIZE),
+                            static_cast<float>(pos.mY - index.second * ESM::Land::REAL_SIZE),
+                            static_cast<float>(pos.mZ));
+        return PathFinder::GetClosestPoint(cell.mPathgrid, localPos);
+    }
+
+    bool PathgridPortals::isConnected(const Cell& cell, int point, int portalPoint)
+    {
+        return point == -1 || cell.mGraph.isPointConnected(point, portalPoint);
+    }
+
+    /*
+     * A* over the portals. The start position is linked to the portals of its
+     * cell that it can reach, the end position to the portals of its cell that
+     * can reach it; the costs are straight distances, so the straight distance
+     * to the end is an exact lower bound.
+     *
+     * Cells are loaded as the search reaches them, hence the search state is
+     * grown to the number of portals after each load.
+     */
+    bool PathgridPortals::findRoute(const ESM::Pathgrid::Point& start, const ESM::Pathgrid::Point& end,
+                                    std::vector<RoutePoint>& route) const
+    {
+        route.clear();
+
+        const CellIndex startIndex = getCellIndex(start);
+        const CellIndex endIndex = getCellIndex(end);
+        if (startIndex == endIndex)
+            return false;
+
+        loadNeighbours(startIndex);
+        const Cell& startCell = loadCell(startIndex);
+        const Cell& endCell = loadCell(endIndex);
+        const int startPoint = getClosestPoint(startCell, startIndex, start);
+        const int endPoint = getClosestPoint(endCell, endIndex, end);
+
+        // a new generation marks every portal unvisited
+        if (++mSearchGeneration == 0)
+        {
+            for (std::vector<SearchNode>::iterator it = mSearchNodes.begin(); it != mSearchNodes.end(); ++it)
+                it->generation = 0;
+            mSearchGeneration = 1;
+        }
+        mSearchNodes.resize(mPortals.size(), SearchNode());
+
+        std::greater<OpenEntry> lowestFirst;
+        mOpenSet.clear();
+
+        for (std::vector<int>::const_iterator it = startCell.mPortals.begin(); it != startCell.mPortals.end(); ++it)
+        {
+            const Portal& portal = mPortals[*it];
+            if (!isConnected(startCell, startPoint, portal.mPoint))
+                continue;
+
+            SearchNode& node = mSearchNodes[*it];
+            node.generation = mSearchGeneration;
+            node.cost = distance(start, portal.mPosition);
+            node.parent = -1;
+            node.closed = false;
+            mOpenSet.push_back(OpenEntry(node.cost + distance(portal.mPosition, end), *it));
+            std::push_heap(mOpenSet.begin(), mOpenSet.end(), lowestFirst);
+        }
+
+        // -1 in the open set stands for the end position
+        const int goal = -1;
+        int goalParent = -1;
+        float goalCost = FLT_MAX;
+        bool found = false;
+        int expanded = 0;
+
+        while (!mOpenSet.empty() && expanded < sMaxExpandedPortals)
+        {
+            std::pop_heap(mOpenSet.begin(), mOpenSet.end(), lowestFirst);
+            const int current = mOpenSet.back().second;
+            mOpenSet.pop_back();
+
+            if (current == goal)
+            {
+                found = true;
+                break;
+            }
+
+            if (mSearchNodes[current].closed)
+                continue; // obsolete entry, this portal was reached by a cheaper route
+            mSearchNodes[current].closed = true;
+            ++expanded;
+
+            loadNeighbours(mPortals[current].mCell);
+            mSearchNodes.resize(mPortals.size(), SearchNode());
+
+            const Portal& portal = mPortals[current];
+            const SearchNode& currentNode = mSearchNodes[current];
+
+            if (portal.mCell == endIndex && isConnected(endCell, endPoint, portal.mPoint))
+            {
+                float cost = currentNode.cost + distance(portal.mPosition, end);
+                if (cost < goalCost)
+                {
+                    goalCost = cost;
+                    goalParent = current;
+                    mOpenSet.push_back(OpenEntry(cost, goal));
+                    std::push_heap(mOpenSet.begin(), mOpenSet.end(), lowestFirst);
+                }
+            }
+
+            for (std::vector<Link>::const_iterator link = portal.mLinks.begin(); link != portal.mLinks.end(); ++link)
+            {
+                SearchNode& dest = mSearchNodes[link->mPortal];
+                bool visited = dest.generation == mSearchGeneration;
+                if (visited && dest.closed)
+                    continue;
+
+                float cost = currentNode.cost + link->mCost;
+                if (!visited || cost < dest.cost)
+                {
+                    dest.generation = mSearchGeneration;
+                    dest.cost = cost;
+                    dest.parent = current;
+                    dest.closed = false;
+                    mOpenSet.push_back(OpenEntry(cost + distance(mPortals[link->mPortal].mPosition, end), link->mPortal));
+                    std::push_heap(mOpenSet.begin(), mOpenSet.end(), lowestFirst);
+                }
+            }
+        }
+
+        if (!found)
+            return false;
+
+        for (int current = goalParent; current != -1; current = mSearchNodes[current].parent)
+        {
+            RoutePoint point;
+            point.mPosition = mPortals[current].mPosition;
+            point.mCellX = mPortals[current].mCell.first;
+            point.mCellY = mPortals[current].mCell.second;
+            route.push_back(point);
+        }
+        std::reverse(route.begin(), route.end());
+        return true;
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef GAME_MWMECHANICS_PATHGRIDPORTALS_H
+#define GAME_MWMECHANICS_PATHGRIDPORTALS_H
+
+#include <map>
+#include <vector>
+
+#include <components/esm/loadpgrd.hpp>
+
+#include "pathgrid.hpp"
+
+namespace MWWorld
+{
+    template <class T>
+    class Store;
+}
+
+namespace MWMechanics
+{
+    /// @brief Coarse graph over the exterior pathgrids, used to plan routes that cross cell borders.
+    ///
+    /// Exterior pathgrids are not connected to each other. The nodes of this graph ("portals") are the pathgrid
+    /// points near a cell border. A portal is linked to the closest portal of each neighbouring cell, if it is
+    /// close enough, and to the other portals of its own cell that it can reach over the cell's pathgrid. Links
+    /// are weighted with the straight distance, the way between two portals of a cell is found by the local
+    /// PathgridGraph search once the actor is there.
+    ///
+    /// Cells are added to the graph the first time a route search reaches them and are kept until the
+    /// content files change, see MWBase::World::getPathgridPortals.
+    class PathgridPortals
+    {
+        public:
+            PathgridPortals(const MWWorld::Store<ESM::Pathgrid>& pathgrids);
+
+            struct RoutePoint
+            {
+                ESM::Pathgrid::Point mPosition; ///< world coordinates
+                int mCellX;
+                int mCellY;
+            };
+
+            /// Plan a route between two exterior positions in different cells.
+            /// @param route Receives the portals to pass through, in order. Consecutive portals in
+            /// different cells are where the route crosses a border.
+            /// @return false if there is no route (or both positions are in the same cell).
+            bool findRoute(const ESM::Pathgrid::Point& start, const ESM::Pathgrid::Point& end,
+                           std::vector<RoutePoint>& route) const;
+
+            /// Maximum number of portals a route search expands before giving up.
+            static const int sMaxExpandedPortals = 2048;
+
+        private:
+            typedef std::pair<int, int> CellIndex;
+
+            struct Link
+            {
+                int mPortal;
+                float mCost;
+            };
+
+            struct Portal
+            {
+                CellIndex mCell;
+                int mPoint; // pathgrid point index
+                ESM::Pathgrid::Point mPosition; // world coordinates
+                std::vector<Link> mLinks;
+            };
+
+            struct Cell
+            {
+                Cell() : mPathgrid(NULL) {}
+
+                const ESM::Pathgrid* mPathgrid;
+                PathgridGraph mGraph;
+                std::vector<int> mPortals;
+            };
+
+            const MWWorld::Store<ESM::Pathgrid>& mPathgrids;
+
+            // the graph is built lazily, hence mutable
+            mutable std::map<CellIndex, Cell> mCells;
+            mutable std::vector<Portal> mPortals;
+
+            // search state, reused across searches (see PathgridGraph)
+            struct SearchNode
+            {
+                unsigned int generation;
+                float cost;
+                int parent;
+                bool closed;
+            };
+            mutable std::vector<SearchNode> mSearchNodes;
+            mutable unsigned int mSearchGeneration;
+            typedef std::pair<float, int> OpenEntry;
+            mutable std::vector<OpenEntry> mOpenSet;
+
+            const Cell& loadCell(const CellIndex& index) const;
+            void loadNeighbours(const CellIndex& index) const;
+            void linkCells(const Cell& from, const Cell& to) const;
+            void addLink(int from, int to) const;
+
+            // pathgrid point of cell closest to the world position pos, or -1 if the cell has no pathgrid
+            static int getClosestPoint(const Cell& cell, const CellIndex& index, const ESM::Pathgrid::Point& pos);
+            // true if both pathgrid points are in the same connected component, -1 stands for any point
+            static bool isConnected(const Cell& cell, int point, int portalPoint);
+    };
+}
+
+#endif
@@ -1,12 +1,20 @@
 #include "physicssystem.hpp"
 
 #include <stdexcept>
+#include <algorithm>
 
 #include <osg/Group>
+#include <osg/Vec2f>
+#include <osg/Stats>
+#include <osg/Timer>
+
+#include <OpenThreads/Thread>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+#include <OpenThreads/ScopedLock>
 
 #include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
 #include <BulletCollision/CollisionShapes/btConeShape.h>
-#include <BulletCollision/CollisionShapes/btSphereShape.h>
 #include <BulletCollision/CollisionShapes/btStaticPlaneShape.h>
 #include <BulletCollision/CollisionShapes/btCompoundShape.h>
 #include <BulletCollision/CollisionDispatch/btCollisionObject.h>
@@ -16,6 +24,7 @@
 #include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
 
 #include <LinearMath/btQuickprof.h>
+#include <LinearMath/btAabbUtil2.h>
 
 #include <components/nifbullet/bulletnifloader.hpp>
 #include <components/resource/resourcesystem.hpp>
@@ -24,6 +33,9 @@
 #include <components/esm/loadgmst.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
 #include <components/sceneutil/unrefqueue.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+#include <components/settings/settings.hpp>
 
 #include <components/nifosg/particle.hpp> // FindRecIndexVisitor
 
@@ -48,6 +60,7 @@
 #include "actor.hpp"
 #include "convert.hpp"
 #include "trace.h"
+#include "raybatch.hpp"
 
 namespace MWPhysics
 {
@@ -67,10 +80,11 @@ namespace MWPhysics
         return obj->getBroadphaseHandle()->m_collisionFilterGroup == CollisionType_Actor;
     }
 
+    static const float sMaxSlopeCos = std::cos(osg::DegreesToRadians(sMaxSlope));
+
     template <class Vec3>
     static bool isWalkableSlope(const Vec3 &normal)
     {
-        static const float sMaxSlopeCos = std::cos(osg::DegreesToRadians(sMaxSlope));
         return (normal.z() > sMaxSlopeCos);
     }
 
@@ -238,6 +252,30 @@ namespace MWPhysics
 
 
     public:
+        /// The parts of the world used by move(), looked up on the main thread once per frame so that move() does
+        /// not need to call into the World and can be used from worker threads.
+        struct WorldState
+        {
+            float mSwimHeightScale;
+            float mStormWalkMult;
+            bool mInStorm;
+            osg::Vec3f mStormDirection;
+
+            static WorldState get()
+            {
+                const MWBase::World* world = MWBase::Environment::get().getWorld();
+                const MWWorld::Store<ESM::GameSetting>& gmst = world->getStore().get<ESM::GameSetting>();
+
+                WorldState state;
+                state.mSwimHeightScale = gmst.find("fSwimHeightScale")->getFloat();
+                state.mStormWalkMult = gmst.find("fStromWalkMult")->getFloat();
+                state.mInStorm = world->isInStorm();
+                if (state.mInStorm)
+                    state.mStormDirection = world->getStormDirection();
+                return state;
+            }
+        };
+
         static osg::Vec3f traceDown(const MWWorld::Ptr &ptr, const osg::Vec3f& position, Actor* actor, btCollisionWorld* collisionWorld, float maxHeight)
         {
             osg::Vec3f offset = actor->getCollisionObjectPosition() - ptr.getRefData().getPosition().asVec3();
@@ -281,9 +319,13 @@ namespace MWPhysics
             }
         }
 
+        /// @note Only modifies \a physicActor, the movement settings of \a ptr, \a standingCollisionTracker and \a actorsBelow,
+        /// so it is safe to move several actors at once from different threads, as long as the collision world is not modified.
+        /// @param actorsBelow Optional, receives the collision objects of actors that this actor landed on and slid off.
         static osg::Vec3f move(osg::Vec3f position, const MWWorld::Ptr &ptr, Actor* physicActor, const osg::Vec3f &movement, float time,
                                   bool isFlying, float waterlevel, float slowFall, const btCollisionWorld* collisionWorld,
-                               std::map<MWWorld::Ptr, MWWorld::Ptr>& standingCollisionTracker)
+                               std::map<MWWorld::Ptr, MWWorld::Ptr>& standingCollisionTracker, const WorldState& worldState,
+                               std::vector<const btCollisionObject*>* actorsBelow = NULL)
         {
             const ESM::Position& refpos = ptr.getRefData().getPosition();
             // Early-out for totally static creatures
@@ -310,9 +352,7 @@ namespace MWPhysics
             // While this is strictly speaking wrong, it's needed for MW compatibility.
             position.z() += halfExtents.z();
 
-            static const float fSwimHeightScale = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                    .find("fSwimHeightScale")->getFloat();
-            float swimlevel = waterlevel + halfExtents.z() - (physicActor->getRenderingHalfExtents().z() * 2 * fSwimHeightScale);
+            float swimlevel = waterlevel + halfExtents.z() - (physicActor->getRenderingHalfExtents().z() * 2 * worldState.mSwimHeightScale);
 
             ActorTracer tracer;
             osg::Vec3f inertia = physicActor->getInertialForce();
@@ -340,13 +380,11 @@ namespace MWPhysics
             ptr.getClass().getMovementSettings(ptr).mPosition[2] = 0;
 
             // Now that we have the effective movement vector, apply wind forces to it
-            if (MWBase::Environment::get().getWorld()->isInStorm())
+            if (worldState.mInStorm)
             {
-                osg::Vec3f stormDirection = MWBase::Environment::get().getWorld()->getStormDirection();
+                const osg::Vec3f& stormDirection = worldState.mStormDirection;
                 float angleDegrees = osg::RadiansToDegrees(std::acos(stormDirection * velocity / (stormDirection.length() * velocity.length())));
-                static const float fStromWalkMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                        .find("fStromWalkMult")->getFloat();
-                velocity *= 1.f-(fStromWalkMult * (angleDegrees/180.f));
+                velocity *= 1.f-(worldState.mStormWalkMult * (angleDegrees/180.f));
             }
 
             Stepper stepper(collisionWorld, colobj);
@@ -474,6 +512,9 @@ namespace MWPhysics
                     // so that we do not stay suspended in air indefinitely.
                     if (tracer.mFraction < 1.0f && tracer.mHitObject->getBroadphaseHandle()->m_collisionFilterGroup == CollisionType_Actor)
                     {
+                        if (actorsBelow)
+                            actorsBelow->push_back(tracer.mHitObject);
+
                         if (osg::Vec3f(velocity.x(), velocity.y(), 0).length2() < 100.f*100.f)
                         {
                             btVector3 aabbMin, aabbMax;
@@ -511,6 +552,437 @@ namespace MWPhysics
     };
 
 
+    // ---------------------------------------------------------------
+
+    /// Movement of one actor during PhysicsSystem::applyQueuedMovement
+    struct ActorMovement
+    {
+        MWWorld::Ptr mPtr;
+        Actor* mActor;
+        osg::Vec3f mVelocity;
+        float mWaterlevel;
+        float mSlowFall;
+        bool mIsFlying;
+
+        osg::Vec3f mStartPosition;
+        osg::Vec3f mPosition;
+        osg::Vec3f mPreviousPosition; ///< Position before the last step
+        bool mPositionChanged;
+
+        // State of the Actor that is modified by MovementSolver::move, to solve the movement again if needed
+        bool mOnGround;
+        bool mOnSlope;
+        bool mWalkingOnWater;
+        osg::Vec3f mInertialForce;
+
+        // Conservative bounds of the actor's collision shape over the movement, for finding conflicts
+        btVector3 mSweptMin;
+        btVector3 mSweptMax;
+
+        // Actors that this actor stood on during the movement, which depends on where they are
+        std::vector<const btCollisionObject*> mActorsBelow;
+    };
+
+    typedef std::map<MWWorld::Ptr, MWWorld::Ptr> CollisionMap;
+
+    // Handing out fewer actors than this to a thread costs more than it saves
+    static const size_t sMinActorsPerBatch = 4;
+
+    // Fixed time step of the actor movement
+    static const float sPhysicsDt = 1.f/60.0f;
+
+    /// Solve the movement without moving the actor's collision object, so that other actors can be solved at the same time
+    static void solveMovement(ActorMovement& movement, int numSteps, float physicsDt, const btCollisionWorld* collisionWorld,
+                              CollisionMap& standingCollisions, const MovementSolver::WorldState& worldState)
+    {
+        osg::Vec3f position = movement.mStartPosition;
+        for (int i=0; i<numSteps; ++i)
+        {
+            movement.mPreviousPosition = position;
+            position = MovementSolver::move(position, movement.mPtr, movement.mActor, movement.mVelocity, physicsDt,
+                                            movement.mIsFlying, movement.mWaterlevel, movement.mSlowFall, collisionWorld,
+                                            standingCollisions, worldState, &movement.mActorsBelow);
+            if (position != movement.mPreviousPosition)
+                movement.mPositionChanged = true;
+        }
+        movement.mPosition = position;
+    }
+
+    class SolveMovementWorkItem : public SceneUtil::WorkItem
+    {
+    public:
+        SolveMovementWorkItem(std::vector<ActorMovement>& movements, size_t begin, size_t end, int numSteps, float physicsDt,
+                              const btCollisionWorld* collisionWorld, const MovementSolver::WorldState& worldState)
+            : mMovements(movements)
+            , mBegin(begin)
+            , mEnd(end)
+            , mNumSteps(numSteps)
+            , mPhysicsDt(physicsDt)
+            , mCollisionWorld(collisionWorld)
+            , mWorldState(worldState)
+        {
+        }
+
+        virtual void doWork()
+        {
+            for (size_t i=mBegin; i<mEnd; ++i)
+                solveMovement(mMovements[i], mNumSteps, mPhysicsDt, mCollisionWorld, mStandingCollisions, mWorldState);
+        }
+
+        const CollisionMap& getStandingCollisions() const
+        {
+            return mStandingCollisions;
+        }
+
+    private:
+        std::vector<ActorMovement>& mMovements;
+        size_t mBegin;
+        size_t mEnd;
+        int mNumSteps;
+        float mPhysicsDt;
+        const btCollisionWorld* mCollisionWorld;
+        MovementSolver::WorldState mWorldState;
+        CollisionMap mStandingCollisions;
+    };
+
+    static void updateSweptBounds(ActorMovement& movement)
+    {
+        // The shape is moved around its center at half height, while other actors collide with it at the collision object
+        // position, see MovementSolver::move. The bounds cover both and any rotation around the z axis.
+        const osg::Vec3f halfExtents = movement.mActor->getHalfExtents();
+        const osg::Vec3f offset = movement.mActor->getCollisionObjectPosition() - movement.mActor->getPosition();
+        const float radius = osg::Vec2f(halfExtents.x(), halfExtents.y()).length();
+        const btVector3 extents(radius, radius, halfExtents.z());
+
+        const osg::Vec3f centers[4] = {
+            movement.mStartPosition + osg::Vec3f(0, 0, halfExtents.z()), movement.mStartPosition + offset,
+            movement.mPosition + osg::Vec3f(0, 0, halfExtents.z()), movement.mPosition + offset
+        };
+
+        movement.mSweptMin = toBullet(centers[0]);
+        movement.mSweptMax = movement.mSweptMin;
+        for (int i=1; i<4; ++i)
+        {
+            movement.mSweptMin.setMin(toBullet(centers[i]));
+            movement.mSweptMax.setMax(toBullet(centers[i]));
+        }
+        movement.mSweptMin -= extents;
+        movement.mSweptMax += extents;
+    }
+
+    /// Solve the movement and move the actor's collision object after every step
+    static void applyMovement(ActorMovement& movement, int numSteps, float physicsDt, btCollisionWorld* collisionWorld,
+                              CollisionMap& standingCollisions, const MovementSolver::WorldState& worldState)
+    {
+        Actor* physicActor = movement.mActor;
+        osg::Vec3f position = physicActor->getPosition();
+        bool positionChanged = false;
+        for (int i=0; i<numSteps; ++i)
+        {
+            position = MovementSolver::move(position, movement.mPtr, physicActor, movement.mVelocity, physicsDt,
+                                            movement.mIsFlying, movement.mWaterlevel, movement.mSlowFall, collisionWorld,
+                                            standingCollisions, worldState);
+            if (position != physicActor->getPosition())
+                positionChanged = true;
+            physicActor->setPosition(position); // always set even if unchanged to make sure interpolation is correct
+        }
+        if (positionChanged)
+            collisionWorld->updateSingleAabb(physicActor->getCollisionObject());
+    }
+
+    /// Solve the movement of all actors against the collision world as it is, without moving their collision objects.
+    /// @param workQueue Optional, to solve batches of actors in parallel.
+    /// @param solvedCollisions Receives the standing collisions of all actors.
+    static void solveMovements(std::vector<ActorMovement>& movements, int numSteps, float physicsDt,
+                               SceneUtil::WorkQueue* workQueue, int numThreads, const btCollisionWorld* collisionWorld,
+                               CollisionMap& solvedCollisions, const MovementSolver::WorldState& worldState)
+    {
+        size_t numBatches = 1;
+        if (workQueue)
+            numBatches = std::max(static_cast<size_t>(1), std::min(static_cast<size_t>(numThreads + 1), movements.size() / sMinActorsPerBatch));
+
+        if (numBatches == 1)
+        {
+            for (std::vector<ActorMovement>::iterator it = movements.begin(); it != movements.end(); ++it)
+                solveMovement(*it, numSteps, physicsDt, collisionWorld, solvedCollisions, worldState);
+            return;
+        }
+
+        size_t batchSize = (movements.size() + numBatches - 1) / numBatches;
+
+        std::vector<osg::ref_ptr<SolveMovementWorkItem> > items;
+        for (size_t begin = 0; begin < movements.size(); begin += batchSize)
+        {
+            osg::ref_ptr<SolveMovementWorkItem> item = new SolveMovementWorkItem(movements, begin, std::min(begin + batchSize, movements.size()),
+                                                                                 numSteps, physicsDt, collisionWorld, worldState);
+            items.push_back(item);
+        }
+
+        // The calling thread takes the first batch itself rather than waiting idly
+        for (size_t i=1; i<items.size(); ++i)
+            workQueue->addWorkItem(items[i], SceneUtil::WorkQueue::Priority_High);
+        items[0]->doWork();
+        for (size_t i=1; i<items.size(); ++i)
+            items[i]->waitTillDone();
+
+        for (size_t i=0; i<items.size(); ++i)
+        {
+            const CollisionMap& batchCollisions = items[i]->getStandingCollisions();
+            for (CollisionMap::const_iterator it = batchCollisions.begin(); it != batchCollisions.end(); ++it)
+                solvedCollisions[it->first] = it->second;
+        }
+    }
+
+    /// Move the collision objects of actors solved by solveMovements(). The collision world must not have changed since.
+    static void commitMovements(std::vector<ActorMovement>& movements, int numSteps, float physicsDt, btCollisionWorld* collisionWorld,
+                                const CollisionMap& solvedCollisions, CollisionMap& standingCollisions, const MovementSolver::WorldState& worldState)
+    {
+        // Two actors moving through the same space may end up overlapping, since each saw the other at its old position.
+        // Likewise an actor that stood on another actor, which actors can't do and slide off, saw it at its old position.
+        // As when solving them one after another, the earlier actor in the queue keeps its movement and the later one is
+        // solved again, after the others have moved. Actors without collision can't conflict. Other objects can't have
+        // moved since the movement was solved, so actors standing on them keep their movement.
+        std::vector<bool> resolve (movements.size(), false);
+        for (size_t i=0; i<movements.size(); ++i)
+            updateSweptBounds(movements[i]);
+        for (size_t i=0; i<movements.size(); ++i)
+        {
+            const ActorMovement& later = movements[i];
+            if (!later.mActor->getCollisionMode())
+                continue;
+            for (size_t j=0; j<i; ++j)
+            {
+                const ActorMovement& earlier = movements[j];
+                if (!earlier.mPositionChanged || !earlier.mActor->getCollisionMode())
+                    continue;
+                if ((later.mPositionChanged && TestAabbAgainstAabb2(later.mSweptMin, later.mSweptMax, earlier.mSweptMin, earlier.mSweptMax))
+                        || std::find(later.mActorsBelow.begin(), later.mActorsBelow.end(), earlier.mActor->getCollisionObject())
+                           != later.mActorsBelow.end())
+                {
+                    resolve[i] = true;
+                    break;
+                }
+            }
+        }
+
+        for (CollisionMap::const_iterator it = solvedCollisions.begin(); it != solvedCollisions.end(); ++it)
+            standingCollisions[it->first] = it->second;
+
+        for (size_t i=0; i<movements.size(); ++i)
+        {
+            if (resolve[i])
+                continue;
+            ActorMovement& movement = movements[i];
+            // Two steps to leave the previous position where the solver would have left it
+            movement.mActor->setPosition(movement.mPreviousPosition);
+            movement.mActor->setPosition(movement.mPosition);
+            if (movement.mPositionChanged)
+                collisionWorld->updateSingleAabb(movement.mActor->getCollisionObject());
+        }
+
+        for (size_t i=0; i<movements.size(); ++i)
+        {
+            if (!resolve[i])
+                continue;
+            ActorMovement& movement = movements[i];
+            Actor* physicActor = movement.mActor;
+            physicActor->setOnGround(movement.mOnGround);
+            physicActor->setOnSlope(movement.mOnSlope);
+            physicActor->setWalkingOnWater(movement.mWalkingOnWater);
+            physicActor->setInertialForce(movement.mInertialForce);
+            standingCollisions.erase(movement.mPtr);
+            applyMovement(movement, numSteps, physicsDt, collisionWorld, standingCollisions, worldState);
+        }
+    }
+
+    /// Copy the state of the actor that MovementSolver::move modifies, before moving it
+    static void beginMovement(ActorMovement& movement)
+    {
+        const Actor* physicActor = movement.mActor;
+        movement.mStartPosition = physicActor->getPosition();
+        movement.mPosition = movement.mStartPosition;
+        movement.mPreviousPosition = physicActor->getPreviousPosition();
+        movement.mPositionChanged = false;
+        movement.mOnGround = physicActor->getOnGround();
+        movement.mOnSlope = physicActor->getOnSlope();
+        movement.mWalkingOnWater = physicActor->isWalkingOnWater();
+        movement.mInertialForce = physicActor->getInertialForce();
+        movement.mActorsBelow.clear();
+    }
+
+    // The physics thread doesn't fall further behind the main thread than this, the simulation slows down instead
+    static const float sMaxPendingTime = 1.f/3.f;
+
+    /// Steps the actor movement handed to it by the main thread in fixed steps, paced by its own clock rather than by
+    /// the frame rate. The main thread holds mMutex while it updates the world, from PhysicsSystem::lockSimulation to
+    /// PhysicsSystem::unlockSimulation, and this thread holds it while doing a step, so the main thread waits for at
+    /// most one step and never for the simulation to catch up.
+    class PhysicsSystem::SimulationThread : public OpenThreads::Thread
+    {
+    public:
+        SimulationThread(PhysicsSystem* physics)
+            : mPhysics(physics)
+            , mQuitNow(false)
+            , mLocked(true)
+            , mPendingTime(0.f)
+        {
+            // The main thread owns the simulation until it first unlocks it
+            mMutex.lock();
+            start();
+        }
+
+        ~SimulationThread()
+        {
+            mQuitNow = true;
+            if (mLocked)
+                mMutex.unlock();
+            mCondition.broadcast();
+            join();
+        }
+
+        /// Call on the main thread. Returns once the step in progress, if any, is done.
+        void lock()
+        {
+            if (mLocked)
+                return;
+            mMutex.lock();
+            mLocked = true;
+        }
+
+        /// Call on the main thread while locked.
+        /// @param time Time to step, in addition to what is left from before.
+        void unlock(float time)
+        {
+            mPendingTime = std::min(mPendingTime + time, sMaxPendingTime);
+            mLocked = false;
+            mCondition.broadcast();
+            mMutex.unlock();
+        }
+
+        /// The movement to step until it is replaced, may only be used while locked.
+        std::vector<ActorMovement>& getMovements()
+        {
+            return mMovements;
+        }
+
+        /// May only be used while locked.
+        void setWorldState(const MovementSolver::WorldState& worldState)
+        {
+            mWorldState = worldState;
+        }
+
+        /// Drop the movement and the time left to step, may only be used while locked.
+        void clear()
+        {
+            mMovements.clear();
+            mPendingTime = 0.f;
+        }
+
+        virtual void run()
+        {
+            const osg::Timer* timer = osg::Timer::instance();
+            const osg::Timer_t stepTicks = static_cast<osg::Timer_t>(sPhysicsDt / timer->getSecondsPerTick());
+
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            osg::Timer_t nextStep = timer->tick();
+            while (!mQuitNow)
+            {
+                osg::Timer_t now = timer->tick();
+                if (mPendingTime < sPhysicsDt)
+                {
+                    // Nothing to step until the main thread hands over more time
+                    nextStep = now;
+                    mCondition.wait(&mMutex, 100);
+                    continue;
+                }
+                if (now < nextStep)
+                {
+                    mCondition.wait(&mMutex, std::max(1UL, static_cast<unsigned long>(timer->delta_m(now, nextStep))));
+                    continue;
+                }
+
+                // Late steps are done right away to catch up, unless the steps can't keep up at all
+                if (timer->delta_s(nextStep, now) > sMaxPendingTime)
+                    nextStep = now;
+
+                step();
+                mPendingTime -= sPhysicsDt;
+                nextStep += stepTicks;
+
+                // Let the main thread in if it is waiting, before doing the next step
+                mMutex.unlock();
+                OpenThreads::Thread::YieldCurrentThread();
+                mMutex.lock();
+            }
+        }
+
+    private:
+        void step()
+        {
+            // Collision events should be available on every step
+            mPhysics->mStandingCollisions.clear();
+
+            mStepMovements.clear();
+            for (std::vector<ActorMovement>::const_iterator it = mMovements.begin(); it != mMovements.end(); ++it)
+            {
+                ActorMap::iterator foundActor = mPhysics->mActors.find(it->mPtr);
+                if (foundActor == mPhysics->mActors.end()) // actor was removed from the scene since
+                    continue;
+                mStepMovements.push_back(*it);
+                mStepMovements.back().mActor = foundActor->second;
+                beginMovement(mStepMovements.back());
+            }
+
+            btCollisionWorld* collisionWorld = mPhysics->mCollisionWorld;
+            if (mPhysics->mMovementWorkQueue && mStepMovements.size() >= 2 * sMinActorsPerBatch)
+            {
+                CollisionMap solvedCollisions;
+                solveMovements(mStepMovements, 1, sPhysicsDt, mPhysics->mMovementWorkQueue.get(), mPhysics->mNumMovementThreads,
+                               collisionWorld, solvedCollisions, mWorldState);
+                commitMovements(mStepMovements, 1, sPhysicsDt, collisionWorld, solvedCollisions, mPhysics->mStandingCollisions, mWorldState);
+            }
+            else
+            {
+                for (std::vector<ActorMovement>::iterator it = mStepMovements.begin(); it != mStepMovements.end(); ++it)
+                    applyMovement(*it, 1, sPhysicsDt, collisionWorld, mPhysics->mStandingCollisions, mWorldState);
+            }
+
+            const osg::Timer_t now = osg::Timer::instance()->tick();
+            for (std::vector<ActorMovement>::const_iterator it = mStepMovements.begin(); it != mStepMovements.end(); ++it)
+            {
+                ActorTransform& transform = mPhysics->mBackTransforms[it->mPtr];
+                transform.mPreviousPosition = it->mActor->getPreviousPosition();
+                transform.mPosition = it->mActor->getPosition();
+                float heightDiff = transform.mPosition.z() - it->mStartPosition.z();
+                if (heightDiff < 0)
+                    transform.mFallHeight -= heightDiff;
+                transform.mStepTick = now;
+            }
+        }
+
+        PhysicsSystem* mPhysics;
+
+        volatile bool mQuitNow;
+        bool mLocked; ///< Whether the main thread holds mMutex, only used on the main thread
+        OpenThreads::Mutex mMutex;
+        OpenThreads::Condition mCondition;
+
+        float mPendingTime;
+        std::vector<ActorMovement> mMovements;
+        std::vector<ActorMovement> mStepMovements;
+        MovementSolver::WorldState mWorldState;
+
+        SimulationThread(const SimulationThread&);
+        SimulationThread& operator=(const SimulationThread&);
+    };
+
+    PhysicsSystem::ActorTransform::ActorTransform()
+        : mFallHeight(0.f)
+        , mStepTick(0)
+    {
+    }
+
+
     // ---------------------------------------------------------------
 
     class HeightField
@@ -687,6 +1159,9 @@ namespace MWPhysics
         , mResourceSystem(resourceSystem)
         , mDebugDrawEnabled(false)
         , mTimeAccum(0.0f)
+        , mNumMovementThreads(std::max(0, Settings::Manager::getInt("movement threads", "Physics")))
+        , mSimulatedTime(0.f)
+        , mMovementPending(false)
         , mWaterHeight(0)
         , mWaterEnabled(false)
         , mParentNode(parentNode)
@@ -702,10 +1177,20 @@ namespace MWPhysics
         // Don't update AABBs of all objects every frame. Most objects in MW are static, so we don't need this.
         // Should a "static" object ever be moved, we have to update its AABB manually using DynamicsWorld::updateSingleAabb.
         mCollisionWorld->setForceUpdateAllAabbs(false);
+
+        std::fill(mRayCounts, mRayCounts + RayCategory_Count, 0);
+
+        if (mNumMovementThreads > 0)
+            mMovementWorkQueue = new SceneUtil::WorkQueue(mNumMovementThreads);
+
+        if (Settings::Manager::getBool("physics thread", "Physics"))
+            mSimulationThread.reset(new SimulationThread(this));
     }
 
     PhysicsSystem::~PhysicsSystem()
     {
+        mSimulationThread.reset();
+
         mResourceSystem->removeResourceManager(mShapeManager.get());
 
         if (mWaterCollisionObject.get())
@@ -768,6 +1253,23 @@ namespace MWPhysics
         found->second->setSolid(false);
     }
 
+    void PhysicsSystem::resetStats()
+    {
+        std::fill(mRayCounts, mRayCounts + RayCategory_Count, 0);
+    }
+
+    void PhysicsSystem::reportStats(unsigned int frameNumber, osg::Stats *stats) const
+    {
+        static const char* rayNames[RayCategory_Count] = { "Rays Other", "Rays Combat", "Rays Detection", "Rays Wander",
+                                                           "Rays Follow", "Rays Path", "Rays Projectile", "Rays Camera", "Rays Script" };
+
+        if (stats->collectStats("resource"))
+        {
+            for (int i=0; i<RayCategory_Count; ++i)
+                stats->setAttribute(frameNumber, rayNames[i], mRayCounts[i]);
+        }
+    }
+
     bool PhysicsSystem::isOnSolidGround (const MWWorld::Ptr& actor) const
     {
         const Actor* physactor = getActor(actor);
@@ -916,109 +1418,186 @@ namespace MWPhysics
             return (point - toOsg(cb.m_hitPointWorld)).length();
     }
 
-    class ClosestNotMeRayResultCallback : public btCollisionWorld::ClosestRayResultCallback
+    /// Casts part of a batch of rays on a worker thread
+    class CastRaysWorkItem : public SceneUtil::WorkItem
     {
     public:
-        ClosestNotMeRayResultCallback(const btCollisionObject* me, const std::vector<const btCollisionObject*> targets, const btVector3& from, const btVector3& to)
-            : btCollisionWorld::ClosestRayResultCallback(from, to)
-            , mMe(me), mTargets(targets)
+        CastRaysWorkItem(const btCollisionWorld* collisionWorld, std::vector<RayQuery>& queries, size_t begin, size_t end)
+            : mCollisionWorld(collisionWorld)
+            , mQueries(queries)
+            , mBegin(begin)
+            , mEnd(end)
         {
         }
 
-        virtual btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace)
+        virtual void doWork()
         {
-            if (rayResult.m_collisionObject == mMe)
-                return 1.f;
-            if (!mTargets.empty())
-            {
-                if ((std::find(mTargets.begin(), mTargets.end(), rayResult.m_collisionObject) == mTargets.end()))
-                {
-                    PtrHolder* holder = static_cast<PtrHolder*>(rayResult.m_collisionObject->getUserPointer());
-                    if (holder && !holder->getPtr().isEmpty() && holder->getPtr().getClass().isActor())
-                        return 1.f;
-                }
-            }
-            return btCollisionWorld::ClosestRayResultCallback::addSingleResult(rayResult, normalInWorldSpace);
+            castRayBatch(mCollisionWorld, mQueries, mBegin, mEnd);
         }
+
     private:
-        const btCollisionObject* mMe;
-        const std::vector<const btCollisionObject*> mTargets;
+        const btCollisionWorld* mCollisionWorld;
+        std::vector<RayQuery>& mQueries;
+        size_t mBegin;
+        size_t mEnd;
     };
 
-    PhysicsSystem::RayResult PhysicsSystem::castRay(const osg::Vec3f &from, const osg::Vec3f &to, MWWorld::ConstPtr ignore, std::vector<MWWorld::Ptr> targets, int mask, int group) const
+    // Handing out fewer rays than this to a thread costs more than it saves
+    static const size_t sMinRaysPerBatch = 32;
+
+    PhysicsSystem::RayRequest::RayRequest()
+        : mRadius(0.f)
+        , mMask(CollisionType_World|CollisionType_HeightMap|CollisionType_Actor|CollisionType_Door)
+        , mGroup(0xff)
+        , mCategory(RayCategory_Other)
+    {
+    }
+
+    const btCollisionObject* PhysicsSystem::getCollisionObject(const MWWorld::ConstPtr &ptr) const
     {
-        btVector3 btFrom = toBullet(from);
-        btVector3 btTo = toBullet(to);
+        const Actor* actor = getActor(ptr);
+        if (actor)
+            return actor->getCollisionObject();
 
-        const btCollisionObject* me = NULL;
-        std::vector<const btCollisionObject*> targetCollisionObjects;
+        const Object* object = getObject(ptr);
+        if (object)
+            return object->getCollisionObject();
+
+        return NULL;
+    }
+
+    void PhysicsSystem::makeRayQuery(const RayRequest &request, RayQuery &query) const
+    {
+        query.mFrom = toBullet(request.mFrom);
+        query.mTo = toBullet(request.mTo);
+        query.mRadius = request.mRadius;
 
-        if (!ignore.isEmpty())
+        if (!request.mIgnore.isEmpty())
+            query.mIgnore = getCollisionObject(request.mIgnore);
+
+        for (std::vector<MWWorld::Ptr>::const_iterator it = request.mTargets.begin(); it != request.mTargets.end(); ++it)
         {
-            const Actor* actor = getActor(ignore);
+            const Actor* actor = getActor(*it);
             if (actor)
-                me = actor->getCollisionObject();
-            else
-            {
-                const Object* object = getObject(ignore);
-                if (object)
-                    me = object->getCollisionObject();
-            }
+                query.mTargets.push_back(actor->getCollisionObject());
         }
 
-        if (!targets.empty())
+        query.mGroup = request.mGroup;
+        query.mMask = request.mMask;
+
+        ++mRayCounts[request.mCategory];
+    }
+
+    void PhysicsSystem::makeRayResult(const RayQuery &query, RayResult &result)
+    {
+        result.mHit = query.mHit;
+        result.mHitObject = MWWorld::Ptr();
+        if (query.mHit)
         {
-            for (std::vector<MWWorld::Ptr>::const_iterator it = targets.begin(); it != targets.end(); ++it)
+            result.mHitPos = toOsg(query.mHitPos);
+            result.mHitNormal = toOsg(query.mHitNormal);
+            if (PtrHolder* ptrHolder = static_cast<PtrHolder*>(query.mHitObject->getUserPointer()))
+                result.mHitObject = ptrHolder->getPtr();
+        }
+    }
+
+    void PhysicsSystem::castRays(const std::vector<RayRequest> &requests, std::vector<RayResult> &results) const
+    {
+        if (requests.size() == 1)
+        {
+            results.resize(1);
+            results[0] = castRay(requests[0]);
+            return;
+        }
+
+        std::vector<RayQuery> queries (requests.size());
+        for (size_t i=0; i<requests.size(); ++i)
+            makeRayQuery(requests[i], queries[i]);
+
+        size_t numBatches = 1;
+        if (mMovementWorkQueue)
+            numBatches = std::max(static_cast<size_t>(1), std::min(static_cast<size_t>(mNumMovementThreads + 1), queries.size() / sMinRaysPerBatch));
+
+        if (numBatches == 1)
+            castRayBatch(mCollisionWorld, queries, 0, queries.size());
+        else
+        {
+            size_t batchSize = (queries.size() + numBatches - 1) / numBatches;
+
+            // The main thread takes the first batch itself rather than waiting idly
+            std::vector<osg::ref_ptr<CastRaysWorkItem> > items;
+            for (size_t begin = batchSize; begin < queries.size(); begin += batchSize)
             {
-                const Actor* actor = getActor(*it);
-                if (actor)
-                    targetCollisionObjects.push_back(actor->getCollisionObject());
+                osg::ref_ptr<CastRaysWorkItem> item = new CastRaysWorkItem(mCollisionWorld, queries, begin, std::min(begin + batchSize, queries.size()));
+                mMovementWorkQueue->addWorkItem(item, SceneUtil::WorkQueue::Priority_High);
+                items.push_back(item);
             }
+
+            castRayBatch(mCollisionWorld, queries, 0, batchSize);
+
+            for (std::vector<osg::ref_ptr<CastRaysWorkItem> >::iterator it = items.begin(); it != items.end(); ++it)
+                (*it)->waitTillDone();
         }
 
-        ClosestNotMeRayResultCallback resultCallback(me, targetCollisionObjects, btFrom, btTo);
-        resultCallback.m_collisionFilterGroup = group;
-        resultCallback.m_collisionFilterMask = mask;
+        results.resize(queries.size());
+        for (size_t i=0; i<queries.size(); ++i)
+            makeRayResult(queries[i], results[i]);
+    }
 
-        mCollisionWorld->rayTest(btFrom, btTo, resultCallback);
+    PhysicsSystem::RayResult PhysicsSystem::castRay(const RayRequest &request) const
+    {
+        RayQuery query;
+        makeRayQuery(request, query);
+
+        castSingleRay(mCollisionWorld, query);
 
         RayResult result;
-        result.mHit = resultCallback.hasHit();
-        if (resultCallback.hasHit())
-        {
-            result.mHitPos = toOsg(resultCallback.m_hitPointWorld);
-            result.mHitNormal = toOsg(resultCallback.m_hitNormalWorld);
-            if (PtrHolder* ptrHolder = static_cast<PtrHolder*>(resultCallback.m_collisionObject->getUserPointer()))
-                result.mHitObject = ptrHolder->getPtr();
-        }
+        makeRayResult(query, result);
         return result;
     }
 
-    PhysicsSystem::RayResult PhysicsSystem::castSphere(const osg::Vec3f &from, const osg::Vec3f &to, float radius)
+    PhysicsSystem::RayResult PhysicsSystem::castRay(const osg::Vec3f &from, const osg::Vec3f &to, MWWorld::ConstPtr ignore, std::vector<MWWorld::Ptr> targets, int mask, int group, RayCategory category) const
     {
-        btCollisionWorld::ClosestConvexResultCallback callback(toBullet(from), toBullet(to));
-        callback.m_collisionFilterGroup = 0xff;
-        callback.m_collisionFilterMask = CollisionType_World|CollisionType_HeightMap|CollisionType_Door;
-
-        btSphereShape shape(radius);
-        const btQuaternion btrot = btQuaternion::getIdentity();
+        RayRequest request;
+        request.mFrom = from;
+        request.mTo = to;
+        request.mIgnore = ignore;
+        request.mTargets.swap(targets);
+        request.mMask = mask;
+        request.mGroup = group;
+        request.mCategory = category;
+
+        return castRay(request);
+    }
 
-        btTransform from_ (btrot, toBullet(from));
-        btTransform to_ (btrot, toBullet(to));
+    PhysicsSystem::RayResult PhysicsSystem::castSphere(const osg::Vec3f &from, const osg::Vec3f &to, float radius, RayCategory category)
+    {
+        RayRequest request;
+        request.mFrom = from;
+        request.mTo = to;
+        request.mRadius = radius;
+        request.mMask = CollisionType_World|CollisionType_HeightMap|CollisionType_Door;
+        request.mCategory = category;
+
+        return castRay(request);
+    }
 
-        mCollisionWorld->convexSweepTest(&shape, from_, to_, callback);
+    static osg::Vec3f getEyeLevelPosition(const Actor* physactor)
+    {
+        return physactor->getCollisionObjectPosition() + osg::Vec3f(0,0,physactor->getHalfExtents().z() * 0.9);
+    }
 
-        RayResult result;
-        result.mHit = callback.hasHit();
-        if (result.mHit)
-        {
-            result.mHitPos = toOsg(callback.m_hitPointWorld);
-            result.mHitNormal = toOsg(callback.m_hitNormalWorld);
-        }
-        return result;
+    static PhysicsSystem::RayRequest getLineOfSightRequest(const Actor* physactor1, const Actor* physactor2, RayCategory category)
+    {
+        PhysicsSystem::RayRequest request;
+        request.mFrom = getEyeLevelPosition(physactor1);
+        request.mTo = getEyeLevelPosition(physactor2);
+        request.mMask = CollisionType_World|CollisionType_HeightMap|CollisionType_Door;
+        request.mCategory = category;
+        return request;
     }
 
-    bool PhysicsSystem::getLineOfSight(const MWWorld::ConstPtr &actor1, const MWWorld::ConstPtr &actor2) const
+    bool PhysicsSystem::getLineOfSight(const MWWorld::ConstPtr &actor1, const MWWorld::ConstPtr &actor2, RayCategory category) const
     {
         const Actor* physactor1 = getActor(actor1);
         const Actor* physactor2 = getActor(actor2);
@@ -1026,12 +1605,36 @@ namespace MWPhysics
         if (!physactor1 || !physactor2)
             return false;
 
-        osg::Vec3f pos1 (physactor1->getCollisionObjectPosition() + osg::Vec3f(0,0,physactor1->getHalfExtents().z() * 0.9)); // eye level
-        osg::Vec3f pos2 (physactor2->getCollisionObjectPosition() + osg::Vec3f(0,0,physactor2->getHalfExtents().z() * 0.9));
+        return !castRay(getLineOfSightRequest(physactor1, physactor2, category)).mHit;
+    }
+
+    void PhysicsSystem::getLineOfSight(const MWWorld::ConstPtr &actor, const std::vector<MWWorld::Ptr> &targets, std::vector<bool> &out,
+                                       RayCategory category) const
+    {
+        out.assign(targets.size(), false);
+
+        const Actor* physactor1 = getActor(actor);
+        if (!physactor1)
+            return;
+
+        std::vector<RayRequest> requests;
+        std::vector<size_t> indices;
+        requests.reserve(targets.size());
+        for (size_t i=0; i<targets.size(); ++i)
+        {
+            const Actor* physactor2 = getActor(targets[i]);
+            if (!physactor2)
+                continue;
+
+            requests.push_back(getLineOfSightRequest(physactor1, physactor2, category));
+            indices.push_back(i);
+        }
 
-        RayResult result = castRay(pos1, pos2, MWWorld::ConstPtr(), std::vector<MWWorld::Ptr>(), CollisionType_World|CollisionType_HeightMap|CollisionType_Door);
+        std::vector<RayResult> results;
+        castRays(requests, results);
 
-        return !result.mHit;
+        for (size_t i=0; i<results.size(); ++i)
+            out[indices[i]] = !results[i].mHit;
     }
 
     bool PhysicsSystem::isOnGround(const MWWorld::Ptr &actor)
@@ -1190,6 +1793,9 @@ namespace MWPhysics
         {
             delete foundActor->second;
             mActors.erase(foundActor);
+
+            mBackTransforms.erase(ptr);
+            mFrontTransforms.erase(ptr);
         }
     }
 
@@ -1230,6 +1836,29 @@ namespace MWPhysics
         }
 
         updateCollisionMapPtr(mStandingCollisions, old, updated);
+
+        updateTransformMapPtr(mBackTransforms, old, updated);
+        updateTransformMapPtr(mFrontTransforms, old, updated);
+
+        if (mSimulationThread.get())
+        {
+            std::vector<ActorMovement>& movements = mSimulationThread->getMovements();
+            for (std::vector<ActorMovement>::iterator it = movements.begin(); it != movements.end(); ++it)
+            {
+                if (it->mPtr == old)
+                    it->mPtr = updated;
+            }
+        }
+    }
+
+    void PhysicsSystem::updateTransformMapPtr(ActorTransformMap& map, const MWWorld::Ptr &old, const MWWorld::Ptr &updated)
+    {
+        ActorTransformMap::iterator found = map.find(old);
+        if (found != map.end())
+        {
+            map[updated] = found->second;
+            map.erase(found);
+        }
     }
 
     Actor *PhysicsSystem::getActor(const MWWorld::Ptr &ptr)
@@ -1310,6 +1939,10 @@ namespace MWPhysics
         {
             foundActor->second->updatePosition();
             mCollisionWorld->updateSingleAabb(foundActor->second->getCollisionObject());
+
+            // Don't interpolate the actor back to where the physics thread had it
+            mBackTransforms.erase(ptr);
+            mFrontTransforms.erase(ptr);
             return;
         }
     }
@@ -1357,28 +1990,21 @@ namespace MWPhysics
     {
         mMovementQueue.clear();
         mStandingCollisions.clear();
+
+        mSimulatedTime = 0.f;
+        mMovementPending = false;
+        mBackTransforms.clear();
+        mFrontTransforms.clear();
+        if (mSimulationThread.get())
+            mSimulationThread->clear();
     }
 
-    const PtrVelocityList& PhysicsSystem::applyQueuedMovement(float dt)
+    void PhysicsSystem::prepareMovements(std::vector<ActorMovement>& movements)
     {
-        mMovementResults.clear();
-
-        mTimeAccum += dt;
-        const float physicsDt = 1.f/60.0f;
-
-        const int maxAllowedSteps = 20;
-        int numSteps = mTimeAccum / (physicsDt);
-        numSteps = std::min(numSteps, maxAllowedSteps);
-
-        mTimeAccum -= numSteps * physicsDt;
+        const MWBase::World *world = MWBase::Environment::get().getWorld();
 
-        if (numSteps)
-        {
-            // Collision events should be available on every frame
-            mStandingCollisions.clear();
-        }
+        movements.reserve(mMovementQueue.size());
 
-        const MWBase::World *world = MWBase::Environment::get().getWorld();
         PtrVelocityList::iterator iter = mMovementQueue.begin();
         for(;iter != mMovementQueue.end();++iter)
         {
@@ -1408,40 +2034,143 @@ namespace MWPhysics
             }
             physicActor->setCanWaterWalk(waterCollision);
 
+            ActorMovement movement;
+            movement.mPtr = physicActor->getPtr();
+            movement.mActor = physicActor;
+            movement.mVelocity = iter->second;
+            movement.mWaterlevel = waterlevel;
             // Slow fall reduces fall speed by a factor of (effect magnitude / 200)
-            float slowFall = 1.f - std::max(0.f, std::min(1.f, effects.get(ESM::MagicEffect::SlowFall).getMagnitude() * 0.005f));
+            movement.mSlowFall = 1.f - std::max(0.f, std::min(1.f, effects.get(ESM::MagicEffect::SlowFall).getMagnitude() * 0.005f));
+            movement.mIsFlying = world->isFlying(iter->first);
+            beginMovement(movement);
+            movements.push_back(movement);
+        }
+
+        mMovementQueue.clear();
+    }
+
+    static osg::Vec3f interpolatePosition(const Actor* physicActor, float interpolationFactor)
+    {
+        return physicActor->getPosition() * interpolationFactor + physicActor->getPreviousPosition() * (1.f - interpolationFactor);
+    }
+
+    const PtrVelocityList& PhysicsSystem::applyQueuedMovement(float dt)
+    {
+        mMovementResults.clear();
 
-            osg::Vec3f position = physicActor->getPosition();
-            float oldHeight = position.z();
-            bool positionChanged = false;
-            for (int i=0; i<numSteps; ++i)
+        if (mSimulationThread.get())
+        {
+            // The queued movement is handed to the physics thread by unlockSimulation, which steps it on its own clock.
+            // Meanwhile show the positions it published, interpolated between its last two steps as time goes by.
+            mSimulatedTime += dt;
+            mMovementPending = true;
+
+            const osg::Timer* timer = osg::Timer::instance();
+            const osg::Timer_t now = timer->tick();
+            for (ActorTransformMap::iterator it = mFrontTransforms.begin(); it != mFrontTransforms.end();)
             {
-                position = MovementSolver::move(position, physicActor->getPtr(), physicActor, iter->second, physicsDt,
-                                                world->isFlying(iter->first),
-                                                waterlevel, slowFall, mCollisionWorld, mStandingCollisions);
-                if (position != physicActor->getPosition())
-                    positionChanged = true;
-                physicActor->setPosition(position); // always set even if unchanged to make sure interpolation is correct
+                const ActorTransform& transform = it->second;
+                float factor = std::min(1.f, static_cast<float>(timer->delta_s(transform.mStepTick, now)) / sPhysicsDt);
+                mMovementResults.push_back(std::make_pair(it->first,
+                    transform.mPosition * factor + transform.mPreviousPosition * (1.f - factor)));
+
+                // Once there, the actor stays until the physics thread moves it again
+                if (factor >= 1.f)
+                    mFrontTransforms.erase(it++);
+                else
+                    ++it;
             }
-            if (positionChanged)
-                mCollisionWorld->updateSingleAabb(physicActor->getCollisionObject());
 
-            float interpolationFactor = mTimeAccum / physicsDt;
-            osg::Vec3f interpolated = position * interpolationFactor + physicActor->getPreviousPosition() * (1.f - interpolationFactor);
+            return mMovementResults;
+        }
 
-            float heightDiff = position.z() - oldHeight;
+        mTimeAccum += dt;
 
-            if (heightDiff < 0)
-                iter->first.getClass().getCreatureStats(iter->first).addToFallHeight(-heightDiff);
+        const int maxAllowedSteps = 20;
+        int numSteps = mTimeAccum / (sPhysicsDt);
+        numSteps = std::min(numSteps, maxAllowedSteps);
 
-            mMovementResults.push_back(std::make_pair(iter->first, interpolated));
+        mTimeAccum -= numSteps * sPhysicsDt;
+
+        if (numSteps)
+        {
+            // Collision events should be available on every frame
+            mStandingCollisions.clear();
         }
 
-        mMovementQueue.clear();
+        const MovementSolver::WorldState worldState = MovementSolver::WorldState::get();
+
+        std::vector<ActorMovement> movements;
+        prepareMovements(movements);
+
+        if (numSteps && mMovementWorkQueue && movements.size() >= 2 * sMinActorsPerBatch)
+        {
+            // Solve all actors against the collision world as it was at the start of the frame
+            CollisionMap solvedCollisions;
+            solveMovements(movements, numSteps, sPhysicsDt, mMovementWorkQueue.get(), mNumMovementThreads,
+                           mCollisionWorld, solvedCollisions, worldState);
+            commitMovements(movements, numSteps, sPhysicsDt, mCollisionWorld, solvedCollisions, mStandingCollisions, worldState);
+        }
+        else
+        {
+            for (std::vector<ActorMovement>::iterator it = movements.begin(); it != movements.end(); ++it)
+                applyMovement(*it, numSteps, sPhysicsDt, mCollisionWorld, mStandingCollisions, worldState);
+        }
+
+        for (std::vector<ActorMovement>::iterator it = movements.begin(); it != movements.end(); ++it)
+        {
+            float heightDiff = it->mActor->getPosition().z() - it->mStartPosition.z();
+
+            if (heightDiff < 0)
+                it->mPtr.getClass().getCreatureStats(it->mPtr).addToFallHeight(-heightDiff);
+
+            mMovementResults.push_back(std::make_pair(it->mPtr, interpolatePosition(it->mActor, mTimeAccum / sPhysicsDt)));
+        }
 
         return mMovementResults;
     }
 
+    void PhysicsSystem::unlockSimulation()
+    {
+        if (!mSimulationThread.get())
+            return;
+
+        float time = 0.f;
+        if (mMovementPending)
+        {
+            std::vector<ActorMovement>& movements = mSimulationThread->getMovements();
+            movements.clear();
+            prepareMovements(movements);
+            mSimulationThread->setWorldState(MovementSolver::WorldState::get());
+
+            time = mSimulatedTime;
+            mSimulatedTime = 0.f;
+            mMovementPending = false;
+        }
+
+        mSimulationThread->unlock(time);
+    }
+
+    void PhysicsSystem::lockSimulation()
+    {
+        if (!mSimulationThread.get())
+            return;
+
+        mSimulationThread->lock();
+
+        // Take over what the physics thread published since the last time
+        for (ActorTransformMap::iterator it = mBackTransforms.begin(); it != mBackTransforms.end(); ++it)
+        {
+            if (it->second.mFallHeight > 0)
+                it->first.getClass().getCreatureStats(it->first).addToFallHeight(it->second.mFallHeight);
+
+            ActorTransform& transform = mFrontTransforms[it->first];
+            transform = it->second;
+            transform.mFallHeight = 0.f;
+        }
+        mBackTransforms.clear();
+    }
+
     void PhysicsSystem::stepSimulation(float dt)
     {
         for (std::set<Object*>::iterator it = mAnimatedObjects.begin(); it != mAnimatedObjects.end(); ++it)
@@ -4,18 +4,22 @@
 #include <memory>
 #include <map>
 #include <set>
+#include <vector>
 
 #include <osg/Quat>
+#include <osg/Timer>
 #include <osg/ref_ptr>
 
 #include "../mwworld/ptr.hpp"
 
 #include "collisiontype.hpp"
+#include "raycategory.hpp"
 
 namespace osg
 {
     class Group;
     class Object;
+    class Stats;
 }
 
 namespace MWRender
@@ -32,6 +36,7 @@ namespace Resource
 namespace SceneUtil
 {
     class UnrefQueue;
+    class WorkQueue;
 }
 
 class btCollisionWorld;
@@ -48,6 +53,8 @@ namespace MWPhysics
     class HeightField;
     class Object;
     class Actor;
+    struct ActorMovement;
+    struct RayQuery;
 
     class PhysicsSystem
     {
@@ -116,12 +123,41 @@ namespace MWPhysics
             /// @param me Optional, a Ptr to ignore in the list of results. targets are actors to filter for, ignoring all other actors.
             RayResult castRay(const osg::Vec3f &from, const osg::Vec3f &to, MWWorld::ConstPtr ignore = MWWorld::ConstPtr(),
                     std::vector<MWWorld::Ptr> targets = std::vector<MWWorld::Ptr>(),
-                    int mask = CollisionType_World|CollisionType_HeightMap|CollisionType_Actor|CollisionType_Door, int group=0xff) const;
+                    int mask = CollisionType_World|CollisionType_HeightMap|CollisionType_Actor|CollisionType_Door, int group=0xff,
+                    RayCategory category = RayCategory_Other) const;
 
-            RayResult castSphere(const osg::Vec3f& from, const osg::Vec3f& to, float radius);
+            RayResult castSphere(const osg::Vec3f& from, const osg::Vec3f& to, float radius, RayCategory category = RayCategory_Other);
+
+            /// A ray or sphere sweep to be cast by castRays.
+            struct RayRequest
+            {
+                osg::Vec3f mFrom;
+                osg::Vec3f mTo;
+                float mRadius; ///< Radius of the sphere to sweep, 0 to cast a ray.
+                MWWorld::ConstPtr mIgnore; ///< Optional, a Ptr to ignore in the list of results.
+                std::vector<MWWorld::Ptr> mTargets; ///< Actors to filter for, ignoring all other actors.
+                int mMask;
+                int mGroup;
+                RayCategory mCategory;
+
+                RayRequest();
+            };
+
+            /// Cast several rays and sphere sweeps at once. The closest hit of each is found in a single walk of the
+            /// broadphase, and large batches are split among the movement threads, if there are any.
+            /// @param results Receives one result per request, in the same order.
+            void castRays(const std::vector<RayRequest>& requests, std::vector<RayResult>& results) const;
+
+            /// Cast a single ray or sphere sweep through the collision world, without setting up a batch.
+            RayResult castRay(const RayRequest& request) const;
 
             /// Return true if actor1 can see actor2.
-            bool getLineOfSight(const MWWorld::ConstPtr& actor1, const MWWorld::ConstPtr& actor2) const;
+            bool getLineOfSight(const MWWorld::ConstPtr& actor1, const MWWorld::ConstPtr& actor2, RayCategory category = RayCategory_Other) const;
+
+            /// Check the line of sight from \a actor to each of \a targets with a single batch of rays.
+            /// @param out Receives whether \a actor can see each of \a targets, in the same order.
+            void getLineOfSight(const MWWorld::ConstPtr& actor, const std::vector<MWWorld::Ptr>& targets, std::vector<bool>& out,
+                                RayCategory category = RayCategory_Other) const;
 
             bool isOnGround (const MWWorld::Ptr& actor);
 
@@ -142,8 +178,19 @@ namespace MWPhysics
             void queueObjectMovement(const MWWorld::Ptr &ptr, const osg::Vec3f &velocity);
 
             /// Apply all queued movements, then clear the list.
+            /// @note If the physics thread is enabled, the queued movement is only handed to the thread by
+            /// unlockSimulation, and the results returned are the positions last published by the thread,
+            /// interpolated between its last two steps.
             const PtrVelocityList& applyQueuedMovement(float dt);
 
+            /// Let the physics thread, if enabled, step the movement queued in the last call to applyQueuedMovement.
+            /// Until lockSimulation is called, nothing else may use the physics system or modify the actors.
+            void unlockSimulation();
+
+            /// Wait for the step the physics thread is running, if any, and take over the results it has
+            /// published since the last call. Does nothing if the simulation is already locked.
+            void lockSimulation();
+
             /// Clear the queued movements list without applying.
             void clearQueuedMovement();
 
@@ -170,10 +217,23 @@ namespace MWPhysics
 
             bool isOnSolidGround (const MWWorld::Ptr& actor) const;
 
+            /// Start counting the rays cast in a new frame.
+            void resetStats();
+
+            /// Report the number of rays cast in each RayCategory since the last call to resetStats.
+            void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
+
         private:
 
             void updateWater();
 
+            void makeRayQuery(const RayRequest& request, RayQuery& query) const;
+            static void makeRayResult(const RayQuery& query, RayResult& result);
+
+            void prepareMovements(std::vector<ActorMovement>& movements);
+
+            const btCollisionObject* getCollisionObject(const MWWorld::ConstPtr& ptr) const;
+
             osg::ref_ptr<SceneUtil::UnrefQueue> mUnrefQueue;
 
             btBroadphaseInterface* mBroadphase;
@@ -210,6 +270,40 @@ namespace MWPhysics
 
             float mTimeAccum;
 
+            mutable unsigned int mRayCounts[RayCategory_Count];
+
+            // Worker threads for solving actor movement, null if all actors are solved on the main thread
+            osg::ref_ptr<SceneUtil::WorkQueue> mMovementWorkQueue;
+            int mNumMovementThreads;
+
+            /// Positions of an actor after the last two steps of the physics thread
+            struct ActorTransform
+            {
+                osg::Vec3f mPreviousPosition;
+                osg::Vec3f mPosition;
+                float mFallHeight; ///< Height fallen since the positions were last taken over by the main thread
+                osg::Timer_t mStepTick; ///< When the last step was done
+
+                ActorTransform();
+            };
+            typedef std::map<MWWorld::Ptr, ActorTransform> ActorTransformMap;
+
+            void updateTransformMapPtr(ActorTransformMap& map, const MWWorld::Ptr &old, const MWWorld::Ptr &updated);
+
+            class SimulationThread;
+            friend class SimulationThread;
+
+            // Steps the actor movement on its own fixed clock, null if the movement is solved in applyQueuedMovement
+            std::auto_ptr<SimulationThread> mSimulationThread;
+
+            float mSimulatedTime; ///< Time passed since the queued movement was last handed to the physics thread
+            bool mMovementPending;
+
+            // Written by the physics thread after each step, taken over by lockSimulation
+            ActorTransformMap mBackTransforms;
+            // Read by applyQueuedMovement on the main thread, until the interpolation reaches the last step
+            ActorTransformMap mFrontTransforms;
+
             float mWaterHeight;
             float mWaterEnabled;
 
@@ -0,0 +1,292 @@
+#include "raybatch.hpp"
+
+#include <algorithm>
+
+#include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+#include <BulletCollision/CollisionShapes/btSphereShape.h>
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <LinearMath/btAabbUtil2.h>
+
+#include "../mwworld/class.hpp"
+
+#include "actor.hpp"
+
+namespace
+{
+    using MWPhysics::RayQuery;
+
+    bool isIgnored(const btCollisionObject* object, const RayQuery& query)
+    {
+        if (object == query.mIgnore)
+            return true;
+        if (!query.mTargets.empty())
+        {
+            if ((std::find(query.mTargets.begin(), query.mTargets.end(), object) == query.mTargets.end()))
+            {
+                MWPhysics::PtrHolder* holder = static_cast<MWPhysics::PtrHolder*>(object->getUserPointer());
+                if (holder && !holder->getPtr().isEmpty() && holder->getPtr().getClass().isActor())
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    class RayCallback : public btCollisionWorld::ClosestRayResultCallback
+    {
+    public:
+        RayCallback(const RayQuery& query)
+            : btCollisionWorld::ClosestRayResultCallback(query.mFrom, query.mTo)
+            , mQuery(query)
+        {
+            m_collisionFilterGroup = query.mGroup;
+            m_collisionFilterMask = query.mMask;
+        }
+
+        virtual btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace)
+        {
+            if (isIgnored(rayResult.m_collisionObject, mQuery))
+                return 1.f;
+            return btCollisionWorld::ClosestRayResultCallback::addSingleResult(rayResult, normalInWorldSpace);
+        }
+
+    private:
+        const RayQuery& mQuery;
+    };
+
+    class SweepCallback : public btCollisionWorld::ClosestConvexResultCallback
+    {
+    public:
+        SweepCallback(const RayQuery& query)
+            : btCollisionWorld::ClosestConvexResultCallback(query.mFrom, query.mTo)
+            , mQuery(query)
+        {
+            m_collisionFilterGroup = query.mGroup;
+            m_collisionFilterMask = query.mMask;
+        }
+
+        virtual btScalar addSingleResult(btCollisionWorld::LocalConvexResult& convexResult, bool normalInWorldSpace)
+        {
+            if (isIgnored(convexResult.m_hitCollisionObject, mQuery))
+                return 1.f;
+            return btCollisionWorld::ClosestConvexResultCallback::addSingleResult(convexResult, normalInWorldSpace);
+        }
+
+    private:
+        const RayQuery& mQuery;
+    };
+
+    /// A query while the batch is being cast
+    class QueryState
+    {
+    public:
+        BT_DECLARE_ALIGNED_ALLOCATOR();
+
+        QueryState(RayQuery& query)
+            : mQuery(query)
+            , mShape(std::max(query.mRadius, btScalar(0)))
+            , mRayCallback(query)
+            , mSweepCallback(query)
+        {
+            const btVector3 direction = query.mTo - query.mFrom;
+            for (int i=0; i<3; ++i)
+            {
+                mInvDirection[i] = direction[i] == btScalar(0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1) / direction[i];
+                mSigns[i] = mInvDirection[i] < btScalar(0);
+            }
+
+            mFromTransform.setIdentity();
+            mFromTransform.setOrigin(query.mFrom);
+            mToTransform.setIdentity();
+            mToTransform.setOrigin(query.mTo);
+        }
+
+        bool isSweep() const
+        {
+            return mQuery.mRadius > 0;
+        }
+
+        btScalar getClosestHitFraction() const
+        {
+            return isSweep() ? mSweepCallback.m_closestHitFraction : mRayCallback.m_closestHitFraction;
+        }
+
+        /// Could the query hit anything within \a volume that is closer than its closest hit so far?
+        bool intersects(const btDbvtVolume& volume) const
+        {
+            const btVector3 radius(mQuery.mRadius, mQuery.mRadius, mQuery.mRadius);
+            const btVector3 bounds[2] = { volume.Mins() - radius, volume.Maxs() + radius };
+            btScalar tmin;
+            return btRayAabb2(mQuery.mFrom, mInvDirection, mSigns, bounds, tmin, 0, getClosestHitFraction());
+        }
+
+        void test(btCollisionObject* object, btScalar allowedPenetration)
+        {
+            if (isSweep())
+            {
+                if (mSweepCallback.needsCollision(object->getBroadphaseHandle()))
+                    btCollisionWorld::objectQuerySingle(&mShape, mFromTransform, mToTransform, object, object->getCollisionShape(),
+                                                        object->getWorldTransform(), mSweepCallback, allowedPenetration);
+            }
+            else
+            {
+                if (mRayCallback.needsCollision(object->getBroadphaseHandle()))
+                    btCollisionWorld::rayTestSingle(mFromTransform, mToTransform, object, object->getCollisionShape(),
+                                                    object->getWorldTransform(), mRayCallback);
+            }
+        }
+
+        /// Cast through the world's own interface, for broadphases we can't walk
+        void cast(const btCollisionWorld* world)
+        {
+            if (isSweep())
+                world->convexSweepTest(&mShape, mFromTransform, mToTransform, mSweepCallback);
+            else
+                world->rayTest(mQuery.mFrom, mQuery.mTo, mRayCallback);
+        }
+
+        void storeResult()
+        {
+            if (isSweep())
+            {
+                mQuery.mHit = mSweepCallback.hasHit();
+                if (mQuery.mHit)
+                {
+                    mQuery.mHitPos = mSweepCallback.m_hitPointWorld;
+                    mQuery.mHitNormal = mSweepCallback.m_hitNormalWorld;
+                    mQuery.mHitObject = mSweepCallback.m_hitCollisionObject;
+                }
+            }
+            else
+            {
+                mQuery.mHit = mRayCallback.hasHit();
+                if (mQuery.mHit)
+                {
+                    mQuery.mHitPos = mRayCallback.m_hitPointWorld;
+                    mQuery.mHitNormal = mRayCallback.m_hitNormalWorld;
+                    mQuery.mHitObject = mRayCallback.m_collisionObject;
+                }
+            }
+        }
+
+    private:
+        RayQuery& mQuery;
+        btVector3 mInvDirection;
+        unsigned int mSigns[3];
+        btTransform mFromTransform;
+        btTransform mToTransform;
+        btSphereShape mShape;
+        RayCallback mRayCallback;
+        SweepCallback mSweepCallback;
+    };
+
+    /// Walks a broadphase tree once for all queries, descending into a node with only the queries that intersect it
+    class BatchWalker
+    {
+    public:
+        BatchWalker(const std::vector<QueryState*>& states, btScalar allowedPenetration)
+            : mStates(states)
+            , mAllowedPenetration(allowedPenetration)
+        {
+        }
+
+        /// @param active Indices of the queries to test, the ones in [\a begin, \a end) are those that reached \a node.
+        /// Indices are appended for the children and removed again before returning.
+        void walk(const btDbvtNode* node, std::vector<size_t>& active, size_t begin, size_t end) const
+        {
+            const size_t first = active.size();
+            for (size_t i=begin; i<end; ++i)
+            {
+                size_t index = active[i];
+                if (mStates[index]->intersects(node->volume))
+                    active.push_back(index);
+            }
+            const size_t last = active.size();
+
+            if (first != last)
+            {
+                if (node->isinternal())
+                {
+                    walk(node->childs[0], active, first, last);
+                    walk(node->childs[1], active, first, last);
+                }
+                else
+                {
+                    const btBroadphaseProxy* proxy = static_cast<const btBroadphaseProxy*>(node->data);
+                    btCollisionObject* object = static_cast<btCollisionObject*>(proxy->m_clientObject);
+                    for (size_t i=first; i<last; ++i)
+                        mStates[active[i]]->test(object, mAllowedPenetration);
+                }
+            }
+
+            active.resize(first);
+        }
+
+    private:
+        const std::vector<QueryState*>& mStates;
+        btScalar mAllowedPenetration;
+    };
+}
+
+namespace MWPhysics
+{
+
+    RayQuery::RayQuery()
+        : mFrom(0, 0, 0)
+        , mTo(0, 0, 0)
+        , mRadius(0)
+        , mIgnore(NULL)
+        , mGroup(0xff)
+        , mMask(0xff)
+        , mHit(false)
+        , mHitPos(0, 0, 0)
+        , mHitNormal(0, 0, 0)
+        , mHitObject(NULL)
+    {
+    }
+
+    void castRayBatch(const btCollisionWorld* world, std::vector<RayQuery>& queries, size_t begin, size_t end)
+    {
+        std::vector<QueryState*> states;
+        states.reserve(end - begin);
+        for (size_t i=begin; i<end; ++i)
+            states.push_back(new QueryState(queries[i]));
+
+        const btDbvtBroadphase* broadphase = dynamic_cast<const btDbvtBroadphase*>(world->getBroadphase());
+        if (broadphase)
+        {
+            BatchWalker walker(states, world->getDispatchInfo().m_allowedCcdPenetration);
+            std::vector<size_t> active;
+            // Static and dynamic objects are kept in separate trees
+            for (int i=0; i<2; ++i)
+            {
+                const btDbvtNode* root = broadphase->m_sets[i].m_root;
+                if (!root)
+                    continue;
+
+                active.clear();
+                for (size_t j=0; j<states.size(); ++j)
+                    active.push_back(j);
+                walker.walk(root, active, 0, active.size());
+            }
+        }
+        else
+        {
+            for (std::vector<QueryState*>::iterator it = states.begin(); it != states.end(); ++it)
+                (*it)->cast(world);
+        }
+
+        for (std::vector<QueryState*>::iterator it = states.begin(); it != states.end(); ++it)
+        {
+            (*it)->storeResult();
+            delete *it;
+        }
+    }
+
+    void castSingleRay(const btCollisionWorld* world, RayQuery& query)
+    {
+        QueryState state(query);
+        state.cast(world);
+        state.storeResult();
+    }
+
+}
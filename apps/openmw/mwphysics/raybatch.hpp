@@ -0,0 +1,45 @@
+#ifndef OPENMW_MWPHYSICS_RAYBATCH_H
+#define OPENMW_MWPHYSICS_RAYBATCH_H
+
+#include <vector>
+
+#include <LinearMath/btVector3.h>
+
+class btCollisionObject;
+class btCollisionWorld;
+
+namespace MWPhysics
+{
+
+    /// A ray or sphere sweep for castRayBatch, with the objects to ignore already looked up.
+    struct RayQuery
+    {
+        btVector3 mFrom;
+        btVector3 mTo;
+        btScalar mRadius; ///< Radius of the sphere to sweep, 0 to cast a ray.
+
+        const btCollisionObject* mIgnore; ///< Optional, an object to ignore.
+        std::vector<const btCollisionObject*> mTargets; ///< If not empty, all actors except these are ignored.
+        int mGroup;
+        int mMask;
+
+        bool mHit;
+        btVector3 mHitPos;
+        btVector3 mHitNormal;
+        const btCollisionObject* mHitObject;
+
+        RayQuery();
+    };
+
+    /// Find the closest hit of each query in [\a begin, \a end).
+    /// @note With a btDbvtBroadphase, the queries share a single walk of the broadphase trees, rather than walking them
+    /// once per query. This walk only reads from the world, so several batches can be cast at the same time from
+    /// different threads, as long as the world is not modified in the meantime.
+    void castRayBatch(const btCollisionWorld* world, std::vector<RayQuery>& queries, size_t begin, size_t end);
+
+    /// Find the closest hit of a single query through the world's own interface, which is cheaper than a batch of one.
+    void castSingleRay(const btCollisionWorld* world, RayQuery& query);
+
+}
+
+#endif
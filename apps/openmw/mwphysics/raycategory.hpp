@@ -0,0 +1,25 @@
+#ifndef OPENMW_MWPHYSICS_RAYCATEGORY_H
+#define OPENMW_MWPHYSICS_RAYCATEGORY_H
+
+namespace MWPhysics
+{
+
+    /// What a ray is cast for, to count the rays cast by each part of the game in the frame statistics.
+    enum RayCategory
+    {
+        RayCategory_Other,
+        RayCategory_Combat,
+        RayCategory_Detection, ///< Sneaking and crime witnesses
+        RayCategory_Wander,
+        RayCategory_Follow,
+        RayCategory_Pathfinding,
+        RayCategory_Projectile,
+        RayCategory_Camera,
+        RayCategory_Script,
+
+        RayCategory_Count
+    };
+
+}
+
+#endif
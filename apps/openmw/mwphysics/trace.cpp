@@ -1,9 +1,12 @@
 #include "trace.h"
 
 #include <map>
+#include <vector>
 
 #include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
 #include <BulletCollision/CollisionShapes/btConvexShape.h>
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <LinearMath/btTransformUtil.h>
 
 #include "collisiontype.hpp"
 #include "actor.hpp"
@@ -49,6 +52,63 @@ protected:
 };
 
 
+/// Equivalent to btCollisionWorld::convexSweepTest, which finds the objects to test through btBroadphaseInterface::rayTest.
+/// The ray test of btDbvtBroadphase uses a stack that is shared by all callers, so this walks the broadphase trees with
+/// its own stack instead, allowing several threads to trace at the same time as long as nobody modifies the world.
+static void convexSweepTest(const btCollisionWorld* world, const btConvexShape* shape, const btTransform& from, const btTransform& to,
+                            btCollisionWorld::ConvexResultCallback& callback)
+{
+    const btDbvtBroadphase* broadphase = dynamic_cast<const btDbvtBroadphase*>(world->getBroadphase());
+    if (!broadphase)
+    {
+        world->convexSweepTest(shape, from, to, callback);
+        return;
+    }
+
+    // Bounds of the shape over the whole sweep, computed the same way as by btCollisionWorld
+    btVector3 linVel, angVel;
+    btTransformUtil::calculateVelocity(from, to, 1.0f, linVel, angVel);
+    btTransform rotation;
+    rotation.setIdentity();
+    rotation.setRotation(from.getRotation());
+    btVector3 castShapeAabbMin, castShapeAabbMax;
+    shape->calculateTemporalAabb(rotation, linVel, angVel, 1.0f, castShapeAabbMin, castShapeAabbMax);
+    const btDbvtVolume sweptVolume = btDbvtVolume::FromMM(from.getOrigin() + castShapeAabbMin, from.getOrigin() + castShapeAabbMax);
+
+    const btScalar allowedPenetration = world->getDispatchInfo().m_allowedCcdPenetration;
+
+    std::vector<const btDbvtNode*> stack;
+    for (int i=0; i<2; ++i)
+    {
+        if (broadphase->m_sets[i].m_root)
+            stack.push_back(broadphase->m_sets[i].m_root);
+
+        while (!stack.empty())
+        {
+            const btDbvtNode* node = stack.back();
+            stack.pop_back();
+
+            if (!Intersect(node->volume, sweptVolume))
+                continue;
+
+            if (node->isinternal())
+            {
+                stack.push_back(node->childs[1]);
+                stack.push_back(node->childs[0]);
+                continue;
+            }
+
+            const btBroadphaseProxy* proxy = static_cast<const btBroadphaseProxy*>(node->data);
+            btCollisionObject* collisionObject = static_cast<btCollisionObject*>(proxy->m_clientObject);
+            if (callback.needsCollision(collisionObject->getBroadphaseHandle()))
+            {
+                btCollisionWorld::objectQuerySingle(shape, from, to, collisionObject, collisionObject->getCollisionShape(),
+                                                    collisionObject->getWorldTransform(), callback, allowedPenetration);
+            }
+        }
+    }
+}
+
 void ActorTracer::doTrace(const btCollisionObject *actor, const osg::Vec3f& start, const osg::Vec3f& end, const btCollisionWorld* world)
 {
     const btVector3 btstart = toBullet(start);
@@ -67,8 +127,7 @@ void ActorTracer::doTrace(const btCollisionObject *actor, const osg::Vec3f& star
 
     const btCollisionShape *shape = actor->getCollisionShape();
     assert(shape->isConvex());
-    world->convexSweepTest(static_cast<const btConvexShape*>(shape),
-                                               from, to, newTraceCallback);
+    convexSweepTest(world, static_cast<const btConvexShape*>(shape), from, to, newTraceCallback);
 
     // Copy the hit data over to our trace results struct:
     if(newTraceCallback.hasHit())
@@ -105,7 +164,7 @@ void ActorTracer::findGround(const Actor* actor, const osg::Vec3f& start, const
     newTraceCallback.m_collisionFilterMask = actor->getCollisionObject()->getBroadphaseHandle()->m_collisionFilterMask;
     newTraceCallback.m_collisionFilterMask &= ~CollisionType_Actor;
 
-    world->convexSweepTest(actor->getConvexShape(), from, to, newTraceCallback);
+    convexSweepTest(world, actor->getConvexShape(), from, to, newTraceCallback);
     if(newTraceCallback.hasHit())
     {
         const btVector3& tracehitnormal = newTraceCallback.m_hitNormalWorld;
@@ -11,6 +11,8 @@ namespace MWPhysics
 {
     class Actor;
 
+    /// @note Tracing only reads from the collision world, so several threads may trace at the same time, provided
+    /// that no collision objects are added, removed or moved in the meantime.
     struct ActorTracer
     {
         osg::Vec3f mEndPos;
@@ -447,6 +447,8 @@ namespace MWRender
         osg::Vec3f mResetAxes;
     };
 
+    unsigned int Animation::sNextUpdatePhase = 0;
+
     Animation::Animation(const MWWorld::Ptr &ptr, osg::ref_ptr<osg::Group> parentNode, Resource::ResourceSystem* resourceSystem)
         : mInsert(parentNode)
         , mSkeleton(NULL)
@@ -458,6 +460,7 @@ namespace MWRender
         , mHeadYawRadians(0.f)
         , mHeadPitchRadians(0.f)
         , mAlpha(1.f)
+        , mUpdatePhase(sNextUpdatePhase++)
     {
         for(size_t i = 0;i < sNumBlendMasks;i++)
             mAnimationTimePtr[i].reset(new AnimationTime);
@@ -489,6 +492,12 @@ namespace MWRender
             mSkeleton->setActive(active);
     }
 
+    void Animation::setUpdateInterval(unsigned int interval)
+    {
+        if (mSkeleton)
+            mSkeleton->setUpdateInterval(interval, mUpdatePhase);
+    }
+
     void Animation::updatePtr(const MWWorld::Ptr &ptr)
     {
         mPtr = ptr;
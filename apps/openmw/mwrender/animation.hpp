@@ -271,6 +271,9 @@ protected:
 
     float mAlpha;
 
+    unsigned int mUpdatePhase;
+    static unsigned int sNextUpdatePhase;
+
     mutable std::map<std::string, float> mAnimVelocities;
 
     osg::ref_ptr<SceneUtil::LightListCallback> mLightListCallback;
@@ -348,6 +351,10 @@ public:
     /// @see SceneUtil::Skeleton::setActive
     void setActive(bool active);
 
+    /// Set the update interval of the object skeleton, if one exists. Each animation updates in different frames.
+    /// @see SceneUtil::Skeleton::setUpdateInterval
+    void setUpdateInterval(unsigned int interval);
+
     osg::Group* getOrCreateObjectRoot();
 
     osg::Group* getObjectRoot();
@@ -266,7 +266,7 @@ namespace MWRender
         mHeight = mCellSize*(mMaxY-mMinY+1);
 
         mWorkItem = new CreateMapWorkItem(mWidth, mHeight, mMinX, mMinY, mMaxX, mMaxY, mCellSize, esmStore.get<ESM::Land>());
-        mWorkQueue->addWorkItem(mWorkItem);
+        mWorkQueue->addWorkItem(mWorkItem, SceneUtil::WorkQueue::Priority_Low);
     }
 
     void GlobalMap::worldPosToImageSpace(float x, float z, float& imageX, float& imageY)
@@ -1,6 +1,7 @@
 #include "objects.hpp"
 
 #include <cmath>
+#include <algorithm>
 
 #include <osg/Group>
 #include <osg/UserDataContainer>
@@ -8,6 +9,8 @@
 #include <components/sceneutil/positionattitudetransform.hpp>
 #include <components/sceneutil/unrefqueue.hpp>
 
+#include <components/settings/settings.hpp>
+
 #include "../mwworld/ptr.hpp"
 #include "../mwworld/class.hpp"
 
@@ -25,10 +28,15 @@ Objects::Objects(Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Gro
     , mResourceSystem(resourceSystem)
     , mUnrefQueue(unrefQueue)
 {
+    mLodDistance = Settings::Manager::getFloat("animation lod distance", "General");
+    mLodPixelSize = Settings::Manager::getFloat("animation lod pixel size", "General");
+    mLodInterval = std::max(1, Settings::Manager::getInt("animation lod interval", "General"));
+    mLodMaxFullRate = std::max(0, Settings::Manager::getInt("animation lod max full rate", "General"));
 }
 
 Objects::~Objects()
 {
+    mActorAnimations.clear();
     mObjects.clear();
 
     for (CellMap::iterator iter = mCellSceneNodes.begin(); iter != mCellSceneNodes.end(); ++iter)
@@ -93,6 +101,7 @@ void Objects::insertCreature(const MWWorld::Ptr &ptr, const std::string &mesh, b
     ptr.getClass().getContainerStore(ptr).setContListener(static_cast<ActorAnimation*>(anim.get()));
 
     mObjects.insert(std::make_pair(ptr, anim));
+    mActorAnimations.insert(anim.get());
 }
 
 void Objects::insertNPC(const MWWorld::Ptr &ptr)
@@ -106,6 +115,7 @@ void Objects::insertNPC(const MWWorld::Ptr &ptr)
     ptr.getClass().getInventoryStore(ptr).setContListener(anim.get());
 
     mObjects.insert(std::make_pair(ptr, anim));
+    mActorAnimations.insert(anim.get());
 }
 
 bool Objects::removeObject (const MWWorld::Ptr& ptr)
@@ -119,6 +129,7 @@ bool Objects::removeObject (const MWWorld::Ptr& ptr)
         if (mUnrefQueue.get())
             mUnrefQueue->push(iter->second);
 
+        mActorAnimations.erase(iter->second.get());
         mObjects.erase(iter);
 
         if (ptr.getClass().isNpc())
@@ -154,6 +165,7 @@ void Objects::removeCell(const MWWorld::CellStore* store)
                 invStore.setContListener(NULL);
             }
 
+            mActorAnimations.erase(iter->second.get());
             mObjects.erase(iter++);
         }
         else
@@ -209,6 +221,42 @@ void Objects::updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur)
     }
 }
 
+void Objects::updateAnimationLod(const osg::Vec3f &cameraPos, float pixelsPerUnit)
+{
+    if (mLodDistance <= 0.f && mLodPixelSize <= 0.f && mLodMaxFullRate == 0)
+        return;
+
+    mFullRateAnimations.clear();
+    for (std::set<Animation*>::const_iterator it = mActorAnimations.begin(); it != mActorAnimations.end(); ++it)
+    {
+        Animation* anim = *it;
+        const osg::Node* node = anim->getPtr().getRefData().getBaseNode();
+        if (!node)
+            continue;
+
+        const osg::BoundingSphere& bound = node->getBound();
+        float distance = (bound.center() - cameraPos).length();
+
+        bool reduced = (mLodDistance > 0.f && distance > mLodDistance)
+                || (mLodPixelSize > 0.f && bound.radius() * 2.f * pixelsPerUnit < mLodPixelSize * distance);
+        if (reduced)
+            anim->setUpdateInterval(mLodInterval);
+        else
+            mFullRateAnimations.push_back(std::make_pair(distance, anim));
+    }
+
+    // only the closest actors get the full rate
+    size_t numFullRate = mFullRateAnimations.size();
+    if (mLodMaxFullRate > 0 && numFullRate > mLodMaxFullRate)
+    {
+        numFullRate = mLodMaxFullRate;
+        std::nth_element(mFullRateAnimations.begin(), mFullRateAnimations.begin() + numFullRate, mFullRateAnimations.end());
+    }
+
+    for (size_t i=0; i<mFullRateAnimations.size(); ++i)
+        mFullRateAnimations[i].second->setUpdateInterval(i < numFullRate ? 1 : mLodInterval);
+}
+
 Animation* Objects::getAnimation(const MWWorld::Ptr &ptr)
 {
     PtrAnimationMap::const_iterator iter = mObjects.find(ptr);
@@ -2,11 +2,14 @@
 #define GAME_RENDER_OBJECTS_H
 
 #include <map>
+#include <set>
+#include <vector>
 #include <memory>
 #include <string>
 
 #include <osg/ref_ptr>
 #include <osg/Object>
+#include <osg/Vec3f>
 
 #include "../mwworld/ptr.hpp"
 
@@ -63,6 +66,15 @@ class Objects{
     CellMap mCellSceneNodes;
     PtrAnimationMap mObjects;
 
+    // NPCs and creatures, a subset of mObjects
+    std::set<Animation*> mActorAnimations;
+
+    float mLodDistance;
+    float mLodPixelSize;
+    unsigned int mLodInterval;
+    unsigned int mLodMaxFullRate;
+    std::vector<std::pair<float, Animation*> > mFullRateAnimations;
+
     osg::ref_ptr<osg::Group> mRootNode;
 
     Resource::ResourceSystem* mResourceSystem;
@@ -93,6 +105,10 @@ public:
     /// Updates containing cell for object rendering data
     void updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur);
 
+    /// Animate actors that are far away or small on screen at a reduced rate, see the 'animation lod' settings.
+    /// @param pixelsPerUnit The height on screen in pixels of an object of size 1 at distance 1.
+    void updateAnimationLod(const osg::Vec3f& cameraPos, float pixelsPerUnit);
+
 private:
     void operator = (const Objects&);
     Objects(const Objects&);
@@ -3,6 +3,7 @@
 #include <stdexcept>
 #include <limits>
 #include <cstdlib>
+#include <cmath>
 
 #include <osg/Light>
 #include <osg/LightModel>
@@ -29,6 +30,7 @@
 #include <components/sceneutil/lightmanager.hpp>
 #include <components/sceneutil/statesetupdater.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
+#include <components/sceneutil/riggeometry.hpp>
 #include <components/sceneutil/workqueue.hpp>
 #include <components/sceneutil/unrefqueue.hpp>
 #include <components/sceneutil/writescene.hpp>
@@ -184,6 +186,13 @@ namespace MWRender
     {
         resourceSystem->getSceneManager()->setParticleSystemMask(MWRender::Mask_ParticleSystem);
         resourceSystem->getSceneManager()->setShaderPath(resourcePath + "/shaders");
+
+        int skinningThreads = Settings::Manager::getInt("skinning threads", "General");
+        if (skinningThreads > 0)
+        {
+            mSkinningQueue = new SceneUtil::WorkQueue(skinningThreads);
+            SceneUtil::RigGeometry::setWorkQueue(mSkinningQueue.get());
+        }
         resourceSystem->getSceneManager()->setForceShaders(Settings::Manager::getBool("force shaders", "Shaders"));
         resourceSystem->getSceneManager()->setClampLighting(Settings::Manager::getBool("clamp lighting", "Shaders"));
         resourceSystem->getSceneManager()->setForcePerPixelLighting(Settings::Manager::getBool("force per pixel lighting", "Shaders"));
@@ -289,6 +298,10 @@ namespace MWRender
     {
         // let background loading thread finish before we delete anything else
         mWorkQueue = NULL;
+
+        // meshes still waiting for the skinning threads are skinned by the thread that draws them
+        SceneUtil::RigGeometry::setWorkQueue(NULL);
+        mSkinningQueue = NULL;
     }
 
     MWRender::Objects& RenderingManager::getObjects()
@@ -501,6 +514,11 @@ namespace MWRender
         osg::Vec3f focal, cameraPos;
         mCamera->getPosition(focal, cameraPos);
         mCurrentCameraPos = cameraPos;
+
+        float fov = mFieldOfViewOverridden ? mFieldOfViewOverride : mFieldOfView;
+        float pixelsPerUnit = mViewer->getCamera()->getViewport()->height() / (2.f * std::tan(osg::DegreesToRadians(fov) / 2.f));
+        mObjects->updateAnimationLod(cameraPos, pixelsPerUnit);
+
         if (mWater->isUnderwater(cameraPos))
         {
             float viewDistance = mViewDistance;
@@ -385,7 +385,7 @@ namespace MWScript
                     }
 
                     Interpreter::Type_Integer value =
-                            MWBase::Environment::get().getWorld()->getLOS(observer, actor) &&
+                            MWBase::Environment::get().getWorld()->getLOS(observer, actor, MWPhysics::RayCategory_Script) &&
                             MWBase::Environment::get().getMechanicsManager()->awarenessCheck(actor, observer);
 
                     runtime.push (value);
@@ -410,7 +410,7 @@ namespace MWScript
                     bool value = false;
                     if(dest != MWWorld::Ptr() && source.getClass().isActor() && dest.getClass().isActor())
                     {
-                        value = MWBase::Environment::get().getWorld()->getLOS(source,dest);
+                        value = MWBase::Environment::get().getWorld()->getLOS(source, dest, MWPhysics::RayCategory_Script);
                     }
                     runtime.push (value);
                 }
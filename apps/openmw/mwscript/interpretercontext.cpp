@@ -10,6 +10,8 @@
 
 #include <components/esm/cellid.hpp>
 
+#include <components/misc/stringops.hpp>
+
 #include "../mwworld/esmstore.hpp"
 
 #include "../mwbase/environment.hpp"
@@ -26,6 +28,7 @@
 
 #include "locals.hpp"
 #include "globalscripts.hpp"
+#include "referencecache.hpp"
 
 namespace MWScript
 {
@@ -34,7 +37,7 @@ namespace MWScript
     {
         if (!id.empty())
         {
-            return MWBase::Environment::get().getWorld()->getPtr (id, activeOnly);
+            return MWBase::Environment::get().getScriptManager()->getReferenceCache().get (id, activeOnly);
         }
         else
         {
@@ -54,7 +57,7 @@ namespace MWScript
     {
         if (!id.empty())
         {
-            return MWBase::Environment::get().getWorld()->getPtr (id, activeOnly);
+            return MWBase::Environment::get().getScriptManager()->getReferenceCache().get (id, activeOnly);
         }
         else
         {
@@ -110,14 +113,28 @@ namespace MWScript
         }
     }
 
-    int InterpreterContext::findLocalVariableIndex (const std::string& scriptId,
-        const std::string& name, char type) const
+    int InterpreterContext::findLocalVariableIndex (const Locals& locals,
+        const std::string& scriptId, const std::string& name, char type, int& slot) const
     {
-        int index = MWBase::Environment::get().getScriptManager()->getLocals (scriptId).
-            searchIndex (type, name);
+        if (const Compiler::Locals *declarations = locals.getDeclarations())
+        {
+            const std::vector<std::string>& names = declarations->get (type);
+
+            if (slot>=0 && slot<static_cast<int> (names.size()) &&
+                Misc::StringUtils::ciEqual (names[slot], name))
+                return slot;
+        }
+
+        const Compiler::Locals& declarations =
+            MWBase::Environment::get().getScriptManager()->getLocals (scriptId);
+
+        int index = declarations.searchIndex (type, name);
 
         if (index!=-1)
+        {
+            slot = index;
             return index;
+        }
 
         std::ostringstream stream;
 
@@ -244,6 +261,42 @@ namespace MWScript
         MWBase::Environment::get().getWorld()->setGlobalFloat (name, value);
     }
 
+    int InterpreterContext::getGlobalSlot (const std::string& name) const
+    {
+        return MWBase::Environment::get().getWorld()->getGlobalSlot (name);
+    }
+
+    int InterpreterContext::getGlobalShort (int slot) const
+    {
+        return MWBase::Environment::get().getWorld()->getGlobalInt (slot);
+    }
+
+    int InterpreterContext::getGlobalLong (int slot) const
+    {
+        // a global long is internally a float.
+        return MWBase::Environment::get().getWorld()->getGlobalInt (slot);
+    }
+
+    float InterpreterContext::getGlobalFloat (int slot) const
+    {
+        return MWBase::Environment::get().getWorld()->getGlobalFloat (slot);
+    }
+
+    void InterpreterContext::setGlobalShort (int slot, int value)
+    {
+        MWBase::Environment::get().getWorld()->setGlobalInt (slot, value);
+    }
+
+    void InterpreterContext::setGlobalLong (int slot, int value)
+    {
+        MWBase::Environment::get().getWorld()->setGlobalInt (slot, value);
+    }
+
+    void InterpreterContext::setGlobalFloat (int slot, float value)
+    {
+        MWBase::Environment::get().getWorld()->setGlobalFloat (slot, value);
+    }
+
     std::vector<std::string> InterpreterContext::getGlobals() const
     {
         std::vector<std::string> ids;
@@ -448,7 +501,7 @@ namespace MWScript
         if (id.empty())
             ref2 = getReferenceImp();
         else
-            ref2 = MWBase::Environment::get().getWorld()->getPtr(id, false);
+            ref2 = getReferenceImp (id, false);
 
         if (ref2.getContainerStore()) // is the object contained?
         {
@@ -460,7 +513,7 @@ namespace MWScript
                 throw std::runtime_error("failed to find container ptr");
         }
 
-        const MWWorld::Ptr ref = MWBase::Environment::get().getWorld()->getPtr(name, false);
+        const MWWorld::Ptr ref = getReferenceImp (name, false);
 
         // If the objects are in different worldspaces, return a large value (just like vanilla)
         if (ref.getCell()->getCell()->getCellId().mWorldspace != ref2.getCell()->getCell()->getCellId().mWorldspace)
@@ -510,61 +563,63 @@ namespace MWScript
     }
 
     int InterpreterContext::getMemberShort (const std::string& id, const std::string& name,
-        bool global) const
+        bool global, int& slot) const
     {
         std::string scriptId (id);
 
         const Locals& locals = getMemberLocals (scriptId, global);
 
-        return locals.mShorts[findLocalVariableIndex (scriptId, name, 's')];
+        return locals.mShorts[findLocalVariableIndex (locals, scriptId, name, 's', slot)];
     }
 
     int InterpreterContext::getMemberLong (const std::string& id, const std::string& name,
-        bool global) const
+        bool global, int& slot) const
     {
         std::string scriptId (id);
 
         const Locals& locals = getMemberLocals (scriptId, global);
 
-        return locals.mLongs[findLocalVariableIndex (scriptId, name, 'l')];
+        return locals.mLongs[findLocalVariableIndex (locals, scriptId, name, 'l', slot)];
     }
 
     float InterpreterContext::getMemberFloat (const std::string& id, const std::string& name,
-        bool global) const
+        bool global, int& slot) const
     {
         std::string scriptId (id);
 
         const Locals& locals = getMemberLocals (scriptId, global);
 
-        return locals.mFloats[findLocalVariableIndex (scriptId, name, 'f')];
+        return locals.mFloats[findLocalVariableIndex (locals, scriptId, name, 'f', slot)];
     }
 
     void InterpreterContext::setMemberShort (const std::string& id, const std::string& name,
-        int value, bool global)
+        int value, bool global, int& slot)
     {
         std::string scriptId (id);
 
         Locals& locals = getMemberLocals (scriptId, global);
 
-        locals.mShorts[findLocalVariableIndex (scriptId, name, 's')] = value;
+        locals.mShorts[findLocalVariableIndex (locals, scriptId, name, 's', slot)] = value;
     }
 
-    void InterpreterContext::setMemberLong (const std::string& id, const std::string& name, int value, bool global)
+    void InterpreterContext::setMemberLong (const std::string& id, const std::string& name,
+        int value, bool global, int& slot)
     {
         std::string scriptId (id);
 
         Locals& locals = getMemberLocals (scriptId, global);
 
-        locals.mLongs[findLocalVariableIndex (scriptId, name, 'l')] = value;
+        locals.mLongs[findLocalVariableIndex (locals, scriptId, name, 'l', slot)] = value;
     }
 
-    void InterpreterContext::setMemberFloat (const std::string& id, const std::string& name, float value, bool global)
+    void InterpreterContext::setMemberFloat (const std::string& id, const std::string& name,
+        float value, bool global, int& slot)
     {
         std::string scriptId (id);
 
         Locals& locals = getMemberLocals (scriptId, global);
 
-        locals.mFloats[findLocalVariableIndex (scriptId, name, 'f')] = value;
+        locals.mFloats[findLocalVariableIndex (locals, scriptId, name, 'f', slot)] = value;
     }
 
     MWWorld::Ptr InterpreterContext::getReference(bool required)
@@ -572,6 +627,16 @@ namespace MWScript
         return getReferenceImp ("", true, required);
     }
 
+    MWWorld::Ptr InterpreterContext::getReference(const std::string& id, bool required, bool activeOnly)
+    {
+        ReferenceCache& cache = MWBase::Environment::get().getScriptManager()->getReferenceCache();
+
+        if (required)
+            return cache.get (id, activeOnly);
+        else
+            return cache.search (id, activeOnly);
+    }
+
     std::string InterpreterContext::getTargetId() const
     {
         return mTargetId;
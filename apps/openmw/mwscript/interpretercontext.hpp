@@ -46,8 +46,11 @@ namespace MWScript
             ///< \a id is changed to the respective script ID, if \a id wasn't a script ID before
 
             /// Throws an exception if local variable can't be found.
-            int findLocalVariableIndex (const std::string& scriptId, const std::string& name,
-                char type) const;
+            ///
+            /// \a slot is checked against the declarations \a locals was configured for first and
+            /// updated, if the variable is found at a different index.
+            int findLocalVariableIndex (const Locals& locals, const std::string& scriptId,
+                const std::string& name, char type, int& slot) const;
 
         public:
 
@@ -89,6 +92,20 @@ namespace MWScript
 
             virtual void setGlobalFloat (const std::string& name, float value);
 
+            virtual int getGlobalSlot (const std::string& name) const;
+
+            virtual int getGlobalShort (int slot) const;
+
+            virtual int getGlobalLong (int slot) const;
+
+            virtual float getGlobalFloat (int slot) const;
+
+            virtual void setGlobalShort (int slot, int value);
+
+            virtual void setGlobalLong (int slot, int value);
+
+            virtual void setGlobalFloat (int slot, float value);
+
             virtual std::vector<std::string> getGlobals () const;
 
             virtual char getGlobalType (const std::string& name) const;
@@ -139,21 +156,30 @@ namespace MWScript
 
             virtual void disable (const std::string& id = "");
 
-            virtual int getMemberShort (const std::string& id, const std::string& name, bool global) const;
+            virtual int getMemberShort (const std::string& id, const std::string& name, bool global,
+                int& slot) const;
 
-            virtual int getMemberLong (const std::string& id, const std::string& name, bool global) const;
+            virtual int getMemberLong (const std::string& id, const std::string& name, bool global,
+                int& slot) const;
 
-            virtual float getMemberFloat (const std::string& id, const std::string& name, bool global) const;
+            virtual float getMemberFloat (const std::string& id, const std::string& name, bool global,
+                int& slot) const;
 
-            virtual void setMemberShort (const std::string& id, const std::string& name, int value, bool global);
+            virtual void setMemberShort (const std::string& id, const std::string& name, int value,
+                bool global, int& slot);
 
-            virtual void setMemberLong (const std::string& id, const std::string& name, int value, bool global);
+            virtual void setMemberLong (const std::string& id, const std::string& name, int value,
+                bool global, int& slot);
 
-            virtual void setMemberFloat (const std::string& id, const std::string& name, float value, bool global);
+            virtual void setMemberFloat (const std::string& id, const std::string& name, float value,
+                bool global, int& slot);
 
             MWWorld::Ptr getReference(bool required=true);
             ///< Reference, that the script is running from (can be empty)
 
+            MWWorld::Ptr getReference(const std::string& id, bool required, bool activeOnly);
+            ///< Explicit reference \a id. Lookups are cached until the active cells change.
+
             void updatePtr(const MWWorld::Ptr& base, const MWWorld::Ptr& updated);
             ///< Update the Ptr stored in mReference, if there is one stored there. Should be called after the reference has been moved to a new cell.
 
@@ -28,7 +28,7 @@ namespace MWScript
         }
     }
 
-    Locals::Locals() : mInitialised (false) {}
+    Locals::Locals() : mInitialised (false), mDeclarations (0) {}
 
     bool Locals::configure (const ESM::Script& script)
     {
@@ -45,10 +45,16 @@ namespace MWScript
         mFloats.clear();
         mFloats.resize (locals.get ('f').size(), 0);
 
+        mDeclarations = &locals;
         mInitialised = true;
         return true;
     }
 
+    const Compiler::Locals *Locals::getDeclarations() const
+    {
+        return mDeclarations;
+    }
+
     bool Locals::isEmpty() const
     {
         return (mShorts.empty() && mLongs.empty() && mFloats.empty());
@@ -11,11 +11,17 @@ namespace ESM
     struct Locals;
 }
 
+namespace Compiler
+{
+    class Locals;
+}
+
 namespace MWScript
 {
     class Locals
     {
             bool mInitialised;
+            const Compiler::Locals *mDeclarations;
 
             void ensure (const std::string& scriptName);
 
@@ -34,6 +40,11 @@ namespace MWScript
             /// \return Did the state of *this change from uninitialised to initialised?
             bool configure (const ESM::Script& script);
 
+            /// Return the declarations of the script *this was configured for.
+            ///
+            /// \note Will return 0, if locals have not been configured yet.
+            const Compiler::Locals *getDeclarations() const;
+
             /// @note var needs to be in lowercase
             ///
             /// \note Locals will be automatically configured first, if necessary
@@ -0,0 +1,65 @@
+#include "referencecache.hpp"
+
+#include <stdexcept>
+
+#include <components/misc/stringops.hpp>
+
+#include "../mwbase/environment.hpp"
+#include "../mwbase/world.hpp"
+
+#include "../mwworld/refdata.hpp"
+
+namespace MWScript
+{
+    MWWorld::Ptr ReferenceCache::search (const std::string& id, bool activeOnly)
+    {
+        std::string lowerCaseId = Misc::StringUtils::lowerCase (id);
+
+        Collection::iterator iter = mReferences.find (lowerCaseId);
+
+        if (iter!=mReferences.end())
+        {
+            if (!iter->second.getRefData().isDeleted())
+                return iter->second;
+
+            mReferences.erase (iter);
+        }
+
+        MWBase::World *world = MWBase::Environment::get().getWorld();
+
+        // The player is not bound to the cell it is listed in, and World::searchPtr finds it
+        // without searching anyway.
+        if (lowerCaseId=="player")
+            return world->searchPtr (id, activeOnly);
+
+        // Active cells are searched first, whether activeOnly is set or not. References found
+        // there are the result of either search. References in containers are not cached.
+        MWWorld::Ptr ptr = world->searchPtr (id, true);
+
+        if (!ptr.isEmpty() && ptr.isInCell())
+        {
+            mReferences.insert (std::make_pair (lowerCaseId, ptr));
+            return ptr;
+        }
+
+        if (activeOnly)
+            return ptr;
+
+        return world->searchPtr (id, false);
+    }
+
+    MWWorld::Ptr ReferenceCache::get (const std::string& id, bool activeOnly)
+    {
+        MWWorld::Ptr ptr = search (id, activeOnly);
+
+        if (ptr.isEmpty())
+            throw std::runtime_error ("unknown ID: " + id);
+
+        return ptr;
+    }
+
+    void ReferenceCache::clear()
+    {
+        mReferences.clear();
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef GAME_SCRIPT_REFERENCECACHE_H
+#define GAME_SCRIPT_REFERENCECACHE_H
+
+#include <string>
+#include <map>
+
+#include "../mwworld/ptr.hpp"
+
+namespace MWScript
+{
+    /// \brief Explicit references resolved by scripts
+    ///
+    /// Only references that are placed in an active cell are cached. The cache must be cleared
+    /// whenever the set of active cells changes or a reference is moved to another cell.
+    class ReferenceCache
+    {
+            typedef std::map<std::string, MWWorld::Ptr> Collection;
+
+            Collection mReferences; // lower case ID, reference
+
+        public:
+
+            MWWorld::Ptr search (const std::string& id, bool activeOnly);
+            ///< Same as World::searchPtr, but cached.
+
+            MWWorld::Ptr get (const std::string& id, bool activeOnly);
+            ///< Same as World::getPtr, but cached.
+
+            void clear();
+    };
+}
+
+#endif
@@ -0,0 +1,233 @@
+#include "scriptcache.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/esm/esmreader.hpp>
+#include <components/esm/esmwriter.hpp>
+
+#include <components/misc/stringops.hpp>
+#include <components/misc/hash.hpp>
+
+namespace
+{
+    // Increase when the layout of the cache or the code generated by the compiler changes
+    const int sCacheFormat = 1;
+
+    const char sLocalTypes[] = { 's', 'l', 'f' };
+    const char *sLocalNames[] = { "SVAR", "LVAR", "FVAR" };
+}
+
+namespace MWScript
+{
+    ScriptCache::ScriptCache (const boost::filesystem::path& cacheFile, unsigned int extensionsHash)
+    : mCacheFile (cacheFile), mExtensionsHash (extensionsHash), mChanged (false)
+    {}
+
+    void ScriptCache::addContentFile (const boost::filesystem::path& file)
+    {
+        ContentFile contentFile;
+        contentFile.mPath = file.string();
+        contentFile.mSize = boost::filesystem::file_size (file);
+        contentFile.mModified = boost::filesystem::last_write_time (file);
+        mContentFiles.push_back (contentFile);
+    }
+
+    uint64_t ScriptCache::hash (const std::string& source)
+    {
+        Misc::Fnv1a<uint64_t> hash;
+        hash.add (source.data(), source.size());
+        return hash.get();
+    }
+
+    bool ScriptCache::readKey (ESM::ESMReader& reader)
+    {
+        if (reader.getRecName()!="SKEY")
+            return false;
+        reader.getRecHeader();
+
+        int format = 0;
+        reader.getHNT (format, "FORM");
+        unsigned int extensionsHash = 0;
+        reader.getHNT (extensionsHash, "EXTS");
+        int count = 0;
+        reader.getHNT (count, "COUN");
+
+        if (format!=sCacheFormat || extensionsHash!=mExtensionsHash ||
+            count!=static_cast<int> (mContentFiles.size()))
+            return false;
+
+        for (std::vector<ContentFile>::const_iterator iter (mContentFiles.begin());
+            iter!=mContentFiles.end(); ++iter)
+        {
+            std::string path = reader.getHNString ("FILE");
+            int64_t size = reader.getHNLong ("SIZE");
+            int64_t modified = reader.getHNLong ("TIME");
+
+            if (path!=iter->mPath || size!=iter->mSize || modified!=iter->mModified)
+                return false;
+        }
+
+        return true;
+    }
+
+    void ScriptCache::readScript (ESM::ESMReader& reader)
+    {
+        if (reader.getRecName()!="SCOD")
+            reader.fail ("Expected compiled script");
+        reader.getRecHeader();
+
+        std::string id = reader.getHNString ("NAME");
+
+        Script& script = mScripts[id];
+
+        reader.getHNT (script.mSourceHash, "HASH");
+
+        reader.getSubNameIs ("CODE");
+        reader.getSubHeader();
+        int size = reader.getSubSize();
+        if (size<=0 || size%sizeof (Interpreter::Type_Code))
+            reader.fail ("Invalid code size");
+        script.mByteCode.resize (size/sizeof (Interpreter::Type_Code));
+        reader.getExact (&script.mByteCode[0], size);
+
+        for (int i=0; i<3; ++i)
+            while (reader.isNextSub (sLocalNames[i]))
+                script.mLocals.declare (sLocalTypes[i], reader.getHString());
+    }
+
+    void ScriptCache::read()
+    {
+        if (!boost::filesystem::exists (mCacheFile))
+            return;
+
+        try
+        {
+            ESM::ESMReader reader;
+            reader.open (mCacheFile.string());
+
+            if (!readKey (reader))
+            {
+                std::cout << "Script cache " << mCacheFile.string() << " is out of date, rebuilding" << std::endl;
+                return;
+            }
+
+            while (reader.hasMoreRecs())
+                readScript (reader);
+        }
+        catch (const std::exception& e)
+        {
+            // The scripts will just be compiled again
+            std::cerr << "Failed to read script cache " << mCacheFile.string() << ", rebuilding: " << e.what() << std::endl;
+            mScripts.clear();
+        }
+    }
+
+    void ScriptCache::write()
+    {
+        if (!mChanged)
+            return;
+
+        // Write to a temporary file first, so that an interrupted write never leaves a damaged cache behind
+        boost::filesystem::path tempFile = mCacheFile.string() + ".tmp";
+
+        try
+        {
+            if (mCacheFile.has_parent_path())
+                boost::filesystem::create_directories (mCacheFile.parent_path());
+
+            boost::filesystem::ofstream stream (tempFile, std::ios::binary);
+            if (!stream.is_open())
+                throw std::runtime_error ("Failed to open " + tempFile.string() + " for writing");
+
+            ESM::ESMWriter writer;
+            writer.setFormat (0);
+            writer.setAuthor ("OpenMW");
+            writer.setDescription ("Script cache");
+            writer.save (stream);
+
+            writer.startRecord ("SKEY");
+            writer.writeHNT ("FORM", sCacheFormat);
+            writer.writeHNT ("EXTS", mExtensionsHash);
+            writer.writeHNT ("COUN", static_cast<int> (mContentFiles.size()));
+            for (std::vector<ContentFile>::const_iterator iter (mContentFiles.begin());
+                iter!=mContentFiles.end(); ++iter)
+            {
+                writer.writeHNString ("FILE", iter->mPath);
+                writer.writeHNT ("SIZE", iter->mSize);
+                writer.writeHNT ("TIME", iter->mModified);
+            }
+            writer.endRecord ("SKEY");
+
+            for (Collection::const_iterator iter (mScripts.begin()); iter!=mScripts.end(); ++iter)
+            {
+                writer.startRecord ("SCOD");
+                writer.writeHNString ("NAME", iter->first);
+                writer.writeHNT ("HASH", iter->second.mSourceHash);
+
+                writer.startSubRecord ("CODE");
+                writer.write (reinterpret_cast<const char *> (&iter->second.mByteCode[0]),
+                    iter->second.mByteCode.size()*sizeof (Interpreter::Type_Code));
+                writer.endRecord ("CODE");
+
+                for (int i=0; i<3; ++i)
+                {
+                    const std::vector<std::string>& names = iter->second.mLocals.get (sLocalTypes[i]);
+
+                    for (std::vector<std::string>::const_iterator name (names.begin());
+                        name!=names.end(); ++name)
+                        writer.writeHNString (sLocalNames[i], *name);
+                }
+
+                writer.endRecord ("SCOD");
+            }
+
+            writer.close();
+            stream.close();
+
+            boost::filesystem::rename (tempFile, mCacheFile);
+
+            mChanged = false;
+
+            std::cout << "Wrote script cache " << mCacheFile.string() << std::endl;
+        }
+        catch (const std::exception& e)
+        {
+            // Not fatal, the scripts will just be compiled again next time
+            std::cerr << "Failed to write script cache " << mCacheFile.string() << ": " << e.what() << std::endl;
+
+            boost::system::error_code ec;
+            boost::filesystem::remove (tempFile, ec);
+        }
+    }
+
+    bool ScriptCache::get (const std::string& id, const std::string& source,
+        std::vector<Interpreter::Type_Code>& byteCode, Compiler::Locals& locals) const
+    {
+        Collection::const_iterator iter = mScripts.find (Misc::StringUtils::lowerCase (id));
+
+        if (iter==mScripts.end() || iter->second.mSourceHash!=hash (source))
+            return false;
+
+        byteCode = iter->second.mByteCode;
+        locals = iter->second.mLocals;
+        return true;
+    }
+
+    void ScriptCache::add (const std::string& id, const std::string& source,
+        const std::vector<Interpreter::Type_Code>& byteCode, const Compiler::Locals& locals)
+    {
+        if (byteCode.empty())
+            return;
+
+        Script& script = mScripts[Misc::StringUtils::lowerCase (id)];
+        script.mSourceHash = hash (source);
+        script.mByteCode = byteCode;
+        script.mLocals = locals;
+
+        mChanged = true;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef GAME_SCRIPT_SCRIPTCACHE_H
+#define GAME_SCRIPT_SCRIPTCACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/filesystem/path.hpp>
+
+#include <components/compiler/locals.hpp>
+
+#include <components/interpreter/types.hpp>
+
+namespace ESM
+{
+    class ESMReader;
+}
+
+namespace MWScript
+{
+    /// \brief On-disk cache of compiled scripts
+    ///
+    /// Compiled code depends on more than the script text (e.g. on which IDs exist and on the
+    /// locals of other scripts), so the whole cache is keyed by the paths, sizes and modification
+    /// times of the content files and by the hash of the compiler extensions. Each script is
+    /// additionally keyed by a hash of its text.
+    class ScriptCache
+    {
+            struct ContentFile
+            {
+                std::string mPath;
+                int64_t mSize;
+                int64_t mModified;
+            };
+
+            struct Script
+            {
+                uint64_t mSourceHash;
+                std::vector<Interpreter::Type_Code> mByteCode;
+                Compiler::Locals mLocals;
+            };
+
+            typedef std::map<std::string, Script> Collection;
+
+            boost::filesystem::path mCacheFile;
+            unsigned int mExtensionsHash;
+            std::vector<ContentFile> mContentFiles;
+            Collection mScripts; // lower case ID, script
+            bool mChanged;
+
+            bool readKey (ESM::ESMReader& reader);
+
+            void readScript (ESM::ESMReader& reader);
+
+            static uint64_t hash (const std::string& source);
+
+        public:
+
+            ScriptCache (const boost::filesystem::path& cacheFile, unsigned int extensionsHash);
+
+            void addContentFile (const boost::filesystem::path& file);
+
+            void read();
+            ///< Read the cache file, if it matches the content files and the extensions.
+
+            void write();
+            ///< Replace the cache file, if scripts have been added since it was read.
+
+            bool get (const std::string& id, const std::string& source,
+                std::vector<Interpreter::Type_Code>& byteCode, Compiler::Locals& locals) const;
+            ///< Return the cached code and locals of the script \a id, if it was compiled from
+            /// \a source.
+
+            void add (const std::string& id, const std::string& source,
+                const std::vector<Interpreter::Type_Code>& byteCode, const Compiler::Locals& locals);
+    };
+}
+
+#endif
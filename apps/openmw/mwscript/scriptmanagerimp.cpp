@@ -18,6 +18,7 @@
 #include "../mwworld/esmstore.hpp"
 
 #include "extensions.hpp"
+#include "scriptcache.hpp"
 
 namespace MWScript
 {
@@ -37,6 +38,17 @@ namespace MWScript
         std::sort (mScriptBlacklist.begin(), mScriptBlacklist.end());
     }
 
+    ScriptManager::~ScriptManager()
+    {
+        if (mCache.get())
+            mCache->write();
+    }
+
+    void ScriptManager::setCache (ScriptCache *cache)
+    {
+        mCache.reset (cache);
+    }
+
     bool ScriptManager::compile (const std::string& name)
     {
         mParser.reset();
@@ -44,6 +56,18 @@ namespace MWScript
 
         if (const ESM::Script *script = mStore.get<ESM::Script>().find (name))
         {
+            if (mCache.get())
+            {
+                std::vector<Interpreter::Type_Code> code;
+                Compiler::Locals locals;
+
+                if (mCache->get (name, script->mScriptText, code, locals))
+                {
+                    mScripts.insert (std::make_pair (name, CompiledScript (code, locals)));
+                    return true;
+                }
+            }
+
             mErrorHandler.setContext(name);
 
             bool Success = true;
@@ -79,7 +103,10 @@ namespace MWScript
             {
                 std::vector<Interpreter::Type_Code> code;
                 mParser.getCode (code);
-                mScripts.insert (std::make_pair (name, std::make_pair (code, mParser.getLocals())));
+                mScripts.insert (std::make_pair (name, CompiledScript (code, mParser.getLocals())));
+
+                if (mCache.get())
+                    mCache->add (name, script->mScriptText, code, mParser.getLocals());
 
                 return true;
             }
@@ -99,7 +126,7 @@ namespace MWScript
             {
                 // failed -> ignore script from now on.
                 std::vector<Interpreter::Type_Code> empty;
-                mScripts.insert (std::make_pair (name, std::make_pair (empty, Compiler::Locals())));
+                mScripts.insert (std::make_pair (name, CompiledScript (empty, Compiler::Locals())));
                 return;
             }
 
@@ -108,7 +135,8 @@ namespace MWScript
         }
 
         // execute script
-        if (!iter->second.first.empty())
+        CompiledScript& script = iter->second;
+        if (!script.mByteCode.empty())
             try
             {
                 if (!mOpcodesInstalled)
@@ -117,14 +145,18 @@ namespace MWScript
                     mOpcodesInstalled = true;
                 }
 
-                mInterpreter.run (&iter->second.first[0], iter->second.first.size(), interpreterContext);
+                if (script.mProgram.empty())
+                    mInterpreter.decode (&script.mByteCode[0], script.mByteCode.size(), script.mProgram);
+
+                mInterpreter.run (script.mProgram, interpreterContext);
             }
             catch (const std::exception& e)
             {
                 std::cerr << "Execution of script " << name << " failed:" << std::endl;
                 std::cerr << e.what() << std::endl;
 
-                iter->second.first.clear(); // don't execute again.
+                script.mByteCode.clear(); // don't execute again.
+                script.mProgram.clear();
             }
     }
 
@@ -157,7 +189,7 @@ namespace MWScript
             ScriptCollection::iterator iter = mScripts.find (name2);
 
             if (iter!=mScripts.end())
-                return iter->second.second;
+                return iter->second.mLocals;
         }
 
         {
@@ -191,4 +223,9 @@ namespace MWScript
     {
         return mGlobalScripts;
     }
+
+    ReferenceCache& ScriptManager::getReferenceCache()
+    {
+        return mReferenceCache;
+    }
 }
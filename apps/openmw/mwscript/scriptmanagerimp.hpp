@@ -2,6 +2,7 @@
 #define GAME_SCRIPT_SCRIPTMANAGER_H
 
 #include <map>
+#include <memory>
 #include <string>
 
 #include <components/compiler/streamerrorhandler.hpp>
@@ -9,10 +10,12 @@
 
 #include <components/interpreter/interpreter.hpp>
 #include <components/interpreter/types.hpp>
+#include <components/interpreter/program.hpp>
 
 #include "../mwbase/scriptmanager.hpp"
 
 #include "globalscripts.hpp"
+#include "referencecache.hpp"
 
 namespace MWWorld
 {
@@ -32,6 +35,8 @@ namespace Interpreter
 
 namespace MWScript
 {
+    class ScriptCache;
+
     class ScriptManager : public MWBase::ScriptManager
     {
             Compiler::StreamErrorHandler mErrorHandler;
@@ -41,13 +46,26 @@ namespace MWScript
             Interpreter::Interpreter mInterpreter;
             bool mOpcodesInstalled;
 
-            typedef std::pair<std::vector<Interpreter::Type_Code>, Compiler::Locals> CompiledScript;
+            struct CompiledScript
+            {
+                std::vector<Interpreter::Type_Code> mByteCode;
+                Compiler::Locals mLocals;
+
+                Interpreter::Program mProgram;
+                ///< Decoded from mByteCode on the first run.
+
+                CompiledScript (const std::vector<Interpreter::Type_Code>& byteCode, const Compiler::Locals& locals)
+                : mByteCode (byteCode), mLocals (locals) {}
+            };
+
             typedef std::map<std::string, CompiledScript> ScriptCollection;
 
             ScriptCollection mScripts;
             GlobalScripts mGlobalScripts;
+            ReferenceCache mReferenceCache;
             std::map<std::string, Compiler::Locals> mOtherLocals;
             std::vector<std::string> mScriptBlacklist;
+            std::auto_ptr<ScriptCache> mCache;
 
         public:
 
@@ -55,6 +73,12 @@ namespace MWScript
                 Compiler::Context& compilerContext, int warningsMode,
                 const std::vector<std::string>& scriptBlacklist);
 
+            virtual ~ScriptManager();
+            ///< Writes newly compiled scripts to the cache, if there is one.
+
+            void setCache (ScriptCache *cache);
+            ///< Use \a cache for compiled scripts. Ownership of \a cache is transferred.
+
             virtual void run (const std::string& name, Interpreter::Context& interpreterContext);
             ///< Run the script with the given name (compile first, if not compiled yet)
 
@@ -70,6 +94,8 @@ namespace MWScript
             ///< Return locals for script \a name.
 
             virtual GlobalScripts& getGlobalScripts();
+
+            virtual ReferenceCache& getReferenceCache();
     };
 }
 
@@ -338,20 +338,9 @@ namespace MWSound
         std::vector<std::string> filelist;
         if (mMusicFiles.find(mCurrentPlaylist) == mMusicFiles.end())
         {
-            const std::map<std::string, VFS::File*>& index = mVFS->getIndex();
-
-            std::string pattern = "Music/" + mCurrentPlaylist;
-            mVFS->normalizeFilename(pattern);
-
-            std::map<std::string, VFS::File*>::const_iterator found = index.lower_bound(pattern);
-            while (found != index.end())
-            {
-                if (found->first.size() >= pattern.size() && found->first.substr(0, pattern.size()) == pattern)
-                    filelist.push_back(found->first);
-                else
-                    break;
-                ++found;
-            }
+            VFS::RecursiveDirectoryRange files = mVFS->getRecursiveDirectoryIterator("Music/" + mCurrentPlaylist);
+            for (VFS::RecursiveDirectoryIterator it = files.begin(); it != files.end(); ++it)
+                filelist.push_back(*it);
 
             mMusicFiles[mCurrentPlaylist] = filelist;
 
@@ -1,11 +1,13 @@
 #include "cellpreloader.hpp"
 
 #include <iostream>
+#include <algorithm>
 
 #include <components/resource/scenemanager.hpp>
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/bulletshapemanager.hpp>
 #include <components/resource/keyframemanager.hpp>
+#include <components/resource/memoryusage.hpp>
 #include <components/misc/resourcehelpers.hpp>
 #include <components/misc/stringops.hpp>
 #include <components/nifosg/nifloader.hpp>
@@ -59,6 +61,7 @@ namespace MWWorld
             , mLandManager(landManager)
             , mPreloadInstances(preloadInstances)
             , mAbort(false)
+            , mMemoryUsage(0)
         {
             mTerrainView = mTerrain->createView();
 
@@ -145,6 +148,18 @@ namespace MWWorld
                     // error will be shown when visiting the cell
                 }
             }
+
+            Resource::MemoryUsage usage;
+            for (std::vector<osg::ref_ptr<const osg::Object> >::const_iterator it = mPreloadedObjects.begin(); it != mPreloadedObjects.end(); ++it)
+                usage.add(it->get());
+            mMemoryUsage = usage.getBytes();
+        }
+
+        /// Estimated memory used by the preloaded objects.
+        /// @note Only valid once the item is done.
+        size_t getMemoryUsage() const
+        {
+            return mMemoryUsage;
         }
 
     private:
@@ -166,6 +181,8 @@ namespace MWWorld
 
         // keep a ref to the loaded objects to make sure it stays loaded as long as this cell is in the preloaded state
         std::vector<osg::ref_ptr<const osg::Object> > mPreloadedObjects;
+
+        size_t mMemoryUsage;
     };
 
     /// Worker thread item: update the resource system's cache, effectively deleting unused entries.
@@ -188,6 +205,23 @@ namespace MWWorld
         Resource::ResourceSystem* mResourceSystem;
     };
 
+    CellPreloader::PreloadEntry::PreloadEntry()
+        : mTimeStamp(0.0)
+        , mScore(0.f)
+        , mPriority(0)
+        , mMemoryUsage(0)
+    {
+    }
+
+    CellPreloader::PreloadEntry::PreloadEntry(double timestamp, float score, int priority, osg::ref_ptr<PreloadItem> workItem)
+        : mTimeStamp(timestamp)
+        , mScore(score)
+        , mPriority(priority)
+        , mMemoryUsage(0)
+        , mWorkItem(workItem)
+    {
+    }
+
     CellPreloader::CellPreloader(Resource::ResourceSystem* resourceSystem, Resource::BulletShapeManager* bulletShapeManager, Terrain::World* terrain, MWRender::LandManager* landManager)
         : mResourceSystem(resourceSystem)
         , mBulletShapeManager(bulletShapeManager)
@@ -196,6 +230,8 @@ namespace MWWorld
         , mExpiryDelay(0.0)
         , mMinCacheSize(0)
         , mMaxCacheSize(0)
+        , mMaxCacheMemory(0)
+        , mCacheMemory(0)
         , mPreloadInstances(true)
         , mLastResourceCacheUpdate(0.0)
     {
@@ -205,7 +241,7 @@ namespace MWWorld
     {
         if (mTerrainPreloadItem)
         {
-            mTerrainPreloadItem->abort();
+            mTerrainPreloadItem->cancel();
             mTerrainPreloadItem->waitTillDone();
             mTerrainPreloadItem = NULL;
         }
@@ -217,7 +253,7 @@ namespace MWWorld
         }
 
         for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();++it)
-            it->second.mWorkItem->abort();
+            it->second.mWorkItem->cancel();
 
         for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();++it)
             it->second.mWorkItem->waitTillDone();
@@ -225,7 +261,7 @@ namespace MWWorld
         mPreloadCells.clear();
     }
 
-    void CellPreloader::preload(CellStore *cell, double timestamp)
+    void CellPreloader::preload(CellStore *cell, double timestamp, float score)
     {
         if (!mWorkQueue)
         {
@@ -238,96 +274,159 @@ namespace MWWorld
             return;
         }
 
+        score = std::max(0.f, std::min(1.f, score));
+
         PreloadMap::iterator found = mPreloadCells.find(cell);
         if (found != mPreloadCells.end())
         {
-            // already preloaded, nothing to do other than updating the timestamp
-            found->second.mTimeStamp = timestamp;
+            // already preloaded, nothing to do other than updating the timestamp and score
+            PreloadEntry& entry = found->second;
+            if (timestamp > entry.mTimeStamp)
+                entry.mScore = score;
+            else
+                entry.mScore = std::max(entry.mScore, score);
+            entry.mTimeStamp = timestamp;
+
+            // the cell became more important while its preload is still queued, so move it up the queue
+            // a preload that has already started is left to finish
+            int priority = getPriority(entry.mScore);
+            if (priority > entry.mPriority && mWorkQueue->setPriority(entry.mWorkItem, priority))
+                entry.mPriority = priority;
             return;
         }
 
-        while (mPreloadCells.size() >= mMaxCacheSize)
+        while (mPreloadCells.size() >= mMaxCacheSize || isOverMemoryBudget())
         {
-            // throw out oldest cell to make room
-            PreloadMap::iterator oldestCell = mPreloadCells.begin();
-            double oldestTimestamp = DBL_MAX;
-            double threshold = 1.0; // seconds
-            for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end(); ++it)
-            {
-                if (it->second.mTimeStamp < oldestTimestamp)
-                {
-                    oldestTimestamp = it->second.mTimeStamp;
-                    oldestCell = it;
-                }
-            }
-
-            if (oldestTimestamp + threshold < timestamp)
-            {
-                oldestCell->second.mWorkItem->abort();
-                mPreloadCells.erase(oldestCell);
-            }
+            // throw out the least important cell to make room
+            // if we are only over the memory budget, the cell has to be one that actually holds resources
+            bool finishedOnly = mPreloadCells.size() < mMaxCacheSize;
+            float evictionScore = 0.f;
+            PreloadMap::iterator leastImportant = findLeastImportant(timestamp, finishedOnly, evictionScore);
+
+            if (leastImportant != mPreloadCells.end() && evictionScore < score)
+                removeEntry(leastImportant);
             else
                 return;
         }
 
+        int priority = getPriority(score);
+        mPreloadCells[cell] = PreloadEntry(timestamp, score, priority, startPreload(cell, priority));
+    }
+
+    osg::ref_ptr<PreloadItem> CellPreloader::startPreload(CellStore *cell, int priority)
+    {
         osg::ref_ptr<PreloadItem> item (new PreloadItem(cell, mResourceSystem->getSceneManager(), mBulletShapeManager, mResourceSystem->getKeyframeManager(), mTerrain, mLandManager, mPreloadInstances));
-        mWorkQueue->addWorkItem(item);
+        mWorkQueue->addWorkItem(item, priority);
+        return item;
+    }
 
-        mPreloadCells[cell] = PreloadEntry(timestamp, item);
+    int CellPreloader::getPriority(float score)
+    {
+        // preloads always come after more urgent work, quantize the score so that small changes don't cause requeueing
+        static const int numLevels = 4;
+        int level = static_cast<int>(score * numLevels);
+        return SceneUtil::WorkQueue::Priority_Low + level * (-1 - SceneUtil::WorkQueue::Priority_Low) / numLevels;
     }
 
-    void CellPreloader::notifyLoaded(CellStore *cell)
+    float CellPreloader::getEvictionScore(const PreloadEntry& entry, double timestamp)
     {
-        PreloadMap::iterator found = mPreloadCells.find(cell);
-        if (found != mPreloadCells.end())
+        double threshold = 1.0; // seconds
+        if (entry.mTimeStamp + threshold < timestamp)
+            return -1.f - static_cast<float>(timestamp - entry.mTimeStamp);
+        return entry.mScore;
+    }
+
+    CellPreloader::PreloadMap::iterator CellPreloader::findLeastImportant(double timestamp, bool finishedOnly, float& evictionScore)
+    {
+        PreloadMap::iterator leastImportant = mPreloadCells.end();
+        for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end(); ++it)
         {
-            // do the deletion in the background thread
-            if (found->second.mWorkItem)
+            if (finishedOnly && it->second.mMemoryUsage == 0)
+                continue;
+
+            float score = getEvictionScore(it->second, timestamp);
+            if (leastImportant == mPreloadCells.end() || score < evictionScore)
             {
-                found->second.mWorkItem->abort();
-                mUnrefQueue->push(mPreloadCells[cell].mWorkItem);
+                evictionScore = score;
+                leastImportant = it;
             }
-
-            mPreloadCells.erase(found);
         }
+        return leastImportant;
     }
 
-    void CellPreloader::clear()
+    void CellPreloader::removeEntry(PreloadMap::iterator it)
     {
-        for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();)
+        // do the deletion in the background thread
+        if (it->second.mWorkItem)
         {
-            if (it->second.mWorkItem)
-            {
-                it->second.mWorkItem->abort();
-                mUnrefQueue->push(it->second.mWorkItem);
-            }
+            it->second.mWorkItem->cancel();
+            mUnrefQueue->push(it->second.mWorkItem);
+        }
+        mCacheMemory -= it->second.mMemoryUsage;
+        mPreloadCells.erase(it);
+    }
+
+    bool CellPreloader::isOverMemoryBudget() const
+    {
+        return mMaxCacheMemory != 0 && mCacheMemory > mMaxCacheMemory;
+    }
 
-            mPreloadCells.erase(it++);
+    void CellPreloader::enforceMemoryBudget(double timestamp)
+    {
+        while (isOverMemoryBudget())
+        {
+            float evictionScore = 0.f;
+            PreloadMap::iterator leastImportant = findLeastImportant(timestamp, true, evictionScore);
+            if (leastImportant == mPreloadCells.end())
+                break;
+            removeEntry(leastImportant);
         }
     }
 
+    void CellPreloader::notifyLoaded(CellStore *cell)
+    {
+        PreloadMap::iterator found = mPreloadCells.find(cell);
+        if (found != mPreloadCells.end())
+            removeEntry(found);
+    }
+
+    void CellPreloader::clear()
+    {
+        for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();)
+            removeEntry(it++);
+    }
+
     void CellPreloader::updateCache(double timestamp)
     {
+        // cells not requested for this long have fallen out of the set of preload candidates
+        double cancelDelay = 0.5; // seconds
+
         for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();)
         {
-            if (mPreloadCells.size() >= mMinCacheSize && it->second.mTimeStamp < timestamp - mExpiryDelay)
+            PreloadEntry& entry = it->second;
+            bool done = entry.mWorkItem->isDone();
+            if (done && entry.mMemoryUsage == 0)
             {
-                if (it->second.mWorkItem)
-                {
-                    it->second.mWorkItem->abort();
-                    mUnrefQueue->push(it->second.mWorkItem);
-                }
-                mPreloadCells.erase(it++);
+                entry.mMemoryUsage = entry.mWorkItem->getMemoryUsage();
+                mCacheMemory += entry.mMemoryUsage;
             }
+
+            if (mPreloadCells.size() >= mMinCacheSize && entry.mTimeStamp < timestamp - mExpiryDelay)
+                removeEntry(it++);
+            else if (!done && entry.mTimeStamp < timestamp - cancelDelay)
+                // don't hold up the worker threads with cells we are moving away from
+                removeEntry(it++);
             else
                 ++it;
         }
 
+        enforceMemoryBudget(timestamp);
+
         if (timestamp - mLastResourceCacheUpdate > 1.0 && (!mUpdateCacheItem || mUpdateCacheItem->isDone()))
         {
             // the resource cache is cleared from the worker thread so that we're not holding up the main thread with delete operations
             mUpdateCacheItem = new UpdateCacheItem(mResourceSystem, timestamp);
-            mWorkQueue->addWorkItem(mUpdateCacheItem, true);
+            mWorkQueue->addWorkItem(mUpdateCacheItem, SceneUtil::WorkQueue::Priority_High);
             mLastResourceCacheUpdate = timestamp;
         }
     }
@@ -347,6 +446,11 @@ namespace MWWorld
         mMaxCacheSize = num;
     }
 
+    void CellPreloader::setMaxCacheMemory(size_t bytes)
+    {
+        mMaxCacheMemory = bytes;
+    }
+
     void CellPreloader::setPreloadInstances(bool preload)
     {
         mPreloadInstances = preload;
@@ -423,7 +527,7 @@ namespace MWWorld
             // right now, we just use it to make sure the resources are preloaded
             mTerrainPreloadPositions = positions;
             mTerrainPreloadItem = new TerrainPreloadItem(mTerrainViews, mTerrain, positions);
-            mWorkQueue->addWorkItem(mTerrainPreloadItem);
+            mWorkQueue->addWorkItem(mTerrainPreloadItem, SceneUtil::WorkQueue::Priority_Low);
         }
     }
 
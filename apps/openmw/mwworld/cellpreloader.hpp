@@ -31,6 +31,7 @@ namespace MWRender
 namespace MWWorld
 {
     class CellStore;
+    class PreloadItem;
 
     class CellPreloader
     {
@@ -39,14 +40,17 @@ namespace MWWorld
         ~CellPreloader();
 
         /// Ask a background thread to preload rendering meshes and collision shapes for objects in this cell.
+        /// @param score How likely the cell is to be needed soon, in the range [0, 1]. Decides the order in which
+        /// cells are preloaded and which cells are thrown out first when the cache is full.
         /// @note The cell itself must be in State_Loaded or State_Preloaded.
-        void preload(MWWorld::CellStore* cell, double timestamp);
+        void preload(MWWorld::CellStore* cell, double timestamp, float score=1.f);
 
         void notifyLoaded(MWWorld::CellStore* cell);
 
         void clear();
 
-        /// Removes preloaded cells that have not had a preload request for a while.
+        /// Removes preloaded cells that have not had a preload request for a while, cancels preloads of cells
+        /// that are no longer requested and enforces the memory budget.
         void updateCache(double timestamp);
 
         /// How long to keep a preloaded cell in cache after it's no longer requested.
@@ -58,6 +62,9 @@ namespace MWWorld
         /// The maximum number of preloaded cells.
         void setMaxCacheSize(unsigned int num);
 
+        /// The maximum estimated memory, in bytes, used by the resources of the preloaded cells. 0 means no limit.
+        void setMaxCacheMemory(size_t bytes);
+
         /// Enables the creation of instances in the preloading thread.
         void setPreloadInstances(bool preload);
 
@@ -79,27 +86,46 @@ namespace MWWorld
         double mExpiryDelay;
         unsigned int mMinCacheSize;
         unsigned int mMaxCacheSize;
+        size_t mMaxCacheMemory;
+        size_t mCacheMemory;
         bool mPreloadInstances;
 
         double mLastResourceCacheUpdate;
 
         struct PreloadEntry
         {
-            PreloadEntry(double timestamp, osg::ref_ptr<SceneUtil::WorkItem> workItem)
-                : mTimeStamp(timestamp)
-                , mWorkItem(workItem)
-            {
-            }
-            PreloadEntry()
-                : mTimeStamp(0.0)
-            {
-            }
+            PreloadEntry(double timestamp, float score, int priority, osg::ref_ptr<PreloadItem> workItem);
+            PreloadEntry();
 
             double mTimeStamp;
-            osg::ref_ptr<SceneUtil::WorkItem> mWorkItem;
+            // The highest score of the preload requests at mTimeStamp
+            float mScore;
+            // The priority mWorkItem was queued with
+            int mPriority;
+            // Estimated memory used by the preloaded resources, known once mWorkItem is done
+            size_t mMemoryUsage;
+            osg::ref_ptr<PreloadItem> mWorkItem;
         };
         typedef std::map<const MWWorld::CellStore*, PreloadEntry> PreloadMap;
 
+        /// Map a preload score to a work queue priority.
+        static int getPriority(float score);
+
+        /// Score used to decide which entry to throw out first. Entries that have not been requested for a while come first.
+        static float getEvictionScore(const PreloadEntry& entry, double timestamp);
+
+        /// @param finishedOnly Only consider entries that are done preloading, i.e. that use memory.
+        /// @return The entry with the lowest eviction score, or mPreloadCells.end().
+        PreloadMap::iterator findLeastImportant(double timestamp, bool finishedOnly, float& evictionScore);
+
+        osg::ref_ptr<PreloadItem> startPreload(MWWorld::CellStore* cell, int priority);
+
+        void removeEntry(PreloadMap::iterator it);
+
+        bool isOverMemoryBudget() const;
+
+        void enforceMemoryBudget(double timestamp);
+
         // Cells that are currently being preloaded, or have already finished preloading
         PreloadMap mPreloadCells;
 
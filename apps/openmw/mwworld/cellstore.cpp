@@ -942,9 +942,9 @@ namespace MWWorld
         return mPathgridGraph.isPointConnected(start, end);
     }
 
-    std::list<ESM::Pathgrid::Point> CellStore::aStarSearch(const int start, const int end) const
+    void CellStore::aStarSearch(const int start, const int end, std::vector<ESM::Pathgrid::Point>& path) const
     {
-        return mPathgridGraph.aStarSearch(start, end);
+        mPathgridGraph.aStarSearch(start, end, path);
     }
 
     void CellStore::setFog(ESM::FogState *fog)
@@ -379,7 +379,7 @@ namespace MWWorld
 
             bool isPointConnected(const int start, const int end) const;
 
-            std::list<ESM::Pathgrid::Point> aStarSearch(const int start, const int end) const;
+            void aStarSearch(const int start, const int end, std::vector<ESM::Pathgrid::Point>& path) const;
 
         private:
 
@@ -0,0 +1,204 @@
+#include "contentcache.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/esm/esmreader.hpp>
+#include <components/esm/esmwriter.hpp>
+
+namespace
+{
+    // Increase when the layout of the cache or of any cached record changes
+    const int sCacheFormat = 2;
+}
+
+namespace MWWorld
+{
+
+    ContentCache::ContentCache(const boost::filesystem::path& cacheFile, int encoding, const std::string& engineVersion)
+        : mCacheFile(cacheFile)
+        , mEncoding(encoding)
+        , mEngineVersion(engineVersion)
+    {
+    }
+
+    void ContentCache::addContentFile(const boost::filesystem::path& file)
+    {
+        ContentFile contentFile;
+        contentFile.mPath = file.string();
+        contentFile.mSize = boost::filesystem::file_size(file);
+        contentFile.mModified = boost::filesystem::last_write_time(file);
+        mContentFiles.push_back(contentFile);
+    }
+
+    bool ContentCache::readKey(ESM::ESMReader& reader)
+    {
+        if (reader.getRecName() != "CKEY")
+            return false;
+        reader.getRecHeader();
+
+        int format = 0;
+        reader.getHNT(format, "FORM");
+        if (format != sCacheFormat)
+            return false;
+        std::string engineVersion = reader.getHNString("VERS");
+        int encoding = 0;
+        reader.getHNT(encoding, "ENCO");
+        int count = 0;
+        reader.getHNT(count, "COUN");
+
+        if (engineVersion != mEngineVersion || encoding != mEncoding || count != static_cast<int>(mContentFiles.size()))
+            return false;
+
+        for (std::vector<ContentFile>::const_iterator it = mContentFiles.begin(); it != mContentFiles.end(); ++it)
+        {
+            std::string path = reader.getHNString("FILE");
+            int64_t size = reader.getHNLong("SIZE");
+            int64_t modified = reader.getHNLong("TIME");
+
+            if (path != it->mPath || size != it->mSize || modified != it->mModified)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool ContentCache::read(ESMStore& store, std::vector<DeferredRecords>& deferred,
+                            std::vector<ESM::ESMReader>& readers, bool mapped, Loading::Listener* listener)
+    {
+        if (!boost::filesystem::exists(mCacheFile))
+            return false;
+
+        ESM::ESMReader reader;
+        reader.setGlobalReaderList(&readers);
+        reader.setMemoryMapped(mapped);
+
+        try
+        {
+            reader.open(mCacheFile.string());
+            if (!readKey(reader))
+            {
+                std::cout << "Content cache " << mCacheFile.string() << " is out of date, rebuilding" << std::endl;
+                return false;
+            }
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to read content cache " << mCacheFile.string() << ", rebuilding: " << e.what() << std::endl;
+            return false;
+        }
+
+        try
+        {
+            deferred.clear();
+            deferred.resize(mContentFiles.size());
+            for (size_t i = 0; i < mContentFiles.size(); ++i)
+            {
+                if (reader.getRecName() != "CDEF")
+                    reader.fail("Expected list of deferred records");
+                reader.getRecHeader();
+
+                reader.getSubNameIs("DATA");
+                reader.getSubHeader();
+
+                size_t count = reader.getSubSize() / (2 * sizeof(uint32_t));
+                deferred[i].reserve(count);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    uint32_t type;
+                    uint32_t offset;
+                    reader.getT(type);
+                    reader.getT(offset);
+
+                    StagedContent::Entry entry;
+                    entry.mType = static_cast<int>(type);
+                    entry.mOffset = offset;
+                    entry.mRecord = NULL;
+                    deferred[i].push_back(entry);
+                }
+            }
+
+            // The rest of the file is regular records
+            store.load(reader, listener);
+        }
+        catch (std::exception& e)
+        {
+            // The store is already partially filled, so we can't fall back to the content files here
+            reader.close();
+            boost::filesystem::remove(mCacheFile);
+            throw std::runtime_error("Failed to read content cache " + mCacheFile.string() + ": " + e.what()
+                                     + "\nThe cache has been removed and will be rebuilt on the next start.");
+        }
+
+        return true;
+    }
+
+    void ContentCache::write(const ESMStore& store, const std::vector<DeferredRecords>& deferred)
+    {
+        // Write to a temporary file first, so that an interrupted write never leaves a damaged cache behind
+        boost::filesystem::path tempFile = mCacheFile.string() + ".tmp";
+
+        try
+        {
+            if (mCacheFile.has_parent_path())
+                boost::filesystem::create_directories(mCacheFile.parent_path());
+
+            boost::filesystem::ofstream stream(tempFile, std::ios::binary);
+            if (!stream.is_open())
+                throw std::runtime_error("Failed to open " + tempFile.string() + " for writing");
+
+            ESM::ESMWriter writer;
+            writer.setFormat(0);
+            writer.setAuthor("OpenMW");
+            writer.setDescription("Content cache");
+            writer.save(stream);
+
+            writer.startRecord("CKEY");
+            writer.writeHNT("FORM", sCacheFormat);
+            writer.writeHNString("VERS", mEngineVersion);
+            writer.writeHNT("ENCO", mEncoding);
+            writer.writeHNT("COUN", static_cast<int>(mContentFiles.size()));
+            for (std::vector<ContentFile>::const_iterator it = mContentFiles.begin(); it != mContentFiles.end(); ++it)
+            {
+                writer.writeHNString("FILE", it->mPath);
+                writer.writeHNT("SIZE", it->mSize);
+                writer.writeHNT("TIME", it->mModified);
+            }
+            writer.endRecord("CKEY");
+
+            for (std::vector<DeferredRecords>::const_iterator it = deferred.begin(); it != deferred.end(); ++it)
+            {
+                writer.startRecord("CDEF");
+                writer.startSubRecord("DATA");
+                for (DeferredRecords::const_iterator entry = it->begin(); entry != it->end(); ++entry)
+                {
+                    writer.writeT(static_cast<uint32_t>(entry->mType));
+                    writer.writeT(static_cast<uint32_t>(entry->mOffset));
+                }
+                writer.endRecord("DATA");
+                writer.endRecord("CDEF");
+            }
+
+            store.writeStatic(writer);
+
+            writer.close();
+            stream.close();
+
+            boost::filesystem::rename(tempFile, mCacheFile);
+
+            std::cout << "Wrote content cache " << mCacheFile.string() << std::endl;
+        }
+        catch (std::exception& e)
+        {
+            // Not fatal, the content files will just be loaded again next time
+            std::cerr << "Failed to write content cache " << mCacheFile.string() << ": " << e.what() << std::endl;
+
+            boost::system::error_code ec;
+            boost::filesystem::remove(tempFile, ec);
+        }
+    }
+
+}
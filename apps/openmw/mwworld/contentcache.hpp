@@ -0,0 +1,72 @@
+#ifndef GAME_MWWORLD_CONTENTCACHE_H
+#define GAME_MWWORLD_CONTENTCACHE_H
+
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+#include "esmstore.hpp"
+
+namespace ESM
+{
+    class ESMReader;
+}
+
+namespace MWWorld
+{
+
+    /// @brief On-disk cache of the records of a fixed list of content files.
+    ///
+    /// The cache holds the merged result of all records that ESMStore::stage() parses, in the
+    /// ESM format, as well as the list of deferred records for each content file. On a hit,
+    /// the merged records are read back from the single cache file and only the deferred
+    /// records are loaded from the content files themselves.
+    ///
+    /// The cache is keyed by the paths, sizes and modification times of the content files,
+    /// the encoding of the content files and the engine version, so that a cache written by
+    /// a different build, whose record loaders may differ, is never used.
+    ///
+    /// @note The deferred records are not cached, they are still read from the content files
+    /// on every start.
+    class ContentCache
+    {
+    public:
+        typedef std::vector<StagedContent::Entry> DeferredRecords;
+
+        /// @param engineVersion Version and revision of the engine, see Version::getOpenmwVersion.
+        ContentCache(const boost::filesystem::path& cacheFile, int encoding, const std::string& engineVersion);
+
+        void addContentFile(const boost::filesystem::path& file);
+
+        /// Check if the cache file is valid for the added content files, and if so, load the
+        /// cached records into \a store.
+        /// @param deferred Receives the deferred records for each content file, in load order.
+        /// @param readers List of all readers, used for setting up the cache reader.
+        /// @return Was the cache valid?
+        /// @note Throws an exception and removes the cache file if it is damaged.
+        bool read(ESMStore& store, std::vector<DeferredRecords>& deferred,
+                  std::vector<ESM::ESMReader>& readers, bool mapped, Loading::Listener* listener);
+
+        /// Replace the cache file with the current contents of \a store.
+        /// @param deferred The deferred records for each content file, in load order.
+        void write(const ESMStore& store, const std::vector<DeferredRecords>& deferred);
+
+    private:
+        struct ContentFile
+        {
+            std::string mPath;
+            int64_t mSize;
+            int64_t mModified;
+        };
+
+        bool readKey(ESM::ESMReader& reader);
+
+        boost::filesystem::path mCacheFile;
+        int mEncoding;
+        std::string mEngineVersion;
+        std::vector<ContentFile> mContentFiles;
+    };
+
+}
+
+#endif
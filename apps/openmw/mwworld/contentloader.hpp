@@ -27,6 +27,11 @@ struct ContentLoader
       mListener.setLabel(filepath.string());
     }
 
+    /// Called after the last content file has been passed to load().
+    virtual void finish()
+    {
+    }
+
     protected:
         Loading::Listener& mListener;
 };
@@ -1,18 +1,98 @@
 #include "esmloader.hpp"
 #include "esmstore.hpp"
+#include "contentcache.hpp"
+
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
 
 #include <components/esm/esmreader.hpp>
+#include <components/settings/settings.hpp>
+#include <components/sceneutil/workqueue.hpp>
+#include <components/to_utf8/to_utf8.hpp>
 
 namespace MWWorld
 {
 
+/// Parses the records of one content file in a background thread.
+class StageContentWorkItem : public SceneUtil::WorkItem
+{
+public:
+    StageContentWorkItem(const ESMStore& store, ESM::ESMReader& reader, ToUTF8::Utf8Encoder* encoder)
+        : mStore(store)
+        , mReader(reader)
+        , mEncoder(encoder)
+        , mParseTime(0.0)
+    {
+    }
+
+    virtual void doWork()
+    {
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+        // The encoder has an internal buffer, so each thread needs its own copy
+        std::auto_ptr<ToUTF8::Utf8Encoder> encoder;
+        if (mEncoder)
+        {
+            encoder.reset(new ToUTF8::Utf8Encoder(*mEncoder));
+            mReader.setEncoder(encoder.get());
+        }
+
+        try
+        {
+            mStore.stage(mReader, mContent);
+        }
+        catch (std::exception& e)
+        {
+            mError = e.what();
+        }
+
+        mReader.setEncoder(mEncoder);
+
+        mParseTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+    }
+
+    ESM::ESMReader& getReader() { return mReader; }
+    StagedContent& getContent() { return mContent; }
+    const std::string& getError() const { return mError; }
+    double getParseTime() const { return mParseTime; }
+
+private:
+    const ESMStore& mStore;
+    ESM::ESMReader& mReader;
+    ToUTF8::Utf8Encoder* mEncoder;
+
+    StagedContent mContent;
+    std::string mError;
+    double mParseTime;
+};
+
 EsmLoader::EsmLoader(MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& readers,
-  ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener)
+  ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener, const boost::filesystem::path& cachePath,
+  const std::string& engineVersion)
   : ContentLoader(listener)
   , mEsm(readers)
   , mStore(store)
   , mEncoder(encoder)
+  , mUseMappedFiles(Settings::Manager::getBool("memory mapped files", "Content"))
+  , mNumFiles(0)
+  , mParseTime(0.0)
+  , mMergeTime(0.0)
+  , mStartTick(osg::Timer::instance()->tick())
+{
+    int numThreads = Settings::Manager::getInt("loading threads", "Content");
+    if (numThreads > 0)
+        mWorkQueue = new SceneUtil::WorkQueue(numThreads);
+
+    if (Settings::Manager::getBool("content cache", "Content"))
+        mCache.reset(new ContentCache(cachePath / "content.cache", encoder ? encoder->getEncoding() : -1, engineVersion));
+}
+
+EsmLoader::~EsmLoader()
 {
+    // Joins the worker threads, so that no file is still being read when the readers go away
+    mWorkQueue = NULL;
 }
 
 void EsmLoader::load(const boost::filesystem::path& filepath, int& index)
@@ -23,9 +103,159 @@ void EsmLoader::load(const boost::filesystem::path& filepath, int& index)
   lEsm.setEncoder(mEncoder);
   lEsm.setIndex(index);
   lEsm.setGlobalReaderList(&mEsm);
+  lEsm.setMemoryMapped(mUseMappedFiles);
   lEsm.open(filepath.string());
   mEsm[index] = lEsm;
-  mStore.load(mEsm[index], &mListener);
+  ++mNumFiles;
+
+  if (mCache.get())
+  {
+    // Whether the cache can be used is only known once all content files are known
+    mCache->addContentFile(filepath);
+    mCachedFiles.push_back(index);
+    return;
+  }
+
+  loadContent(index);
+}
+
+void EsmLoader::loadContent(int index)
+{
+  ESM::ESMReader& esm = mEsm[index];
+
+  if (!mWorkQueue)
+  {
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    if (mCache.get())
+    {
+      // Go through the staging steps to find out which records the cache can't hold
+      mStore.prepareLoad(esm);
+      StagedContent content;
+      mStore.stage(esm, content);
+      mStore.merge(esm, content, &mListener);
+      mDeferred[index].swap(content.mEntries);
+    }
+    else
+      mStore.load(esm, &mListener);
+
+    double loadTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+    mMergeTime += loadTime;
+
+    std::ostringstream stream;
+    stream << "Loaded " << boost::filesystem::path(esm.getName()).filename().string() << " in "
+           << std::fixed << std::setprecision(1) << loadTime * 1000.0 << " ms";
+    std::cout << stream.str() << std::endl;
+    return;
+  }
+
+  // Masters have to be resolved in load order, before the records are parsed
+  mStore.prepareLoad(esm);
+
+  osg::ref_ptr<StageContentWorkItem> item = new StageContentWorkItem(mStore, esm, mEncoder);
+  mWorkQueue->addWorkItem(item);
+  mStaged.push_back(item);
+
+  // Merge whatever is ready while the rest is still being parsed
+  mergeStaged(false);
+}
+
+bool EsmLoader::loadFromCache()
+{
+  std::vector<ContentCache::DeferredRecords> deferred;
+  if (!mCache->read(mStore, deferred, mEsm, mUseMappedFiles, &mListener))
+    return false;
+
+  // Records the cache can't hold are still read from the content files
+  for (size_t i = 0; i < mCachedFiles.size(); ++i)
+  {
+    ESM::ESMReader& esm = mEsm[mCachedFiles[i]];
+    mListener.setLabel(boost::filesystem::path(esm.getName()).filename().string());
+
+    mStore.prepareLoad(esm);
+    StagedContent content;
+    content.mEntries.swap(deferred[i]);
+    mStore.merge(esm, content, &mListener);
+  }
+
+  return true;
+}
+
+void EsmLoader::finish()
+{
+  if (mNumFiles == 0)
+    return;
+
+  bool cacheHit = false;
+  if (mCache.get())
+  {
+    cacheHit = loadFromCache();
+    if (!cacheHit)
+    {
+      mDeferred.clear();
+      mDeferred.resize(mEsm.size());
+      for (std::vector<int>::const_iterator it = mCachedFiles.begin(); it != mCachedFiles.end(); ++it)
+        loadContent(*it);
+    }
+  }
+
+  mergeStaged(true);
+
+  if (mCache.get() && !cacheHit)
+  {
+    std::vector<ContentCache::DeferredRecords> deferred;
+    for (std::vector<int>::const_iterator it = mCachedFiles.begin(); it != mCachedFiles.end(); ++it)
+      deferred.push_back(mDeferred[*it]);
+    mCache->write(mStore, deferred);
+  }
+
+  double totalTime = osg::Timer::instance()->delta_s(mStartTick, osg::Timer::instance()->tick());
+
+  std::ostringstream stream;
+  stream << "Loaded " << mNumFiles << " content files" << (cacheHit ? " from cache" : "") << " in "
+         << std::fixed << std::setprecision(1) << totalTime * 1000.0 << " ms";
+  if (mWorkQueue && !cacheHit)
+    stream << " (parse " << mParseTime * 1000.0 << " ms, merge " << mMergeTime * 1000.0 << " ms)";
+  std::cout << stream.str() << std::endl;
+
+  mNumFiles = 0;
+  mCachedFiles.clear();
+  mDeferred.clear();
+}
+
+void EsmLoader::mergeStaged(bool wait)
+{
+  while (!mStaged.empty())
+  {
+    osg::ref_ptr<StageContentWorkItem> item = mStaged.front();
+    if (!wait && !item->isDone())
+      return;
+
+    item->waitTillDone();
+    mStaged.pop_front();
+
+    ESM::ESMReader& esm = item->getReader();
+    if (!item->getError().empty())
+      throw std::runtime_error(item->getError());
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    std::string filename = boost::filesystem::path(esm.getName()).filename().string();
+    mListener.setLabel(filename);
+    mStore.merge(esm, item->getContent(), &mListener);
+    if (mCache.get())
+      mDeferred[esm.getIndex()].swap(item->getContent().mEntries);
+
+    double mergeTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+    mParseTime += item->getParseTime();
+    mMergeTime += mergeTime;
+
+    std::ostringstream stream;
+    stream << "Loaded " << filename << ": " << item->getContent().mEntries.size() << " records parsed in "
+           << std::fixed << std::setprecision(1) << item->getParseTime() * 1000.0 << " ms, merged in "
+           << mergeTime * 1000.0 << " ms";
+    std::cout << stream.str() << std::endl;
+  }
 }
 
 } /* namespace MWWorld */
@@ -2,8 +2,14 @@
 #define ESMLOADER_HPP
 
 #include <vector>
+#include <deque>
+#include <memory>
+
+#include <osg/ref_ptr>
+#include <osg/Timer>
 
 #include "contentloader.hpp"
+#include "esmstore.hpp"
 
 namespace ToUTF8
 {
@@ -15,22 +21,61 @@ namespace ESM
     class ESMReader;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace MWWorld
 {
 
-class ESMStore;
+class StageContentWorkItem;
+class ContentCache;
 
+/// @note If the [Content] 'loading threads' setting is non-zero, content files are parsed in
+/// background threads and merged into the ESMStore in load order as they become ready.
+/// finish() must be called after the last file to merge the remaining files.
+/// @note If the [Content] 'content cache' setting is enabled, all loading is postponed to finish(),
+/// where the records are loaded from the cache in \a cachePath if it matches the content files
+/// and \a engineVersion.
 struct EsmLoader : public ContentLoader
 {
     EsmLoader(MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& readers,
-      ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener);
+      ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener, const boost::filesystem::path& cachePath,
+      const std::string& engineVersion);
+    ~EsmLoader();
 
     void load(const boost::filesystem::path& filepath, int& index);
 
+    void finish();
+
     private:
+      /// Load the content file with the given index, or queue it to be parsed.
+      void loadContent(int index);
+
+      /// @return Was the cache valid?
+      bool loadFromCache();
+
+      /// Merge parsed files in load order.
+      /// @param wait Wait for all files to be parsed, instead of stopping at the first file that isn't ready.
+      void mergeStaged(bool wait);
+
       std::vector<ESM::ESMReader>& mEsm;
       MWWorld::ESMStore& mStore;
       ToUTF8::Utf8Encoder* mEncoder;
+      bool mUseMappedFiles;
+
+      osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+      std::deque<osg::ref_ptr<StageContentWorkItem> > mStaged;
+
+      std::auto_ptr<ContentCache> mCache;
+      std::vector<int> mCachedFiles;
+      std::vector<std::vector<StagedContent::Entry> > mDeferred;
+
+      size_t mNumFiles;
+      double mParseTime;
+      double mMergeTime;
+      osg::Timer_t mStartTick;
 };
 
 } /* namespace MWWorld */
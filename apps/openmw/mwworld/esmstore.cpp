@@ -27,12 +27,14 @@ static bool isCacheableRecord(int id)
     return false;
 }
 
-void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
+StagedContent::~StagedContent()
 {
-    listener->setProgressRange(1000);
-
-    ESM::Dialogue *dialogue = 0;
+    for (std::vector<Entry>::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+        delete it->mRecord;
+}
 
+void ESMStore::prepareLoad(ESM::ESMReader &esm)
+{
     // Land texture loading needs to use a separate internal store for each plugin.
     // We set the number of plugins here to avoid continual resizes during loading,
     // and so we can properly verify if valid plugin indices are being passed to the
@@ -50,7 +52,8 @@ void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
         std::string fname = mast.name;
         int index = ~0;
         for (int i = 0; i < esm.getIndex(); i++) {
-            const std::string &candidate = allPlugins->at(i).getContext().filename;
+            // Don't use getContext() here, earlier files might still be read by another thread
+            const std::string &candidate = allPlugins->at(i).getName();
             std::string fnamecandidate = boost::filesystem::path(candidate).filename().string();
             if (Misc::StringUtils::ciEqual(fname, fnamecandidate)) {
                 index = i;
@@ -66,6 +69,15 @@ void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
         }
         mast.index = index;
     }
+}
+
+void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
+{
+    listener->setProgressRange(1000);
+
+    ESM::Dialogue *dialogue = 0;
+
+    prepareLoad(esm);
 
     // Loop through all records
     while(esm.hasMoreRecs())
@@ -73,51 +85,155 @@ void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
         ESM::NAME n = esm.getRecName();
         esm.getRecHeader();
 
-        // Look up the record type.
-        std::map<int, StoreBase *>::iterator it = mStores.find(n.intval);
+        loadRecord(esm, n, dialogue);
 
-        if (it == mStores.end()) {
-            if (n.intval == ESM::REC_INFO) {
-                if (dialogue)
-                {
-                    dialogue->readInfo(esm, esm.getIndex() != 0);
-                }
-                else
-                {
-                    std::cerr << "error: info record without dialog" << std::endl;
-                    esm.skipRecord();
-                }
-            } else if (n.intval == ESM::REC_MGEF) {
-                mMagicEffects.load (esm);
-            } else if (n.intval == ESM::REC_SKIL) {
-                mSkills.load (esm);
+        listener->setProgress(static_cast<size_t>(esm.getFileOffset() / (float)esm.getFileSize() * 1000));
+    }
+}
+
+void ESMStore::loadRecord(ESM::ESMReader &esm, ESM::NAME n, ESM::Dialogue *&dialogue)
+{
+    // Look up the record type.
+    std::map<int, StoreBase *>::iterator it = mStores.find(n.intval);
+
+    if (it == mStores.end()) {
+        if (n.intval == ESM::REC_INFO) {
+            if (dialogue)
+            {
+                dialogue->readInfo(esm, esm.getIndex() != 0);
             }
-            else if (n.intval==ESM::REC_FILT || n.intval == ESM::REC_DBGP)
+            else
             {
-                // ignore project file only records
+                std::cerr << "error: info record without dialog" << std::endl;
                 esm.skipRecord();
             }
-            else {
-                std::stringstream error;
-                error << "Unknown record: " << n.toString();
-                throw std::runtime_error(error.str());
-            }
+        } else if (n.intval == ESM::REC_MGEF) {
+            mMagicEffects.load (esm);
+        } else if (n.intval == ESM::REC_SKIL) {
+            mSkills.load (esm);
+        }
+        else if (n.intval==ESM::REC_FILT || n.intval == ESM::REC_DBGP)
+        {
+            // ignore project file only records
+            esm.skipRecord();
+        }
+        else {
+            std::stringstream error;
+            error << "Unknown record: " << n.toString();
+            throw std::runtime_error(error.str());
+        }
+    } else {
+        RecordId id = it->second->load(esm);
+        if (id.mIsDeleted)
+        {
+            it->second->eraseStatic(id.mId);
+            return;
+        }
+
+        if (n.intval==ESM::REC_DIAL) {
+            dialogue = const_cast<ESM::Dialogue*>(mDialogs.find(id.mId));
         } else {
-            RecordId id = it->second->load(esm);
+            dialogue = 0;
+        }
+    }
+}
+
+void ESMStore::stage(ESM::ESMReader &esm, StagedContent &content) const
+{
+    while(esm.hasMoreRecs())
+    {
+        StagedContent::Entry entry;
+        entry.mOffset = esm.getFileOffset();
+
+        ESM::NAME n = esm.getRecName();
+        esm.getRecHeader();
+
+        entry.mType = n.intval;
+        entry.mRecord = NULL;
+
+        std::map<int, StoreBase *>::const_iterator it = mStores.find(n.intval);
+        if (it != mStores.end())
+            entry.mRecord = it->second->parse(esm);
+        else if (n.intval==ESM::REC_FILT || n.intval == ESM::REC_DBGP)
+        {
+            // ignore project file only records
+            esm.skipRecord();
+            continue;
+        }
+        else if (n.intval != ESM::REC_INFO && n.intval != ESM::REC_MGEF && n.intval != ESM::REC_SKIL)
+        {
+            std::stringstream error;
+            error << "Unknown record: " << n.toString();
+            throw std::runtime_error(error.str());
+        }
+
+        // Deferred records are read again in merge()
+        if (!entry.mRecord)
+            esm.skipRecord();
+
+        content.mEntries.push_back(entry);
+    }
+}
+
+void ESMStore::merge(ESM::ESMReader &esm, StagedContent &content, Loading::Listener* listener)
+{
+    listener->setProgressRange(1000);
+
+    ESM::Dialogue *dialogue = 0;
+
+    ESM::ESM_Context context = esm.getContext();
+
+    std::vector<StagedContent::Entry> deferred;
+
+    const size_t count = content.mEntries.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        StagedContent::Entry &entry = content.mEntries[i];
+
+        if (entry.mRecord)
+        {
+            StoreBase *store = mStores[entry.mType];
+            RecordId id = store->merge(*entry.mRecord);
+
+            delete entry.mRecord;
+            entry.mRecord = NULL;
+
             if (id.mIsDeleted)
+                store->eraseStatic(id.mId);
+            else
+                dialogue = 0;
+        }
+        else
+        {
+            // Seek to the deferred record, unless the previous one was deferred as well
+            if (esm.getFileOffset() != entry.mOffset)
             {
-                it->second->eraseStatic(id.mId);
-                continue;
+                context.filePos = entry.mOffset;
+                context.leftFile = esm.getFileSize() - entry.mOffset;
+                context.leftRec = 0;
+                context.leftSub = 0;
+                context.subCached = false;
+                esm.restoreContext(context);
             }
 
-            if (n.intval==ESM::REC_DIAL) {
-                dialogue = const_cast<ESM::Dialogue*>(mDialogs.find(id.mId));
-            } else {
-                dialogue = 0;
-            }
+            ESM::NAME n = esm.getRecName();
+            esm.getRecHeader();
+
+            loadRecord(esm, n, dialogue);
+
+            deferred.push_back(entry);
         }
-        listener->setProgress(static_cast<size_t>(esm.getFileOffset() / (float)esm.getFileSize() * 1000));
+
+        listener->setProgress(static_cast<size_t>(i / (float)count * 1000));
     }
+
+    content.mEntries.swap(deferred);
+}
+
+void ESMStore::writeStatic(ESM::ESMWriter &writer) const
+{
+    for (std::map<int, StoreBase *>::const_iterator it = mStores.begin(); it != mStores.end(); ++it)
+        it->second->writeStatic(writer);
 }
 
 void ESMStore::setUp()
@@ -14,6 +14,29 @@ namespace Loading
 
 namespace MWWorld
 {
+    /// Records of a single content file that have been parsed by ESMStore::stage() and are
+    /// waiting to be merged into the ESMStore by ESMStore::merge().
+    class StagedContent
+    {
+    public:
+        struct Entry
+        {
+            int mType;
+            size_t mOffset; ///< File offset of the record, used to load deferred records
+            StagedRecord *mRecord; ///< NULL if the record is deferred to the merge
+        };
+
+        StagedContent() {}
+        ~StagedContent();
+
+        std::vector<Entry> mEntries;
+
+    private:
+        // not implemented
+        StagedContent(const StagedContent&);
+        StagedContent& operator=(const StagedContent&);
+    };
+
     class ESMStore
     {
         Store<ESM::Activator>       mActivators;
@@ -74,6 +97,8 @@ namespace MWWorld
 
         unsigned int mDynamicCount;
 
+        void loadRecord(ESM::ESMReader &esm, ESM::NAME name, ESM::Dialogue *&dialogue);
+
     public:
         /// \todo replace with SharedIterator<StoreBase>
         typedef std::map<int, StoreBase *>::const_iterator iterator;
@@ -160,6 +185,22 @@ namespace MWWorld
 
         void load(ESM::ESMReader &esm, Loading::Listener* listener);
 
+        /// Resolve the master files of \a esm and prepare the stores for a new content file.
+        /// Called by load(). Must be called for each file before stage() and merge().
+        void prepareLoad(ESM::ESMReader &esm);
+
+        /// Parse the records of \a esm into \a content without modifying the store.
+        /// Can be used from a background thread while other files are being merged.
+        void stage(ESM::ESMReader &esm, StagedContent &content) const;
+
+        /// Insert records parsed by stage() in file order. Has the same effect as load().
+        /// @note Afterwards \a content only holds the deferred records, which can be merged
+        /// again later to repeat loading of the file without the records stage() parsed.
+        void merge(ESM::ESMReader &esm, StagedContent &content, Loading::Listener* listener);
+
+        /// Write all records that stage() is able to parse, in the same format load() reads.
+        void writeStatic(ESM::ESMWriter &writer) const;
+
         template <class T>
         const Store<T> &get() const {
             throw std::runtime_error("Storage for this type not exist");
@@ -1,6 +1,7 @@
 #include "globals.hpp"
 
 #include <stdexcept>
+#include <algorithm>
 
 #include <components/misc/stringops.hpp>
 
@@ -9,6 +10,17 @@
 
 #include "esmstore.hpp"
 
+namespace
+{
+    struct SlotNameLess
+    {
+        bool operator() (const std::map<std::string, ESM::Global>::iterator& slot, const std::string& name) const
+        {
+            return slot->first < name;
+        }
+    };
+}
+
 namespace MWWorld
 {
     Globals::Collection::const_iterator Globals::find (const std::string& name) const
@@ -42,6 +54,12 @@ namespace MWWorld
         {
             mVariables.insert (std::make_pair (Misc::StringUtils::lowerCase (iter->mId), *iter));
         }
+
+        mSlots.clear();
+        mSlots.reserve (mVariables.size());
+
+        for (Collection::iterator iter (mVariables.begin()); iter!=mVariables.end(); ++iter)
+            mSlots.push_back (iter);
     }
 
     const ESM::Variant& Globals::operator[] (const std::string& name) const
@@ -54,6 +72,29 @@ namespace MWWorld
         return find (Misc::StringUtils::lowerCase (name))->second.mValue;
     }
 
+    const ESM::Variant& Globals::operator[] (int slot) const
+    {
+        return mSlots.at (slot)->second.mValue;
+    }
+
+    ESM::Variant& Globals::operator[] (int slot)
+    {
+        return mSlots.at (slot)->second.mValue;
+    }
+
+    int Globals::getSlot (const std::string& name) const
+    {
+        std::string lowerCaseName = Misc::StringUtils::lowerCase (name);
+
+        std::vector<Collection::iterator>::const_iterator iter =
+            std::lower_bound (mSlots.begin(), mSlots.end(), lowerCaseName, SlotNameLess());
+
+        if (iter==mSlots.end() || (*iter)->first!=lowerCaseName)
+            return -1;
+
+        return iter - mSlots.begin();
+    }
+
     char Globals::getType (const std::string& name) const
     {
         Collection::const_iterator iter = mVariables.find (Misc::StringUtils::lowerCase (name));
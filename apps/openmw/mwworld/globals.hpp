@@ -33,6 +33,8 @@ namespace MWWorld
 
             Collection mVariables; // type, value
 
+            std::vector<Collection::iterator> mSlots; // in the order of mVariables
+
             Collection::const_iterator find (const std::string& name) const;
 
             Collection::iterator find (const std::string& name);
@@ -43,6 +45,15 @@ namespace MWWorld
 
             ESM::Variant& operator[] (const std::string& name);
 
+            const ESM::Variant& operator[] (int slot) const;
+
+            ESM::Variant& operator[] (int slot);
+
+            int getSlot (const std::string& name) const;
+            ///< Return a slot, that can be used instead of the name to access the variable, or -1,
+            /// if there is no global variable with this name. Slots stay valid across calls of fill,
+            /// as long as the content of the store does not change.
+
             char getType (const std::string& name) const;
             ///< If there is no global variable with this name, ' ' is returned.
 
@@ -1,6 +1,7 @@
 #include "scene.hpp"
 
 #include <limits>
+#include <cmath>
 #include <iostream>
 
 #include <components/loadinglistener/loadinglistener.hpp>
@@ -14,12 +15,15 @@
 #include "../mwbase/soundmanager.hpp"
 #include "../mwbase/mechanicsmanager.hpp"
 #include "../mwbase/windowmanager.hpp"
+#include "../mwbase/scriptmanager.hpp"
 
 #include "../mwrender/renderingmanager.hpp"
 #include "../mwrender/landmanager.hpp"
 
 #include "../mwphysics/physicssystem.hpp"
 
+#include "../mwscript/referencecache.hpp"
+
 #include "player.hpp"
 #include "localscripts.hpp"
 #include "esmstore.hpp"
@@ -250,6 +254,7 @@ namespace MWWorld
         MWBase::Environment::get().getWindowManager()->removeCell(*iter);
 
         MWBase::Environment::get().getWorld()->getLocalScripts().clearCell (*iter);
+        MWBase::Environment::get().getScriptManager()->getReferenceCache().clear();
 
         MWBase::Environment::get().getSoundManager()->stopSound (*iter);
         mActiveCells.erase(*iter);
@@ -288,6 +293,7 @@ namespace MWWorld
             // register local scripts
             // do this before insertCell, to make sure we don't add scripts from levelled creature spawning twice
             MWBase::Environment::get().getWorld()->getLocalScripts().addCell (cell);
+            MWBase::Environment::get().getScriptManager()->getReferenceCache().clear();
 
             if (respawn)
                 cell->respawn();
@@ -484,10 +490,12 @@ namespace MWWorld
         mPhysics->setUnrefQueue(rendering.getUnrefQueue());
 
         rendering.getResourceSystem()->setExpiryDelay(Settings::Manager::getFloat("cache expiry delay", "Cells"));
+        rendering.getResourceSystem()->setMaxCacheMemory(static_cast<size_t>(std::max(0, Settings::Manager::getInt("cache memory budget", "Cells"))) * 1024 * 1024);
 
         mPreloader->setExpiryDelay(Settings::Manager::getFloat("preload cell expiry delay", "Cells"));
         mPreloader->setMinCacheSize(Settings::Manager::getInt("preload cell cache min", "Cells"));
         mPreloader->setMaxCacheSize(Settings::Manager::getInt("preload cell cache max", "Cells"));
+        mPreloader->setMaxCacheMemory(static_cast<size_t>(std::max(0, Settings::Manager::getInt("preload cell cache memory", "Cells"))) * 1024 * 1024);
         mPreloader->setPreloadInstances(Settings::Manager::getBool("preload instances", "Cells"));
     }
 
@@ -733,16 +741,18 @@ namespace MWWorld
 
             if (sqrDistToPlayer < mPreloadDistance*mPreloadDistance)
             {
+                // the closer we are to the door, the more likely we are to use it
+                float score = 1.f - std::sqrt(sqrDistToPlayer) / mPreloadDistance;
                 try
                 {
                     if (!door.getCellRef().getDestCell().empty())
-                        preloadCell(MWBase::Environment::get().getWorld()->getInterior(door.getCellRef().getDestCell()));
+                        preloadCell(MWBase::Environment::get().getWorld()->getInterior(door.getCellRef().getDestCell()), false, score);
                     else
                     {
                         osg::Vec3f pos = door.getCellRef().getDoorDest().asVec3();
                         int x,y;
                         MWBase::Environment::get().getWorld()->positionToIndex (pos.x(), pos.y(), x, y);
-                        preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true);
+                        preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true, score);
                         exteriorPositions.push_back(pos);
                     }
                 }
@@ -783,12 +793,12 @@ namespace MWWorld
                 float loadDist = 8192/2 + 8192 - mCellLoadingThreshold + mPreloadDistance;
 
                 if (dist < loadDist)
-                    preloadCell(MWBase::Environment::get().getWorld()->getExterior(cellX+dx, cellY+dy));
+                    preloadCell(MWBase::Environment::get().getWorld()->getExterior(cellX+dx, cellY+dy), false, 1.f - dist / loadDist);
             }
         }
     }
 
-    void Scene::preloadCell(CellStore *cell, bool preloadSurrounding)
+    void Scene::preloadCell(CellStore *cell, bool preloadSurrounding, float score)
     {
         if (preloadSurrounding && cell->isExterior())
         {
@@ -799,14 +809,16 @@ namespace MWWorld
             {
                 for (int dy = -mHalfGridSize; dy <= mHalfGridSize; ++dy)
                 {
-                    mPreloader->preload(MWBase::Environment::get().getWorld()->getExterior(x+dx, y+dy), mRendering.getReferenceTime());
+                    // we arrive in the center of the grid, so surrounding cells are needed later
+                    float surroundingScore = score / (1 + std::max(std::abs(dx), std::abs(dy)));
+                    mPreloader->preload(MWBase::Environment::get().getWorld()->getExterior(x+dx, y+dy), mRendering.getReferenceTime(), surroundingScore);
                     if (++numpreloaded >= mPreloader->getMaxCacheSize())
                         break;
                 }
             }
         }
         else
-            mPreloader->preload(cell, mRendering.getReferenceTime());
+            mPreloader->preload(cell, mRendering.getReferenceTime(), score);
     }
 
     void Scene::preloadTerrain(const osg::Vec3f &pos)
@@ -826,24 +838,29 @@ namespace MWWorld
 
         bool operator()(const MWWorld::Ptr& ptr)
         {
-            if ((ptr.getRefData().getPosition().asVec3() - mPlayerPos).length2() > mPreloadDist * mPreloadDist)
+            float sqrDist = (ptr.getRefData().getPosition().asVec3() - mPlayerPos).length2();
+            if (sqrDist > mPreloadDist * mPreloadDist)
                 return true;
 
+            // travel requires talking to the service provider first, so these destinations are never as urgent as
+            // the ones we can walk into, but a nearby provider is more likely to be used
+            float score = 0.25f * (1.f - std::sqrt(sqrDist) / mPreloadDist);
+
+            const std::vector<ESM::Transport::Dest>* transport;
             if (ptr.getClass().isNpc())
-            {
-                const std::vector<ESM::Transport::Dest>& transport = ptr.get<ESM::NPC>()->mBase->mTransport.mList;
-                mList.insert(mList.begin(), transport.begin(), transport.end());
-            }
+                transport = &ptr.get<ESM::NPC>()->mBase->mTransport.mList;
             else
-            {
-                const std::vector<ESM::Transport::Dest>& transport = ptr.get<ESM::Creature>()->mBase->mTransport.mList;
-                mList.insert(mList.begin(), transport.begin(), transport.end());
-            }
+                transport = &ptr.get<ESM::Creature>()->mBase->mTransport.mList;
+
+            mList.insert(mList.end(), transport->begin(), transport->end());
+            mScores.insert(mScores.end(), transport->size(), score);
             return true;
         }
         float mPreloadDist;
         osg::Vec3f mPlayerPos;
         std::vector<ESM::Transport::Dest> mList;
+        // The score of each destination in mList
+        std::vector<float> mScores;
     };
 
     void Scene::preloadFastTravelDestinations(const osg::Vec3f& playerPos, const osg::Vec3f& /*predictedPos*/, std::vector<osg::Vec3f>& exteriorPositions) // ignore predictedPos here since opening dialogue with travel service takes extra time
@@ -858,16 +875,18 @@ namespace MWWorld
             cellStore->forEachType<ESM::Creature>(listVisitor);
         }
 
-        for (std::vector<ESM::Transport::Dest>::const_iterator it = listVisitor.mList.begin(); it != listVisitor.mList.end(); ++it)
+        for (unsigned int i=0; i<listVisitor.mList.size(); ++i)
         {
-            if (!it->mCellName.empty())
-                preloadCell(MWBase::Environment::get().getWorld()->getInterior(it->mCellName));
+            const ESM::Transport::Dest& dest = listVisitor.mList[i];
+            float score = listVisitor.mScores[i];
+            if (!dest.mCellName.empty())
+                preloadCell(MWBase::Environment::get().getWorld()->getInterior(dest.mCellName), false, score);
             else
             {
-                osg::Vec3f pos = it->mPos.asVec3();
+                osg::Vec3f pos = dest.mPos.asVec3();
                 int x,y;
                 MWBase::Environment::get().getWorld()->positionToIndex( pos.x(), pos.y(), x, y);
-                preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true);
+                preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true, score);
                 exteriorPositions.push_back(pos);
             }
         }
@@ -88,7 +88,8 @@ namespace MWWorld
 
             ~Scene();
 
-            void preloadCell(MWWorld::CellStore* cell, bool preloadSurrounding=false);
+            /// @param score How likely the cell is to be needed soon, in the range [0, 1].
+            void preloadCell(MWWorld::CellStore* cell, bool preloadSurrounding=false, float score=1.f);
             void preloadTerrain(const osg::Vec3f& pos);
 
             void unloadCell (CellStoreCollection::iterator iter);
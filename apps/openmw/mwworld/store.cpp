@@ -6,6 +6,7 @@
 #include <components/loadinglistener/loadinglistener.hpp>
 #include <components/misc/rng.hpp>
 
+#include <memory>
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
@@ -122,6 +123,8 @@ namespace MWWorld
     Store<T>::Store(const Store<T>& orig)
         : mStatic(orig.mStatic)
     {
+        for (typename Static::iterator it = mStatic.begin(); it != mStatic.end(); ++it)
+            mStaticIndex.insert(&it->first, Misc::StringUtils::ciHash(it->first), &it->second);
     }
 
     template<typename T>
@@ -131,25 +134,26 @@ namespace MWWorld
         assert(mShared.size() >= mStatic.size());
         mShared.erase(mShared.begin() + mStatic.size(), mShared.end());
         mDynamic.clear();
+        mDynamicIndex.clear();
     }
 
     template<typename T>
     const T *Store<T>::search(const std::string &id) const
     {
-        std::string idLower = Misc::StringUtils::lowerCase(id);
-
-        typename Dynamic::const_iterator dit = mDynamic.find(idLower);
-        if (dit != mDynamic.end()) {
-            return &dit->second;
-        }
-
-        typename std::map<std::string, T>::const_iterator it = mStatic.find(idLower);
-
-        if (it != mStatic.end() && Misc::StringUtils::ciEqual(it->second.mId, id)) {
-            return &(it->second);
-        }
+        return searchHashed(id, Misc::StringUtils::ciHash(id));
+    }
+    template<typename T>
+    const T *Store<T>::search(const HashedId &id) const
+    {
+        return searchHashed(id.mId, id.mHash);
+    }
+    template<typename T>
+    const T *Store<T>::searchHashed(const std::string &id, size_t hash) const
+    {
+        if (const T *ptr = mDynamicIndex.find(id, hash))
+            return ptr;
 
-        return 0;
+        return mStaticIndex.find(id, hash);
     }
     template<typename T>
     bool Store<T>::isDynamic(const std::string &id) const
@@ -169,7 +173,17 @@ namespace MWWorld
     template<typename T>
     const T *Store<T>::find(const std::string &id) const
     {
-        const T *ptr = search(id);
+        return findHashed(id, Misc::StringUtils::ciHash(id));
+    }
+    template<typename T>
+    const T *Store<T>::find(const HashedId &id) const
+    {
+        return findHashed(id.mId, id.mHash);
+    }
+    template<typename T>
+    const T *Store<T>::findHashed(const std::string &id, size_t hash) const
+    {
+        const T *ptr = searchHashed(id, hash);
         if (ptr == 0) {
             std::ostringstream msg;
             msg << T::getRecordType() << " '" << id << "' not found";
@@ -198,9 +212,33 @@ namespace MWWorld
         record.load(esm, isDeleted);
         Misc::StringUtils::lowerCaseInPlace(record.mId);
 
+        return insertLoaded(record, isDeleted);
+    }
+    template<typename T>
+    StagedRecord *Store<T>::parse(ESM::ESMReader &esm) const
+    {
+        std::auto_ptr<TypedStagedRecord<T> > staged(new TypedStagedRecord<T>);
+
+        staged->mRecord.load(esm, staged->mIsDeleted);
+        Misc::StringUtils::lowerCaseInPlace(staged->mRecord.mId);
+
+        return staged.release();
+    }
+    template<typename T>
+    RecordId Store<T>::merge(const StagedRecord &record)
+    {
+        const TypedStagedRecord<T> &staged = static_cast<const TypedStagedRecord<T>&>(record);
+        return insertLoaded(staged.mRecord, staged.mIsDeleted);
+    }
+    template<typename T>
+    RecordId Store<T>::insertLoaded(const T &record, bool isDeleted)
+    {
         std::pair<typename Static::iterator, bool> inserted = mStatic.insert(std::make_pair(record.mId, record));
         if (inserted.second)
+        {
             mShared.push_back(&inserted.first->second);
+            mStaticIndex.insert(&inserted.first->first, Misc::StringUtils::ciHash(record.mId), &inserted.first->second);
+        }
         else
             inserted.first->second = record;
 
@@ -251,6 +289,7 @@ namespace MWWorld
         T *ptr = &result.first->second;
         if (result.second) {
             mShared.push_back(ptr);
+            mDynamicIndex.insert(&result.first->first, Misc::StringUtils::ciHash(id), ptr);
         } else {
             *ptr = item;
         }
@@ -265,6 +304,7 @@ namespace MWWorld
         T *ptr = &result.first->second;
         if (result.second) {
             mShared.push_back(ptr);
+            mStaticIndex.insert(&result.first->first, Misc::StringUtils::ciHash(id), ptr);
         } else {
             *ptr = item;
         }
@@ -289,6 +329,7 @@ namespace MWWorld
                 }
                 ++sharedIter;
             }
+            mStaticIndex.erase(it->first);
             mStatic.erase(it);
         }
 
@@ -303,6 +344,7 @@ namespace MWWorld
         if (it == mDynamic.end()) {
             return false;
         }
+        mDynamicIndex.erase(it->first);
         mDynamic.erase(it);
 
         // have to reinit the whole shared part
@@ -330,6 +372,19 @@ namespace MWWorld
         }
     }
     template<typename T>
+    void Store<T>::writeStatic (ESM::ESMWriter& writer) const
+    {
+        // Iterate mShared so that the records are read back in the same order
+        typename std::vector<T *>::const_iterator it = mShared.begin();
+        typename std::vector<T *>::const_iterator end = mShared.begin() + mStatic.size();
+        for (; it != end; ++it)
+        {
+            writer.startRecord (T::sRecordId);
+            (*it)->save (writer);
+            writer.endRecord (T::sRecordId);
+        }
+    }
+    template<typename T>
     RecordId Store<T>::read(ESM::ESMReader& reader)
     {
         T record;
@@ -1051,25 +1106,42 @@ namespace MWWorld
     template <>
     inline RecordId Store<ESM::Dialogue>::load(ESM::ESMReader &esm) {
         // The original letter case of a dialogue ID is saved, because it's printed
-        ESM::Dialogue dialogue;
         bool isDeleted = false;
 
-        dialogue.loadId(esm);
+        // The ID stays in the reader until the next read, so it is only converted again for a new dialogue
+        ESM::StringRef id = esm.getHNStringRef("NAME");
+
+        std::string idLower = esm.toString(id);
+        Misc::StringUtils::lowerCaseInPlace(idLower);
 
-        std::string idLower = Misc::StringUtils::lowerCase(dialogue.mId);
         std::map<std::string, ESM::Dialogue>::iterator found = mStatic.find(idLower);
         if (found == mStatic.end())
         {
+            ESM::Dialogue dialogue;
+            dialogue.mId = esm.toString(id);
             dialogue.loadData(esm, isDeleted);
-            mStatic.insert(std::make_pair(idLower, dialogue));
+            found = mStatic.insert(std::make_pair(idLower, dialogue)).first;
+            mStaticIndex.insert(&found->first, Misc::StringUtils::ciHash(idLower), &found->second);
         }
         else
-        {
             found->second.loadData(esm, isDeleted);
-            dialogue = found->second;
-        }
 
-        return RecordId(dialogue.mId, isDeleted);
+        // Don't copy the dialogue, its list of infos can be long
+        return RecordId(found->second.mId, isDeleted);
+    }
+
+    template <>
+    StagedRecord *Store<ESM::Dialogue>::parse(ESM::ESMReader &esm) const
+    {
+        // INFO records following a dialogue need it to be present in the store, so dialogues
+        // have to be loaded in order
+        return NULL;
+    }
+
+    template <>
+    void Store<ESM::Dialogue>::writeStatic (ESM::ESMWriter& writer) const
+    {
+        // Not supported, see parse()
     }
 
 }
@@ -5,6 +5,8 @@
 #include <vector>
 #include <map>
 
+#include <components/misc/stringindex.hpp>
+
 #include "recordcmp.hpp"
 
 namespace ESM
@@ -27,6 +29,34 @@ namespace MWWorld
         RecordId(const std::string &id = "", bool isDeleted = false);
     };
 
+    /// A record ID with its case-insensitive hash precomputed, for callers that look up the same ID repeatedly.
+    struct HashedId
+    {
+        std::string mId;
+        size_t mHash;
+
+        explicit HashedId(const std::string &id)
+            : mId(id), mHash(Misc::StringUtils::ciHash(id))
+        {}
+    };
+
+    /// A record that has been parsed from a content file, but not inserted into its Store yet.
+    class StagedRecord
+    {
+    public:
+        virtual ~StagedRecord() {}
+    };
+
+    template <class T>
+    class TypedStagedRecord : public StagedRecord
+    {
+    public:
+        T mRecord;
+        bool mIsDeleted;
+
+        TypedStagedRecord() : mIsDeleted(false) {}
+    };
+
     class StoreBase
     {
     public:
@@ -41,11 +71,22 @@ namespace MWWorld
         virtual int getDynamicSize() const { return 0; }
         virtual RecordId load(ESM::ESMReader &esm) = 0;
 
+        /// Parse the current record without modifying the Store, so that it can be inserted later
+        /// through merge(). May be called from a background thread while the Store is being modified.
+        /// @return NULL if this Store needs its records to be loaded in order through load().
+        virtual StagedRecord *parse(ESM::ESMReader &esm) const { return NULL; }
+
+        /// Insert a record returned by parse(). Has the same effect as the load() call that was deferred.
+        virtual RecordId merge(const StagedRecord &record) { return RecordId(); }
+
         virtual bool eraseStatic(const std::string &id) {return false;}
         virtual void clearDynamic() {}
 
         virtual void write (ESM::ESMWriter& writer, Loading::Listener& progress) const {}
 
+        /// Write the records loaded from content files, for stores that support parse().
+        virtual void writeStatic (ESM::ESMWriter& writer) const {}
+
         virtual RecordId read (ESM::ESMReader& reader) { return RecordId(); }
         ///< Read into dynamic storage
     };
@@ -144,6 +185,11 @@ namespace MWWorld
                                      // for heads/hairs in the character creation)
         std::map<std::string, T> mDynamic;
 
+        // Hash indices into mStatic and mDynamic, keyed by the map keys. The map nodes never move, so
+        // record pointers stay valid when the indices grow.
+        Misc::CiStringIndex<T> mStaticIndex;
+        Misc::CiStringIndex<T> mDynamicIndex;
+
         typedef std::map<std::string, T> Dynamic;
         typedef std::map<std::string, T> Static;
 
@@ -160,6 +206,7 @@ namespace MWWorld
         void setUp();
 
         const T *search(const std::string &id) const;
+        const T *search(const HashedId &id) const;
 
         /**
          * Does the record with this ID come from the dynamic store?
@@ -170,6 +217,7 @@ namespace MWWorld
         const T *searchRandom(const std::string &id) const;
 
         const T *find(const std::string &id) const;
+        const T *find(const HashedId &id) const;
 
         /** Returns a random record that starts with the named ID. An exception is thrown if none
          * are found. */
@@ -192,8 +240,16 @@ namespace MWWorld
         bool erase(const T &item);
 
         RecordId load(ESM::ESMReader &esm);
+        StagedRecord *parse(ESM::ESMReader &esm) const;
+        RecordId merge(const StagedRecord &record);
         void write(ESM::ESMWriter& writer, Loading::Listener& progress) const;
+        void writeStatic(ESM::ESMWriter& writer) const;
         RecordId read(ESM::ESMReader& reader);
+
+    private:
+        RecordId insertLoaded(const T &record, bool isDeleted);
+        const T *searchHashed(const std::string &id, size_t hash) const;
+        const T *findHashed(const std::string &id, size_t hash) const;
     };
 
     template <>
@@ -12,6 +12,8 @@
 
 #include <components/files/collections.hpp>
 
+#include <components/version/version.hpp>
+
 #include <components/resource/resourcesystem.hpp>
 
 #include <components/sceneutil/positionattitudetransform.hpp>
@@ -29,6 +31,7 @@
 #include "../mwmechanics/levelledlist.hpp"
 #include "../mwmechanics/combat.hpp"
 #include "../mwmechanics/aiavoiddoor.hpp" //Used to tell actors to avoid doors
+#include "../mwmechanics/pathgridportals.hpp"
 
 #include "../mwrender/animation.hpp"
 #include "../mwrender/npcanimation.hpp"
@@ -38,6 +41,7 @@
 
 #include "../mwscript/interpretercontext.hpp"
 #include "../mwscript/globalscripts.hpp"
+#include "../mwscript/referencecache.hpp"
 
 #include "../mwclass/door.hpp"
 
@@ -101,6 +105,12 @@ namespace MWWorld
             }
         }
 
+        void finish()
+        {
+            for (LoadersContainer::iterator it = mLoaders.begin(); it != mLoaders.end(); ++it)
+                it->second->finish();
+        }
+
         private:
           typedef std::map<std::string, ContentLoader*> LoadersContainer;
           LoadersContainer mLoaders;
@@ -147,8 +157,8 @@ namespace MWWorld
         const std::vector<std::string>& contentFiles,
         ToUTF8::Utf8Encoder* encoder, const std::map<std::string,std::string>& fallbackMap,
         int activationDistanceOverride, const std::string& startCell, const std::string& startupScript,
-            const std::string& resourcePath, const std::string& userDataPath)
-    : mResourceSystem(resourceSystem), mFallback(fallbackMap), mPlayer (0), mLocalScripts (mStore),
+            const std::string& resourcePath, const std::string& userDataPath, const std::string& cachePath)
+    : mResourceSystem(resourceSystem), mFallback(fallbackMap), mPlayer (0), mPathgridPortals(NULL), mLocalScripts (mStore),
       mSky (true), mCells (mStore, mEsm),
       mGodMode(false), mScriptsEnabled(true), mContentFiles (contentFiles), mUserDataPath(userDataPath),
       mActivationDistanceOverride (activationDistanceOverride), mStartupScript(startupScript),
@@ -165,8 +175,11 @@ namespace MWWorld
         Loading::Listener* listener = MWBase::Environment::get().getWindowManager()->getLoadingScreen();
         listener->loadingOn();
 
+        // Records are cached as this build loads them, so a different build must not use the cache
+        Version::Version version = Version::getOpenmwVersion(resourcePath);
+
         GameContentLoader gameContentLoader(*listener);
-        EsmLoader esmLoader(mStore, mEsm, encoder, *listener);
+        EsmLoader esmLoader(mStore, mEsm, encoder, *listener, cachePath, version.mVersion + " " + version.mCommitHash);
 
         gameContentLoader.addLoader(".esm", &esmLoader);
         gameContentLoader.addLoader(".esp", &esmLoader);
@@ -187,6 +200,8 @@ namespace MWWorld
         mStore.setUp();
         mStore.movePlayerRecord();
 
+        mPathgridPortals = new MWMechanics::PathgridPortals(mStore.get<ESM::Pathgrid>());
+
         mSwimHeightScale = mStore.get<ESM::GameSetting>().find("fSwimHeightScale")->getFloat();
 
         mWeatherManager = new MWWorld::WeatherManager(*mRendering, mFallback, mStore);
@@ -485,6 +500,8 @@ namespace MWWorld
 
     World::~World()
     {
+        finishPhysics();
+
         // Must be cleared before mRendering is destroyed
         mProjectileManager->clear();
         delete mWeatherManager;
@@ -493,6 +510,7 @@ namespace MWWorld
         delete mPhysics;
 
         delete mPlayer;
+        delete mPathgridPortals;
     }
 
     const ESM::Cell *World::getExterior (const std::string& cellName) const
@@ -561,6 +579,11 @@ namespace MWWorld
         return mStore;
     }
 
+    const MWMechanics::PathgridPortals& World::getPathgridPortals() const
+    {
+        return *mPathgridPortals;
+    }
+
     std::vector<ESM::ESMReader>& World::getEsmReader()
     {
         return mEsm;
@@ -610,6 +633,49 @@ namespace MWWorld
         return mGlobalVariables[name].getFloat();
     }
 
+    int World::getGlobalSlot (const std::string& name) const
+    {
+        return mGlobalVariables.getSlot (name);
+    }
+
+    void World::setGlobalInt (int slot, int value)
+    {
+        ESM::Variant& variable = mGlobalVariables[slot];
+
+        if (&variable==mGameHour)
+            setHour (value);
+        else if (&variable==mDay)
+            setDay (value);
+        else if (&variable==mMonth)
+            setMonth (value);
+        else
+            variable.setInteger (value);
+    }
+
+    void World::setGlobalFloat (int slot, float value)
+    {
+        ESM::Variant& variable = mGlobalVariables[slot];
+
+        if (&variable==mGameHour)
+            setHour (value);
+        else if (&variable==mDay)
+            setDay (static_cast<int>(value));
+        else if (&variable==mMonth)
+            setMonth (static_cast<int>(value));
+        else
+            variable.setFloat (value);
+    }
+
+    int World::getGlobalInt (int slot) const
+    {
+        return mGlobalVariables[slot].getInteger();
+    }
+
+    float World::getGlobalFloat (int slot) const
+    {
+        return mGlobalVariables[slot].getFloat();
+    }
+
     char World::getGlobalVariableType (const std::string& name) const
     {
         return mGlobalVariables.getType (name);
@@ -1152,6 +1218,8 @@ namespace MWWorld
 
         if (currCell != newCell)
         {
+            MWBase::Environment::get().getScriptManager()->getReferenceCache().clear();
+
             removeContainerScripts(ptr);
 
             if (isPlayer)
@@ -1449,11 +1517,28 @@ namespace MWWorld
             moveObjectImp(player->first, player->second.x(), player->second.y(), player->second.z(), false);
     }
 
-    bool World::castRay (float x1, float y1, float z1, float x2, float y2, float z2)
+    void World::startPhysics()
+    {
+        mPhysics->unlockSimulation();
+    }
+
+    void World::finishPhysics()
+    {
+        mPhysics->lockSimulation();
+        mPhysics->resetStats();
+    }
+
+    void World::reportStats(unsigned int frameNumber, osg::Stats *stats) const
+    {
+        mPhysics->reportStats(frameNumber, stats);
+    }
+
+    bool World::castRay (float x1, float y1, float z1, float x2, float y2, float z2, MWPhysics::RayCategory category)
     {
         osg::Vec3f a(x1,y1,z1);
         osg::Vec3f b(x2,y2,z2);
-        MWPhysics::PhysicsSystem::RayResult result = mPhysics->castRay(a, b, MWWorld::Ptr(), std::vector<MWWorld::Ptr>(), MWPhysics::CollisionType_World|MWPhysics::CollisionType_Door);
+        MWPhysics::PhysicsSystem::RayResult result = mPhysics->castRay(a, b, MWWorld::Ptr(), std::vector<MWWorld::Ptr>(), MWPhysics::CollisionType_World|MWPhysics::CollisionType_Door,
+                                                                       0xff, category);
         return result.mHit;
     }
 
@@ -1688,7 +1773,7 @@ namespace MWWorld
             osg::Vec3f focal, camera;
             mRendering->getCamera()->getPosition(focal, camera);
             float radius = mRendering->getNearClipDistance()*2.5f;
-            MWPhysics::PhysicsSystem::RayResult result = mPhysics->castSphere(focal, camera, radius);
+            MWPhysics::PhysicsSystem::RayResult result = mPhysics->castSphere(focal, camera, radius, MWPhysics::RayCategory_Camera);
             if (result.mHit)
                 mRendering->getCamera()->setCameraDistance((result.mHitPos - focal).length() - radius, false, false);
         }
@@ -2470,17 +2555,43 @@ namespace MWWorld
         }
     }
 
-    bool World::getLOS(const MWWorld::ConstPtr& actor, const MWWorld::ConstPtr& targetActor)
+    bool World::getLOS(const MWWorld::ConstPtr& actor, const MWWorld::ConstPtr& targetActor, MWPhysics::RayCategory category)
     {
         if (!targetActor.getRefData().isEnabled() || !actor.getRefData().isEnabled())
             return false; // cannot get LOS unless both NPC's are enabled
         if (!targetActor.getRefData().getBaseNode() || !actor.getRefData().getBaseNode())
             return false; // not in active cell
 
-        return mPhysics->getLineOfSight(actor, targetActor);
+        return mPhysics->getLineOfSight(actor, targetActor, category);
     }
 
-    float World::getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist, bool includeWater)
+    void World::getLOS(const MWWorld::ConstPtr& actor, const std::vector<MWWorld::Ptr>& targetActors, std::vector<bool>& out,
+                       MWPhysics::RayCategory category)
+    {
+        out.assign(targetActors.size(), false);
+
+        if (!actor.getRefData().isEnabled() || !actor.getRefData().getBaseNode())
+            return;
+
+        // Same conditions as for a single target, only cast rays to targets that pass them
+        std::vector<MWWorld::Ptr> targets;
+        std::vector<size_t> indices;
+        for (size_t i=0; i<targetActors.size(); ++i)
+        {
+            const MWWorld::Ptr& target = targetActors[i];
+            if (!target.getRefData().isEnabled() || !target.getRefData().getBaseNode())
+                continue;
+            targets.push_back(target);
+            indices.push_back(i);
+        }
+
+        std::vector<bool> visible;
+        mPhysics->getLineOfSight(actor, targets, visible, category);
+        for (size_t i=0; i<visible.size(); ++i)
+            out[indices[i]] = visible[i];
+    }
+
+    float World::getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist, bool includeWater, MWPhysics::RayCategory category)
     {
         osg::Vec3f to (dir);
         to.normalize();
@@ -2490,7 +2601,7 @@ namespace MWWorld
         if (includeWater) {
             collisionTypes |= MWPhysics::CollisionType_Water;
         }
-        MWPhysics::PhysicsSystem::RayResult result = mPhysics->castRay(from, to, MWWorld::Ptr(), std::vector<MWWorld::Ptr>(), collisionTypes);
+        MWPhysics::PhysicsSystem::RayResult result = mPhysics->castRay(from, to, MWWorld::Ptr(), std::vector<MWWorld::Ptr>(), collisionTypes, 0xff, category);
 
         if (!result.mHit)
             return maxDist;
@@ -2649,6 +2760,8 @@ namespace MWWorld
                 throw std::runtime_error(msg.str());
             }
         }
+
+        contentLoader.finish();
     }
 
     bool World::startSpellCast(const Ptr &actor)
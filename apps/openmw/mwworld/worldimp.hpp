@@ -63,6 +63,11 @@ namespace ToUTF8
 
 struct ContentLoader;
 
+namespace MWMechanics
+{
+    class PathgridPortals;
+}
+
 namespace MWWorld
 {
     class WeatherManager;
@@ -84,6 +89,7 @@ namespace MWWorld
             MWWorld::Player *mPlayer;
             std::vector<ESM::ESMReader> mEsm;
             MWWorld::ESMStore mStore;
+            MWMechanics::PathgridPortals* mPathgridPortals;
             LocalScripts mLocalScripts;
             MWWorld::Globals mGlobalVariables;
             MWPhysics::PhysicsSystem *mPhysics;
@@ -193,7 +199,7 @@ namespace MWWorld
                 const Files::Collections& fileCollections,
                 const std::vector<std::string>& contentFiles,
                 ToUTF8::Utf8Encoder* encoder, const std::map<std::string,std::string>& fallbackMap,
-                int activationDistanceOverride, const std::string& startCell, const std::string& startupScript, const std::string& resourcePath, const std::string& userDataPath);
+                int activationDistanceOverride, const std::string& startCell, const std::string& startupScript, const std::string& resourcePath, const std::string& userDataPath, const std::string& cachePath);
 
             virtual ~World();
 
@@ -233,6 +239,8 @@ namespace MWWorld
 
             virtual const MWWorld::ESMStore& getStore() const;
 
+            virtual const MWMechanics::PathgridPortals& getPathgridPortals() const;
+
             virtual std::vector<ESM::ESMReader>& getEsmReader();
 
             virtual LocalScripts& getLocalScripts();
@@ -262,6 +270,18 @@ namespace MWWorld
             virtual float getGlobalFloat (const std::string& name) const;
             ///< Get value independently from real type.
 
+            virtual int getGlobalSlot (const std::string& name) const;
+            ///< Return a slot for faster access to the global variable \a name or -1, if there is no
+            /// global variable with this name.
+
+            virtual void setGlobalInt (int slot, int value);
+
+            virtual void setGlobalFloat (int slot, float value);
+
+            virtual int getGlobalInt (int slot) const;
+
+            virtual float getGlobalFloat (int slot) const;
+
             virtual char getGlobalVariableType (const std::string& name) const;
             ///< Return ' ', if there is no global variable with this name.
 
@@ -404,7 +424,19 @@ namespace MWWorld
             ///< Queues movement for \a ptr (in local space), to be applied in the next call to
             /// doPhysics.
 
-            virtual bool castRay (float x1, float y1, float z1, float x2, float y2, float z2);
+            virtual void startPhysics();
+            ///< Let the physics thread, if enabled, step the movement applied in the last doPhysics on its own clock.
+            /// Call at the end of the frame; nothing may access the world until finishPhysics is called.
+
+            virtual void finishPhysics();
+            ///< Wait for the step the physics thread is doing, if any, and take over the positions it published since
+            /// startPhysics. They are reported by the next doPhysics.
+            /// Call at the start of the frame; the ray counts reported by reportStats start here.
+
+            virtual void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
+
+            virtual bool castRay (float x1, float y1, float z1, float x2, float y2, float z2,
+                                  MWPhysics::RayCategory category = MWPhysics::RayCategory_Other);
             ///< cast a Ray and return true if there is an object in the ray path.
 
             virtual bool toggleCollisionMode();
@@ -542,10 +574,17 @@ namespace MWWorld
             virtual void getItemsOwnedBy (const MWWorld::ConstPtr& npc, std::vector<MWWorld::Ptr>& out);
             ///< get all items in active cells owned by this Npc
 
-            virtual bool getLOS(const MWWorld::ConstPtr& actor,const MWWorld::ConstPtr& targetActor);
+            virtual bool getLOS(const MWWorld::ConstPtr& actor,const MWWorld::ConstPtr& targetActor,
+                                MWPhysics::RayCategory category = MWPhysics::RayCategory_Other);
             ///< get Line of Sight (morrowind stupid implementation)
 
-            virtual float getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist, bool includeWater = false);
+            virtual void getLOS(const MWWorld::ConstPtr& actor, const std::vector<MWWorld::Ptr>& targetActors, std::vector<bool>& out,
+                                MWPhysics::RayCategory category = MWPhysics::RayCategory_Other);
+            ///< Batched version of getLOS, for all of \a targetActors at once.
+            /// @param out Receives whether \a actor has a line of sight to each of \a targetActors, in the same order.
+
+            virtual float getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist, bool includeWater = false,
+                                                 MWPhysics::RayCategory category = MWPhysics::RayCategory_Other);
 
             virtual void enableActorCollision(const MWWorld::Ptr& actor, bool enable);
 
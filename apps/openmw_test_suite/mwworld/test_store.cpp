@@ -1,7 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <cctype>
+#include <sstream>
+
 #include <boost/filesystem/fstream.hpp>
 
+#include <osg/Timer>
+
 #include <components/files/configurationmanager.hpp>
 #include <components/esm/esmreader.hpp>
 #include <components/esm/esmwriter.hpp>
@@ -193,6 +198,81 @@ TEST_F(ContentFileTest, content_diagnostics_test)
     std::cout << "diagnostics_test successful, results printed to " << file << std::endl;
 }
 
+struct LookupTimes
+{
+    size_t mCount;
+    double mMapTime;
+    double mHashTime;
+    double mHashedIdTime;
+
+    LookupTimes() : mCount(0), mMapTime(0), mHashTime(0), mHashedIdTime(0) {}
+};
+
+template <typename T>
+void benchmarkLookup(MWWorld::ESMStore& esmStore, LookupTimes& times)
+{
+    const MWWorld::Store<T>& store = esmStore.get<T>();
+
+    // Look up the IDs in the letter case that scripts and dialogue usually use
+    std::vector<std::string> ids;
+    std::vector<MWWorld::HashedId> hashedIds;
+    std::map<std::string, const T*> map;
+    for (typename MWWorld::Store<T>::iterator it = store.begin(); it != store.end(); ++it)
+    {
+        std::string id = it->mId;
+        if (!id.empty())
+            id[0] = static_cast<char>(std::toupper(id[0]));
+        ids.push_back(id);
+        hashedIds.push_back(MWWorld::HashedId(id));
+        map[Misc::StringUtils::lowerCase(id)] = &*it;
+    }
+
+    const int iterations = 10;
+    size_t found = 0;
+
+    // The lookup that Store<T> used before, a case smashed copy and a std::map search
+    osg::Timer timer;
+    for (int i = 0; i < iterations; ++i)
+        for (std::vector<std::string>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+            found += map.find(Misc::StringUtils::lowerCase(*it)) != map.end();
+    times.mMapTime += timer.time_s();
+
+    timer.setStartTick();
+    for (int i = 0; i < iterations; ++i)
+        for (std::vector<std::string>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+            found += store.search(*it) != NULL;
+    times.mHashTime += timer.time_s();
+
+    timer.setStartTick();
+    for (int i = 0; i < iterations; ++i)
+        for (std::vector<MWWorld::HashedId>::const_iterator it = hashedIds.begin(); it != hashedIds.end(); ++it)
+            found += store.search(*it) != NULL;
+    times.mHashedIdTime += timer.time_s();
+
+    times.mCount += ids.size() * iterations;
+
+    ASSERT_TRUE (found == 3 * ids.size() * iterations);
+}
+
+/// Compare the speed of record lookups through std::map and through the hash index of Store<T>, using all
+/// IDs from the content files.
+TEST_F(ContentFileTest, lookup_benchmark_test)
+{
+    if (mContentFiles.empty())
+    {
+        std::cout << "No content files found, skipping test" << std::endl;
+        return;
+    }
+
+    LookupTimes times;
+    RUN_TEST_FOR_TYPES(benchmarkLookup, mEsmStore, times);
+
+    std::cout << "lookup_benchmark_test: " << times.mCount << " lookups" << std::endl
+              << "  std::map:     " << times.mMapTime * 1000 << " ms" << std::endl
+              << "  hash index:   " << times.mHashTime * 1000 << " ms" << std::endl
+              << "  pre-hashed:   " << times.mHashedIdTime * 1000 << " ms" << std::endl;
+}
+
 // TODO:
 /// Print results of autocalculated NPC spell lists. Also serves as test for attribute/skill autocalculation which the spell autocalculation heavily relies on
 /// - even incorrect rounding modes can completely change the resulting spell lists.
@@ -313,3 +393,104 @@ TEST_F(StoreTest, overwrite_test)
 
     ASSERT_TRUE (overwrittenRec && overwrittenRec->mModel == "the_new_model");
 }
+
+/// Tests that parsing a file with stage() and merging it later has the same effect as load().
+TEST_F(StoreTest, staged_load_test)
+{
+    const std::string recordId = "foobar";
+
+    typedef ESM::Apparatus RecordType;
+
+    RecordType record;
+    record.blank();
+    record.mId = recordId;
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+
+    // master file inserts a record
+    Files::IStreamPtr file = getEsmFile(record, false);
+    reader.open(file, "filename");
+    mEsmStore.prepareLoad(reader);
+    {
+        MWWorld::StagedContent content;
+        mEsmStore.stage(reader, content);
+
+        // nothing is inserted until the content is merged
+        ASSERT_TRUE (mEsmStore.get<RecordType>().getSize() == 0);
+
+        mEsmStore.merge(reader, content, &dummyListener);
+    }
+    mEsmStore.setUp();
+
+    ASSERT_TRUE (mEsmStore.get<RecordType>().getSize() == 1);
+
+    // now a plugin deletes it
+    file = getEsmFile(record, true);
+    reader.open(file, "filename");
+    mEsmStore.prepareLoad(reader);
+    {
+        MWWorld::StagedContent content;
+        mEsmStore.stage(reader, content);
+        mEsmStore.merge(reader, content, &dummyListener);
+    }
+    mEsmStore.setUp();
+
+    ASSERT_TRUE (mEsmStore.get<RecordType>().getSize() == 0);
+}
+
+/// Tests case insensitive lookups through the hash index, for static and dynamic records.
+TEST_F(StoreTest, hashed_lookup_test)
+{
+    typedef ESM::Apparatus RecordType;
+
+    MWWorld::Store<RecordType> store;
+
+    RecordType record;
+    record.blank();
+
+    record.mId = "Static_0";
+    store.insertStatic(record);
+    const RecordType* first = store.search("static_0");
+    ASSERT_TRUE (first != NULL);
+
+    // Enough records to make the index grow a few times
+    for (int i = 1; i < 100; ++i)
+    {
+        std::ostringstream id;
+        id << "Static_" << i;
+        record.mId = id.str();
+        store.insertStatic(record);
+    }
+
+    record.mId = "Dynamic";
+    store.insert(record);
+
+    ASSERT_TRUE (store.search("static_42") != NULL);
+    ASSERT_TRUE (store.search("STATIC_42") != NULL);
+    ASSERT_TRUE (store.search(MWWorld::HashedId("Static_99")) != NULL);
+    ASSERT_TRUE (store.search("static_100") == NULL);
+    ASSERT_TRUE (store.search("dYnAmIc") != NULL);
+
+    // record pointers handed out before the index grew are still valid
+    ASSERT_TRUE (first == store.search("static_0"));
+    ASSERT_TRUE (first == store.find(MWWorld::HashedId("Static_0")));
+    ASSERT_TRUE (first->mId == "Static_0");
+
+    store.eraseStatic("Static_42");
+    ASSERT_TRUE (store.search("static_42") == NULL);
+    ASSERT_TRUE (store.search("static_43") != NULL);
+
+    store.erase("dynamic");
+    ASSERT_TRUE (store.search("Dynamic") == NULL);
+
+    // copies have their own index
+    store.insert(record);
+    MWWorld::Store<RecordType> copy(store);
+    store.clearDynamic();
+    ASSERT_TRUE (store.search("Dynamic") == NULL);
+    ASSERT_TRUE (copy.search("Static_43") != NULL);
+    ASSERT_TRUE (copy.search("Static_43") != store.search("Static_43"));
+}
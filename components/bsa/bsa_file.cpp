@@ -23,6 +23,9 @@
 
 #include "bsa_file.hpp"
 
+#include <cassert>
+#include <cstring>
+#include <iostream>
 #include <stdexcept>
 
 #include <boost/filesystem/path.hpp>
@@ -31,6 +34,60 @@
 using namespace std;
 using namespace Bsa;
 
+namespace
+{
+    /// Normalize a character the way the archive hashes expect it
+    char normalizeChar(char c)
+    {
+        if (c == '/')
+            return '\\';
+        if (c >= 'A' && c <= 'Z')
+            return c - 'A' + 'a';
+        return c;
+    }
+
+    size_t bucket(const BSAFile::Hash &hash)
+    {
+        // The low word only depends on the first half of the name, so mix in the high word
+        return hash.low ^ (hash.high * 0x9e3779b1u);
+    }
+}
+
+BSAFile::Hash BSAFile::getHash(const char *name)
+{
+    size_t len = strlen(name);
+    size_t half = len / 2;
+    uint32_t sum = 0;
+    uint32_t off = 0;
+    size_t i = 0;
+
+    // The first half of the name is xored in at rotating bit offsets
+    for (; i < half; ++i)
+    {
+        sum ^= static_cast<uint32_t>(normalizeChar(name[i])) << (off & 0x1F);
+        off += 8;
+    }
+
+    Hash hash;
+    hash.low = sum;
+
+    // The second half rotates the sum right after each character
+    sum = 0;
+    off = 0;
+    for (; i < len; ++i)
+    {
+        uint32_t temp = static_cast<uint32_t>(normalizeChar(name[i])) << (off & 0x1F);
+        sum ^= temp;
+        uint32_t n = temp & 0x1F;
+        if (n != 0)
+            sum = (sum << (32 - n)) | (sum >> n);
+        off += 8;
+    }
+
+    hash.high = sum;
+    return hash;
+}
+
 
 /// Error handling
 void BSAFile::fail(const string &msg)
@@ -62,7 +119,8 @@ void BSAFile::readHeader()
      *
      * ---------- end of directory block -------------
      *
-     * - 8*filenum - hash table block, we currently ignore this
+     * - 8*filenum - hash table block, a hash of each file name (see
+     *   getHash()), in the same order as the files
      *
      * ----------- start of data buffer --------------
      *
@@ -123,9 +181,13 @@ void BSAFile::readHeader()
     // Check our position
     assert(input.tellg() == std::streampos(12+dirsize));
 
+    // Read the hash table
+    hashes.resize(filenum);
+    if (filenum > 0)
+        input.read(reinterpret_cast<char*>(&hashes[0]), 8*filenum);
+
     // Calculate the offset of the data buffer. All file offsets are
     // relative to this. 12 header bytes + directory + hash table
-    // (skipped)
     size_t fileDataOffset = 12 + dirsize + 8*filenum;
 
     // Set up the the FileStruct table
@@ -139,9 +201,38 @@ void BSAFile::readHeader()
 
         if(fs.offset + fs.fileSize > fsize)
             fail("Archive contains offsets outside itself");
+    }
+
+    // Archives written by some tools have a hash table that doesn't match
+    // the file names. Lookups hash the requested name, so use computed
+    // hashes for those.
+    for(size_t i=0;i<filenum;i++)
+    {
+        if (!(getHash(files[i].name) == hashes[i]))
+        {
+            std::cerr << "Warning: hash table of " << filename << " does not match its file names" << std::endl;
+            for(size_t j=0;j<filenum;j++)
+                hashes[j] = getHash(files[j].name);
+            break;
+        }
+    }
 
-        // Add the file name to the lookup
-        lookup[fs.name] = i;
+    // Set up the lookup table, at most half full
+    size_t capacity = 16;
+    while (capacity < filenum*2)
+        capacity *= 2;
+
+    // Insert the files in reverse order. A lookup returns the first match along
+    // the probe sequence, so of several files with the same name the last one
+    // wins.
+    lookup.assign(capacity, 0);
+    const size_t mask = capacity - 1;
+    for(size_t i=filenum;i-- > 0;)
+    {
+        size_t slot = bucket(hashes[i]) & mask;
+        while (lookup[slot] != 0)
+            slot = (slot + 1) & mask;
+        lookup[slot] = static_cast<uint32_t>(i + 1);
     }
 
     isLoaded = true;
@@ -150,20 +241,37 @@ void BSAFile::readHeader()
 /// Get the index of a given file name, or -1 if not found
 int BSAFile::getIndex(const char *str) const
 {
-    Lookup::const_iterator it = lookup.find(str);
-    if(it == lookup.end())
+    if (lookup.empty())
         return -1;
 
-    int res = it->second;
-    assert(res >= 0 && (size_t)res < files.size());
-    return res;
+    const Hash hash = getHash(str);
+    const size_t mask = lookup.size() - 1;
+    for (size_t slot = bucket(hash) & mask; lookup[slot] != 0; slot = (slot + 1) & mask)
+    {
+        int res = lookup[slot] - 1;
+        assert((size_t)res < files.size());
+        if (!(hashes[res] == hash))
+            continue;
+
+        // Confirm the name, in case of a hash collision
+        const char *name = files[res].name;
+        size_t j = 0;
+        for (; str[j] != 0 && normalizeChar(str[j]) == normalizeChar(name[j]); ++j)
+            ;
+        if (str[j] == 0 && name[j] == 0)
+            return res;
+    }
+    return -1;
 }
 
 /// Open an archive file.
-void BSAFile::open(const string &file)
+void BSAFile::open(const string &file, bool memoryMapped)
 {
     filename = file;
     readHeader();
+
+    if (memoryMapped)
+        mappedFile = Files::openMappedFile(filename.c_str());
 }
 
 Files::IStreamPtr BSAFile::getFile(const char *file)
@@ -173,12 +281,19 @@ Files::IStreamPtr BSAFile::getFile(const char *file)
     if(i == -1)
         fail("File not found: " + string(file));
 
-    const FileStruct &fs = files[i];
-
-    return Files::openConstrainedFileStream (filename.c_str (), fs.offset, fs.fileSize);
+    return getFile(&files[i]);
 }
 
 Files::IStreamPtr BSAFile::getFile(const FileStruct *file)
 {
+    if (mappedFile)
+        return Files::openMappedFileStream (mappedFile, file->offset, file->fileSize);
     return Files::openConstrainedFileStream (filename.c_str (), file->offset, file->fileSize);
 }
+
+const char* BSAFile::getMappedData(const FileStruct *file) const
+{
+    if (!mappedFile)
+        return NULL;
+    return mappedFile->data() + file->offset;
+}
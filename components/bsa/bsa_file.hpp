@@ -27,11 +27,9 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
-#include <map>
-
-#include <components/misc/stringops.hpp>
 
 #include <components/files/constrainedfilestream.hpp>
+#include <components/files/mappedfile.hpp>
 
 
 namespace Bsa
@@ -56,6 +54,18 @@ public:
     };
     typedef std::vector<FileStruct> FileList;
 
+    /// The hash of a file name, as stored in the hash table block of the archive
+    struct Hash
+    {
+        uint32_t low, high;
+
+        bool operator==(const Hash &other) const
+        { return low == other.low && high == other.high; }
+    };
+
+    /// Compute the hash of a file name. Letter case and slash direction are ignored.
+    static Hash getHash(const char *name);
+
 private:
     /// Table of files in this archive
     FileList files;
@@ -69,19 +79,17 @@ private:
     /// Used for error messages
     std::string filename;
 
-    /// Case insensitive string comparison
-    struct iltstr
-    {
-        bool operator()(const char *s1, const char *s2) const
-        { return Misc::StringUtils::ciLess(s1, s2); }
-    };
+    /// The whole archive, if it is memory mapped
+    Files::MappedFilePtr mappedFile;
+
+    /// Hash of each file name, same order as files[]
+    std::vector<Hash> hashes;
 
-    /** A map used for fast file name lookup. The value is the index into
-        the files[] vector above. The iltstr ensures that file name
-        checks are case insensitive.
+    /** Open addressing hash table used for fast file name lookup. Each
+        slot holds an index into the files[] vector above plus one, or
+        zero if empty. Names are only compared when the hashes match.
     */
-    typedef std::map<const char*, int, iltstr> Lookup;
-    Lookup lookup;
+    std::vector<uint32_t> lookup;
 
     /// Error handling
     void fail(const std::string &msg);
@@ -104,7 +112,9 @@ public:
     { }
 
     /// Open an archive file.
-    void open(const std::string &file);
+    /// @param memoryMapped Map the archive into memory once, and return streams that read
+    /// from the mapping instead of opening the archive again for every file.
+    void open(const std::string &file, bool memoryMapped = false);
 
     /* -----------------------------------
      * Archive file routines
@@ -126,10 +136,20 @@ public:
     */
     Files::IStreamPtr getFile(const FileStruct* file);
 
+    /** Get the contents of a file contained in the archive straight from the mapping.
+     * @return NULL if the archive is not memory mapped.
+     * @note Thread safe.
+    */
+    const char* getMappedData(const FileStruct* file) const;
+
     /// Get a list of all files
     /// @note Thread safe.
     const FileList &getList() const
     { return files; }
+
+    /// Get the path of the archive
+    const std::string &getFilename() const
+    { return filename; }
 };
 
 }
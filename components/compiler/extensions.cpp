@@ -1,11 +1,35 @@
 #include "extensions.hpp"
 
 #include <cassert>
+#include <cstddef>
 #include <stdexcept>
 
+#include <components/misc/hash.hpp>
+
 #include "generator.hpp"
 #include "literals.hpp"
 
+namespace
+{
+    typedef Misc::Fnv1a<uint32_t> Hash;
+
+    void hashString (Hash& hash, const std::string& string)
+    {
+        // include the terminator, so that the boundaries between strings are part of the hash
+        hash.add (string.c_str(), string.size()+1);
+    }
+
+    void hashInt (Hash& hash, int value)
+    {
+        unsigned char bytes[4];
+
+        for (int i=0; i<4; ++i)
+            bytes[i] = static_cast<unsigned char> (static_cast<unsigned int> (value) >> (8*i));
+
+        hash.add (bytes, 4);
+    }
+}
+
 namespace Compiler
 {
     Extensions::Extensions() : mNextKeywordIndex (-1) {}
@@ -213,4 +237,36 @@ namespace Compiler
             iter!=mKeywords.end(); ++iter)
             keywords.push_back (iter->first);
     }
+
+    unsigned int Extensions::getHash() const
+    {
+        Hash hash;
+
+        for (std::map<std::string, int>::const_iterator iter (mKeywords.begin());
+            iter!=mKeywords.end(); ++iter)
+        {
+            hashString (hash, iter->first);
+
+            std::map<int, Function>::const_iterator function = mFunctions.find (iter->second);
+
+            if (function!=mFunctions.end())
+            {
+                hashInt (hash, function->second.mReturn);
+                hashString (hash, function->second.mArguments);
+                hashInt (hash, function->second.mCode);
+                hashInt (hash, function->second.mCodeExplicit);
+            }
+
+            std::map<int, Instruction>::const_iterator instruction = mInstructions.find (iter->second);
+
+            if (instruction!=mInstructions.end())
+            {
+                hashString (hash, instruction->second.mArguments);
+                hashInt (hash, instruction->second.mCode);
+                hashInt (hash, instruction->second.mCodeExplicit);
+            }
+        }
+
+        return hash.get();
+    }
 }
@@ -109,6 +109,10 @@ namespace Compiler
 
             void listKeywords (std::vector<std::string>& keywords) const;
             ///< Append all known keywords to \a kaywords.
+
+            unsigned int getHash() const;
+            ///< Return a hash of all registered keywords, their arguments and opcodes. Code compiled
+            /// with a different set of extensions can't be reused if the hash differs.
     };
 }
 
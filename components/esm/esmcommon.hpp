@@ -108,6 +108,35 @@ typedef FIXED_STRING<32> NAME32;
 typedef FIXED_STRING<64> NAME64;
 typedef FIXED_STRING<256> NAME256;
 
+/* A non-owning reference to a string inside the buffer of an ESMReader.
+   The referenced data is not converted to UTF8 and is only valid until
+   the next read from the reader that returned it (or, for memory mapped
+   readers, until the reader is closed). Use ESMReader::toString() to
+   get a converted copy that can be stored.
+ */
+struct StringRef
+{
+    const char* mData;
+    size_t mSize;
+
+    StringRef() : mData(NULL), mSize(0) {}
+    StringRef(const char* data, size_t size) : mData(data), mSize(size) {}
+
+    bool empty() const { return mSize == 0; }
+
+    bool operator==(const char* str) const
+    {
+        return std::strlen(str) == mSize && std::memcmp(mData, str, mSize) == 0;
+    }
+    bool operator!=(const char* str) const { return !( (*this) == str ); }
+
+    bool operator==(const std::string& str) const
+    {
+        return str.size() == mSize && std::memcmp(mData, str.data(), mSize) == 0;
+    }
+    bool operator!=(const std::string& str) const { return !( (*this) == str ); }
+};
+
 /* This struct defines a file 'context' which can be saved and later
    restored by an ESMReader instance. It will save the position within
    a file, and when restored will let you read from that position as
@@ -15,7 +15,7 @@ using namespace Misc;
 ESM_Context ESMReader::getContext()
 {
     // Update the file position before returning
-    mCtx.filePos = mEsm->tellg();
+    mCtx.filePos = getFileOffset();
     return mCtx;
 }
 
@@ -26,6 +26,8 @@ ESMReader::ESMReader()
     , mGlobalReaderList(NULL)
     , mEncoder(NULL)
     , mFileSize(0)
+    , mMappedOffset(0)
+    , mUseMappedFile(false)
 {
 }
 
@@ -44,12 +46,17 @@ void ESMReader::restoreContext(const ESM_Context &rc)
     mCtx = rc;
 
     // Make sure we seek to the right place
-    mEsm->seekg(mCtx.filePos);
+    if (mMappedFile)
+        mMappedOffset = mCtx.filePos;
+    else
+        mEsm->seekg(mCtx.filePos);
 }
 
 void ESMReader::close()
 {
     mEsm.reset();
+    mMappedFile.reset();
+    mMappedOffset = 0;
     mCtx.filename.clear();
     mCtx.leftFile = 0;
     mCtx.leftRec = 0;
@@ -69,15 +76,24 @@ void ESMReader::openRaw(Files::IStreamPtr _esm, const std::string& name)
     mEsm->seekg(0, mEsm->beg);
 }
 
-void ESMReader::openRaw(const std::string& filename)
+void ESMReader::openRaw(Files::MappedFilePtr file, const std::string& name)
 {
-    openRaw(Files::openConstrainedFileStream(filename.c_str()), filename);
+    close();
+    mMappedFile = file;
+    mCtx.filename = name;
+    mCtx.leftFile = mFileSize = mMappedFile->size();
 }
 
-void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
+void ESMReader::openRaw(const std::string& filename)
 {
-    openRaw(_esm, name);
+    if (mUseMappedFile)
+        openRaw(Files::openMappedFile(filename.c_str()), filename);
+    else
+        openRaw(Files::openConstrainedFileStream(filename.c_str()), filename);
+}
 
+void ESMReader::readHeader()
+{
     if (getRecName() != "TES3")
         fail("Not a valid Morrowind file");
 
@@ -86,9 +102,22 @@ void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
     mHeader.load (*this);
 }
 
+void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
+{
+    openRaw(_esm, name);
+    readHeader();
+}
+
+void ESMReader::open(Files::MappedFilePtr file, const std::string &name)
+{
+    openRaw(file, name);
+    readHeader();
+}
+
 void ESMReader::open(const std::string &file)
 {
-    open (Files::openConstrainedFileStream (file.c_str ()), file);
+    openRaw(file);
+    readHeader();
 }
 
 int64_t ESMReader::getHNLong(const char *name)
@@ -132,6 +161,27 @@ std::string ESMReader::getHString()
     return getString(mCtx.leftSub);
 }
 
+StringRef ESMReader::getHNStringRef(const char* name)
+{
+    getSubNameIs(name);
+    return getHStringRef();
+}
+
+StringRef ESMReader::getHStringRef()
+{
+    getSubHeader();
+
+    // See getHString()
+    if (mCtx.leftSub == 0)
+    {
+        mCtx.leftRec--;
+        skip(1);
+        return StringRef();
+    }
+
+    return getStringRef(mCtx.leftSub);
+}
+
 void ESMReader::getHExact(void*p, int size)
 {
     getSubHeader();
@@ -315,6 +365,16 @@ void ESMReader::getRecHeader(uint32_t &flags)
 
 void ESMReader::getExact(void*x, int size)
 {
+    if (mMappedFile)
+    {
+        if (size < 0 || mMappedOffset + size > mMappedFile->size())
+            fail("Read error: unexpected end of file");
+
+        memcpy(x, mMappedFile->data() + mMappedOffset, size);
+        mMappedOffset += size;
+        return;
+    }
+
     try
     {
         mEsm->read((char*)x, size);
@@ -327,6 +387,32 @@ void ESMReader::getExact(void*x, int size)
 
 std::string ESMReader::getString(int size)
 {
+    if (mMappedFile)
+    {
+        if (size < 0 || mMappedOffset + size > mMappedFile->size())
+            fail("Read error: unexpected end of file");
+
+        // Strings are read straight from the mapping
+        const char *ptr = mMappedFile->data() + mMappedOffset;
+        mMappedOffset += size;
+        size_t length = strnlen(ptr, size);
+
+        // The encoder expects zero terminated input, which the mapping is not.
+        // Pure ascii strings don't need any conversion, others are copied
+        // to the buffer first.
+        bool ascii = true;
+        for (size_t i = 0; i < length && ascii; ++i)
+            ascii = static_cast<unsigned char>(ptr[i]) < 128;
+        if (!mEncoder || ascii)
+            return std::string (ptr, length);
+
+        if (mBuffer.size() <= length)
+            mBuffer.resize(3*length);
+        memcpy(&mBuffer[0], ptr, length);
+        mBuffer[length] = 0;
+        return mEncoder->getUtf8(&mBuffer[0], length);
+    }
+
     size_t s = size;
     if (mBuffer.size() <= s)
         // Add some extra padding to reduce the chance of having to resize
@@ -349,6 +435,52 @@ std::string ESMReader::getString(int size)
     return std::string (ptr, size);
 }
 
+StringRef ESMReader::getStringRef(int size)
+{
+    if (mMappedFile)
+    {
+        if (size < 0 || mMappedOffset + size > mMappedFile->size())
+            fail("Read error: unexpected end of file");
+
+        // Strings are referenced straight in the mapping, no copy needed
+        const char *ptr = mMappedFile->data() + mMappedOffset;
+        mMappedOffset += size;
+        return StringRef(ptr, strnlen(ptr, size));
+    }
+
+    size_t s = size;
+    if (mBuffer.size() <= s)
+        mBuffer.resize(3*s);
+
+    mBuffer[s] = 0;
+
+    char *ptr = &mBuffer[0];
+    getExact(ptr, size);
+
+    return StringRef(ptr, strnlen(ptr, size));
+}
+
+std::string ESMReader::toString(const StringRef &ref)
+{
+    bool ascii = true;
+    for (size_t i = 0; i < ref.mSize && ascii; ++i)
+        ascii = static_cast<unsigned char>(ref.mData[i]) < 128;
+    if (!mEncoder || ascii)
+        return std::string (ref.mData, ref.mSize);
+
+    // The encoder expects zero terminated input. A reference into the
+    // mapping is not, so it is copied to the buffer first.
+    if (mBuffer.empty() || ref.mData != &mBuffer[0])
+    {
+        if (mBuffer.size() <= ref.mSize)
+            mBuffer.resize(3*ref.mSize);
+        memcpy(&mBuffer[0], ref.mData, ref.mSize);
+        mBuffer[ref.mSize] = 0;
+    }
+
+    return mEncoder->getUtf8(&mBuffer[0], ref.mSize);
+}
+
 void ESMReader::fail(const std::string &msg)
 {
     using namespace std;
@@ -359,8 +491,8 @@ void ESMReader::fail(const std::string &msg)
     ss << "\n  File: " << mCtx.filename;
     ss << "\n  Record: " << mCtx.recName.toString();
     ss << "\n  Subrecord: " << mCtx.subName.toString();
-    if (mEsm.get())
-        ss << "\n  Offset: 0x" << hex << mEsm->tellg();
+    if (mEsm.get() || mMappedFile.get())
+        ss << "\n  Offset: 0x" << hex << getFileOffset();
     throw std::runtime_error(ss.str());
 }
 
@@ -371,11 +503,18 @@ void ESMReader::setEncoder(ToUTF8::Utf8Encoder* encoder)
 
 size_t ESMReader::getFileOffset()
 {
+    if (mMappedFile)
+        return mMappedOffset;
     return mEsm->tellg();
 }
 
 void ESMReader::skip(int bytes)
 {
+    if (mMappedFile)
+    {
+        mMappedOffset += bytes;
+        return;
+    }
     mEsm->seekg(getFileOffset()+bytes);
 }
 
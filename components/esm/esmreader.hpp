@@ -8,6 +8,7 @@
 #include <sstream>
 
 #include <components/files/constrainedfilestream.hpp>
+#include <components/files/mappedfile.hpp>
 
 #include <components/misc/stringops.hpp>
 
@@ -73,6 +74,18 @@ public:
 
   void openRaw(const std::string &filename);
 
+  /// Raw opening of a file that has already been mapped into memory.
+  void openRaw(Files::MappedFilePtr file, const std::string &name);
+
+  /// Load ES file from a memory mapping, parses the header.
+  void open(Files::MappedFilePtr file, const std::string &name);
+
+  /// If enabled, files opened by name (including reopening in restoreContext())
+  /// are mapped into memory and read directly from the mapping instead of
+  /// through a file stream.
+  void setMemoryMapped(bool enabled) { mUseMappedFile = enabled; }
+  bool isMemoryMapped() const { return mUseMappedFile; }
+
   /// Get the current position in the file. Make sure that the file has been opened!
   size_t getFileOffset();
 
@@ -161,6 +174,13 @@ public:
   // Read a string, including the sub-record header (but not the name)
   std::string getHString();
 
+  // Same as getHNString(), but returns a reference into the reader's
+  // buffer instead of a converted copy. See StringRef for lifetime rules.
+  StringRef getHNStringRef(const char* name);
+
+  // Same as getHString(), but returns a reference into the reader's buffer.
+  StringRef getHStringRef();
+
   // Read the given number of bytes from a subrecord
   void getHExact(void*p, int size);
 
@@ -255,6 +275,13 @@ public:
   // them from native encoding to UTF8 in the process.
   std::string getString(int size);
 
+  // Read the next 'size' bytes without copying or converting them when
+  // possible. The result is cut off at the first zero byte, like getString().
+  StringRef getStringRef(int size);
+
+  // Convert a string reference from native encoding to UTF8.
+  std::string toString(const StringRef &ref);
+
   void skip(int bytes);
 
   /// Used for error handling
@@ -269,6 +296,8 @@ public:
   size_t getFileSize() const { return mFileSize; }
 
 private:
+  void readHeader();
+
   Files::IStreamPtr mEsm;
 
   ESM_Context mCtx;
@@ -287,6 +316,11 @@ private:
 
   size_t mFileSize;
 
+  // Only set for memory mapped files, in which case mEsm is empty
+  Files::MappedFilePtr mMappedFile;
+  size_t mMappedOffset;
+  bool mUseMappedFile;
+
 };
 }
 #endif
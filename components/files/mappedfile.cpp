@@ -0,0 +1,177 @@
+#include "mappedfile.hpp"
+
+#include <stdexcept>
+#include <sstream>
+
+#if FILE_API == FILE_API_POSIX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#elif FILE_API == FILE_API_WIN32
+#include <boost/locale.hpp>
+#endif
+
+namespace Files
+{
+
+#if FILE_API == FILE_API_POSIX
+
+    MappedFile::MappedFile(const char* filename)
+        : mData(NULL)
+        , mSize(0)
+        , mMapping(MAP_FAILED)
+    {
+#ifdef O_BINARY
+        static const int openFlags = O_RDONLY | O_BINARY;
+#else
+        static const int openFlags = O_RDONLY;
+#endif
+
+        int handle = ::open(filename, openFlags, 0);
+        if (handle == -1)
+        {
+            std::ostringstream os;
+            os << "Failed to open '" << filename << "' for reading: " << strerror(errno);
+            throw std::runtime_error(os.str());
+        }
+
+        struct stat info;
+        if (::fstat(handle, &info) == -1)
+        {
+            std::ostringstream os;
+            os << "An fstat() call failed on '" << filename << "': " << strerror(errno);
+            ::close(handle);
+            throw std::runtime_error(os.str());
+        }
+
+        mSize = static_cast<size_t>(info.st_size);
+
+        if (mSize > 0)
+        {
+            mMapping = ::mmap(NULL, mSize, PROT_READ, MAP_PRIVATE, handle, 0);
+            if (mMapping == MAP_FAILED)
+            {
+                std::ostringstream os;
+                os << "Failed to map '" << filename << "' into memory: " << strerror(errno);
+                ::close(handle);
+                throw std::runtime_error(os.str());
+            }
+            mData = static_cast<const char*>(mMapping);
+        }
+
+        // The mapping stays valid after the descriptor is closed
+        ::close(handle);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (mMapping != MAP_FAILED)
+            ::munmap(mMapping, mSize);
+    }
+
+#elif FILE_API == FILE_API_WIN32
+
+    MappedFile::MappedFile(const char* filename)
+        : mData(NULL)
+        , mSize(0)
+        , mFile(INVALID_HANDLE_VALUE)
+        , mMapping(NULL)
+    {
+        std::wstring wname = boost::locale::conv::utf_to_utf<wchar_t>(filename);
+        mFile = CreateFileW(wname.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+
+        if (mFile == INVALID_HANDLE_VALUE)
+        {
+            std::ostringstream os;
+            os << "Failed to open '" << filename << "' for reading.";
+            throw std::runtime_error(os.str());
+        }
+
+        BY_HANDLE_FILE_INFORMATION info;
+        if (!GetFileInformationByHandle(mFile, &info))
+        {
+            CloseHandle(mFile);
+            throw std::runtime_error("A query operation on a file failed.");
+        }
+
+        if (info.nFileSizeHigh != 0)
+        {
+            CloseHandle(mFile);
+            throw std::runtime_error("Files greater that 4GB are not supported.");
+        }
+
+        mSize = info.nFileSizeLow;
+
+        if (mSize > 0)
+        {
+            mMapping = CreateFileMappingW(mFile, 0, PAGE_READONLY, 0, 0, 0);
+            const void* view = mMapping ? MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+            if (view == NULL)
+            {
+                if (mMapping)
+                    CloseHandle(mMapping);
+                CloseHandle(mFile);
+
+                std::ostringstream os;
+                os << "Failed to map '" << filename << "' into memory.";
+                throw std::runtime_error(os.str());
+            }
+            mData = static_cast<const char*>(view);
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (mData)
+            UnmapViewOfFile(mData);
+        if (mMapping)
+            CloseHandle(mMapping);
+        CloseHandle(mFile);
+    }
+
+#else
+
+    MappedFile::MappedFile(const char* filename)
+        : mData(NULL)
+        , mSize(0)
+    {
+        LowLevelFile file;
+        file.open(filename);
+
+        mSize = file.size();
+        if (mSize > 0)
+        {
+            mBuffer.resize(mSize);
+            if (file.read(&mBuffer[0], mSize) != mSize)
+            {
+                std::ostringstream os;
+                os << "Failed to read '" << filename << "'.";
+                throw std::runtime_error(os.str());
+            }
+            mData = &mBuffer[0];
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+    }
+
+#endif
+
+    MappedFilePtr openMappedFile(const char* filename)
+    {
+        return MappedFilePtr(new MappedFile(filename));
+    }
+
+    IStreamPtr openMappedFileStream(const MappedFilePtr& file, size_t start, size_t length)
+    {
+        if (start > file->size() || length > file->size() - start)
+            throw std::runtime_error("Stream range is outside of the mapped file");
+        return IStreamPtr(new MappedFileStream(file, start, length));
+    }
+
+}
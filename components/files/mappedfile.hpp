@@ -0,0 +1,73 @@
+#ifndef OPENMW_COMPONENTS_FILES_MAPPEDFILE_H
+#define OPENMW_COMPONENTS_FILES_MAPPEDFILE_H
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "lowlevelfile.hpp"
+#include "constrainedfilestream.hpp"
+#include "memorystream.hpp"
+
+namespace Files
+{
+
+    /// @brief A read-only view of an entire file mapped into the address space of the process.
+    /// @note On platforms without a mapping API the file contents are read into a heap buffer instead.
+    class MappedFile
+    {
+    public:
+        /// @note Throws std::runtime_error if the file can not be opened or mapped.
+        MappedFile(const char* filename);
+        ~MappedFile();
+
+        /// Pointer to the first byte of the file, or NULL for an empty file.
+        const char* data() const { return mData; }
+
+        size_t size() const { return mSize; }
+
+    private:
+        // not implemented
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+
+        const char* mData;
+        size_t mSize;
+
+#if FILE_API == FILE_API_POSIX
+        void* mMapping;
+#elif FILE_API == FILE_API_WIN32
+        HANDLE mFile;
+        HANDLE mMapping;
+#else
+        std::vector<char> mBuffer;
+#endif
+    };
+
+    typedef boost::shared_ptr<MappedFile> MappedFilePtr;
+
+    MappedFilePtr openMappedFile(const char* filename);
+
+    /// @brief A stream that reads a range of a MappedFile straight from memory.
+    /// @note Holds a reference to the MappedFile, so that the mapping stays valid as long as the stream exists.
+    struct MappedFileStream : virtual MemBuf, std::istream
+    {
+        MappedFileStream(const MappedFilePtr& file, size_t start, size_t length)
+            : MemBuf(file->data() + start, length)
+            , std::istream(static_cast<std::streambuf*>(this))
+            , mFile(file)
+        {
+        }
+
+    private:
+        MappedFilePtr mFile;
+    };
+
+    /// Open a stream over \a length bytes of \a file, starting at \a start.
+    /// @note Throws std::runtime_error if the range is outside of the file.
+    IStreamPtr openMappedFileStream(const MappedFilePtr& file, size_t start, size_t length);
+
+}
+
+#endif
@@ -49,6 +49,23 @@ namespace Interpreter
 
             virtual void setGlobalFloat (const std::string& name, float value) = 0;
 
+            virtual int getGlobalSlot (const std::string& name) const = 0;
+            ///< Return a slot, that can be used instead of \a name to access the global variable,
+            /// or -1, if there is no such variable. Slots stay valid as long as the content files
+            /// do not change.
+
+            virtual int getGlobalShort (int slot) const = 0;
+
+            virtual int getGlobalLong (int slot) const = 0;
+
+            virtual float getGlobalFloat (int slot) const = 0;
+
+            virtual void setGlobalShort (int slot, int value) = 0;
+
+            virtual void setGlobalLong (int slot, int value) = 0;
+
+            virtual void setGlobalFloat (int slot, float value) = 0;
+
             virtual std::vector<std::string> getGlobals () const = 0;
 
             virtual char getGlobalType (const std::string& name) const = 0;
@@ -96,18 +113,27 @@ namespace Interpreter
 
             virtual void disable (const std::string& id = "") = 0;
 
-            virtual int getMemberShort (const std::string& id, const std::string& name, bool global) const = 0;
+            /// \a slot is the index of the variable \a name within the locals of the script, as
+            /// returned by an earlier call for the same variable, or -1, if unknown. If it turns out
+            /// to be wrong, it is replaced with the correct index.
+
+            virtual int getMemberShort (const std::string& id, const std::string& name, bool global,
+                int& slot) const = 0;
 
-            virtual int getMemberLong (const std::string& id, const std::string& name, bool global) const = 0;
+            virtual int getMemberLong (const std::string& id, const std::string& name, bool global,
+                int& slot) const = 0;
 
-            virtual float getMemberFloat (const std::string& id, const std::string& name, bool global) const = 0;
+            virtual float getMemberFloat (const std::string& id, const std::string& name, bool global,
+                int& slot) const = 0;
 
-            virtual void setMemberShort (const std::string& id, const std::string& name, int value, bool global) = 0;
+            virtual void setMemberShort (const std::string& id, const std::string& name, int value,
+                bool global, int& slot) = 0;
 
-            virtual void setMemberLong (const std::string& id, const std::string& name, int value, bool global) = 0;
+            virtual void setMemberLong (const std::string& id, const std::string& name, int value,
+                bool global, int& slot) = 0;
 
-            virtual void setMemberFloat (const std::string& id, const std::string& name, float value, bool global)
-                = 0;
+            virtual void setMemberFloat (const std::string& id, const std::string& name, float value,
+                bool global, int& slot) = 0;
 
             virtual std::string getTargetId() const = 0;
     };
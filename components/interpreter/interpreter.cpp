@@ -1,6 +1,7 @@
 #include "interpreter.hpp"
 
 #include <cassert>
+#include <cstring>
 #include <sstream>
 #include <stdexcept>
 
@@ -8,7 +9,7 @@
 
 namespace Interpreter
 {
-    void Interpreter::execute (Type_Code code)
+    void Interpreter::decode (Type_Code code, Instruction& instruction) const
     {
         unsigned int segSpec = code>>30;
 
@@ -16,46 +17,54 @@ namespace Interpreter
         {
             case 0:
             {
-                int opcode = code>>24;
-                unsigned int arg0 = code & 0xffffff;
-
-                std::map<int, Opcode1 *>::iterator iter = mSegment0.find (opcode);
-
-                if (iter==mSegment0.end())
-                    abortUnknownCode (0, opcode);
-
-                iter->second->execute (mRuntime, arg0);
+                unsigned int opcode = code>>24;
+                instruction.mKind = Instruction::Kind_Opcode1;
+                instruction.mOpcode1 = mSegment0.find (opcode);
+                instruction.mArg0 = code & 0xffffff;
+                instruction.mArg1 = 0;
+
+                if (!instruction.mOpcode1)
+                {
+                    instruction.mKind = Instruction::Kind_Unknown;
+                    instruction.mArg0 = 0;
+                    instruction.mArg1 = opcode;
+                }
 
                 return;
             }
 
             case 1:
             {
-                int opcode = (code>>24) & 0x3f;
-                unsigned int arg0 = (code>>16) & 0xfff;
-                unsigned int arg1 = code & 0xfff;
-
-                std::map<int, Opcode2 *>::iterator iter = mSegment1.find (opcode);
-
-                if (iter==mSegment1.end())
-                    abortUnknownCode (1, opcode);
-
-                iter->second->execute (mRuntime, arg0, arg1);
+                unsigned int opcode = (code>>24) & 0x3f;
+                instruction.mKind = Instruction::Kind_Opcode2;
+                instruction.mOpcode2 = mSegment1.find (opcode);
+                instruction.mArg0 = (code>>16) & 0xfff;
+                instruction.mArg1 = code & 0xfff;
+
+                if (!instruction.mOpcode2)
+                {
+                    instruction.mKind = Instruction::Kind_Unknown;
+                    instruction.mArg0 = 1;
+                    instruction.mArg1 = opcode;
+                }
 
                 return;
             }
 
             case 2:
             {
-                int opcode = (code>>20) & 0x3ff;
-                unsigned int arg0 = code & 0xfffff;
-
-                std::map<int, Opcode1 *>::iterator iter = mSegment2.find (opcode);
-
-                if (iter==mSegment2.end())
-                    abortUnknownCode (2, opcode);
-
-                iter->second->execute (mRuntime, arg0);
+                unsigned int opcode = (code>>20) & 0x3ff;
+                instruction.mKind = Instruction::Kind_Opcode1;
+                instruction.mOpcode1 = mSegment2.find (opcode);
+                instruction.mArg0 = code & 0xfffff;
+                instruction.mArg1 = 0;
+
+                if (!instruction.mOpcode1)
+                {
+                    instruction.mKind = Instruction::Kind_Unknown;
+                    instruction.mArg0 = 2;
+                    instruction.mArg1 = opcode;
+                }
 
                 return;
             }
@@ -67,51 +76,92 @@ namespace Interpreter
         {
             case 0x30:
             {
-                int opcode = (code>>8) & 0x3ffff;
-                unsigned int arg0 = code & 0xff;
-
-                std::map<int, Opcode1 *>::iterator iter = mSegment3.find (opcode);
-
-                if (iter==mSegment3.end())
-                    abortUnknownCode (3, opcode);
-
-                iter->second->execute (mRuntime, arg0);
+                unsigned int opcode = (code>>8) & 0x3ffff;
+                instruction.mKind = Instruction::Kind_Opcode1;
+                instruction.mOpcode1 = mSegment3.find (opcode);
+                instruction.mArg0 = code & 0xff;
+                instruction.mArg1 = 0;
+
+                if (!instruction.mOpcode1)
+                {
+                    instruction.mKind = Instruction::Kind_Unknown;
+                    instruction.mArg0 = 3;
+                    instruction.mArg1 = opcode;
+                }
 
                 return;
             }
 
             case 0x31:
             {
-                int opcode = (code>>16) & 0x3ff;
-                unsigned int arg0 = (code>>8) & 0xff;
-                unsigned int arg1 = code & 0xff;
-
-                std::map<int, Opcode2 *>::iterator iter = mSegment4.find (opcode);
-
-                if (iter==mSegment4.end())
-                    abortUnknownCode (4, opcode);
-
-                iter->second->execute (mRuntime, arg0, arg1);
+                unsigned int opcode = (code>>16) & 0x3ff;
+                instruction.mKind = Instruction::Kind_Opcode2;
+                instruction.mOpcode2 = mSegment4.find (opcode);
+                instruction.mArg0 = (code>>8) & 0xff;
+                instruction.mArg1 = code & 0xff;
+
+                if (!instruction.mOpcode2)
+                {
+                    instruction.mKind = Instruction::Kind_Unknown;
+                    instruction.mArg0 = 4;
+                    instruction.mArg1 = opcode;
+                }
 
                 return;
             }
 
             case 0x32:
             {
-                int opcode = code & 0x3ffffff;
+                unsigned int opcode = code & 0x3ffffff;
+                instruction.mKind = Instruction::Kind_Opcode0;
+                instruction.mOpcode0 = mSegment5.find (opcode);
+                instruction.mArg0 = 0;
+                instruction.mArg1 = 0;
+
+                if (!instruction.mOpcode0)
+                {
+                    instruction.mKind = Instruction::Kind_Unknown;
+                    instruction.mArg0 = 5;
+                    instruction.mArg1 = opcode;
+                }
+
+                return;
+            }
+        }
+
+        // reported when executed, like unknown opcodes
+        instruction.mKind = Instruction::Kind_Unknown;
+        instruction.mOpcode0 = 0;
+        instruction.mArg0 = ~0u;
+        instruction.mArg1 = code;
+    }
 
-                std::map<int, Opcode0 *>::iterator iter = mSegment5.find (opcode);
+    void Interpreter::execute (const Instruction& instruction)
+    {
+        switch (instruction.mKind)
+        {
+            case Instruction::Kind_Opcode0:
 
-                if (iter==mSegment5.end())
-                    abortUnknownCode (5, opcode);
+                instruction.mOpcode0->execute (mRuntime);
+                return;
 
-                iter->second->execute (mRuntime);
+            case Instruction::Kind_Opcode1:
 
+                instruction.mOpcode1->execute (mRuntime, instruction.mArg0);
                 return;
-            }
-        }
 
-        abortUnknownSegment (code);
+            case Instruction::Kind_Opcode2:
+
+                instruction.mOpcode2->execute (mRuntime, instruction.mArg0, instruction.mArg1);
+                return;
+
+            case Instruction::Kind_Unknown:
+
+                if (instruction.mArg0==~0u)
+                    abortUnknownSegment (instruction.mArg1);
+
+                abortUnknownCode (instruction.mArg0, instruction.mArg1);
+        }
     }
 
     void Interpreter::abortUnknownCode (int segment, int opcode)
@@ -159,70 +209,87 @@ namespace Interpreter
         }
     }
 
-    Interpreter::Interpreter() : mRunning (false)
+    Interpreter::Interpreter()
+    : mRunning (false), mSegment0 (0x40), mSegment1 (0x40), mSegment2 (0x400), mSegment3 (0x40000),
+      mSegment4 (0x400), mSegment5 (0x4000000)
     {}
 
     Interpreter::~Interpreter()
-    {
-        for (std::map<int, Opcode1 *>::iterator iter (mSegment0.begin());
-            iter!=mSegment0.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode2 *>::iterator iter (mSegment1.begin());
-            iter!=mSegment1.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode1 *>::iterator iter (mSegment2.begin());
-            iter!=mSegment2.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode1 *>::iterator iter (mSegment3.begin());
-            iter!=mSegment3.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode2 *>::iterator iter (mSegment4.begin());
-            iter!=mSegment4.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode0 *>::iterator iter (mSegment5.begin());
-            iter!=mSegment5.end(); ++iter)
-            delete iter->second;
-    }
+    {}
 
     void Interpreter::installSegment0 (int code, Opcode1 *opcode)
     {
-        assert(mSegment0.find(code) == mSegment0.end());
-        mSegment0.insert (std::make_pair (code, opcode));
+        bool installed = mSegment0.install (code, opcode);
+        assert (installed);
+        (void)installed;
     }
 
     void Interpreter::installSegment1 (int code, Opcode2 *opcode)
     {
-        assert(mSegment1.find(code) == mSegment1.end());
-        mSegment1.insert (std::make_pair (code, opcode));
+        bool installed = mSegment1.install (code, opcode);
+        assert (installed);
+        (void)installed;
     }
 
     void Interpreter::installSegment2 (int code, Opcode1 *opcode)
     {
-        assert(mSegment2.find(code) == mSegment2.end());
-        mSegment2.insert (std::make_pair (code, opcode));
+        bool installed = mSegment2.install (code, opcode);
+        assert (installed);
+        (void)installed;
     }
 
     void Interpreter::installSegment3 (int code, Opcode1 *opcode)
     {
-        assert(mSegment3.find(code) == mSegment3.end());
-        mSegment3.insert (std::make_pair (code, opcode));
+        bool installed = mSegment3.install (code, opcode);
+        assert (installed);
+        (void)installed;
     }
 
     void Interpreter::installSegment4 (int code, Opcode2 *opcode)
     {
-        assert(mSegment4.find(code) == mSegment4.end());
-        mSegment4.insert (std::make_pair (code, opcode));
+        bool installed = mSegment4.install (code, opcode);
+        assert (installed);
+        (void)installed;
     }
 
     void Interpreter::installSegment5 (int code, Opcode0 *opcode)
     {
-        assert(mSegment5.find(code) == mSegment5.end());
-        mSegment5.insert (std::make_pair (code, opcode));
+        bool installed = mSegment5.install (code, opcode);
+        assert (installed);
+        (void)installed;
+    }
+
+    void Interpreter::decode (const Type_Code *code, int codeSize, Program& program) const
+    {
+        assert (codeSize>=4);
+
+        int opcodes = static_cast<int> (code[0]);
+
+        const Type_Code *codeBlock = code + 4;
+
+        program.mInstructions.resize (opcodes);
+
+        for (int i=0; i<opcodes; ++i)
+            decode (codeBlock[i], program.mInstructions[i]);
+
+        const char *literalBlock =
+            reinterpret_cast<const char *> (code + 4 + code[0] + code[1] + code[2]);
+        int literalSize = static_cast<int> (code[3]) * 4;
+
+        program.mStringLiterals.clear();
+
+        for (int offset = 0; offset<literalSize; )
+        {
+            int length = std::strlen (literalBlock+offset);
+            program.mStringLiterals.push_back (std::string (literalBlock+offset, length));
+            offset += length + 1;
+        }
+
+        program.mGlobalSlots.assign (program.mStringLiterals.size(), Program::Slot_Unresolved);
+        program.mMemberSlots.assign (program.mStringLiterals.size(), -1);
+
+        program.mCode = code;
+        program.mCodeSize = codeSize;
     }
 
     void Interpreter::run (const Type_Code *code, int codeSize, Context& context)
@@ -239,11 +306,43 @@ namespace Interpreter
 
             const Type_Code *codeBlock = code + 4;
 
+            Instruction instruction;
+
+            while (mRuntime.getPC()>=0 && mRuntime.getPC()<opcodes)
+            {
+                decode (codeBlock[mRuntime.getPC()], instruction);
+                mRuntime.setPC (mRuntime.getPC()+1);
+                execute (instruction);
+            }
+        }
+        catch (...)
+        {
+            end();
+            throw;
+        }
+
+        end();
+    }
+
+    void Interpreter::run (const Program& program, Context& context)
+    {
+        assert (!program.empty());
+
+        begin();
+
+        try
+        {
+            mRuntime.configure (program, context);
+
+            int opcodes = static_cast<int> (program.mInstructions.size());
+
+            const Instruction *instructions = opcodes>0 ? &program.mInstructions[0] : 0;
+
             while (mRuntime.getPC()>=0 && mRuntime.getPC()<opcodes)
             {
-                Type_Code runCode = codeBlock[mRuntime.getPC()];
+                const Instruction& instruction = instructions[mRuntime.getPC()];
                 mRuntime.setPC (mRuntime.getPC()+1);
-                execute (runCode);
+                execute (instruction);
             }
         }
         catch (...)
@@ -1,11 +1,12 @@
 #ifndef INTERPRETER_INTERPRETER_H_INCLUDED
 #define INTERPRETER_INTERPRETER_H_INCLUDED
 
-#include <map>
 #include <stack>
+#include <vector>
 
 #include "runtime.hpp"
 #include "types.hpp"
+#include "program.hpp"
 
 namespace Interpreter
 {
@@ -13,23 +14,80 @@ namespace Interpreter
     class Opcode1;
     class Opcode2;
 
+    /// Opcode handlers of one segment, in arrays indexed by opcode
+    ///
+    /// The upper half of each segment is reserved for extensions, so the lower and upper half
+    /// get an array each, starting at the first opcode of the half.
+
+    template<typename T>
+    class OpcodeTable
+    {
+            unsigned int mExtensionBase;
+            std::vector<T *> mCore;
+            std::vector<T *> mExtensions;
+
+            // not implemented
+            OpcodeTable (const OpcodeTable&);
+            OpcodeTable& operator= (const OpcodeTable&);
+
+        public:
+
+            OpcodeTable (unsigned int segmentSize) : mExtensionBase (segmentSize/2) {}
+
+            ~OpcodeTable()
+            {
+                for (typename std::vector<T *>::iterator iter (mCore.begin()); iter!=mCore.end(); ++iter)
+                    delete *iter;
+
+                for (typename std::vector<T *>::iterator iter (mExtensions.begin()); iter!=mExtensions.end(); ++iter)
+                    delete *iter;
+            }
+
+            bool install (unsigned int code, T *opcode)
+            ///< \return false, if there already is an opcode \a code.
+            {
+                std::vector<T *>& table = code<mExtensionBase ? mCore : mExtensions;
+                unsigned int index = code<mExtensionBase ? code : code-mExtensionBase;
+
+                if (index>=table.size())
+                    table.resize (index+1, 0);
+                else if (table[index])
+                    return false;
+
+                table[index] = opcode;
+                return true;
+            }
+
+            T *find (unsigned int code) const
+            ///< \return 0, if there is no opcode \a code.
+            {
+                if (code<mExtensionBase)
+                    return code<mCore.size() ? mCore[code] : 0;
+
+                code -= mExtensionBase;
+                return code<mExtensions.size() ? mExtensions[code] : 0;
+            }
+    };
+
     class Interpreter
     {
             std::stack<Runtime> mCallstack;
             bool mRunning;
             Runtime mRuntime;
-            std::map<int, Opcode1 *> mSegment0;
-            std::map<int, Opcode2 *> mSegment1;
-            std::map<int, Opcode1 *> mSegment2;
-            std::map<int, Opcode1 *> mSegment3;
-            std::map<int, Opcode2 *> mSegment4;
-            std::map<int, Opcode0 *> mSegment5;
+            OpcodeTable<Opcode1> mSegment0;
+            OpcodeTable<Opcode2> mSegment1;
+            OpcodeTable<Opcode1> mSegment2;
+            OpcodeTable<Opcode1> mSegment3;
+            OpcodeTable<Opcode2> mSegment4;
+            OpcodeTable<Opcode0> mSegment5;
 
             // not implemented
             Interpreter (const Interpreter&);
             Interpreter& operator= (const Interpreter&);
 
-            void execute (Type_Code code);
+            void decode (Type_Code code, Instruction& instruction) const;
+
+            void execute (const Instruction& instruction);
 
             void abortUnknownCode (int segment, int opcode);
 
@@ -63,7 +121,18 @@ namespace Interpreter
             void installSegment5 (int code, Opcode0 *opcode);
             ///< ownership of \a opcode is transferred to *this.
 
+            void decode (const Type_Code *code, int codeSize, Program& program) const;
+            ///< Look up the opcode handlers of \a code once, for running it repeatedly with
+            /// run (const Program&, Context&). \a code must exist as long as \a program is used.
+            ///
+            /// \note Unknown opcodes are not reported here, but when they are executed, like
+            /// with run (const Type_Code*, int, Context&).
+            /// \note \a program is only valid for this interpreter, and only as long as no
+            /// further opcodes are installed.
+
             void run (const Type_Code *code, int codeSize, Context& context);
+
+            void run (const Program& program, Context& context);
     };
 }
 
@@ -122,9 +122,12 @@ namespace Interpreter
                 Type_Integer data = runtime[0].mInteger;
                 int index = runtime[1].mInteger;
 
-                std::string name = runtime.getStringLiteral (index);
+                int slot = runtime.getGlobalSlot (index);
 
-                runtime.getContext().setGlobalShort (name, data);
+                if (slot!=-1)
+                    runtime.getContext().setGlobalShort (slot, data);
+                else
+                    runtime.getContext().setGlobalShort (runtime.getStringLiteral (index), data);
 
                 runtime.pop();
                 runtime.pop();
@@ -140,9 +143,12 @@ namespace Interpreter
                 Type_Integer data = runtime[0].mInteger;
                 int index = runtime[1].mInteger;
 
-                std::string name = runtime.getStringLiteral (index);
+                int slot = runtime.getGlobalSlot (index);
 
-                runtime.getContext().setGlobalLong (name, data);
+                if (slot!=-1)
+                    runtime.getContext().setGlobalLong (slot, data);
+                else
+                    runtime.getContext().setGlobalLong (runtime.getStringLiteral (index), data);
 
                 runtime.pop();
                 runtime.pop();
@@ -158,9 +164,12 @@ namespace Interpreter
                 Type_Float data = runtime[0].mFloat;
                 int index = runtime[1].mInteger;
 
-                std::string name = runtime.getStringLiteral (index);
+                int slot = runtime.getGlobalSlot (index);
 
-                runtime.getContext().setGlobalFloat (name, data);
+                if (slot!=-1)
+                    runtime.getContext().setGlobalFloat (slot, data);
+                else
+                    runtime.getContext().setGlobalFloat (runtime.getStringLiteral (index), data);
 
                 runtime.pop();
                 runtime.pop();
@@ -174,8 +183,9 @@ namespace Interpreter
             virtual void execute (Runtime& runtime)
             {
                 int index = runtime[0].mInteger;
-                std::string name = runtime.getStringLiteral (index);
-                Type_Integer value = runtime.getContext().getGlobalShort (name);
+                int slot = runtime.getGlobalSlot (index);
+                Type_Integer value = slot!=-1 ? runtime.getContext().getGlobalShort (slot) :
+                    runtime.getContext().getGlobalShort (runtime.getStringLiteral (index));
                 runtime[0].mInteger = value;
             }
     };
@@ -187,8 +197,9 @@ namespace Interpreter
             virtual void execute (Runtime& runtime)
             {
                 int index = runtime[0].mInteger;
-                std::string name = runtime.getStringLiteral (index);
-                Type_Integer value = runtime.getContext().getGlobalLong (name);
+                int slot = runtime.getGlobalSlot (index);
+                Type_Integer value = slot!=-1 ? runtime.getContext().getGlobalLong (slot) :
+                    runtime.getContext().getGlobalLong (runtime.getStringLiteral (index));
                 runtime[0].mInteger = value;
             }
     };
@@ -200,8 +211,9 @@ namespace Interpreter
             virtual void execute (Runtime& runtime)
             {
                 int index = runtime[0].mInteger;
-                std::string name = runtime.getStringLiteral (index);
-                Type_Float value = runtime.getContext().getGlobalFloat (name);
+                int slot = runtime.getGlobalSlot (index);
+                Type_Float value = slot!=-1 ? runtime.getContext().getGlobalFloat (slot) :
+                    runtime.getContext().getGlobalFloat (runtime.getStringLiteral (index));
                 runtime[0].mFloat = value;
             }
     };
@@ -222,7 +234,8 @@ namespace Interpreter
                 index = runtime[2].mInteger;
                 std::string variable = runtime.getStringLiteral (index);
 
-                runtime.getContext().setMemberShort (id, variable, data, mGlobal);
+                runtime.getContext().setMemberShort (id, variable, data, mGlobal,
+                    runtime.getMemberSlot (index));
 
                 runtime.pop();
                 runtime.pop();
@@ -246,7 +259,8 @@ namespace Interpreter
                 index = runtime[2].mInteger;
                 std::string variable = runtime.getStringLiteral (index);
 
-                runtime.getContext().setMemberLong (id, variable, data, mGlobal);
+                runtime.getContext().setMemberLong (id, variable, data, mGlobal,
+                    runtime.getMemberSlot (index));
 
                 runtime.pop();
                 runtime.pop();
@@ -270,7 +284,8 @@ namespace Interpreter
                 index = runtime[2].mInteger;
                 std::string variable = runtime.getStringLiteral (index);
 
-                runtime.getContext().setMemberFloat (id, variable, data, mGlobal);
+                runtime.getContext().setMemberFloat (id, variable, data, mGlobal,
+                    runtime.getMemberSlot (index));
 
                 runtime.pop();
                 runtime.pop();
@@ -292,9 +307,10 @@ namespace Interpreter
                 std::string id = runtime.getStringLiteral (index);
                 index = runtime[1].mInteger;
                 std::string variable = runtime.getStringLiteral (index);
+                int& slot = runtime.getMemberSlot (index);
                 runtime.pop();
 
-                int value = runtime.getContext().getMemberShort (id, variable, mGlobal);
+                int value = runtime.getContext().getMemberShort (id, variable, mGlobal, slot);
                 runtime[0].mInteger = value;
             }
     };
@@ -313,9 +329,10 @@ namespace Interpreter
                 std::string id = runtime.getStringLiteral (index);
                 index = runtime[1].mInteger;
                 std::string variable = runtime.getStringLiteral (index);
+                int& slot = runtime.getMemberSlot (index);
                 runtime.pop();
 
-                int value = runtime.getContext().getMemberLong (id, variable, mGlobal);
+                int value = runtime.getContext().getMemberLong (id, variable, mGlobal, slot);
                 runtime[0].mInteger = value;
             }
     };
@@ -334,9 +351,10 @@ namespace Interpreter
                 std::string id = runtime.getStringLiteral (index);
                 index = runtime[1].mInteger;
                 std::string variable = runtime.getStringLiteral (index);
+                int& slot = runtime.getMemberSlot (index);
                 runtime.pop();
 
-                float value = runtime.getContext().getMemberFloat (id, variable, mGlobal);
+                float value = runtime.getContext().getMemberFloat (id, variable, mGlobal, slot);
                 runtime[0].mFloat = value;
             }
     };
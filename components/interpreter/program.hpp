@@ -0,0 +1,85 @@
+#ifndef INTERPRETER_PROGRAM_H_INCLUDED
+#define INTERPRETER_PROGRAM_H_INCLUDED
+
+#include <vector>
+#include <string>
+
+#include "types.hpp"
+
+namespace Interpreter
+{
+    class Opcode0;
+    class Opcode1;
+    class Opcode2;
+
+    /// Instruction with the opcode handler and the arguments already decoded
+
+    struct Instruction
+    {
+        enum Kind
+        {
+            Kind_Opcode0,
+            Kind_Opcode1,
+            Kind_Opcode2,
+            Kind_Unknown ///< \a mArg0 is the segment, \a mArg1 the opcode.
+        };
+
+        Kind mKind;
+
+        union
+        {
+            Opcode0 *mOpcode0;
+            Opcode1 *mOpcode1;
+            Opcode2 *mOpcode2;
+        };
+
+        unsigned int mArg0;
+        unsigned int mArg1;
+    };
+
+    /// Script in the form executed by Interpreter::run
+    ///
+    /// Decoded by Interpreter::decode. There is one instruction for each opcode in the code block, so
+    /// program counters and jumps are the same as for the code it was decoded from.
+
+    struct Program
+    {
+        std::vector<Instruction> mInstructions;
+
+        const Type_Code *mCode;
+        ///< Code the program was decoded from, used for literals. Not owned by the program.
+
+        int mCodeSize;
+
+        std::vector<std::string> mStringLiterals;
+
+        mutable std::vector<int> mGlobalSlots;
+        ///< Global variable slots for string literals naming a global variable, resolved on first
+        /// use (see Context::getGlobalSlot). Unresolved slots are Slot_Unresolved.
+
+        mutable std::vector<int> mMemberSlots;
+        ///< Member variable indices for string literals naming a member variable (see
+        /// Context::getMemberShort), -1 if not known yet.
+
+        enum { Slot_Unresolved = -2 };
+
+        Program() : mCode (0), mCodeSize (0) {}
+
+        bool empty() const
+        {
+            return mCode==0;
+        }
+
+        void clear()
+        {
+            mInstructions.clear();
+            mStringLiterals.clear();
+            mGlobalSlots.clear();
+            mMemberSlots.clear();
+            mCode = 0;
+            mCodeSize = 0;
+        }
+    };
+}
+
+#endif
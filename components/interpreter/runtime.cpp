@@ -4,9 +4,12 @@
 #include <cassert>
 #include <cstring>
 
+#include "context.hpp"
+#include "program.hpp"
+
 namespace Interpreter
 {
-    Runtime::Runtime() : mContext (0), mCode (0), mCodeSize(0), mPC (0) {}
+    Runtime::Runtime() : mContext (0), mCode (0), mCodeSize(0), mProgram (0), mMemberSlot (-1), mPC (0) {}
 
     int Runtime::getPC() const
     {
@@ -33,6 +36,12 @@ namespace Interpreter
 
     std::string Runtime::getStringLiteral (int index) const
     {
+        if (mProgram)
+        {
+            assert (index>=0 && index<static_cast<int> (mProgram->mStringLiterals.size()));
+            return mProgram->mStringLiterals[index];
+        }
+
         assert (index>=0 && static_cast<int> (mCode[3])>0);
 
         const char *literalBlock =
@@ -49,6 +58,34 @@ namespace Interpreter
         return literalBlock+offset;
     }
 
+    int Runtime::getGlobalSlot (int index)
+    {
+        if (!mProgram)
+            return mContext->getGlobalSlot (getStringLiteral (index));
+
+        assert (index>=0 && index<static_cast<int> (mProgram->mGlobalSlots.size()));
+
+        int& slot = mProgram->mGlobalSlots[index];
+
+        if (slot==Program::Slot_Unresolved)
+            slot = mContext->getGlobalSlot (mProgram->mStringLiterals[index]);
+
+        return slot;
+    }
+
+    int& Runtime::getMemberSlot (int index)
+    {
+        if (!mProgram)
+        {
+            mMemberSlot = -1;
+            return mMemberSlot;
+        }
+
+        assert (index>=0 && index<static_cast<int> (mProgram->mMemberSlots.size()));
+
+        return mProgram->mMemberSlots[index];
+    }
+
     void Runtime::configure (const Type_Code *code, int codeSize, Context& context)
     {
         clear();
@@ -59,11 +96,19 @@ namespace Interpreter
         mPC = 0;
     }
 
+    void Runtime::configure (const Program& program, Context& context)
+    {
+        configure (program.mCode, program.mCodeSize, context);
+
+        mProgram = &program;
+    }
+
     void Runtime::clear()
     {
         mContext = 0;
         mCode = 0;
         mCodeSize = 0;
+        mProgram = 0;
         mStack.clear();
     }
 
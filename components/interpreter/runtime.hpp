@@ -9,6 +9,7 @@
 namespace Interpreter
 {
     class Context;
+    struct Program;
 
     /// Runtime data and engine interface
 
@@ -17,6 +18,8 @@ namespace Interpreter
             Context *mContext;
             const Type_Code *mCode;
             int mCodeSize;
+            const Program *mProgram;
+            int mMemberSlot;
             int mPC;
             std::vector<Data> mStack;
 
@@ -33,10 +36,22 @@ namespace Interpreter
 
             std::string getStringLiteral (int index) const;
 
+            int getGlobalSlot (int index);
+            ///< Return the slot of the global variable named by string literal \a index (see
+            /// Context::getGlobalSlot). The slot is resolved only once, if running a program.
+
+            int& getMemberSlot (int index);
+            ///< Return the index hint for the member variable named by string literal \a index
+            /// (see Context::getMemberShort). The hint persists between runs, if running a program.
+
             void configure (const Type_Code *code, int codeSize, Context& context);
             ///< \a context and \a code must exist as least until either configure, clear or
             /// the destructor is called. \a codeSize is given in 32-bit words.
 
+            void configure (const Program& program, Context& context);
+            ///< \a context and \a program must exist as least until either configure, clear or
+            /// the destructor is called.
+
             void clear();
 
             void setPC (int PC);
@@ -0,0 +1,60 @@
+#ifndef MISC_HASH_H
+#define MISC_HASH_H
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace Misc
+{
+
+    template <typename T>
+    struct FnvParameters;
+
+    template <>
+    struct FnvParameters<uint32_t>
+    {
+        static uint32_t offsetBasis() { return 2166136261u; }
+        static uint32_t prime() { return 16777619u; }
+    };
+
+    template <>
+    struct FnvParameters<uint64_t>
+    {
+        static uint64_t offsetBasis() { return 14695981039346656037ULL; }
+        static uint64_t prime() { return 1099511628211ULL; }
+    };
+
+    /// @brief Incremental FNV-1a hash of a byte sequence.
+    /// @par The result only depends on the bytes added and the hash type (uint32_t or uint64_t),
+    /// not on the platform, so it can be stored in files.
+    template <typename T>
+    class Fnv1a
+    {
+    public:
+        Fnv1a()
+            : mHash(FnvParameters<T>::offsetBasis())
+        {
+        }
+
+        void add(unsigned char byte)
+        {
+            mHash ^= byte;
+            mHash *= FnvParameters<T>::prime();
+        }
+
+        void add(const void* data, std::size_t size)
+        {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (std::size_t i = 0; i < size; ++i)
+                add(bytes[i]);
+        }
+
+        T get() const { return mHash; }
+
+    private:
+        T mHash;
+    };
+
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef MISC_STRINGINDEX_H
+#define MISC_STRINGINDEX_H
+
+#include <string>
+#include <vector>
+
+#include "stringops.hpp"
+
+namespace Misc
+{
+
+    /// @brief Hash table mapping case-insensitive strings to pointers, using open addressing with linear probing.
+    /// @note Neither keys nor values are owned by the index. A key must stay valid and unchanged for as long as
+    /// it is in the index, which is why it is passed by pointer (typically to the key of a std::map node).
+    /// @note Hashes must be computed with StringUtils::ciHash.
+    template <class T>
+    class CiStringIndex
+    {
+    public:
+        CiStringIndex()
+            : mSize(0)
+        {
+        }
+
+        size_t size() const { return mSize; }
+
+        void clear()
+        {
+            mSlots.clear();
+            mSize = 0;
+        }
+
+        /// Insert or replace the entry for \a key.
+        void insert(const std::string *key, size_t hash, T *value)
+        {
+            if ((mSize + 1) * 2 > mSlots.size())
+                rehash(mSlots.empty() ? 16 : mSlots.size() * 2);
+
+            size_t i = findSlot(*key, hash);
+            if (mSlots[i].mKey == NULL)
+                ++mSize;
+
+            mSlots[i].mHash = hash;
+            mSlots[i].mKey = key;
+            mSlots[i].mValue = value;
+        }
+
+        /// @return NULL if not found.
+        T *find(const std::string &key, size_t hash) const
+        {
+            if (mSlots.empty())
+                return NULL;
+            return mSlots[findSlot(key, hash)].mValue;
+        }
+
+        T *find(const std::string &key) const
+        {
+            return find(key, StringUtils::ciHash(key));
+        }
+
+        /// @return Was an entry removed?
+        bool erase(const std::string &key, size_t hash)
+        {
+            if (mSlots.empty())
+                return false;
+
+            size_t i = findSlot(key, hash);
+            if (mSlots[i].mKey == NULL)
+                return false;
+
+            // Shift following entries of the probe sequence back, so that no tombstones are needed
+            const size_t mask = mSlots.size() - 1;
+            size_t j = i;
+            while (true)
+            {
+                j = (j + 1) & mask;
+                if (mSlots[j].mKey == NULL)
+                    break;
+
+                size_t home = mSlots[j].mHash & mask;
+                bool movable = (i <= j) ? (home <= i || home > j) : (home <= i && home > j);
+                if (movable)
+                {
+                    mSlots[i] = mSlots[j];
+                    i = j;
+                }
+            }
+
+            mSlots[i] = Slot();
+            --mSize;
+            return true;
+        }
+
+        bool erase(const std::string &key)
+        {
+            return erase(key, StringUtils::ciHash(key));
+        }
+
+    private:
+        struct Slot
+        {
+            size_t mHash;
+            const std::string *mKey;
+            T *mValue;
+
+            Slot() : mHash(0), mKey(NULL), mValue(NULL) {}
+        };
+
+        /// @return The slot holding \a key, or the empty slot that ends its probe sequence.
+        size_t findSlot(const std::string &key, size_t hash) const
+        {
+            const size_t mask = mSlots.size() - 1;
+            size_t i = hash & mask;
+            while (mSlots[i].mKey != NULL)
+            {
+                if (mSlots[i].mHash == hash && StringUtils::ciEqual(*mSlots[i].mKey, key))
+                    break;
+                i = (i + 1) & mask;
+            }
+            return i;
+        }
+
+        void rehash(size_t capacity)
+        {
+            std::vector<Slot> slots(capacity);
+            mSlots.swap(slots);
+
+            const size_t mask = capacity - 1;
+            for (typename std::vector<Slot>::const_iterator it = slots.begin(); it != slots.end(); ++it)
+            {
+                if (it->mKey == NULL)
+                    continue;
+                size_t i = it->mHash & mask;
+                while (mSlots[i].mKey != NULL)
+                    i = (i + 1) & mask;
+                mSlots[i] = *it;
+            }
+        }
+
+        std::vector<Slot> mSlots; // Size is zero or a power of two, at most half of the slots are used
+        size_t mSize;
+    };
+
+}
+
+#endif
@@ -5,6 +5,8 @@
 #include <string>
 #include <algorithm>
 
+#include "hash.hpp"
+
 namespace Misc
 {
 class StringUtils
@@ -107,6 +109,20 @@ public:
         return out;
     }
 
+    /// Case-insensitive FNV-1a hash, consistent with ciEqual.
+    static size_t ciHash(const char *str, size_t len)
+    {
+        Fnv1a<uint32_t> hash;
+        for (size_t i = 0; i < len; ++i)
+            hash.add(static_cast<unsigned char>(toLower(str[i])));
+        return hash.get();
+    }
+
+    static size_t ciHash(const std::string &str)
+    {
+        return ciHash(str.data(), str.size());
+    }
+
     struct CiComp
     {
         bool operator()(const std::string& left, const std::string& right) const
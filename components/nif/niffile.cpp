@@ -12,8 +12,20 @@ NIFFile::NIFFile(Files::IStreamPtr stream, const std::string &name)
     : ver(0)
     , filename(name)
     , mUseSkinning(false)
+    , mFileSize(0)
 {
-    parse(stream);
+    NIFStream nif (this, stream);
+    parse(nif);
+}
+
+NIFFile::NIFFile(const char *data, size_t size, const std::string &name)
+    : ver(0)
+    , filename(name)
+    , mUseSkinning(false)
+    , mFileSize(0)
+{
+    NIFStream nif (this, data, size);
+    parse(nif);
 }
 
 NIFFile::~NIFFile()
@@ -133,9 +145,9 @@ std::string NIFFile::printVersion(unsigned int version)
     return stream.str();
 }
 
-void NIFFile::parse(Files::IStreamPtr stream)
+void NIFFile::parse(NIFStream &nif)
 {
-    NIFStream nif (this, stream);
+    mFileSize = nif.size();
 
     // Check the header string
     std::string head = nif.getVersionString();
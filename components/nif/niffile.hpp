@@ -34,8 +34,10 @@ class NIFFile
 
     bool mUseSkinning;
 
+    size_t mFileSize;
+
     /// Parse the file
-    void parse(Files::IStreamPtr stream);
+    void parse(NIFStream &nif);
 
     /// Get the file's version in a human readable form
     ///\returns A string containing a human readable NIF version number
@@ -63,6 +65,8 @@ public:
 
     /// Open a NIF stream. The name is used for error messages.
     NIFFile(Files::IStreamPtr stream, const std::string &name);
+    /// Parse a NIF file that is already in memory, without copying it. The name is used for error messages.
+    NIFFile(const char *data, size_t size, const std::string &name);
     ~NIFFile();
 
     /// Get a given record
@@ -91,6 +95,9 @@ public:
 
     /// Get the name of the file
     std::string getFilename() const { return filename; }
+
+    /// Get the size of the file in bytes. The parsed records use about as much memory.
+    size_t getFileSize() const { return mFileSize; }
 };
 typedef boost::shared_ptr<const Nif::NIFFile> NIFFilePtr;
 
@@ -6,7 +6,9 @@
 #include "nifstream.hpp"
 
 #include <sstream>
-#include <map>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 
 #include <boost/shared_ptr.hpp>
 
@@ -15,30 +17,14 @@
 namespace Nif
 {
 
-template<typename T>
-struct KeyT {
-    T mValue;
-
-    // FIXME: Implement Quadratic and TBC interpolation
-    /*
-    T mForwardValue;  // Only for Quadratic interpolation, and never for QuaternionKeyList
-    T mBackwardValue; // Only for Quadratic interpolation, and never for QuaternionKeyList
-    float mTension;    // Only for TBC interpolation
-    float mBias;       // Only for TBC interpolation
-    float mContinuity; // Only for TBC interpolation
-    */
-};
-typedef KeyT<float> FloatKey;
-typedef KeyT<osg::Vec3f> Vector3Key;
-typedef KeyT<osg::Vec4f> Vector4Key;
-typedef KeyT<osg::Quat> QuaternionKey;
-
+/// @brief A keyframe track, stored as separate arrays of times, values and tangents sorted by time.
+/// @par Quadratic and TBC (tension, bias, continuity) keys are evaluated as cubic Hermite splines between
+/// two keys. Their tangents are computed once when the track is read, so that sampling only needs the two
+/// keys around the sample time. For rotations, the "tangents" are the control quaternions of a squad
+/// (spherical quadrangle) interpolation instead.
 template<typename T, T (NIFStream::*getValue)()>
 struct KeyMapT {
-    typedef std::map< float, KeyT<T> > MapType;
-
     typedef T ValueType;
-    typedef KeyT<T> KeyType;
 
     static const unsigned int sLinearInterpolation = 1;
     static const unsigned int sQuadraticInterpolation = 2;
@@ -46,10 +32,27 @@ struct KeyMapT {
     static const unsigned int sXYZInterpolation = 4;
 
     unsigned int mInterpolationType;
-    MapType mKeys;
+
+    /// Strictly increasing
+    std::vector<float> mTimes;
+    std::vector<T> mValues;
+    /// Tangent arriving at / leaving each key, scaled to the interval to the previous / next key.
+    /// Empty for linear interpolation.
+    std::vector<T> mInTangents;
+    std::vector<T> mOutTangents;
 
     KeyMapT() : mInterpolationType(sLinearInterpolation) {}
 
+    bool empty() const { return mTimes.empty(); }
+    size_t size() const { return mTimes.size(); }
+
+    /// Get the number of bytes used by the keys.
+    size_t getMemoryUsage() const
+    {
+        return mTimes.capacity() * sizeof(float)
+             + (mValues.capacity() + mInTangents.capacity() + mOutTangents.capacity()) * sizeof(T);
+    }
+
     //Read in a KeyGroup (see http://niftools.sourceforge.net/doc/nif/NiKeyframeData.html)
     void read(NIFStream *nif, bool force=false)
     {
@@ -61,38 +64,30 @@ struct KeyMapT {
         if(count == 0 && !force)
             return;
 
-        mKeys.clear();
+        mTimes.clear();
+        mValues.clear();
+        mInTangents.clear();
+        mOutTangents.clear();
 
         mInterpolationType = nif->getUInt();
 
-        KeyT<T> key;
+        std::vector<Key> keys;
         NIFStream &nifReference = *nif;
 
-        if(mInterpolationType == sLinearInterpolation)
-        {
-            for(size_t i = 0;i < count;i++)
-            {
-                float time = nif->getFloat();
-                readValue(nifReference, key);
-                mKeys[time] = key;
-            }
-        }
-        else if(mInterpolationType == sQuadraticInterpolation)
-        {
-            for(size_t i = 0;i < count;i++)
-            {
-                float time = nif->getFloat();
-                readQuadratic(nifReference, key);
-                mKeys[time] = key;
-            }
-        }
-        else if(mInterpolationType == sTBCInterpolation)
+        if(mInterpolationType == sLinearInterpolation
+                || mInterpolationType == sQuadraticInterpolation
+                || mInterpolationType == sTBCInterpolation)
         {
+            keys.resize(count);
             for(size_t i = 0;i < count;i++)
             {
-                float time = nif->getFloat();
-                readTBC(nifReference, key);
-                mKeys[time] = key;
+                keys[i].mTime = nif->getFloat();
+                if (mInterpolationType == sLinearInterpolation)
+                    readValue(nifReference, keys[i]);
+                else if (mInterpolationType == sQuadraticInterpolation)
+                    readQuadratic(nifReference, keys[i]);
+                else
+                    readTBC(nifReference, keys[i]);
             }
         }
         //XYZ keys aren't actually read here.
@@ -122,33 +117,195 @@ struct KeyMapT {
             error << "Unhandled interpolation type: " << mInterpolationType;
             nif->file->fail(error.str());
         }
+
+        if (keys.empty())
+            return;
+
+        // Sort by time. Of several keys with the same time the last one wins.
+        std::stable_sort(keys.begin(), keys.end(), compareTime);
+        size_t numKeys = 0;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (numKeys > 0 && keys[numKeys-1].mTime == keys[i].mTime)
+                keys[numKeys-1] = keys[i];
+            else
+                keys[numKeys++] = keys[i];
+        }
+        keys.resize(numKeys);
+
+        mTimes.reserve(numKeys);
+        mValues.reserve(numKeys);
+        for (size_t i = 0; i < numKeys; ++i)
+        {
+            mTimes.push_back(keys[i].mTime);
+            mValues.push_back(keys[i].mValue);
+        }
+
+        if (mInterpolationType != sLinearInterpolation && numKeys > 1)
+        {
+            mInTangents.resize(numKeys);
+            mOutTangents.resize(numKeys);
+            computeTangents(keys);
+        }
     }
 
 private:
-    static void readValue(NIFStream &nif, KeyT<T> &key)
+    struct Key
+    {
+        float mTime;
+        T mValue;
+        T mInTangent;
+        T mOutTangent;
+        float mTension;
+        float mBias;
+        float mContinuity;
+
+        Key() : mTime(0.f), mValue(), mInTangent(), mOutTangent(), mTension(0.f), mBias(0.f), mContinuity(0.f) {}
+    };
+
+    static bool compareTime(const Key& left, const Key& right)
+    {
+        return left.mTime < right.mTime;
+    }
+
+    static void readValue(NIFStream &nif, Key &key)
     {
         key.mValue = (nif.*getValue)();
     }
 
-    template <typename U>
-    static void readQuadratic(NIFStream &nif, KeyT<U> &key)
+    static void readQuadratic(NIFStream &nif, Key &key)
     {
         readValue(nif, key);
-        /*key.mForwardValue = */(nif.*getValue)();
-        /*key.mBackwardValue = */(nif.*getValue)();
+        readQuadraticTangents(nif, key.mInTangent, key.mOutTangent);
     }
 
-    static void readQuadratic(NIFStream &nif, KeyT<osg::Quat> &key)
+    template <typename U>
+    static void readQuadraticTangents(NIFStream &nif, U &inTangent, U &outTangent)
+    {
+        inTangent = (nif.*getValue)();
+        outTangent = (nif.*getValue)();
+    }
+
+    // Quadratic rotation keys have no tangents, they are computed like those of TBC keys with all parameters 0.
+    static void readQuadraticTangents(NIFStream &, osg::Quat &, osg::Quat &)
     {
-        readValue(nif, key);
     }
 
-    static void readTBC(NIFStream &nif, KeyT<T> &key)
+    static void readTBC(NIFStream &nif, Key &key)
     {
         readValue(nif, key);
-        /*key.mTension = */nif.getFloat();
-        /*key.mBias = */nif.getFloat();
-        /*key.mContinuity = */nif.getFloat();
+        key.mTension = nif.getFloat();
+        key.mBias = nif.getFloat();
+        key.mContinuity = nif.getFloat();
+    }
+
+    /// Weights of the differences to the previous and next key in the incoming and outgoing tangent of a
+    /// Kochanek-Bartels spline, adjusted for keys that are not evenly spaced in time.
+    struct TangentWeights
+    {
+        float mInPrevious;
+        float mInNext;
+        float mOutPrevious;
+        float mOutNext;
+    };
+
+    static TangentWeights getTangentWeights(const std::vector<Key>& keys, size_t i)
+    {
+        const Key& key = keys[i];
+        const float tension = 1.f - key.mTension;
+        TangentWeights weights;
+        weights.mInPrevious = tension * (1.f + key.mBias) * (1.f - key.mContinuity) * 0.5f;
+        weights.mInNext = tension * (1.f - key.mBias) * (1.f + key.mContinuity) * 0.5f;
+        weights.mOutPrevious = tension * (1.f + key.mBias) * (1.f + key.mContinuity) * 0.5f;
+        weights.mOutNext = tension * (1.f - key.mBias) * (1.f - key.mContinuity) * 0.5f;
+
+        if (i > 0 && i + 1 < keys.size())
+        {
+            const float previousInterval = keys[i].mTime - keys[i-1].mTime;
+            const float nextInterval = keys[i+1].mTime - keys[i].mTime;
+            const float inScale = 2.f * previousInterval / (previousInterval + nextInterval);
+            const float outScale = 2.f * nextInterval / (previousInterval + nextInterval);
+            weights.mInPrevious *= inScale;
+            weights.mInNext *= inScale;
+            weights.mOutPrevious *= outScale;
+            weights.mOutNext *= outScale;
+        }
+        return weights;
+    }
+
+    // The first and last key use the difference to their only neighbour on both sides,
+    // which makes a track of two keys with default parameters linear.
+    void computeTangents(const std::vector<Key>& keys)
+    {
+        computeTangents(keys, static_cast<T*>(NULL));
+    }
+
+    template <typename U>
+    void computeTangents(const std::vector<Key>& keys, U*)
+    {
+        const size_t numKeys = keys.size();
+        for (size_t i = 0; i < numKeys; ++i)
+        {
+            if (mInterpolationType == sQuadraticInterpolation)
+            {
+                mInTangents[i] = keys[i].mInTangent;
+                mOutTangents[i] = keys[i].mOutTangent;
+                continue;
+            }
+
+            const U previous = (i > 0) ? keys[i].mValue - keys[i-1].mValue : keys[i+1].mValue - keys[i].mValue;
+            const U next = (i + 1 < numKeys) ? keys[i+1].mValue - keys[i].mValue : previous;
+
+            const TangentWeights weights = getTangentWeights(keys, i);
+            mInTangents[i] = previous * weights.mInPrevious + next * weights.mInNext;
+            mOutTangents[i] = previous * weights.mOutPrevious + next * weights.mOutNext;
+        }
+    }
+
+    // Rotation from a to b, in the representation of the shorter arc. Note that osg::Quat multiplies in reverse order.
+    static osg::Quat getRotation(const osg::Quat& a, const osg::Quat& b)
+    {
+        osg::Quat rotation = b * a.inverse();
+        if (rotation.w() < 0)
+            rotation = -rotation;
+        return rotation;
+    }
+
+    static osg::Vec3f logRotation(const osg::Quat& q)
+    {
+        osg::Vec3f axis (q.x(), q.y(), q.z());
+        const float sinAngle = axis.length();
+        if (sinAngle < 1e-6f)
+            return axis;
+        return axis * (std::atan2(sinAngle, static_cast<float>(q.w())) / sinAngle);
+    }
+
+    static osg::Quat expRotation(const osg::Vec3f& v)
+    {
+        const float angle = v.length();
+        if (angle < 1e-6f)
+            return osg::Quat(v.x(), v.y(), v.z(), 1.f);
+        const osg::Vec3f axis = v * (std::sin(angle) / angle);
+        return osg::Quat(axis.x(), axis.y(), axis.z(), std::cos(angle));
+    }
+
+    void computeTangents(const std::vector<Key>& keys, osg::Quat*)
+    {
+        const size_t numKeys = keys.size();
+        for (size_t i = 0; i < numKeys; ++i)
+        {
+            const osg::Quat& value = keys[i].mValue;
+            const osg::Vec3f previous = logRotation((i > 0) ? getRotation(keys[i-1].mValue, value) : getRotation(value, keys[i+1].mValue));
+            const osg::Vec3f next = (i + 1 < numKeys) ? logRotation(getRotation(value, keys[i+1].mValue)) : previous;
+
+            const TangentWeights weights = getTangentWeights(keys, i);
+            const osg::Vec3f inTangent = previous * weights.mInPrevious + next * weights.mInNext;
+            const osg::Vec3f outTangent = previous * weights.mOutPrevious + next * weights.mOutNext;
+
+            // control points of the squad interpolation
+            mInTangents[i] = expRotation((previous - inTangent) * 0.5f) * value;
+            mOutTangents[i] = expRotation((outTangent - next) * 0.5f) * value;
+        }
     }
 };
 typedef KeyMapT<float,&NIFStream::getFloat> FloatKeyMap;
@@ -1,36 +1,72 @@
 #include "nifstream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
 //For error reporting
 #include "niffile.hpp"
 
 namespace Nif
 {
 
-//Private functions
-uint8_t NIFStream::read_byte()
+namespace
 {
-    uint8_t byte;
-    inp->read((char*)&byte, 1);
-    return byte;
+    bool isLittleEndian()
+    {
+        const uint16_t one = 1;
+        return *reinterpret_cast<const uint8_t*>(&one) == 1;
+    }
 }
-uint16_t NIFStream::read_le16()
+
+NIFStream::NIFStream(NIFFile * file, Files::IStreamPtr inp)
+    : mData(NULL), mSize(0), mPos(0), file(file)
 {
-    uint8_t buffer[2];
-    inp->read((char*)buffer, 2);
-    return buffer[0] | (buffer[1]<<8);
+    inp->seekg(0, std::ios::end);
+    std::streamoff size = inp->tellg();
+    inp->seekg(0, std::ios::beg);
+    if (size > 0 && inp->good())
+    {
+        mBuffer.resize(static_cast<size_t>(size));
+        inp->read(&mBuffer[0], size);
+        mBuffer.resize(static_cast<size_t>(inp->gcount()));
+    }
+    else
+    {
+        // not seekable, read in chunks until the end
+        inp->clear();
+        char chunk[65536];
+        while (inp->read(chunk, sizeof(chunk)) || inp->gcount() > 0)
+            mBuffer.insert(mBuffer.end(), chunk, chunk + inp->gcount());
+    }
+
+    if (!mBuffer.empty())
+        mData = &mBuffer[0];
+    mSize = mBuffer.size();
 }
-uint32_t NIFStream::read_le32()
+
+//Private functions
+void NIFStream::failEndOfFile()
 {
-    uint8_t buffer[4];
-    inp->read((char*)buffer, 4);
-    return buffer[0] | (buffer[1]<<8) | (buffer[2]<<16) | (buffer[3]<<24);
+    file->fail("Unexpected end of file");
 }
-float NIFStream::read_le32f()
+
+template <typename T>
+void NIFStream::readLittleEndianArray(T *dest, size_t count)
 {
-    union {
-        uint32_t i;
-        float f;
-    } u = { read_le32() };
-    return u.f;
+    if (count == 0)
+        return;
+    if (count > (mSize - mPos) / sizeof(T))
+        failEndOfFile();
+
+    const char *src = getBytes(count * sizeof(T));
+    std::memcpy(dest, src, count * sizeof(T));
+
+    if (sizeof(T) > 1 && !isLittleEndian())
+    {
+        char *bytes = reinterpret_cast<char*>(dest);
+        for (size_t i = 0; i < count; ++i)
+            std::reverse(bytes + i * sizeof(T), bytes + (i+1) * sizeof(T));
+    }
 }
 
 //Public functions
@@ -85,11 +121,10 @@ Transformation NIFStream::getTrafo()
 
 std::string NIFStream::getString(size_t length)
 {
-    std::vector<char> str (length+1, 0);
-
-    inp->read(&str[0], length);
+    const char *str = getBytes(length);
 
-    return &str[0];
+    // the string ends at the first null character, if any
+    return std::string(str, std::find(str, str + length, '\0'));
 }
 std::string NIFStream::getString()
 {
@@ -98,40 +133,55 @@ std::string NIFStream::getString()
 }
 std::string NIFStream::getVersionString()
 {
-    std::string result;
-    std::getline(*inp, result);
-    return result;
+    const char *begin = mData + mPos;
+    const char *end = std::find(begin, mData + mSize, '\n');
+    mPos = std::min(mSize, static_cast<size_t>(end - mData) + 1);
+    return std::string(begin, end);
 }
 
+// The vectors are tightly packed arrays of floats, as OSG relies on for its vertex arrays,
+// so they can be read in one go as well.
+void NIFStream::getUChars(std::vector<unsigned char> &vec, size_t size)
+{
+    vec.resize(size);
+    if (size)
+        readLittleEndianArray(&vec[0], size);
+}
+void NIFStream::getShorts(std::vector<short> &vec, size_t size)
+{
+    vec.resize(size);
+    if (size)
+        readLittleEndianArray(&vec[0], size);
+}
 void NIFStream::getUShorts(std::vector<unsigned short> &vec, size_t size)
 {
     vec.resize(size);
-    for(size_t i = 0;i < vec.size();i++)
-        vec[i] = getUShort();
+    if (size)
+        readLittleEndianArray(&vec[0], size);
 }
 void NIFStream::getFloats(std::vector<float> &vec, size_t size)
 {
     vec.resize(size);
-    for(size_t i = 0;i < vec.size();i++)
-        vec[i] = getFloat();
+    if (size)
+        readLittleEndianArray(&vec[0], size);
 }
 void NIFStream::getVector2s(std::vector<osg::Vec2f> &vec, size_t size)
 {
     vec.resize(size);
-    for(size_t i = 0;i < vec.size();i++)
-        vec[i] = getVector2();
+    if (size)
+        readLittleEndianArray(vec[0]._v, size * 2);
 }
 void NIFStream::getVector3s(std::vector<osg::Vec3f> &vec, size_t size)
 {
     vec.resize(size);
-    for(size_t i = 0;i < vec.size();i++)
-        vec[i] = getVector3();
+    if (size)
+        readLittleEndianArray(vec[0]._v, size * 3);
 }
 void NIFStream::getVector4s(std::vector<osg::Vec4f> &vec, size_t size)
 {
     vec.resize(size);
-    for(size_t i = 0;i < vec.size();i++)
-        vec[i] = getVector4();
+    if (size)
+        readLittleEndianArray(vec[0]._v, size * 4);
 }
 void NIFStream::getQuaternions(std::vector<osg::Quat> &quat, size_t size)
 {
@@ -20,23 +20,71 @@ namespace Nif
 
 class NIFFile;
 
+/// Reads the data of a .nif file from memory. The file is either read into a buffer
+/// in one go, or used in place if the caller already has it in memory.
 class NIFStream {
 
-    /// Input stream
-    Files::IStreamPtr inp;
-
-    uint8_t read_byte();
-    uint16_t read_le16();
-    uint32_t read_le32();
-    float read_le32f();
+    /// Data of the file read from a stream, empty if reading from memory that isn't ours
+    std::vector<char> mBuffer;
+
+    const char *mData;
+    size_t mSize;
+    size_t mPos;
+
+    /// Get the next \a size bytes and advance past them. Fails if the file is too short.
+    const char *getBytes(size_t size)
+    {
+        if (size > mSize - mPos)
+            failEndOfFile();
+        const char *bytes = mData + mPos;
+        mPos += size;
+        return bytes;
+    }
+
+    void failEndOfFile();
+
+    uint8_t read_byte()
+    {
+        return *reinterpret_cast<const uint8_t*>(getBytes(1));
+    }
+    uint16_t read_le16()
+    {
+        const uint8_t *buffer = reinterpret_cast<const uint8_t*>(getBytes(2));
+        return buffer[0] | (buffer[1]<<8);
+    }
+    uint32_t read_le32()
+    {
+        const uint8_t *buffer = reinterpret_cast<const uint8_t*>(getBytes(4));
+        return buffer[0] | (buffer[1]<<8) | (buffer[2]<<16) | (buffer[3]<<24);
+    }
+    float read_le32f()
+    {
+        union {
+            uint32_t i;
+            float f;
+        } u = { read_le32() };
+        return u.f;
+    }
+
+    /// Read \a count little endian values of type T into \a dest
+    template <typename T>
+    void readLittleEndianArray(T *dest, size_t count);
 
 public:
 
     NIFFile * const file;
 
-    NIFStream (NIFFile * file, Files::IStreamPtr inp): inp (inp), file (file) {}
+    /// Read the whole stream into a buffer.
+    NIFStream (NIFFile * file, Files::IStreamPtr inp);
+
+    /// Read from memory without copying it. The data must outlive the NIFStream.
+    NIFStream (NIFFile * file, const char *data, size_t size)
+        : mData(data), mSize(size), mPos(0), file(file) {}
+
+    void skip(size_t size) { getBytes(size); }
 
-    void skip(size_t size) { inp->ignore(size); }
+    /// Size of the file in bytes
+    size_t size() const { return mSize; }
 
     char getChar() { return read_byte(); }
     short getShort() { return read_le16(); }
@@ -59,6 +107,8 @@ public:
     ///This is special since the version string doesn't start with a number, and ends with "\n"
     std::string getVersionString();
 
+    void getUChars(std::vector<unsigned char> &vec, size_t size);
+    void getShorts(std::vector<short> &vec, size_t size);
     void getUShorts(std::vector<unsigned short> &vec, size_t size);
     void getFloats(std::vector<float> &vec, size_t size);
     void getVector2s(std::vector<osg::Vec2f> &vec, size_t size);
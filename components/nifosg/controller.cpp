@@ -116,6 +116,12 @@ osg::Vec3f KeyframeController::getTranslation(float time) const
     return osg::Vec3f();
 }
 
+size_t KeyframeController::getMemoryUsage() const
+{
+    return mRotations.getMemoryUsage() + mXRotations.getMemoryUsage() + mYRotations.getMemoryUsage()
+         + mZRotations.getMemoryUsage() + mTranslations.getMemoryUsage() + mScales.getMemoryUsage();
+}
+
 void KeyframeController::operator() (osg::Node* node, osg::NodeVisitor* nv)
 {
     if (hasInput())
@@ -12,6 +12,8 @@
 #include <boost/shared_ptr.hpp>
 
 #include <set> //UVController
+#include <vector>
+#include <algorithm>
 
 // FlipController
 #include <osg/Texture2D>
@@ -49,19 +51,16 @@ namespace NifOsg
         typedef typename MapT::ValueType ValueT;
 
         ValueInterpolator()
-            : mDefaultVal(ValueT())
+            : mLastKey(0)
+            , mDefaultVal(ValueT())
         {
         }
 
         ValueInterpolator(boost::shared_ptr<const MapT> keys, ValueT defaultVal = ValueT())
-            : mKeys(keys)
+            : mLastKey(0)
+            , mKeys(keys)
             , mDefaultVal(defaultVal)
         {
-            if (keys)
-            {
-                mLastLowKey = mKeys->mKeys.end();
-                mLastHighKey = mKeys->mKeys.end();
-            }
         }
 
         ValueT interpKey(float time) const
@@ -69,61 +68,53 @@ namespace NifOsg
             if (empty())
                 return mDefaultVal;
 
-            const typename MapT::MapType & keys = mKeys->mKeys;
+            const std::vector<float>& times = mKeys->mTimes;
+            const std::vector<ValueT>& values = mKeys->mValues;
 
-            if(time <= keys.begin()->first)
-                return keys.begin()->second.mValue;
+            if(time <= times.front())
+                return values.front();
+            if(time >= times.back())
+                return values.back();
 
-            // retrieve the current position in the map, optimized for the most common case
+            // find the key before the time, optimized for the most common case
             // where time moves linearly along the keyframe track
-            typename MapT::MapType::const_iterator it = mLastHighKey;
-            if (mLastHighKey != keys.end())
+            size_t key = mLastKey;
+            if (!(times[key] <= time && time < times[key+1]))
             {
-                if (time > mLastHighKey->first)
+                // try if we're there by incrementing one
+                ++key;
+                if (!(key + 1 < times.size() && times[key] <= time && time < times[key+1]))
                 {
-                    // try if we're there by incrementing one
-                    ++mLastLowKey;
-                    ++mLastHighKey;
-                    it = mLastHighKey;
+                    // still not there, reorient by searching the whole track
+                    key = std::upper_bound(times.begin(), times.end(), time) - times.begin() - 1;
                 }
-                if (mLastHighKey == keys.end() || (time < mLastLowKey->first || time > mLastHighKey->first))
-                    it = keys.lower_bound(time); // still not there, reorient by performing lower_bound check on the whole map
             }
-            else
-                it = keys.lower_bound(time);
-
-            // now do the actual interpolation
-            if (it != keys.end())
-            {
-                float aTime = it->first;
-                const typename MapT::KeyType* aKey = &it->second;
-
-                // cache for next time
-                mLastHighKey = it;
 
-                assert (it != keys.begin()); // Shouldn't happen, was checked at beginning of this function
+            // cache for next time
+            mLastKey = key;
 
-                typename MapT::MapType::const_iterator last = --it;
-                mLastLowKey = last;
-                float aLastTime = last->first;
-                const typename MapT::KeyType* aLastKey = &last->second;
+            float a = (time - times[key]) / (times[key+1] - times[key]);
 
-                float a = (time - aLastTime) / (aTime - aLastTime);
-
-                return InterpolationFunc()(aLastKey->mValue, aKey->mValue, a);
-            }
-            else
-                return keys.rbegin()->second.mValue;
+            if (mKeys->mOutTangents.empty())
+                return InterpolationFunc()(values[key], values[key+1], a);
+            return InterpolationFunc()(values[key], mKeys->mOutTangents[key], mKeys->mInTangents[key+1], values[key+1], a);
         }
 
         bool empty() const
         {
-            return !mKeys || mKeys->mKeys.empty();
+            return !mKeys || mKeys->empty();
+        }
+
+        /// Get the number of bytes used by the keys, which may be shared with other interpolators.
+        size_t getMemoryUsage() const
+        {
+            return mKeys ? mKeys->getMemoryUsage() : 0;
         }
 
     private:
-        mutable typename MapT::MapType::const_iterator mLastLowKey;
-        mutable typename MapT::MapType::const_iterator mLastHighKey;
+        /// Index of the key before the last sampled time, always less than the number of keys - 1
+        /// if the track has more than one key.
+        mutable size_t mLastKey;
 
         boost::shared_ptr<const MapT> mKeys;
 
@@ -137,6 +128,18 @@ namespace NifOsg
         {
             return a + ((b - a) * fraction);
         }
+
+        /// Cubic Hermite spline from \a a to \a b, with the tangent leaving \a a and the tangent arriving at \a b.
+        template <typename ValueType>
+        inline ValueType operator()(const ValueType& a, const ValueType& outTangent, const ValueType& inTangent, const ValueType& b, float fraction)
+        {
+            const float fraction2 = fraction * fraction;
+            const float fraction3 = fraction2 * fraction;
+            return a * (2.f * fraction3 - 3.f * fraction2 + 1.f)
+                 + b * (3.f * fraction2 - 2.f * fraction3)
+                 + outTangent * (fraction3 - 2.f * fraction2 + fraction)
+                 + inTangent * (fraction3 - fraction2);
+        }
     };
 
     struct QuaternionSlerpFunc
@@ -147,6 +150,16 @@ namespace NifOsg
             result.slerp(fraction, a, b);
             return result;
         }
+
+        /// Squad interpolation from \a a to \a b, using the control points computed by Nif::KeyMapT.
+        inline osg::Quat operator()(const osg::Quat& a, const osg::Quat& outControl, const osg::Quat& inControl, const osg::Quat& b, float fraction)
+        {
+            osg::Quat outer, inner, result;
+            outer.slerp(fraction, a, b);
+            inner.slerp(fraction, outControl, inControl);
+            result.slerp(2.f * fraction * (1.f - fraction), outer, inner);
+            return result;
+        }
     };
 
     typedef ValueInterpolator<Nif::QuaternionKeyMap, QuaternionSlerpFunc> QuaternionInterpolator;
@@ -205,6 +218,9 @@ namespace NifOsg
 
         virtual void operator() (osg::Node*, osg::NodeVisitor*);
 
+        /// Get the number of bytes used by the keyframes.
+        size_t getMemoryUsage() const;
+
     private:
         QuaternionInterpolator mRotations;
 
@@ -83,15 +83,22 @@ namespace
             collectDrawableProperties(nifNode->parent, out);
     }
 
+    /// Switches between two copies of a geometry in every frame that the update traversal reaches it, so that the copy
+    /// changed in a frame is not the one still being drawn from the last frame. In the other frames, e.g. when a Skeleton
+    /// skips its update, the copy changed last is shown again.
     class FrameSwitch : public osg::Group
     {
     public:
         FrameSwitch()
+            : mCurrent(0)
+            , mLastFrameNumber(0)
         {
         }
 
         FrameSwitch(const FrameSwitch& copy, const osg::CopyOp& copyop)
             : osg::Group(copy, copyop)
+            , mCurrent(0)
+            , mLastFrameNumber(0)
         {
         }
 
@@ -103,13 +110,23 @@ namespace
                 osg::Group::traverse(nv);
             else
             {
+                if (nv.getVisitorType() == osg::NodeVisitor::UPDATE_VISITOR && nv.getTraversalNumber() != mLastFrameNumber)
+                {
+                    mLastFrameNumber = nv.getTraversalNumber();
+                    mCurrent = 1 - mCurrent;
+                }
+
                 for (unsigned int i=0; i<getNumChildren(); ++i)
                 {
-                    if (i%2 == nv.getTraversalNumber()%2)
+                    if (i%2 == mCurrent)
                         getChild(i)->accept(nv);
                 }
             }
         }
+
+    private:
+        unsigned int mCurrent;
+        unsigned int mLastFrameNumber;
     };
 
     // NodeCallback used to have a node always oriented towards the camera. The node can have translation and scale
@@ -74,6 +74,10 @@ namespace NifOsg
 
         static bool getShowMarkers();
 
+        /// Increase when the scene graphs created by load() change, so that templates converted by an older loader
+        /// are not read from the Resource::TemplateCache.
+        static const int sVersion = 1;
+
     private:
 
         static bool sShowMarkers;
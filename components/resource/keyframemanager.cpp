@@ -27,7 +27,16 @@ namespace Resource
         else
         {
             osg::ref_ptr<NifOsg::KeyframeHolder> loaded (new NifOsg::KeyframeHolder);
-            NifOsg::Loader::loadKf(Nif::NIFFilePtr(new Nif::NIFFile(mVFS->getNormalized(normalized), normalized)), *loaded.get());
+            // Files in a memory mapped archive are parsed in place, loose files are read through a stream
+            Nif::NIFFilePtr file;
+            const char* data = NULL;
+            size_t size = 0;
+            if (mVFS->getMemory(normalized, data, size))
+                file.reset(new Nif::NIFFile(data, size, normalized));
+            else
+                file.reset(new Nif::NIFFile(mVFS->getNormalized(normalized), normalized));
+
+            NifOsg::Loader::loadKf(file, *loaded.get());
 
             mCache->addEntryToObjectCache(normalized, loaded);
             return loaded;
@@ -0,0 +1,236 @@
+#include "memoryusage.hpp"
+
+#include <osg/NodeVisitor>
+#include <osg/Geometry>
+#include <osg/Texture>
+#include <osg/Image>
+
+#include <BulletCollision/CollisionShapes/btCompoundShape.h>
+#include <BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h>
+#include <BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h>
+#include <BulletCollision/CollisionShapes/btStridingMeshInterface.h>
+
+#include <components/nif/niffile.hpp>
+#include <components/nifosg/nifloader.hpp>
+
+#include "bulletshape.hpp"
+#include "niffilemanager.hpp"
+
+namespace
+{
+
+    class MemoryUsageVisitor : public osg::NodeVisitor
+    {
+    public:
+        MemoryUsageVisitor(Resource::MemoryUsage& usage)
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            , mUsage(usage)
+        {
+        }
+
+        virtual void apply(osg::Node& node)
+        {
+            mUsage.addStateSet(node.getStateSet());
+            traverse(node);
+        }
+
+        virtual void apply(osg::Drawable& drawable)
+        {
+            mUsage.addDrawable(&drawable);
+        }
+
+    private:
+        Resource::MemoryUsage& mUsage;
+    };
+
+    void addArrays(Resource::MemoryUsage& usage, const osg::Geometry::ArrayList& arrays)
+    {
+        for (osg::Geometry::ArrayList::const_iterator it = arrays.begin(); it != arrays.end(); ++it)
+            usage.addBufferData(it->get());
+    }
+
+}
+
+namespace Resource
+{
+
+    MemoryUsage::MemoryUsage(bool countImageFiles)
+        : mBytes(0)
+        , mCountImageFiles(countImageFiles)
+    {
+    }
+
+    void MemoryUsage::add(const osg::Object* object)
+    {
+        if (!object)
+            return;
+
+        if (const osg::Node* node = dynamic_cast<const osg::Node*>(object))
+            addNode(node);
+        else if (const osg::Image* image = dynamic_cast<const osg::Image*>(object))
+            addImage(image);
+        else if (const BulletShape* shape = dynamic_cast<const BulletShape*>(object))
+            addCollisionShape(shape->mCollisionShape);
+        else if (const NifFileHolder* nif = dynamic_cast<const NifFileHolder*>(object))
+            addNifFile(nif->mNifFile.get());
+        else if (const NifOsg::KeyframeHolder* keyframes = dynamic_cast<const NifOsg::KeyframeHolder*>(object))
+            addKeyframes(keyframes);
+    }
+
+    size_t MemoryUsage::getBytes() const
+    {
+        return mBytes;
+    }
+
+    void MemoryUsage::addNode(const osg::Node* node)
+    {
+        if (!node || !markCounted(node))
+            return;
+
+        // The visitor does not modify the node
+        MemoryUsageVisitor visitor(*this);
+        const_cast<osg::Node*>(node)->accept(visitor);
+    }
+
+    void MemoryUsage::addDrawable(const osg::Drawable* drawable)
+    {
+        if (!drawable)
+            return;
+
+        addStateSet(drawable->getStateSet());
+
+        const osg::Geometry* geom = drawable->asGeometry();
+        if (!geom)
+            return;
+
+        addBufferData(geom->getVertexArray());
+        addBufferData(geom->getNormalArray());
+        addBufferData(geom->getColorArray());
+        addBufferData(geom->getSecondaryColorArray());
+        addBufferData(geom->getFogCoordArray());
+        addArrays(*this, geom->getTexCoordArrayList());
+        addArrays(*this, geom->getVertexAttribArrayList());
+
+        const osg::Geometry::PrimitiveSetList& primitives = geom->getPrimitiveSetList();
+        for (osg::Geometry::PrimitiveSetList::const_iterator it = primitives.begin(); it != primitives.end(); ++it)
+            addBufferData(it->get());
+    }
+
+    void MemoryUsage::addStateSet(const osg::StateSet* stateset)
+    {
+        if (!stateset || !markCounted(stateset))
+            return;
+
+        const osg::StateSet::TextureAttributeList& texAttributes = stateset->getTextureAttributeList();
+        for (osg::StateSet::TextureAttributeList::const_iterator unit = texAttributes.begin(); unit != texAttributes.end(); ++unit)
+        {
+            for (osg::StateSet::AttributeList::const_iterator it = unit->begin(); it != unit->end(); ++it)
+            {
+                const osg::Texture* texture = it->second.first->asTexture();
+                if (!texture)
+                    continue;
+                for (unsigned int i=0; i<texture->getNumImages(); ++i)
+                {
+                    const osg::Image* image = texture->getImage(i);
+                    if (image && (mCountImageFiles || image->getFileName().empty()))
+                        addImage(image);
+                }
+            }
+        }
+    }
+
+    void MemoryUsage::addImage(const osg::Image* image)
+    {
+        if (!image || !markCounted(image))
+            return;
+        mBytes += image->getTotalSizeInBytesIncludingMipmaps();
+    }
+
+    void MemoryUsage::addBufferData(const osg::BufferData* data)
+    {
+        if (!data || !markCounted(data))
+            return;
+        mBytes += data->getTotalDataSize();
+    }
+
+    void MemoryUsage::addCollisionShape(const btCollisionShape* shape)
+    {
+        if (!shape)
+            return;
+
+        if (shape->isCompound())
+        {
+            const btCompoundShape* compound = static_cast<const btCompoundShape*>(shape);
+            for (int i=0; i<compound->getNumChildShapes(); ++i)
+                addCollisionShape(compound->getChildShape(i));
+            return;
+        }
+
+        // Instances wrap the triangle mesh shape of their source shape, see BulletShape::duplicateCollisionShape
+        if (const btScaledBvhTriangleMeshShape* scaled = dynamic_cast<const btScaledBvhTriangleMeshShape*>(shape))
+        {
+            addCollisionShape(const_cast<btScaledBvhTriangleMeshShape*>(scaled)->getChildShape());
+            return;
+        }
+
+        const btBvhTriangleMeshShape* trishape = dynamic_cast<const btBvhTriangleMeshShape*>(shape);
+        if (!trishape || !markCounted(trishape))
+            return;
+
+        const btStridingMeshInterface* mesh = trishape->getMeshInterface();
+        size_t numTriangles = 0;
+        for (int part=0; part<mesh->getNumSubParts(); ++part)
+        {
+            const unsigned char* vertices = NULL;
+            const unsigned char* indices = NULL;
+            int numVertices = 0, vertexStride = 0, indexStride = 0, numFaces = 0;
+            PHY_ScalarType vertexType, indexType;
+            mesh->getLockedReadOnlyVertexIndexBase(&vertices, numVertices, vertexType, vertexStride,
+                                                   &indices, indexStride, numFaces, indexType, part);
+            mesh->unLockReadOnlyVertexBase(part);
+
+            mBytes += static_cast<size_t>(numVertices) * vertexStride + static_cast<size_t>(numFaces) * indexStride;
+            numTriangles += numFaces;
+        }
+
+        // The bounding volume hierarchy has up to two quantized nodes per triangle
+        if (const_cast<btBvhTriangleMeshShape*>(trishape)->getOptimizedBvh())
+            mBytes += numTriangles * 2 * sizeof(btQuantizedBvhNode);
+    }
+
+    void MemoryUsage::addNifFile(const Nif::NIFFile* file)
+    {
+        if (!file || !markCounted(file))
+            return;
+        mBytes += file->getFileSize();
+    }
+
+    void MemoryUsage::addKeyframes(const NifOsg::KeyframeHolder* keyframes)
+    {
+        if (!keyframes || !markCounted(keyframes))
+            return;
+
+        for (NifOsg::TextKeyMap::const_iterator it = keyframes->mTextKeys.begin(); it != keyframes->mTextKeys.end(); ++it)
+            mBytes += sizeof(NifOsg::TextKeyMap::value_type) + it->second.capacity();
+
+        for (NifOsg::KeyframeHolder::KeyframeControllerMap::const_iterator it = keyframes->mKeyframeControllers.begin();
+             it != keyframes->mKeyframeControllers.end(); ++it)
+        {
+            if (it->second && markCounted(it->second.get()))
+                mBytes += it->second->getMemoryUsage();
+        }
+    }
+
+    bool MemoryUsage::markCounted(const void* data)
+    {
+        return mCounted.insert(data).second;
+    }
+
+    size_t estimateMemoryUsage(const osg::Object* object)
+    {
+        MemoryUsage usage (false);
+        usage.add(object);
+        return usage.getBytes();
+    }
+
+}
@@ -0,0 +1,74 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_MEMORYUSAGE_H
+#define OPENMW_COMPONENTS_RESOURCE_MEMORYUSAGE_H
+
+#include <set>
+#include <cstddef>
+
+namespace osg
+{
+    class Object;
+    class Node;
+    class Drawable;
+    class StateSet;
+    class Image;
+    class BufferData;
+}
+
+class btCollisionShape;
+
+namespace Nif
+{
+    class NIFFile;
+}
+
+namespace NifOsg
+{
+    class KeyframeHolder;
+}
+
+namespace Resource
+{
+
+    /// @brief Estimates the memory used by the resources held by a set of objects.
+    /// @par Vertex arrays, primitive sets, texture images, collision meshes, parsed NIF files and keyframes are counted.
+    /// Data that is shared between the added objects (e.g. a texture used by several meshes, or the triangle mesh of a
+    /// BulletShape and its instances) is only counted once. The size of the scene graph nodes themselves is not counted.
+    class MemoryUsage
+    {
+    public:
+        /// @param countImageFiles Count the images of textures in a scene graph that were read from a file. Images that are
+        /// embedded in a model are always counted.
+        MemoryUsage(bool countImageFiles=true);
+
+        /// Add the resources held by \a object. Recognizes nodes, images, BulletShapes and the objects cached by the
+        /// NifFileManager and KeyframeManager, other objects are ignored.
+        void add(const osg::Object* object);
+
+        /// @return The estimated number of bytes of all resources added so far.
+        size_t getBytes() const;
+
+        void addNode(const osg::Node* node);
+        void addDrawable(const osg::Drawable* drawable);
+        void addStateSet(const osg::StateSet* stateset);
+        void addImage(const osg::Image* image);
+        void addBufferData(const osg::BufferData* data);
+        void addCollisionShape(const btCollisionShape* shape);
+        void addNifFile(const Nif::NIFFile* file);
+        void addKeyframes(const NifOsg::KeyframeHolder* keyframes);
+
+    private:
+        /// @return True if \a data was not counted before.
+        bool markCounted(const void* data);
+
+        std::set<const void*> mCounted;
+        size_t mBytes;
+        bool mCountImageFiles;
+    };
+
+    /// Convenience function returning the estimated memory used by the resources held by a single cached object.
+    /// @note Texture images read from a file are not counted, the ImageManager caches and counts those.
+    size_t estimateMemoryUsage(const osg::Object* object);
+
+}
+
+#endif
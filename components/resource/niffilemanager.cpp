@@ -1,6 +1,5 @@
 #include "niffilemanager.hpp"
 
-#include <osg/Object>
 #include <osg/Stats>
 
 #include <components/vfs/manager.hpp>
@@ -10,27 +9,6 @@
 namespace Resource
 {
 
-    class NifFileHolder : public osg::Object
-    {
-    public:
-        NifFileHolder(const Nif::NIFFilePtr& file)
-            : mNifFile(file)
-        {
-        }
-        NifFileHolder(const NifFileHolder& copy, const osg::CopyOp& copyop)
-            : mNifFile(copy.mNifFile)
-        {
-        }
-
-        NifFileHolder()
-        {
-        }
-
-        META_Object(Resource, NifFileHolder)
-
-        Nif::NIFFilePtr mNifFile;
-    };
-
     NifFileManager::NifFileManager(const VFS::Manager *vfs)
         : ResourceManager(vfs)
     {
@@ -49,7 +27,14 @@ namespace Resource
             return static_cast<NifFileHolder*>(obj.get())->mNifFile;
         else
         {
-            Nif::NIFFilePtr file (new Nif::NIFFile(mVFS->get(name), name));
+            // Files in a memory mapped archive are parsed in place, loose files are read through a stream
+            Nif::NIFFilePtr file;
+            const char* data = NULL;
+            size_t size = 0;
+            if (mVFS->getMemory(name, data, size))
+                file.reset(new Nif::NIFFile(data, size, name));
+            else
+                file.reset(new Nif::NIFFile(mVFS->get(name), name));
             obj = new NifFileHolder(file);
             mCache->addEntryToObjectCache(name, obj);
             return file;
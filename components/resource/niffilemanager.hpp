@@ -2,6 +2,7 @@
 #define OPENMW_COMPONENTS_RESOURCE_NIFFILEMANAGER_H
 
 #include <osg/ref_ptr>
+#include <osg/Object>
 
 #include <components/nif/niffile.hpp>
 
@@ -10,6 +11,28 @@
 namespace Resource
 {
 
+    /// The object a NIFFile is stored as in the cache of the NifFileManager.
+    class NifFileHolder : public osg::Object
+    {
+    public:
+        NifFileHolder(const Nif::NIFFilePtr& file)
+            : mNifFile(file)
+        {
+        }
+        NifFileHolder(const NifFileHolder& copy, const osg::CopyOp& copyop)
+            : mNifFile(copy.mNifFile)
+        {
+        }
+
+        NifFileHolder()
+        {
+        }
+
+        META_Object(Resource, NifFileHolder)
+
+        Nif::NIFFilePtr mNifFile;
+    };
+
     /// @brief Handles caching of NIFFiles.
     /// @note May be used from any thread.
     class NifFileManager : public ResourceManager
@@ -13,9 +13,15 @@
 
 #include "objectcache.hpp"
 
+#include <algorithm>
+
 #include <osg/Object>
 #include <osg/Node>
 
+#include <components/misc/stringops.hpp>
+
+#include "memoryusage.hpp"
+
 namespace Resource
 {
 
@@ -32,49 +38,200 @@ ObjectCache::~ObjectCache()
 {
 }
 
+ObjectCache::Shard& ObjectCache::getShard(const std::string &fileName)
+{
+    return _shards[Misc::StringUtils::ciHash(fileName) % sNumShards];
+}
+
+const ObjectCache::Shard& ObjectCache::getShard(const std::string &fileName) const
+{
+    return _shards[Misc::StringUtils::ciHash(fileName) % sNumShards];
+}
+
+void ObjectCache::insert(Shard& shard, const std::string& fileName, osg::Object* object, double timestamp, size_t bytes)
+{
+    ObjectCacheMap::iterator itr = shard._objectCache.find(fileName);
+    if (itr != shard._objectCache.end())
+    {
+        // replace the object, but keep its position in the replacement order
+        Entry& entry = itr->second;
+        size_t& listBytes = entry._frequent ? shard._frequentBytes : shard._recentBytes;
+        listBytes = listBytes - entry._bytes + bytes;
+        entry._object = object;
+        entry._timeStamp = timestamp;
+        entry._bytes = bytes;
+        return;
+    }
+
+    bool frequent = false;
+    std::map<std::string, Ghost>::iterator ghost = shard._ghosts.find(fileName);
+    if (ghost != shard._ghosts.end())
+    {
+        // the object was evicted too early, so give more room to the list it was evicted from
+        size_t totalBytes = shard._recentBytes + shard._frequentBytes + bytes;
+        if (ghost->second._frequent)
+        {
+            shard._recentTargetBytes -= std::min(shard._recentTargetBytes, bytes);
+            shard._frequentGhosts.erase(ghost->second._position);
+        }
+        else
+        {
+            shard._recentTargetBytes = std::min(shard._recentTargetBytes + bytes, totalBytes);
+            shard._recentGhosts.erase(ghost->second._position);
+        }
+        shard._ghosts.erase(ghost);
+
+        // it was requested before, so it is not a one-off
+        frequent = true;
+    }
+
+    itr = shard._objectCache.insert(std::make_pair(fileName, Entry())).first;
+    Entry& entry = itr->second;
+    entry._object = object;
+    entry._timeStamp = timestamp;
+    entry._bytes = bytes;
+    entry._frequent = frequent;
+    if (frequent)
+    {
+        entry._lruPosition = shard._frequent.insert(shard._frequent.end(), &itr->first);
+        shard._frequentBytes += bytes;
+    }
+    else
+    {
+        entry._lruPosition = shard._recent.insert(shard._recent.end(), &itr->first);
+        shard._recentBytes += bytes;
+    }
+}
+
+void ObjectCache::touch(Shard& shard, ObjectCacheMap::iterator itr)
+{
+    Entry& entry = itr->second;
+    if (entry._frequent)
+        shard._frequent.splice(shard._frequent.end(), shard._frequent, entry._lruPosition);
+    else
+    {
+        shard._recent.erase(entry._lruPosition);
+        shard._recentBytes -= entry._bytes;
+
+        entry._frequent = true;
+        entry._lruPosition = shard._frequent.insert(shard._frequent.end(), &itr->first);
+        shard._frequentBytes += entry._bytes;
+    }
+}
+
+void ObjectCache::erase(Shard& shard, ObjectCacheMap::iterator itr, std::vector<osg::ref_ptr<osg::Object> >& removed)
+{
+    Entry& entry = itr->second;
+    if (entry._frequent)
+    {
+        shard._frequent.erase(entry._lruPosition);
+        shard._frequentBytes -= entry._bytes;
+    }
+    else
+    {
+        shard._recent.erase(entry._lruPosition);
+        shard._recentBytes -= entry._bytes;
+    }
+
+    removed.push_back(entry._object);
+    shard._objectCache.erase(itr);
+}
+
+void ObjectCache::addGhost(Shard& shard, const std::string& fileName, bool frequent)
+{
+    if (shard._ghosts.find(fileName) != shard._ghosts.end())
+        return;
+
+    std::list<std::string>& ghosts = frequent ? shard._frequentGhosts : shard._recentGhosts;
+    Ghost ghost;
+    ghost._frequent = frequent;
+    ghost._position = ghosts.insert(ghosts.end(), fileName);
+    shard._ghosts[fileName] = ghost;
+
+    // remember about as many evicted keys as there are entries, forget the oldest ones of the longer list first
+    const size_t maxGhosts = std::max(shard._objectCache.size(), static_cast<size_t>(64));
+    while (shard._ghosts.size() > maxGhosts)
+    {
+        std::list<std::string>& longest = (shard._recentGhosts.size() >= shard._frequentGhosts.size()) ? shard._recentGhosts : shard._frequentGhosts;
+        shard._ghosts.erase(longest.front());
+        longest.pop_front();
+    }
+}
+
+ObjectCache::ObjectCacheMap::iterator ObjectCache::findEvictable(Shard& shard, const LRUList& lru)
+{
+    for (LRUList::const_iterator it = lru.begin(); it != lru.end(); ++it)
+    {
+        ObjectCacheMap::iterator itr = shard._objectCache.find(**it);
+        const Entry& entry = itr->second;
+
+        // evicting objects that are referenced elsewhere would not free anything
+        if (entry._bytes > 0 && (!entry._object || entry._object->referenceCount() <= 1))
+            return itr;
+    }
+    return shard._objectCache.end();
+}
+
 void ObjectCache::addEntryToObjectCache(const std::string& filename, osg::Object* object, double timestamp)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    _objectCache[filename]=ObjectTimeStampPair(object,timestamp);
+    size_t bytes = estimateMemoryUsage(object);
+
+    Shard& shard = getShard(filename);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+    insert(shard, filename, object, timestamp, bytes);
 }
 
 osg::ref_ptr<osg::Object> ObjectCache::getRefFromObjectCache(const std::string& fileName)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    ObjectCacheMap::iterator itr = _objectCache.find(fileName);
-    if (itr!=_objectCache.end())
+    Shard& shard = getShard(fileName);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+    ObjectCacheMap::iterator itr = shard._objectCache.find(fileName);
+    if (itr!=shard._objectCache.end())
     {
-        return itr->second.first;
+        ++shard._hits;
+        touch(shard, itr);
+        return itr->second._object;
+    }
+    else
+    {
+        ++shard._misses;
+        return 0;
     }
-    else return 0;
 }
 
 bool ObjectCache::checkInObjectCache(const std::string &fileName, double timeStamp)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    ObjectCacheMap::iterator itr = _objectCache.find(fileName);
-    if (itr!=_objectCache.end())
+    Shard& shard = getShard(fileName);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+    ObjectCacheMap::iterator itr = shard._objectCache.find(fileName);
+    if (itr!=shard._objectCache.end())
     {
-        itr->second.second = timeStamp;
+        ++shard._hits;
+        touch(shard, itr);
+        itr->second._timeStamp = timeStamp;
         return true;
     }
+    // not counted as a miss, the object will be requested through getRefFromObjectCache when it is loaded
     else return false;
 }
 
 void ObjectCache::updateTimeStampOfObjectsInCacheWithExternalReferences(double referenceTime)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-
-    // look for objects with external references and update their time stamp.
-    for(ObjectCacheMap::iterator itr=_objectCache.begin();
-        itr!=_objectCache.end();
-        ++itr)
+    for (unsigned int i=0; i<sNumShards; ++i)
     {
-        // if ref count is greater the 1 the object has an external reference.
-        if (itr->second.first->referenceCount()>1)
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_shards[i]._objectCacheMutex);
+
+        // look for objects with external references and update their time stamp.
+        for(ObjectCacheMap::iterator itr=_shards[i]._objectCache.begin();
+            itr!=_shards[i]._objectCache.end();
+            ++itr)
         {
-            // so update it time stamp.
-            itr->second.second = referenceTime;
+            // if ref count is greater the 1 the object has an external reference.
+            if (itr->second._object && itr->second._object->referenceCount()>1)
+            {
+                // so update it time stamp.
+                itr->second._timeStamp = referenceTime;
+            }
         }
     }
 }
@@ -83,18 +240,16 @@ void ObjectCache::removeExpiredObjectsInCache(double expiryTime)
 {
     std::vector<osg::ref_ptr<osg::Object> > objectsToRemove;
 
+    for (unsigned int i=0; i<sNumShards; ++i)
     {
-        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_shards[i]._objectCacheMutex);
 
         // Remove expired entries from object cache
-        ObjectCacheMap::iterator oitr = _objectCache.begin();
-        while(oitr != _objectCache.end())
+        ObjectCacheMap::iterator oitr = _shards[i]._objectCache.begin();
+        while(oitr != _shards[i]._objectCache.end())
         {
-            if (oitr->second.second<=expiryTime)
-            {
-                objectsToRemove.push_back(oitr->second.first);
-                _objectCache.erase(oitr++);
-            }
+            if (oitr->second._timeStamp<=expiryTime)
+                erase(_shards[i], oitr++, objectsToRemove);
             else
             {
                 ++oitr;
@@ -106,54 +261,149 @@ void ObjectCache::removeExpiredObjectsInCache(double expiryTime)
     objectsToRemove.clear();
 }
 
+size_t ObjectCache::evictObjectsInCache(size_t bytes)
+{
+    std::vector<osg::ref_ptr<osg::Object> > objectsToRemove;
+
+    const size_t totalBytes = getCacheBytes();
+    if (totalBytes == 0)
+        return 0;
+
+    size_t freed = 0;
+    for (unsigned int i=0; i<sNumShards; ++i)
+    {
+        Shard& shard = _shards[i];
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+
+        // each shard frees its share of the requested memory
+        const size_t shardBytes = shard._recentBytes + shard._frequentBytes;
+        const size_t toFree = static_cast<size_t>(static_cast<double>(bytes) * shardBytes / totalBytes + 0.5);
+
+        size_t shardFreed = 0;
+        while (shardFreed < toFree)
+        {
+            // evict from the list that is over its target, if possible
+            bool preferRecent = shard._recentBytes > shard._recentTargetBytes;
+            ObjectCacheMap::iterator victim = findEvictable(shard, preferRecent ? shard._recent : shard._frequent);
+            if (victim == shard._objectCache.end())
+                victim = findEvictable(shard, preferRecent ? shard._frequent : shard._recent);
+            if (victim == shard._objectCache.end())
+                break;
+
+            shardFreed += victim->second._bytes;
+            ++shard._evictions;
+            addGhost(shard, victim->first, victim->second._frequent);
+            erase(shard, victim, objectsToRemove);
+        }
+        freed += shardFreed;
+    }
+
+    // note, actual unref happens outside of the lock
+    objectsToRemove.clear();
+
+    return freed;
+}
+
 void ObjectCache::removeFromObjectCache(const std::string& fileName)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    ObjectCacheMap::iterator itr = _objectCache.find(fileName);
-    if (itr!=_objectCache.end()) _objectCache.erase(itr);
+    std::vector<osg::ref_ptr<osg::Object> > objectsToRemove;
+
+    Shard& shard = getShard(fileName);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+    ObjectCacheMap::iterator itr = shard._objectCache.find(fileName);
+    if (itr!=shard._objectCache.end()) erase(shard, itr, objectsToRemove);
 }
 
 void ObjectCache::clear()
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    _objectCache.clear();
+    for (unsigned int i=0; i<sNumShards; ++i)
+    {
+        Shard& shard = _shards[i];
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._objectCacheMutex);
+        shard._objectCache.clear();
+        shard._recent.clear();
+        shard._frequent.clear();
+        shard._recentBytes = 0;
+        shard._frequentBytes = 0;
+        shard._recentGhosts.clear();
+        shard._frequentGhosts.clear();
+        shard._ghosts.clear();
+        shard._recentTargetBytes = 0;
+    }
 }
 
 void ObjectCache::releaseGLObjects(osg::State* state)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-
-    for(ObjectCacheMap::iterator itr = _objectCache.begin();
-        itr != _objectCache.end();
-        ++itr)
+    for (unsigned int i=0; i<sNumShards; ++i)
     {
-        osg::Object* object = itr->second.first.get();
-        object->releaseGLObjects(state);
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_shards[i]._objectCacheMutex);
+
+        for(ObjectCacheMap::iterator itr = _shards[i]._objectCache.begin();
+            itr != _shards[i]._objectCache.end();
+            ++itr)
+        {
+            osg::Object* object = itr->second._object.get();
+            if (object)
+                object->releaseGLObjects(state);
+        }
     }
 }
 
 void ObjectCache::accept(osg::NodeVisitor &nv)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-
-    for(ObjectCacheMap::iterator itr = _objectCache.begin();
-        itr != _objectCache.end();
-        ++itr)
+    for (unsigned int i=0; i<sNumShards; ++i)
     {
-        osg::Object* object = itr->second.first.get();
-        if (object)
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_shards[i]._objectCacheMutex);
+
+        for(ObjectCacheMap::iterator itr = _shards[i]._objectCache.begin();
+            itr != _shards[i]._objectCache.end();
+            ++itr)
         {
-            osg::Node* node = dynamic_cast<osg::Node*>(object);
-            if (node)
-                node->accept(nv);
+            osg::Object* object = itr->second._object.get();
+            if (object)
+            {
+                osg::Node* node = dynamic_cast<osg::Node*>(object);
+                if (node)
+                    node->accept(nv);
+            }
         }
     }
 }
 
 unsigned int ObjectCache::getCacheSize() const
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    return _objectCache.size();
+    unsigned int size = 0;
+    for (unsigned int i=0; i<sNumShards; ++i)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_shards[i]._objectCacheMutex);
+        size += _shards[i]._objectCache.size();
+    }
+    return size;
+}
+
+size_t ObjectCache::getCacheBytes() const
+{
+    size_t bytes = 0;
+    for (unsigned int i=0; i<sNumShards; ++i)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_shards[i]._objectCacheMutex);
+        bytes += _shards[i]._recentBytes + _shards[i]._frequentBytes;
+    }
+    return bytes;
+}
+
+CacheStats ObjectCache::getCacheStats() const
+{
+    CacheStats stats;
+    for (unsigned int i=0; i<sNumShards; ++i)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_shards[i]._objectCacheMutex);
+        stats.mBytes += _shards[i]._recentBytes + _shards[i]._frequentBytes;
+        stats.mHits += _shards[i]._hits;
+        stats.mMisses += _shards[i]._misses;
+        stats.mEvictions += _shards[i]._evictions;
+    }
+    return stats;
 }
 
 }
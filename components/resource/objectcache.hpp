@@ -1,5 +1,7 @@
 // Resource ObjectCache for OpenMW, forked from osgDB ObjectCache by Robert Osfield, see copyright notice below.
 // The main change from the upstream version is that removeExpiredObjectsInCache no longer keeps a lock while the unref happens.
+// The cache is also split into shards with their own locks, and keeps track of the estimated memory used by its objects,
+// so that unreferenced objects can be evicted to stay within a memory budget (see evictObjectsInCache).
 
 /* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
  *
@@ -17,11 +19,16 @@
 #ifndef OPENMW_COMPONENTS_RESOURCE_OBJECTCACHE
 #define OPENMW_COMPONENTS_RESOURCE_OBJECTCACHE
 
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
 #include <osg/Referenced>
 #include <osg/ref_ptr>
 
 #include <string>
 #include <map>
+#include <list>
+#include <vector>
 
 namespace osg
 {
@@ -32,6 +39,21 @@ namespace osg
 
 namespace Resource {
 
+/// Counters of an ObjectCache, accumulated since the cache was created.
+struct CacheStats
+{
+    CacheStats() : mBytes(0), mHits(0), mMisses(0), mEvictions(0) {}
+
+    size_t mBytes;
+    unsigned int mHits;
+    unsigned int mMisses;
+    unsigned int mEvictions;
+};
+
+/// @par Objects are ordered for eviction by an adaptive replacement policy (ARC): objects that were only requested once
+/// and objects that were requested repeatedly are kept in separate LRU lists, and the keys of recently evicted objects
+/// decide how much memory each list gets. A mesh that is reused over and over is thus not pushed out by a burst of
+/// objects that are only used once.
 class ObjectCache : public osg::Referenced
 {
     public:
@@ -77,24 +99,99 @@ class ObjectCache : public osg::Referenced
         template <class Functor>
         void call(Functor& f)
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-            for (ObjectCacheMap::iterator it = _objectCache.begin(); it != _objectCache.end(); ++it)
-                f(it->second.first.get());
+            for (unsigned int i=0; i<sNumShards; ++i)
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_shards[i]._objectCacheMutex);
+                for (ObjectCacheMap::iterator it = _shards[i]._objectCache.begin(); it != _shards[i]._objectCache.end(); ++it)
+                    f(it->second._object.get());
+            }
         }
 
         /** Get the number of objects in the cache. */
         unsigned int getCacheSize() const;
 
+        /** Get the estimated memory used by the objects in the cache, see MemoryUsage.*/
+        size_t getCacheBytes() const;
+
+        /** Remove objects without external references from the cache, in the order of the replacement policy,
+          * until at least the given number of bytes has been freed or no such objects are left.
+          * @return The number of bytes freed.*/
+        size_t evictObjectsInCache(size_t bytes);
+
+        /** Get the hit, miss and eviction counters as well as the memory used.*/
+        CacheStats getCacheStats() const;
+
     protected:
 
         virtual ~ObjectCache();
 
-        typedef std::pair<osg::ref_ptr<osg::Object>, double >           ObjectTimeStampPair;
-        typedef std::map<std::string, ObjectTimeStampPair >             ObjectCacheMap;
+        typedef std::list<const std::string*>                           LRUList;
+
+        struct Entry
+        {
+            Entry() : _timeStamp(0.0), _bytes(0), _frequent(false) {}
+
+            osg::ref_ptr<osg::Object>   _object;
+            double                      _timeStamp;
+            size_t                      _bytes;
+            // Was the object requested again after it was added? Decides which LRU list it is in.
+            bool                        _frequent;
+            LRUList::iterator           _lruPosition;
+        };
+        typedef std::map<std::string, Entry>                            ObjectCacheMap;
+
+        struct Ghost
+        {
+            bool                        _frequent;
+            std::list<std::string>::iterator _position;
+        };
+
+        struct Shard
+        {
+            Shard() : _recentBytes(0), _frequentBytes(0), _recentTargetBytes(0), _hits(0), _misses(0), _evictions(0) {}
+
+            ObjectCacheMap              _objectCache;
+            mutable OpenThreads::Mutex  _objectCacheMutex;
+
+            // Least recently used entries first
+            LRUList                     _recent;
+            LRUList                     _frequent;
+            size_t                      _recentBytes;
+            size_t                      _frequentBytes;
+
+            // Keys of evicted entries, oldest first. A request for one of them tells us which list was evicted from too eagerly.
+            std::list<std::string>      _recentGhosts;
+            std::list<std::string>      _frequentGhosts;
+            std::map<std::string, Ghost> _ghosts;
+
+            // The share of memory the list of recent entries should get, adapted on ghost hits
+            size_t                      _recentTargetBytes;
+
+            unsigned int                _hits;
+            unsigned int                _misses;
+            unsigned int                _evictions;
+        };
+
+        static const unsigned int sNumShards = 16;
+
+        Shard& getShard(const std::string& fileName);
+        const Shard& getShard(const std::string& fileName) const;
+
+        /// Insert a new entry, or replace the object of an existing one. The shard must be locked.
+        static void insert(Shard& shard, const std::string& fileName, osg::Object* object, double timestamp, size_t bytes);
+
+        /// Move an entry to the most recently used end of its list, promoting it to the list of frequent entries. The shard must be locked.
+        static void touch(Shard& shard, ObjectCacheMap::iterator itr);
+
+        /// Remove an entry. The object is added to \a removed, so that the unref can happen once the shard is unlocked.
+        static void erase(Shard& shard, ObjectCacheMap::iterator itr, std::vector<osg::ref_ptr<osg::Object> >& removed);
+
+        static void addGhost(Shard& shard, const std::string& fileName, bool frequent);
 
-        ObjectCacheMap                          _objectCache;
-        mutable OpenThreads::Mutex              _objectCacheMutex;
+        /// @return The least recently used entry of \a lru without external references, or the end of the cache.
+        static ObjectCacheMap::iterator findEvictable(Shard& shard, const LRUList& lru);
 
+        Shard _shards[sNumShards];
 };
 
 }
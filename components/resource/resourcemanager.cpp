@@ -33,4 +33,19 @@ namespace Resource
         return mVFS;
     }
 
+    size_t ResourceManager::getCacheMemoryUsage() const
+    {
+        return mCache->getCacheBytes();
+    }
+
+    size_t ResourceManager::shrinkCache(size_t bytes)
+    {
+        return mCache->evictObjectsInCache(bytes);
+    }
+
+    CacheStats ResourceManager::getCacheStats() const
+    {
+        return mCache->getCacheStats();
+    }
+
 }
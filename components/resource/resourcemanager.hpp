@@ -1,6 +1,8 @@
 #ifndef OPENMW_COMPONENTS_RESOURCE_MANAGER_H
 #define OPENMW_COMPONENTS_RESOURCE_MANAGER_H
 
+#include <cstddef>
+
 #include <osg/ref_ptr>
 
 namespace VFS
@@ -16,6 +18,7 @@ namespace osg
 namespace Resource
 {
     class ObjectCache;
+    struct CacheStats;
 
     /// @brief Base class for managers that require a virtual file system and object cache.
     /// @par This base class implements clearing of the cache, but populating it and what it's used for is up to the individual sub classes.
@@ -33,6 +36,15 @@ namespace Resource
 
         const VFS::Manager* getVFS() const;
 
+        /// Estimated memory used by the cached objects.
+        size_t getCacheMemoryUsage() const;
+
+        /// Evict cached objects that are not referenced elsewhere, until \a bytes are freed or no such objects are left.
+        /// @return The number of bytes freed.
+        size_t shrinkCache(size_t bytes);
+
+        CacheStats getCacheStats() const;
+
         virtual void reportStats(unsigned int frameNumber, osg::Stats* stats) const {}
 
     protected:
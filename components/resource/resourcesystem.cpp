@@ -4,12 +4,16 @@
 #include "imagemanager.hpp"
 #include "niffilemanager.hpp"
 #include "keyframemanager.hpp"
+#include "objectcache.hpp"
+
+#include <osg/Stats>
 
 namespace Resource
 {
 
     ResourceSystem::ResourceSystem(const VFS::Manager *vfs)
         : mVFS(vfs)
+        , mMaxCacheMemory(0)
     {
         mNifFileManager.reset(new NifFileManager(vfs));
         mKeyframeManager.reset(new KeyframeManager(vfs));
@@ -62,10 +66,35 @@ namespace Resource
         mNifFileManager->setExpiryDelay(0.0);
     }
 
+    void ResourceSystem::setMaxCacheMemory(size_t bytes)
+    {
+        mMaxCacheMemory = bytes;
+    }
+
     void ResourceSystem::updateCache(double referenceTime)
     {
         for (std::vector<ResourceManager*>::iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
             (*it)->updateCache(referenceTime);
+
+        if (mMaxCacheMemory == 0)
+            return;
+
+        size_t total = 0;
+        for (std::vector<ResourceManager*>::iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
+            total += (*it)->getCacheMemoryUsage();
+
+        if (total <= mMaxCacheMemory)
+            return;
+
+        // each cache gives up its share of the excess. Managers referencing objects of other managers come first
+        // (see the constructor), so those objects are unreferenced by the time their own cache is shrunk.
+        double excess = static_cast<double>(total - mMaxCacheMemory);
+        for (std::vector<ResourceManager*>::iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
+        {
+            size_t share = static_cast<size_t>(excess * (*it)->getCacheMemoryUsage() / total + 0.5);
+            if (share > 0)
+                (*it)->shrinkCache(share);
+        }
     }
 
     void ResourceSystem::addResourceManager(ResourceManager *resourceMgr)
@@ -87,8 +116,23 @@ namespace Resource
 
     void ResourceSystem::reportStats(unsigned int frameNumber, osg::Stats *stats) const
     {
+        CacheStats cacheStats;
         for (std::vector<ResourceManager*>::const_iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
+        {
             (*it)->reportStats(frameNumber, stats);
+
+            CacheStats managerStats = (*it)->getCacheStats();
+            cacheStats.mBytes += managerStats.mBytes;
+            cacheStats.mHits += managerStats.mHits;
+            cacheStats.mMisses += managerStats.mMisses;
+            cacheStats.mEvictions += managerStats.mEvictions;
+        }
+
+        // in megabytes
+        stats->setAttribute(frameNumber, "Cache Memory", cacheStats.mBytes / (1024.0 * 1024.0));
+        stats->setAttribute(frameNumber, "Cache Hits", cacheStats.mHits);
+        stats->setAttribute(frameNumber, "Cache Misses", cacheStats.mMisses);
+        stats->setAttribute(frameNumber, "Cache Evictions", cacheStats.mEvictions);
     }
 
 }
@@ -2,6 +2,7 @@
 #define OPENMW_COMPONENTS_RESOURCE_RESOURCESYSTEM_H
 
 #include <memory>
+#include <cstddef>
 #include <vector>
 
 namespace VFS
@@ -51,6 +52,11 @@ namespace Resource
         /// How long to keep objects in cache after no longer being referenced.
         void setExpiryDelay(double expiryDelay);
 
+        /// The estimated memory, in bytes, that the caches of all resource managers may use together. 0 means no limit.
+        /// @par When the caches use more, updateCache() evicts objects that are no longer referenced from each cache,
+        /// in proportion to the memory that cache uses.
+        void setMaxCacheMemory(size_t bytes);
+
         /// @note May be called from any thread.
         const VFS::Manager* getVFS() const;
 
@@ -68,6 +74,8 @@ namespace Resource
 
         const VFS::Manager* mVFS;
 
+        size_t mMaxCacheMemory;
+
         ResourceSystem(const ResourceSystem&);
         void operator = (const ResourceSystem&);
     };
@@ -1,6 +1,7 @@
 #include "scenemanager.hpp"
 
 #include <iostream>
+#include <sstream>
 #include <cstdlib>
 
 #include <osg/Node>
@@ -32,6 +33,7 @@
 #include "niffilemanager.hpp"
 #include "objectcache.hpp"
 #include "multiobjectcache.hpp"
+#include "templatecache.hpp"
 
 namespace
 {
@@ -459,6 +461,21 @@ namespace Resource
         return options;
     }
 
+    void SceneManager::setTemplateCache(TemplateCache *cache)
+    {
+        mTemplateCache.reset(cache);
+    }
+
+    std::string SceneManager::getTemplateSettingsKey() const
+    {
+        std::ostringstream key;
+        key << "nif " << NifOsg::Loader::sVersion << NifOsg::Loader::getShowMarkers()
+            << " " << mForceShaders << mClampLighting << mForcePerPixelLighting << mAutoUseNormalMaps << mAutoUseSpecularMaps
+            << " " << getOptimizationOptions()
+            << " " << mNormalMapPattern << " " << mNormalHeightMapPattern << " " << mSpecularMapPattern;
+        return key.str();
+    }
+
     osg::ref_ptr<const osg::Node> SceneManager::getTemplate(const std::string &name)
     {
         std::string normalized = name;
@@ -469,12 +486,28 @@ namespace Resource
             return osg::ref_ptr<const osg::Node>(static_cast<osg::Node*>(obj.get()));
         else
         {
+            // only .nif files are worth caching, anything else is read by osgDB anyway
+            const bool useTemplateCache = mTemplateCache.get() && getFileExtension(normalized) == "nif";
+            const std::string sourceName = normalized;
+
             osg::ref_ptr<osg::Node> loaded;
+            bool fromTemplateCache = false;
             try
             {
-                Files::IStreamPtr file = mVFS->get(normalized);
+                if (useTemplateCache)
+                {
+                    osg::ref_ptr<osgDB::Options> options (new osgDB::Options);
+                    options->setReadFileCallback(new ImageReadCallback(mImageManager));
+                    loaded = mTemplateCache->read(normalized, getTemplateSettingsKey(), options);
+                    fromTemplateCache = loaded.valid();
+                }
+
+                if (!fromTemplateCache)
+                {
+                    Files::IStreamPtr file = mVFS->get(normalized);
 
-                loaded = load(file, normalized, mImageManager, mNifFileManager);
+                    loaded = load(file, normalized, mImageManager, mNifFileManager);
+                }
             }
             catch (std::exception& e)
             {
@@ -520,7 +553,8 @@ namespace Resource
             mSharedStateManager->share(loaded.get());
             mSharedStateMutex.unlock();
 
-            if (canOptimize(normalized))
+            // cached templates are optimized already
+            if (!fromTemplateCache && canOptimize(normalized))
             {
                 SceneUtil::Optimizer optimizer;
                 optimizer.setIsOperationPermissibleForObjectCallback(new CanOptimizeCallback);
@@ -530,6 +564,11 @@ namespace Resource
                 optimizer.optimize(loaded, options);
             }
 
+            // the programs of a cached template are replaced by the shader visitor when it is read, so that the
+            // cache stays valid when the shader sources change
+            if (useTemplateCache && !fromTemplateCache && normalized == sourceName)
+                mTemplateCache->write(normalized, getTemplateSettingsKey(), loaded);
+
             if (mIncrementalCompileOperation)
                 mIncrementalCompileOperation->add(loaded);
 
@@ -37,6 +37,7 @@ namespace Resource
 {
 
     class MultiObjectCache;
+    class TemplateCache;
 
     /// @brief Handles loading and caching of scenes, e.g. .nif files or .osg files
     /// @note Some methods of the scene manager can be used from any thread, see the methods documentation for more details.
@@ -140,6 +141,11 @@ namespace Resource
         /// otherwise should be disabled to reduce memory usage.
         void setUnRefImageDataAfterApply(bool unref);
 
+        /// Store converted .nif templates in \a cache and read them from there instead of converting them again.
+        /// @note Takes ownership of the given pointer.
+        /// @note Not thread safe, call before loading any templates.
+        void setTemplateCache(TemplateCache* cache);
+
         /// @see ResourceManager::updateCache
         virtual void updateCache(double referenceTime);
 
@@ -159,6 +165,10 @@ namespace Resource
 
         osg::ref_ptr<MultiObjectCache> mInstanceCache;
 
+        std::auto_ptr<TemplateCache> mTemplateCache;
+        /// Loader version and settings that affect the cached templates
+        std::string getTemplateSettingsKey() const;
+
         osg::ref_ptr<Resource::SharedStateManager> mSharedStateManager;
         mutable OpenThreads::Mutex mSharedStateMutex;
 
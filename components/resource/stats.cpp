@@ -259,7 +259,7 @@ void StatsHandler::setUpScene(osgViewer::ViewerBase *viewer)
         _resourceStatsChildNum = _switch->getNumChildren();
         _switch->addChild(group, false);
 
-        const char* statNames[] = {"Compiling", "WorkQueue", "WorkThread", "", "Texture", "StateSet", "Node", "Node Instance", "Shape", "Shape Instance", "Image", "Nif", "Keyframe", "", "Terrain Chunk", "Terrain Texture", "Land", "Composite", "", "UnrefQueue"};
+        const char* statNames[] = {"Compiling", "WorkQueue", "WorkThread", "", "WorkQueue High", "WorkQueue Normal", "WorkQueue Low", "Wait High", "Wait Normal", "Wait Low", "", "Texture", "StateSet", "Node", "Node Instance", "Shape", "Shape Instance", "Image", "Nif", "Keyframe", "", "Cache Memory", "Cache Hits", "Cache Misses", "Cache Evictions", "", "Terrain Chunk", "Terrain Texture", "Land", "Composite", "", "UnrefQueue", "", "Rays Other", "Rays Combat", "Rays Detection", "Rays Wander", "Rays Follow", "Rays Path", "Rays Projectile", "Rays Camera", "Rays Script"};
 
         int numLines = sizeof(statNames) / sizeof(statNames[0]);
 
@@ -0,0 +1,259 @@
+#include "templatecache.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <osg/Node>
+#include <osg/Drawable>
+#include <osg/Texture>
+#include <osg/Image>
+#include <osg/UserDataContainer>
+#include <osg/Version>
+
+#include <osgDB/Registry>
+
+#include <OpenThreads/ScopedLock>
+
+#include <components/vfs/manager.hpp>
+
+#include <components/sceneutil/serialize.hpp>
+
+namespace
+{
+
+    /// Checks that every object of a scene can be written to the osgb format and restored, see SceneUtil::canSerialize.
+    class CacheableVisitor : public osg::NodeVisitor
+    {
+    public:
+        CacheableVisitor()
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            , mCacheable(true)
+        {
+        }
+
+        virtual void apply(osg::Node& node)
+        {
+            checkNode(node);
+            if (mCacheable)
+                traverse(node);
+        }
+
+        virtual void apply(osg::Drawable& drawable)
+        {
+            checkNode(drawable);
+            check(drawable.getComputeBoundingBoxCallback());
+            check(drawable.getDrawCallback());
+        }
+
+        bool mCacheable;
+
+    private:
+        void checkNode(osg::Node& node)
+        {
+            check(&node);
+            checkCallback(node.getUpdateCallback());
+            checkCallback(node.getCullCallback());
+            checkCallback(node.getEventCallback());
+            checkStateSet(node.getStateSet());
+            checkUserData(node.getUserDataContainer());
+        }
+
+        void checkCallback(const osg::Callback* callback)
+        {
+            for (; callback && mCacheable; callback = callback->getNestedCallback())
+                check(callback);
+        }
+
+        void checkUserData(const osg::UserDataContainer* container)
+        {
+            if (!container)
+                return;
+            check(container);
+            for (unsigned int i=0; i<container->getNumUserObjects(); ++i)
+                check(container->getUserObject(i));
+        }
+
+        void checkStateSet(const osg::StateSet* stateset)
+        {
+            if (!stateset || !mCacheable)
+                return;
+            check(stateset);
+            checkCallback(stateset->getUpdateCallback());
+            checkCallback(stateset->getEventCallback());
+
+            const osg::StateSet::AttributeList& attributes = stateset->getAttributeList();
+            for (osg::StateSet::AttributeList::const_iterator it = attributes.begin(); it != attributes.end(); ++it)
+                check(it->second.first.get());
+
+            const osg::StateSet::TextureAttributeList& texAttributes = stateset->getTextureAttributeList();
+            for (unsigned int unit=0; unit<texAttributes.size(); ++unit)
+            {
+                for (osg::StateSet::AttributeList::const_iterator it = texAttributes[unit].begin(); it != texAttributes[unit].end(); ++it)
+                {
+                    const osg::StateAttribute* attribute = it->second.first.get();
+                    check(attribute);
+
+                    // images are written as references to the file they were read from
+                    const osg::Texture* texture = attribute->asTexture();
+                    if (texture)
+                    {
+                        for (unsigned int i=0; i<texture->getNumImages(); ++i)
+                        {
+                            const osg::Image* image = texture->getImage(i);
+                            if (image && image->getFileName().empty())
+                                mCacheable = false;
+                        }
+                    }
+                }
+            }
+
+            const osg::StateSet::UniformList& uniforms = stateset->getUniformList();
+            for (osg::StateSet::UniformList::const_iterator it = uniforms.begin(); it != uniforms.end(); ++it)
+                check(it->second.first.get());
+        }
+
+        void check(const osg::Object* object)
+        {
+            if (object && !SceneUtil::canSerialize(object))
+                mCacheable = false;
+        }
+    };
+
+    osgDB::ReaderWriter* getReaderWriter()
+    {
+        return osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+    }
+
+}
+
+namespace Resource
+{
+
+    TemplateCache::TemplateCache(const VFS::Manager *vfs, const std::string &path)
+        : mVFS(vfs)
+        , mPath(path)
+    {
+        SceneUtil::registerUserDataSerializers();
+
+        try
+        {
+            boost::filesystem::create_directories(mPath);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to create model cache directory " << mPath.string() << ": " << e.what() << std::endl;
+        }
+    }
+
+    std::string TemplateCache::getKey(const std::string &normalizedName, const std::string &settingsKey) const
+    {
+        boost::filesystem::path source = mVFS->getArchivePath(normalizedName);
+
+        std::ostringstream key;
+        key << "openmw-template " << sFormatVersion << " osg " << osgGetVersion()
+            << " " << normalizedName << " " << source.string() << " " << boost::filesystem::file_size(source)
+            << " " << boost::filesystem::last_write_time(source) << " " << settingsKey;
+        return key.str();
+    }
+
+    boost::filesystem::path TemplateCache::getCacheFile(const std::string &normalizedName) const
+    {
+        // escape everything but a few safe characters, so that different names never share a file
+        static const char hexDigits[] = "0123456789abcdef";
+        std::string filename;
+        for (std::string::const_iterator it = normalizedName.begin(); it != normalizedName.end(); ++it)
+        {
+            const unsigned char c = static_cast<unsigned char>(*it);
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '_')
+                filename += c;
+            else
+            {
+                filename += '%';
+                filename += hexDigits[c >> 4];
+                filename += hexDigits[c & 0xf];
+            }
+        }
+        return mPath / (filename + ".osgb");
+    }
+
+    osg::ref_ptr<osg::Node> TemplateCache::read(const std::string &normalizedName, const std::string& settingsKey, const osgDB::Options *options) const
+    {
+        osgDB::ReaderWriter* reader = getReaderWriter();
+        if (!reader)
+            return NULL;
+
+        boost::filesystem::path cacheFile = getCacheFile(normalizedName);
+        try
+        {
+            boost::filesystem::ifstream stream(cacheFile, std::ios::binary);
+            if (!stream.is_open())
+                return NULL;
+
+            std::string key;
+            std::getline(stream, key);
+            if (key != getKey(normalizedName, settingsKey))
+                return NULL;
+
+            osgDB::ReaderWriter::ReadResult result = reader->readNode(stream, options);
+            if (!result.success())
+            {
+                std::cerr << "Failed to read " << cacheFile.string() << ": " << result.message() << std::endl;
+                return NULL;
+            }
+            return result.getNode();
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to read " << cacheFile.string() << ": " << e.what() << std::endl;
+            return NULL;
+        }
+    }
+
+    void TemplateCache::write(const std::string &normalizedName, const std::string& settingsKey, const osg::Node *node) const
+    {
+        osgDB::ReaderWriter* writer = getReaderWriter();
+        if (!writer || !isCacheable(node))
+            return;
+
+        boost::filesystem::path cacheFile = getCacheFile(normalizedName);
+        boost::filesystem::path tempFile = cacheFile.string() + ".tmp";
+
+        // the same template may be loaded by several threads at once
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mWriteMutex);
+        try
+        {
+            {
+                boost::filesystem::ofstream stream(tempFile, std::ios::binary);
+                if (!stream.is_open())
+                    throw std::runtime_error("can not open " + tempFile.string());
+
+                stream << getKey(normalizedName, settingsKey) << '\n';
+
+                osg::ref_ptr<osgDB::Options> options (new osgDB::Options("WriteImageHint=UseExternal"));
+                osgDB::ReaderWriter::WriteResult result = writer->writeNode(*node, stream, options);
+                if (!result.success())
+                    throw std::runtime_error(result.message());
+            }
+
+            boost::filesystem::rename(tempFile, cacheFile);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to write " << cacheFile.string() << ": " << e.what() << std::endl;
+            boost::system::error_code ec;
+            boost::filesystem::remove(tempFile, ec);
+        }
+    }
+
+    bool TemplateCache::isCacheable(const osg::Node *node)
+    {
+        CacheableVisitor visitor;
+        const_cast<osg::Node*>(node)->accept(visitor);
+        return visitor.mCacheable;
+    }
+
+}
@@ -0,0 +1,74 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_TEMPLATECACHE_H
+#define OPENMW_COMPONENTS_RESOURCE_TEMPLATECACHE_H
+
+#include <string>
+
+#include <boost/filesystem/path.hpp>
+
+#include <osg/ref_ptr>
+
+#include <OpenThreads/Mutex>
+
+namespace osg
+{
+    class Node;
+}
+
+namespace osgDB
+{
+    class Options;
+}
+
+namespace VFS
+{
+    class Manager;
+}
+
+namespace Resource
+{
+
+    /// @brief Stores converted and optimized scene templates as .osgb files, so that later sessions can read them
+    /// instead of converting the original file again.
+    /// @par Only templates made of core osg classes and the user data of the NIF loader can be stored, see isCacheable().
+    /// The serializers of our other classes (NIF controllers, skinned geometry, particle systems, ...) are only meant for
+    /// exporting scenes and can not restore them.
+    /// @par Each file starts with a key line made of the cache format, the OSG version, the name of the template, the path,
+    /// size and modification time of the file on disk the template was read from (the loose file or its archive), and a key
+    /// for the version of the loader and any settings that affect the conversion. A file whose key doesn't match is ignored and replaced by the next write.
+    /// @note Thread safe.
+    class TemplateCache
+    {
+    public:
+        /// @param path The directory to store the templates in, created if it does not exist.
+        TemplateCache(const VFS::Manager* vfs, const std::string& path);
+
+        /// Read the template of \a normalizedName, using \a options to read external files, e.g. images.
+        /// @return NULL if there is no valid cached template.
+        osg::ref_ptr<osg::Node> read(const std::string& normalizedName, const std::string& settingsKey, const osgDB::Options* options) const;
+
+        /// Store the template of \a normalizedName. Does nothing if the template is not cacheable.
+        /// @note The template must not be modified while it is being written.
+        void write(const std::string& normalizedName, const std::string& settingsKey, const osg::Node* node) const;
+
+        /// Can the scene be written and read back without losing anything?
+        static bool isCacheable(const osg::Node* node);
+
+        /// Increase when the cache file layout, the user data serializers or the optimizer change. Changes to the
+        /// conversion of a file format are covered by the loader version in the settings key.
+        static const int sFormatVersion = 2;
+
+    private:
+        std::string getKey(const std::string& normalizedName, const std::string& settingsKey) const;
+
+        /// Each name has its own file, the name is escaped rather than flattened.
+        boost::filesystem::path getCacheFile(const std::string& normalizedName) const;
+
+        const VFS::Manager* mVFS;
+        boost::filesystem::path mPath;
+
+        mutable OpenThreads::Mutex mWriteMutex;
+    };
+
+}
+
+#endif
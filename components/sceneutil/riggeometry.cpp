@@ -4,12 +4,59 @@
 #include <iostream>
 #include <cstdlib>
 
+#include <OpenThreads/ScopedLock>
+
 #include "skeleton.hpp"
 #include "util.hpp"
+#include "workqueue.hpp"
 
 namespace SceneUtil
 {
 
+WorkQueue* RigGeometry::sWorkQueue = NULL;
+
+/// Skins the vertices of one RigGeometry for one frame. Whichever comes first of a work thread and the
+/// RigGeometry itself (when it is about to be drawn) does the work, the other one waits for it.
+class RigGeometry::SkinningItem : public WorkItem
+{
+public:
+    SkinningItem(RigGeometry* rig)
+        : mRig(rig)
+    {
+    }
+
+    virtual void doWork()
+    {
+        run();
+    }
+
+    void finish()
+    {
+        if (!run())
+            waitTillDone();
+    }
+
+    /// Make sure the RigGeometry is not used by the item anymore, without doing the work if it has not started.
+    void abandon()
+    {
+        if (mStarted.exchange(1) != 0)
+            waitTillDone();
+    }
+
+private:
+    bool run()
+    {
+        if (mStarted.exchange(1) != 0)
+            return false;
+        mRig->skinVertices();
+        return true;
+    }
+
+    // The RigGeometry finishes or abandons the item before it is destroyed
+    RigGeometry* mRig;
+    OpenThreads::Atomic mStarted;
+};
+
 class UpdateRigBounds : public osg::Drawable::UpdateCallback
 {
 public:
@@ -85,6 +132,17 @@ RigGeometry::RigGeometry(const RigGeometry &copy, const osg::CopyOp &copyop)
     setSourceGeometry(copy.mSourceGeometry);
 }
 
+RigGeometry::~RigGeometry()
+{
+    if (mSkinningItem)
+        mSkinningItem->abandon();
+}
+
+void RigGeometry::setWorkQueue(WorkQueue *workQueue)
+{
+    sWorkQueue = workQueue;
+}
+
 void RigGeometry::setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeometry)
 {
     mSourceGeometry = sourceGeometry;
@@ -172,7 +230,9 @@ bool RigGeometry::initFromParentSkeleton(osg::NodeVisitor* nv)
         return false;
     }
 
-    typedef std::map<unsigned short, std::vector<BoneWeight> > Vertex2BoneMap;
+    typedef std::pair<Bone*, osg::Matrixf> BoneBindMatrixPair;
+    typedef std::pair<BoneBindMatrixPair, float> BoneWeightPair;
+    typedef std::map<unsigned short, std::vector<BoneWeightPair> > Vertex2BoneMap;
     Vertex2BoneMap vertex2BoneMap;
     for (std::map<std::string, BoneInfluence>::const_iterator it = mInfluenceMap->mMap.begin(); it != mInfluenceMap->mMap.end(); ++it)
     {
@@ -190,18 +250,45 @@ bool RigGeometry::initFromParentSkeleton(osg::NodeVisitor* nv)
         const std::map<unsigned short, float>& weights = it->second.mWeights;
         for (std::map<unsigned short, float>::const_iterator weightIt = weights.begin(); weightIt != weights.end(); ++weightIt)
         {
-            std::vector<BoneWeight>& vec = vertex2BoneMap[weightIt->first];
+            std::vector<BoneWeightPair>& vec = vertex2BoneMap[weightIt->first];
 
-            BoneWeight b = std::make_pair(std::make_pair(bone, bi.mInvBindMatrix), weightIt->second);
+            BoneWeightPair b = std::make_pair(std::make_pair(bone, bi.mInvBindMatrix), weightIt->second);
 
             vec.push_back(b);
         }
     }
 
+    // group the vertices with the same influences, the map sorts them by bone
+    typedef std::map<std::vector<BoneWeightPair>, std::vector<unsigned short> > Bone2VertexMap;
+    Bone2VertexMap bone2VertexMap;
     for (Vertex2BoneMap::iterator it = vertex2BoneMap.begin(); it != vertex2BoneMap.end(); ++it)
     {
-        mBone2VertexMap[it->second].push_back(it->first);
+        bone2VertexMap[it->second].push_back(it->first);
+    }
+
+    mBoneWeights.clear();
+    mVertices.clear();
+    mInfluenceGroups.clear();
+    for (Bone2VertexMap::const_iterator it = bone2VertexMap.begin(); it != bone2VertexMap.end(); ++it)
+    {
+        InfluenceGroup group;
+        group.mFirstWeight = mBoneWeights.size();
+        group.mNumWeights = it->first.size();
+        group.mFirstVertex = mVertices.size();
+        group.mNumVertices = it->second.size();
+        mInfluenceGroups.push_back(group);
+
+        for (std::vector<BoneWeightPair>::const_iterator weightIt = it->first.begin(); weightIt != it->first.end(); ++weightIt)
+        {
+            BoneWeight weight;
+            weight.mBone = weightIt->first.first;
+            weight.mInvBindMatrix = weightIt->first.second;
+            weight.mWeight = weightIt->second;
+            mBoneWeights.push_back(weight);
+        }
+        mVertices.insert(mVertices.end(), it->second.begin(), it->second.end());
     }
+    mGroupMatrices.resize(mInfluenceGroups.size());
 
     return true;
 }
@@ -238,7 +325,8 @@ void RigGeometry::update(osg::NodeVisitor* nv)
             return;
     }
 
-    if (!mSkeleton->getActive() && mLastFrameNumber != 0)
+    // the FrameSwitch keeps showing this copy until the skeleton is updated again
+    if (!mSkeleton->wasUpdated(nv->getTraversalNumber()) && mLastFrameNumber != 0)
         return;
 
     if (mLastFrameNumber == nv->getTraversalNumber())
@@ -247,53 +335,137 @@ void RigGeometry::update(osg::NodeVisitor* nv)
 
     mSkeleton->updateBoneMatrices(nv->getTraversalNumber());
 
-    // skinning
-    osg::Vec3Array* positionSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getVertexArray());
-    osg::Vec3Array* normalSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getNormalArray());
-    osg::Vec4Array* tangentSrc = mSourceTangents;
-
-    osg::Vec3Array* positionDst = static_cast<osg::Vec3Array*>(getVertexArray());
-    osg::Vec3Array* normalDst = static_cast<osg::Vec3Array*>(getNormalArray());
-    osg::Vec4Array* tangentDst = static_cast<osg::Vec4Array*>(getTexCoordArray(7));
+    // the previous frame has to be done before we change the matrices
+    finishSkinning();
 
-    for (Bone2VertexMap::const_iterator it = mBone2VertexMap.begin(); it != mBone2VertexMap.end(); ++it)
+    for (unsigned int i=0; i<mInfluenceGroups.size(); ++i)
     {
-        osg::Matrixf resultMat  (0, 0, 0, 0,
-                                0, 0, 0, 0,
-                                0, 0, 0, 0,
-                                0, 0, 0, 1);
-
-        for (std::vector<BoneWeight>::const_iterator weightIt = it->first.begin(); weightIt != it->first.end(); ++weightIt)
+        const InfluenceGroup& group = mInfluenceGroups[i];
+        osg::Matrixf& resultMat = mGroupMatrices[i];
+        resultMat.set(0, 0, 0, 0,
+                      0, 0, 0, 0,
+                      0, 0, 0, 0,
+                      0, 0, 0, 1);
+
+        for (unsigned int w=group.mFirstWeight; w<group.mFirstWeight+group.mNumWeights; ++w)
         {
-            Bone* bone = weightIt->first.first;
-            const osg::Matrix& invBindMatrix = weightIt->first.second;
-            float weight = weightIt->second;
-            const osg::Matrixf& boneMatrix = bone->mMatrixInSkeletonSpace;
-            accumulateMatrix(invBindMatrix, boneMatrix, weight, resultMat);
+            const BoneWeight& weight = mBoneWeights[w];
+            accumulateMatrix(weight.mInvBindMatrix, weight.mBone->mMatrixInSkeletonSpace, weight.mWeight, resultMat);
         }
         if (mGeomToSkelMatrix)
             resultMat *= (*mGeomToSkelMatrix);
+    }
+
+    if (sWorkQueue)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mSkinningMutex);
+        mSkinningItem = new SkinningItem(this);
+        sWorkQueue->addWorkItem(mSkinningItem);
+    }
+    else
+        skinVertices();
+}
+
+namespace
+{
+    // The skinning matrices are affine, so unlike osg::Matrixf::preMult there is no need to divide by w.
+    inline void transformPoint(const float* m, const osg::Vec3f& src, osg::Vec3f& dst)
+    {
+        const float x = src.x(), y = src.y(), z = src.z();
+        dst.set(m[0]*x + m[4]*y + m[8]*z + m[12],
+                m[1]*x + m[5]*y + m[9]*z + m[13],
+                m[2]*x + m[6]*y + m[10]*z + m[14]);
+    }
+
+    inline void transformVector(const float* m, const osg::Vec3f& src, osg::Vec3f& dst)
+    {
+        const float x = src.x(), y = src.y(), z = src.z();
+        dst.set(m[0]*x + m[4]*y + m[8]*z,
+                m[1]*x + m[5]*y + m[9]*z,
+                m[2]*x + m[6]*y + m[10]*z);
+    }
+}
+
+void RigGeometry::skinVertices()
+{
+    if (mInfluenceGroups.empty())
+        return;
+
+    const osg::Vec3f* positionSrc = &static_cast<osg::Vec3Array*>(mSourceGeometry->getVertexArray())->front();
+    osg::Vec3Array* normalSrcArray = static_cast<osg::Vec3Array*>(mSourceGeometry->getNormalArray());
+    osg::Vec4Array* tangentSrcArray = mSourceTangents;
+
+    osg::Vec3Array* positionDstArray = static_cast<osg::Vec3Array*>(getVertexArray());
+    osg::Vec3Array* normalDstArray = static_cast<osg::Vec3Array*>(getNormalArray());
+    osg::Vec4Array* tangentDstArray = static_cast<osg::Vec4Array*>(getTexCoordArray(7));
+
+    osg::Vec3f* positionDst = &positionDstArray->front();
+    const osg::Vec3f* normalSrc = normalDstArray ? &normalSrcArray->front() : NULL;
+    osg::Vec3f* normalDst = normalDstArray ? &normalDstArray->front() : NULL;
+    const osg::Vec4f* tangentSrc = tangentDstArray ? &tangentSrcArray->front() : NULL;
+    osg::Vec4f* tangentDst = tangentDstArray ? &tangentDstArray->front() : NULL;
+
+    for (unsigned int i=0; i<mInfluenceGroups.size(); ++i)
+    {
+        const InfluenceGroup& group = mInfluenceGroups[i];
+        const float* m = mGroupMatrices[i].ptr();
+        const unsigned short* vertex = &mVertices[group.mFirstVertex];
+        const unsigned short* end = vertex + group.mNumVertices;
 
-        for (std::vector<unsigned short>::const_iterator vertexIt = it->second.begin(); vertexIt != it->second.end(); ++vertexIt)
+        for (const unsigned short* it = vertex; it != end; ++it)
+            transformPoint(m, positionSrc[*it], positionDst[*it]);
+
+        if (normalDst)
         {
-            unsigned short vertex = *vertexIt;
-            (*positionDst)[vertex] = resultMat.preMult((*positionSrc)[vertex]);
-            if (normalDst)
-                (*normalDst)[vertex] = osg::Matrix::transform3x3((*normalSrc)[vertex], resultMat);
-            if (tangentDst)
+            for (const unsigned short* it = vertex; it != end; ++it)
+                transformVector(m, normalSrc[*it], normalDst[*it]);
+        }
+
+        if (tangentDst)
+        {
+            for (const unsigned short* it = vertex; it != end; ++it)
             {
-                osg::Vec4f srcTangent = (*tangentSrc)[vertex];
-                osg::Vec3f transformedTangent = osg::Matrix::transform3x3(osg::Vec3f(srcTangent.x(), srcTangent.y(), srcTangent.z()), resultMat);
-                (*tangentDst)[vertex] = osg::Vec4f(transformedTangent, srcTangent.w());
+                const osg::Vec4f& srcTangent = tangentSrc[*it];
+                osg::Vec3f transformedTangent;
+                transformVector(m, osg::Vec3f(srcTangent.x(), srcTangent.y(), srcTangent.z()), transformedTangent);
+                tangentDst[*it] = osg::Vec4f(transformedTangent, srcTangent.w());
             }
         }
     }
 
-    positionDst->dirty();
-    if (normalDst)
-        normalDst->dirty();
-    if (tangentDst)
-        tangentDst->dirty();
+    positionDstArray->dirty();
+    if (normalDstArray)
+        normalDstArray->dirty();
+    if (tangentDstArray)
+        tangentDstArray->dirty();
+}
+
+void RigGeometry::finishSkinning() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mSkinningMutex);
+    if (mSkinningItem)
+    {
+        mSkinningItem->finish();
+        mSkinningItem = NULL;
+    }
+}
+
+void RigGeometry::drawImplementation(osg::RenderInfo &renderInfo) const
+{
+    finishSkinning();
+    osg::Geometry::drawImplementation(renderInfo);
+}
+
+void RigGeometry::accept(osg::PrimitiveFunctor &functor) const
+{
+    finishSkinning();
+    osg::Geometry::accept(functor);
+}
+
+void RigGeometry::accept(osg::PrimitiveIndexFunctor &functor) const
+{
+    finishSkinning();
+    osg::Geometry::accept(functor);
 }
 
 void RigGeometry::updateBounds(osg::NodeVisitor *nv)
@@ -304,7 +476,7 @@ void RigGeometry::updateBounds(osg::NodeVisitor *nv)
             return;
     }
 
-    if (!mSkeleton->getActive() && !mBoundsFirstFrame)
+    if (!mSkeleton->wasUpdated(nv->getTraversalNumber()) && !mBoundsFirstFrame)
         return;
     mBoundsFirstFrame = false;
 
@@ -4,11 +4,14 @@
 #include <osg/Geometry>
 #include <osg/Matrixf>
 
+#include <OpenThreads/Mutex>
+
 namespace SceneUtil
 {
 
     class Skeleton;
     class Bone;
+    class WorkQueue;
 
     /// @brief Mesh skinning implementation.
     /// @note A RigGeometry may be attached directly to a Skeleton, or somewhere below a Skeleton.
@@ -16,11 +19,14 @@ namespace SceneUtil
     /// @note To avoid race conditions, the rig geometry needs to be double buffered. This can be done
     /// using a FrameSwitch node that has two RigGeometry children. In the future we may want to consider implementing
     /// the double buffering inside RigGeometry.
+    /// @note If a work queue is set with setWorkQueue(), the vertices are skinned on its threads. The cull traversal only
+    /// computes the skinning matrices, and the geometry waits for its vertices before it is drawn or intersected.
     class RigGeometry : public osg::Geometry
     {
     public:
         RigGeometry();
         RigGeometry(const RigGeometry& copy, const osg::CopyOp& copyop);
+        ~RigGeometry();
 
         META_Object(SceneUtil, RigGeometry)
 
@@ -51,6 +57,17 @@ namespace SceneUtil
         // Called automatically by our UpdateCallback
         void updateBounds(osg::NodeVisitor* nv);
 
+        virtual void drawImplementation(osg::RenderInfo& renderInfo) const;
+
+        using osg::Geometry::accept;
+        virtual void accept(osg::PrimitiveFunctor& functor) const;
+        virtual void accept(osg::PrimitiveIndexFunctor& functor) const;
+
+        /// Skin the vertices of all RigGeometries on the threads of \a workQueue, or on the cull thread if NULL.
+        /// @note Not thread safe, set before rendering starts. The work queue must outlive the use of any RigGeometry,
+        /// or be unset first.
+        static void setWorkQueue(WorkQueue* workQueue);
+
     private:
         osg::ref_ptr<osg::Geometry> mSourceGeometry;
         osg::ref_ptr<osg::Vec4Array> mSourceTangents;
@@ -60,15 +77,39 @@ namespace SceneUtil
 
         osg::ref_ptr<InfluenceMap> mInfluenceMap;
 
-        typedef std::pair<Bone*, osg::Matrixf> BoneBindMatrixPair;
+        struct BoneWeight
+        {
+            Bone* mBone;
+            osg::Matrixf mInvBindMatrix;
+            float mWeight;
+        };
 
-        typedef std::pair<BoneBindMatrixPair, float> BoneWeight;
+        /// Vertices influenced by the same bones with the same weights, which share a skinning matrix
+        struct InfluenceGroup
+        {
+            unsigned int mFirstWeight;
+            unsigned int mNumWeights;
+            unsigned int mFirstVertex;
+            unsigned int mNumVertices;
+        };
+
+        // Flat layout of the influences, the groups are sorted by bone, their vertices in ascending order
+        std::vector<BoneWeight> mBoneWeights;
+        std::vector<unsigned short> mVertices;
+        std::vector<InfluenceGroup> mInfluenceGroups;
 
-        typedef std::vector<unsigned short> VertexList;
+        /// Skinning matrix of each group in the current frame
+        std::vector<osg::Matrixf> mGroupMatrices;
 
-        typedef std::map<std::vector<BoneWeight>, VertexList> Bone2VertexMap;
+        class SkinningItem;
+        friend class SkinningItem;
 
-        Bone2VertexMap mBone2VertexMap;
+        /// Skinning of the current frame, if done by the work queue
+        mutable osg::ref_ptr<SkinningItem> mSkinningItem;
+        // the geometry may be drawn and intersected at the same time
+        mutable OpenThreads::Mutex mSkinningMutex;
+
+        static WorkQueue* sWorkQueue;
 
         typedef std::map<Bone*, osg::BoundingSpheref> BoneSphereMap;
 
@@ -79,6 +120,12 @@ namespace SceneUtil
 
         bool initFromParentSkeleton(osg::NodeVisitor* nv);
 
+        /// Transform the source vertices with the matrices in mGroupMatrices.
+        void skinVertices();
+
+        /// Wait for the skinning of the current frame, if any, or do it on this thread if it has not started yet.
+        void finishSkinning() const;
+
         void updateGeomToSkelMatrix(const osg::NodePath& nodePath);
     };
 
@@ -7,9 +7,15 @@
 #include <components/sceneutil/skeleton.hpp>
 #include <components/sceneutil/riggeometry.hpp>
 
+#include <components/nifosg/userdata.hpp>
+#include <components/nifosg/nifloader.hpp>
+
 namespace SceneUtil
 {
 
+// Set once the serializers for exporting scenes are registered
+static bool exportSerializersRegistered = false;
+
 template <class Cls>
 static osg::Object* createInstanceFunc() { return new Cls; }
 
@@ -73,6 +79,93 @@ public:
     }
 };
 
+static bool checkNodeUserData(const NifOsg::NodeUserData&)
+{
+    return true;
+}
+
+static bool readNodeUserData(osgDB::InputStream& is, NifOsg::NodeUserData& userData)
+{
+    is >> userData.mIndex >> userData.mScale;
+    is >> is.BEGIN_BRACKET;
+    for (int i=0; i<3; ++i)
+        for (int j=0; j<3; ++j)
+            is >> userData.mRotationScale.mValues[i][j];
+    is >> is.END_BRACKET;
+    return true;
+}
+
+static bool writeNodeUserData(osgDB::OutputStream& os, const NifOsg::NodeUserData& userData)
+{
+    os << userData.mIndex << userData.mScale;
+    os << os.BEGIN_BRACKET << std::endl;
+    for (int i=0; i<3; ++i)
+    {
+        for (int j=0; j<3; ++j)
+            os << userData.mRotationScale.mValues[i][j];
+        os << std::endl;
+    }
+    os << os.END_BRACKET << std::endl;
+    return true;
+}
+
+class NodeUserDataSerializer : public osgDB::ObjectWrapper
+{
+public:
+    NodeUserDataSerializer()
+        : osgDB::ObjectWrapper(createInstanceFunc<NifOsg::NodeUserData>, "NifOsg::NodeUserData", "osg::Object NifOsg::NodeUserData")
+    {
+        addSerializer( new osgDB::UserSerializer<NifOsg::NodeUserData>(
+            "Data", &checkNodeUserData, &readNodeUserData, &writeNodeUserData), osgDB::BaseSerializer::RW_USER );
+    }
+};
+
+static bool checkTextKeys(const NifOsg::TextKeyMapHolder& holder)
+{
+    return !holder.mTextKeys.empty();
+}
+
+static bool readTextKeys(osgDB::InputStream& is, NifOsg::TextKeyMapHolder& holder)
+{
+    unsigned int size = is.readSize();
+    is >> is.BEGIN_BRACKET;
+    for (unsigned int i=0; i<size; ++i)
+    {
+        float time;
+        std::string text;
+        is >> time;
+        is.readWrappedString(text);
+        holder.mTextKeys.insert(std::make_pair(time, text));
+    }
+    is >> is.END_BRACKET;
+    return true;
+}
+
+static bool writeTextKeys(osgDB::OutputStream& os, const NifOsg::TextKeyMapHolder& holder)
+{
+    os.writeSize(holder.mTextKeys.size());
+    os << os.BEGIN_BRACKET << std::endl;
+    for (NifOsg::TextKeyMap::const_iterator it = holder.mTextKeys.begin(); it != holder.mTextKeys.end(); ++it)
+    {
+        os << it->first;
+        os.writeWrappedString(it->second);
+        os << std::endl;
+    }
+    os << os.END_BRACKET << std::endl;
+    return true;
+}
+
+class TextKeyMapHolderSerializer : public osgDB::ObjectWrapper
+{
+public:
+    TextKeyMapHolderSerializer()
+        : osgDB::ObjectWrapper(createInstanceFunc<NifOsg::TextKeyMapHolder>, "NifOsg::TextKeyMapHolder", "osg::Object NifOsg::TextKeyMapHolder")
+    {
+        addSerializer( new osgDB::UserSerializer<NifOsg::TextKeyMapHolder>(
+            "TextKeys", &checkTextKeys, &readTextKeys, &writeTextKeys), osgDB::BaseSerializer::RW_USER );
+    }
+};
+
 osgDB::ObjectWrapper* makeDummySerializer(const std::string& classname)
 {
     return new osgDB::ObjectWrapper(createInstanceFunc<osg::DummyObject>, classname, "osg::Object");
@@ -87,11 +180,26 @@ public:
     }
 };
 
+void registerUserDataSerializers()
+{
+    static bool done = false;
+    if (!done)
+    {
+        osgDB::ObjectWrapperManager* mgr = osgDB::Registry::instance()->getObjectWrapperManager();
+        mgr->addWrapper(new NodeUserDataSerializer);
+        mgr->addWrapper(new TextKeyMapHolderSerializer);
+
+        done = true;
+    }
+}
+
 void registerSerializers()
 {
     static bool done = false;
     if (!done)
     {
+        registerUserDataSerializers();
+
         osgDB::ObjectWrapperManager* mgr = osgDB::Registry::instance()->getObjectWrapperManager();
         mgr->addWrapper(new PositionAttitudeTransformSerializer);
         mgr->addWrapper(new SkeletonSerializer);
@@ -114,10 +222,8 @@ void registerSerializers()
             "SceneUtil::UpdateRigGeometry",
             "SceneUtil::LightSource",
             "SceneUtil::StateSetUpdater",
-            "NifOsg::NodeUserData",
             "NifOsg::FlipController",
             "NifOsg::KeyframeController",
-            "NifOsg::TextKeyMapHolder",
             "NifOsg::Emitter",
             "NifOsg::ParticleSystem",
             "NifOsg::GrowFadeAffector",
@@ -136,9 +242,21 @@ void registerSerializers()
             mgr->addWrapper(makeDummySerializer(ignore[i]));
         }
 
-
+        exportSerializersRegistered = true;
         done = true;
     }
 }
 
+bool canSerialize(const osg::Object* object)
+{
+    // the geometry data would be left out
+    if (exportSerializersRegistered)
+        return false;
+
+    if (std::string(object->libraryName()) == "osg")
+        return true;
+
+    return dynamic_cast<const NifOsg::NodeUserData*>(object) || dynamic_cast<const NifOsg::TextKeyMapHolder*>(object);
+}
+
 }
@@ -1,12 +1,26 @@
 #ifndef OPENMW_COMPONENTS_SCENEUTIL_SERIALIZE_H
 #define OPENMW_COMPONENTS_SCENEUTIL_SERIALIZE_H
 
+namespace osg
+{
+    class Object;
+}
+
 namespace SceneUtil
 {
 
     /// Register osg node serializers for certain SceneUtil classes if not already done so
+    /// @note These are meant for exporting scenes to look at. Most of our classes are written as placeholders and
+    /// geometry data is left out, so that nothing written afterwards can be read back, see canSerialize().
     void registerSerializers();
 
+    /// Register the serializers of the user data that the NIF loader attaches to nodes, so that scenes using it
+    /// can be written and read back. Also done by registerSerializers().
+    void registerUserDataSerializers();
+
+    /// Can \a object be written and read back with the registered serializers, without losing anything?
+    bool canSerialize(const osg::Object* object);
+
 }
 
 #endif
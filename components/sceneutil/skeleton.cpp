@@ -6,6 +6,7 @@
 #include <components/misc/stringops.hpp>
 
 #include <iostream>
+#include <algorithm>
 
 namespace SceneUtil
 {
@@ -37,7 +38,10 @@ Skeleton::Skeleton()
     : mBoneCacheInit(false)
     , mNeedToUpdateBoneMatrices(true)
     , mActive(true)
+    , mUpdateInterval(1)
+    , mUpdatePhase(0)
     , mLastFrameNumber(0)
+    , mLastUpdateFrameNumber(0)
     , mTraversedEvenFrame(false)
     , mTraversedOddFrame(false)
 {
@@ -49,7 +53,10 @@ Skeleton::Skeleton(const Skeleton &copy, const osg::CopyOp &copyop)
     , mBoneCacheInit(false)
     , mNeedToUpdateBoneMatrices(true)
     , mActive(copy.mActive)
+    , mUpdateInterval(1)
+    , mUpdatePhase(0)
     , mLastFrameNumber(0)
+    , mLastUpdateFrameNumber(0)
     , mTraversedEvenFrame(false)
     , mTraversedOddFrame(false)
 {
@@ -142,6 +149,27 @@ bool Skeleton::getActive() const
     return mActive;
 }
 
+void Skeleton::setUpdateInterval(unsigned int interval, unsigned int phase)
+{
+    mUpdateInterval = std::max(1u, interval);
+    mUpdatePhase = phase % mUpdateInterval;
+}
+
+unsigned int Skeleton::getUpdateInterval() const
+{
+    return mUpdateInterval;
+}
+
+bool Skeleton::isUpdateFrame(unsigned int traversalNumber) const
+{
+    return mUpdateInterval <= 1 || (traversalNumber + mUpdatePhase) % mUpdateInterval == 0;
+}
+
+bool Skeleton::wasUpdated(unsigned int traversalNumber) const
+{
+    return mLastUpdateFrameNumber == traversalNumber;
+}
+
 void Skeleton::markDirty()
 {
     mTraversedEvenFrame = false;
@@ -152,11 +180,15 @@ void Skeleton::markDirty()
 
 void Skeleton::traverse(osg::NodeVisitor& nv)
 {
-    if (!getActive() && nv.getVisitorType() == osg::NodeVisitor::UPDATE_VISITOR
-            // need to process at least 2 frames before shutting off update, since we need to have both frame-alternating RigGeometries initialized
-            // this would be more naturally handled if the double-buffering was implemented in RigGeometry itself rather than in a FrameSwitch decorator node
-            && mLastFrameNumber != 0 && mTraversedEvenFrame && mTraversedOddFrame)
-        return;
+    if (nv.getVisitorType() == osg::NodeVisitor::UPDATE_VISITOR)
+    {
+        if ((!getActive() || !isUpdateFrame(nv.getTraversalNumber()))
+                // need to process at least 2 frames before shutting off update, since we need to have both frame-alternating RigGeometries initialized
+                // this would be more naturally handled if the double-buffering was implemented in RigGeometry itself rather than in a FrameSwitch decorator node
+                && mLastFrameNumber != 0 && mTraversedEvenFrame && mTraversedOddFrame)
+            return;
+        mLastUpdateFrameNumber = nv.getTraversalNumber();
+    }
     osg::Group::traverse(nv);
 }
 
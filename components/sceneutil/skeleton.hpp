@@ -53,6 +53,21 @@ namespace SceneUtil
 
         bool getActive() const;
 
+        /// Update the animation only in one frame out of every \a interval frames, e.g. for distant actors. In the other frames
+        /// the RigGeometries keep showing the pose of the last update.
+        /// @param interval 1 to update in every frame.
+        /// @param phase Offset of the updated frames, use different values to spread the updates of many skeletons over the frames.
+        void setUpdateInterval(unsigned int interval, unsigned int phase);
+
+        unsigned int getUpdateInterval() const;
+
+        /// Is the animation updated in the given frame, see setUpdateInterval?
+        bool isUpdateFrame(unsigned int traversalNumber) const;
+
+        /// Has the update traversal of the given frame updated the animation? Unlike isUpdateFrame, this accounts
+        /// for inactive skeletons and for the frames needed to initialize new RigGeometries.
+        bool wasUpdated(unsigned int traversalNumber) const;
+
         void traverse(osg::NodeVisitor& nv);
 
         void markDirty();
@@ -73,7 +88,11 @@ namespace SceneUtil
 
         bool mActive;
 
+        unsigned int mUpdateInterval;
+        unsigned int mUpdatePhase;
+
         unsigned int mLastFrameNumber;
+        unsigned int mLastUpdateFrameNumber;
         bool mTraversedEvenFrame;
         bool mTraversedOddFrame;
     };
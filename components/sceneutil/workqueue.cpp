@@ -1,7 +1,10 @@
 #include "workqueue.hpp"
 
+#include <algorithm>
 #include <iostream>
 
+#include <osg/Stats>
+
 namespace SceneUtil
 {
 
@@ -39,12 +42,30 @@ bool WorkItem::isDone() const
     return (mDone > 0);
 }
 
+void WorkItem::cancel()
+{
+    mCancelled.exchange(1);
+    abort();
+}
+
+bool WorkItem::isCancelled() const
+{
+    return (mCancelled > 0);
+}
+
 WorkQueue::WorkQueue(int workerThreads)
     : mIsReleased(false)
+    , mNumItems(0)
+    , mNextQueue(0)
+    , mNextSequence(0)
 {
+    // Without threads, items are still queued, but never started
+    for (int i=0; i<std::max(workerThreads, 1); ++i)
+        mQueues.push_back(new ThreadQueue);
+
     for (int i=0; i<workerThreads; ++i)
     {
-        WorkThread* thread = new WorkThread(this);
+        WorkThread* thread = new WorkThread(this, i);
         mThreads.push_back(thread);
         thread->startThread();
     }
@@ -54,8 +75,12 @@ WorkQueue::~WorkQueue()
 {
     {
         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-        while (!mQueue.empty())
-            mQueue.pop_back();
+        for (unsigned int i=0; i<mQueues.size(); ++i)
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> queueLock(mQueues[i]->mMutex);
+            mQueues[i]->mItems.clear();
+        }
+        mNumItems = 0;
         mIsReleased = true;
         mCondition.broadcast();
     }
@@ -65,9 +90,12 @@ WorkQueue::~WorkQueue()
         mThreads[i]->join();
         delete mThreads[i];
     }
+
+    for (unsigned int i=0; i<mQueues.size(); ++i)
+        delete mQueues[i];
 }
 
-void WorkQueue::addWorkItem(osg::ref_ptr<WorkItem> item, bool front)
+void WorkQueue::addWorkItem(osg::ref_ptr<WorkItem> item, int priority)
 {
     if (item->isDone())
     {
@@ -75,35 +103,119 @@ void WorkQueue::addWorkItem(osg::ref_ptr<WorkItem> item, bool front)
         return;
     }
 
+    QueuedItem queuedItem;
+    queuedItem.mItem = item;
+    queuedItem.mPriority = priority;
+    queuedItem.mQueuedTick = osg::Timer::instance()->tick();
+
+    // Count the item in the same lock that publishes it. A thread that takes the item right away
+    // has to wait for mMutex to uncount it, so the counters never drop below the number of items.
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-    if (front)
-        mQueue.push_front(item);
-    else
-        mQueue.push_back(item);
+    queuedItem.mSequence = mNextSequence++;
+    ThreadQueue* queue = mQueues[mNextQueue];
+    mNextQueue = (mNextQueue + 1) % mQueues.size();
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> queueLock(queue->mMutex);
+        queue->mItems.push_back(queuedItem);
+        std::push_heap(queue->mItems.begin(), queue->mItems.end(), CompareQueuedItems());
+    }
+
+    ++mNumItems;
+    ++mStats[getPriorityClass(priority)].mNumItems;
     mCondition.signal();
 }
 
-osg::ref_ptr<WorkItem> WorkQueue::removeWorkItem()
+bool WorkQueue::setPriority(const WorkItem* item, int priority)
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-    while (mQueue.empty() && !mIsReleased)
+    for (unsigned int i=0; i<mQueues.size(); ++i)
     {
-        mCondition.wait(&mMutex);
+        ThreadQueue* queue = mQueues[i];
+        OpenThreads::ScopedLock<OpenThreads::Mutex> queueLock(queue->mMutex);
+        for (std::vector<QueuedItem>::iterator it = queue->mItems.begin(); it != queue->mItems.end(); ++it)
+        {
+            if (it->mItem != item)
+                continue;
+
+            --mStats[getPriorityClass(it->mPriority)].mNumItems;
+            ++mStats[getPriorityClass(priority)].mNumItems;
+            it->mPriority = priority;
+            std::make_heap(queue->mItems.begin(), queue->mItems.end(), CompareQueuedItems());
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkQueue::takeWorkItem(unsigned int thread, QueuedItem& queuedItem)
+{
+    // Find the queue with the highest priority item, preferring our own queue for equal priorities
+    ThreadQueue* best = NULL;
+    int bestPriority = 0;
+    for (unsigned int i=0; i<mQueues.size(); ++i)
+    {
+        ThreadQueue* queue = mQueues[(thread + i) % mQueues.size()];
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(queue->mMutex);
+        if (!queue->mItems.empty() && (!best || queue->mItems.front().mPriority > bestPriority))
+        {
+            best = queue;
+            bestPriority = queue->mItems.front().mPriority;
+        }
     }
-    if (!mQueue.empty())
+
+    if (!best)
+        return false;
+
     {
-        osg::ref_ptr<WorkItem> item = mQueue.front();
-        mQueue.pop_front();
-        return item;
+        // Another thread may have taken the item in the meantime, in which case we take the next one or try again
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(best->mMutex);
+        if (best->mItems.empty())
+            return false;
+        std::pop_heap(best->mItems.begin(), best->mItems.end(), CompareQueuedItems());
+        queuedItem = best->mItems.back();
+        best->mItems.pop_back();
+    }
+
+    double waitTime = osg::Timer::instance()->delta_s(queuedItem.mQueuedTick, osg::Timer::instance()->tick());
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+    --mNumItems;
+    PriorityStats& stats = mStats[getPriorityClass(queuedItem.mPriority)];
+    --stats.mNumItems;
+    ++stats.mNumStarted;
+    stats.mWaitTime += waitTime;
+    return true;
+}
+
+osg::ref_ptr<WorkItem> WorkQueue::removeWorkItem(unsigned int thread)
+{
+    while (true)
+    {
+        QueuedItem queuedItem;
+        if (takeWorkItem(thread, queuedItem))
+        {
+            if (!queuedItem.mItem->isCancelled())
+                return queuedItem.mItem;
+
+            queuedItem.mItem->signalDone();
+            continue;
+        }
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        while (mNumItems == 0 && !mIsReleased)
+        {
+            mCondition.wait(&mMutex);
+        }
+        if (mIsReleased)
+            return NULL;
     }
-    else
-        return NULL;
 }
 
 unsigned int WorkQueue::getNumItems() const
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-    return mQueue.size();
+    return mNumItems;
 }
 
 unsigned int WorkQueue::getNumActiveThreads() const
@@ -117,8 +229,42 @@ unsigned int WorkQueue::getNumActiveThreads() const
     return count;
 }
 
-WorkThread::WorkThread(WorkQueue *workQueue)
+WorkQueue::PriorityClass WorkQueue::getPriorityClass(int priority)
+{
+    if (priority < Priority_Normal)
+        return Class_Low;
+    if (priority > Priority_Normal)
+        return Class_High;
+    return Class_Normal;
+}
+
+void WorkQueue::reportStats(unsigned int frameNumber, osg::Stats *stats) const
+{
+    static const char* queueNames[Class_Count] = { "WorkQueue Low", "WorkQueue Normal", "WorkQueue High" };
+    static const char* waitNames[Class_Count] = { "Wait Low", "Wait Normal", "Wait High" };
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+    stats->setAttribute(frameNumber, "WorkQueue", mNumItems);
+    stats->setAttribute(frameNumber, "WorkThread", getNumActiveThreads());
+
+    for (int i=0; i<Class_Count; ++i)
+    {
+        stats->setAttribute(frameNumber, queueNames[i], mStats[i].mNumItems);
+
+        // in milliseconds
+        if (mStats[i].mNumStarted > 0)
+            stats->setAttribute(frameNumber, waitNames[i], mStats[i].mWaitTime / mStats[i].mNumStarted * 1000.0);
+
+        mStats[i].mNumStarted = 0;
+        mStats[i].mWaitTime = 0.0;
+    }
+}
+
+WorkThread::WorkThread(WorkQueue *workQueue, unsigned int index)
     : mWorkQueue(workQueue)
+    , mIndex(index)
+    , mActive(false)
 {
 }
 
@@ -126,7 +272,7 @@ void WorkThread::run()
 {
     while (true)
     {
-        osg::ref_ptr<WorkItem> item = mWorkQueue->removeWorkItem();
+        osg::ref_ptr<WorkItem> item = mWorkQueue->removeWorkItem(mIndex);
         if (!item)
             return;
         mActive = true;
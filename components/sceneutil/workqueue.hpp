@@ -8,8 +8,14 @@
 
 #include <osg/Referenced>
 #include <osg/ref_ptr>
+#include <osg/Timer>
 
-#include <queue>
+#include <vector>
+
+namespace osg
+{
+    class Stats;
+}
 
 namespace SceneUtil
 {
@@ -34,8 +40,15 @@ namespace SceneUtil
         /// Set abort flag in order to return from doWork() as soon as possible. May not be respected by all WorkItems.
         virtual void abort() {}
 
+        /// Mark the work as no longer wanted. If the item is still queued, it will be completed without calling doWork(),
+        /// otherwise abort() is called.
+        void cancel();
+
+        bool isCancelled() const;
+
     protected:
         OpenThreads::Atomic mDone;
+        OpenThreads::Atomic mCancelled;
         OpenThreads::Mutex mMutex;
         OpenThreads::Condition mCondition;
     };
@@ -43,31 +56,105 @@ namespace SceneUtil
     class WorkThread;
 
     /// @brief A work queue that users can push work items onto, to be completed by one or more background threads.
-    /// @note Work items will be processed in the order that they were given in, however
-    /// if multiple work threads are involved then it is possible for a later item to complete before earlier items.
+    /// @note Work items with a higher priority are started first. If multiple work threads are involved then it is possible
+    /// for a later item to complete before earlier items.
+    /// @par Each work thread has its own queue, which new items are distributed to in turn. A thread takes items from its
+    /// own queue, unless another queue has an item with a higher priority or its own queue is empty, in which case it steals
+    /// from the other queue. Items with the same priority are started in the order that they were given in within each queue,
+    /// but not necessarily across queues.
     class WorkQueue : public osg::Referenced
     {
     public:
+        /// Common priorities. Any other value may be used as well.
+        enum Priority
+        {
+            Priority_Low = -100, ///< Speculative work that may turn out to be unnecessary, e.g. preloading
+            Priority_Normal = 0,
+            Priority_High = 100 ///< Work that has to be done before queued work of normal priority
+        };
+
         WorkQueue(int numWorkerThreads=1);
         ~WorkQueue();
 
-        /// Add a new work item to the back of the queue.
+        /// Add a new work item to the queue.
         /// @par The work item's waitTillDone() method may be used by the caller to wait until the work is complete.
-        /// @param front If true, add item to the front of the queue. If false (default), add to the back.
-        void addWorkItem(osg::ref_ptr<WorkItem> item, bool front=false);
+        /// @param priority Items with a higher priority are started before items with a lower priority.
+        void addWorkItem(osg::ref_ptr<WorkItem> item, int priority=Priority_Normal);
+
+        /// Change the priority of an item that is still queued.
+        /// @return false if the item is not queued, e.g. because a thread has already started it.
+        bool setPriority(const WorkItem* item, int priority);
 
-        /// Get the next work item from the front of the queue. If the queue is empty, waits until a new item is added.
+        /// Get the next work item for the given thread. If the queues are empty, waits until a new item is added.
+        /// Cancelled items are completed without being returned.
         /// If the workqueue is in the process of being destroyed, may return NULL.
         /// @par Used internally by the WorkThread.
-        osg::ref_ptr<WorkItem> removeWorkItem();
+        osg::ref_ptr<WorkItem> removeWorkItem(unsigned int thread);
 
         unsigned int getNumItems() const;
 
         unsigned int getNumActiveThreads() const;
 
+        /// Report the number of queued items and the average time that the items started since the last call
+        /// waited in the queue, for low, normal and high priorities.
+        void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
+
     private:
+        struct QueuedItem
+        {
+            osg::ref_ptr<WorkItem> mItem;
+            int mPriority;
+            unsigned int mSequence;
+            osg::Timer_t mQueuedTick;
+        };
+
+        /// Heap order, the item with the highest priority and lowest sequence number is at the top.
+        struct CompareQueuedItems
+        {
+            bool operator()(const QueuedItem& left, const QueuedItem& right) const
+            {
+                if (left.mPriority != right.mPriority)
+                    return left.mPriority < right.mPriority;
+                return left.mSequence > right.mSequence;
+            }
+        };
+
+        struct ThreadQueue
+        {
+            OpenThreads::Mutex mMutex; // if both are held, locked after WorkQueue::mMutex
+            std::vector<QueuedItem> mItems; // heap ordered by CompareQueuedItems
+        };
+
+        enum PriorityClass
+        {
+            Class_Low,
+            Class_Normal,
+            Class_High,
+            Class_Count
+        };
+
+        struct PriorityStats
+        {
+            unsigned int mNumItems;
+            unsigned int mNumStarted; // since the last reportStats()
+            double mWaitTime; // total of the items started since the last reportStats()
+
+            PriorityStats() : mNumItems(0), mNumStarted(0), mWaitTime(0.0) {}
+        };
+
+        static PriorityClass getPriorityClass(int priority);
+
+        /// Take the next item for the given thread from its own queue or another queue.
+        bool takeWorkItem(unsigned int thread, QueuedItem& queuedItem);
+
         bool mIsReleased;
-        std::deque<osg::ref_ptr<WorkItem> > mQueue;
+        std::vector<ThreadQueue*> mQueues;
+
+        // protected by mMutex
+        unsigned int mNumItems;
+        unsigned int mNextQueue;
+        unsigned int mNextSequence;
+        mutable PriorityStats mStats[Class_Count];
 
         mutable OpenThreads::Mutex mMutex;
         OpenThreads::Condition mCondition;
@@ -79,7 +166,7 @@ namespace SceneUtil
     class WorkThread : public OpenThreads::Thread
     {
     public:
-        WorkThread(WorkQueue* workQueue);
+        WorkThread(WorkQueue* workQueue, unsigned int index);
 
         virtual void run();
 
@@ -87,6 +174,7 @@ namespace SceneUtil
 
     private:
         WorkQueue* mWorkQueue;
+        unsigned int mIndex;
         volatile bool mActive;
     };
 
@@ -14,6 +14,14 @@ namespace VFS
         virtual ~File() {}
 
         virtual Files::IStreamPtr open() = 0;
+
+        /// Path of the file on disk that holds this resource, i.e. the file itself or the archive containing it.
+        virtual std::string getPath() = 0;
+
+        /// Get the contents of the file without copying them, if they are already in memory, e.g. in a memory mapped
+        /// archive. The contents stay valid as long as the archive exists.
+        /// @return false if the contents are not in memory and have to be read through open().
+        virtual bool getMemory(const char*& data, size_t& size) { return false; }
     };
 
     class Archive
@@ -4,9 +4,9 @@ namespace VFS
 {
 
 
-BsaArchive::BsaArchive(const std::string &filename)
+BsaArchive::BsaArchive(const std::string &filename, bool memoryMapped)
 {
-    mFile.open(filename);
+    mFile.open(filename, memoryMapped);
 
     const Bsa::BSAFile::FileList &filelist = mFile.getList();
     for(Bsa::BSAFile::FileList::const_iterator it = filelist.begin();it != filelist.end();++it)
@@ -40,4 +40,16 @@ Files::IStreamPtr BsaArchiveFile::open()
     return mFile->getFile(mInfo);
 }
 
+std::string BsaArchiveFile::getPath()
+{
+    return mFile->getFilename();
+}
+
+bool BsaArchiveFile::getMemory(const char*& data, size_t& size)
+{
+    data = mFile->getMappedData(mInfo);
+    size = mInfo->fileSize;
+    return data != NULL;
+}
+
 }
@@ -15,6 +15,10 @@ namespace VFS
 
         virtual Files::IStreamPtr open();
 
+        virtual std::string getPath();
+
+        virtual bool getMemory(const char*& data, size_t& size);
+
         const Bsa::BSAFile::FileStruct* mInfo;
         Bsa::BSAFile* mFile;
     };
@@ -22,7 +26,8 @@ namespace VFS
     class BsaArchive : public Archive
     {
     public:
-        BsaArchive(const std::string& filename);
+        /// @param memoryMapped See Bsa::BSAFile::open
+        BsaArchive(const std::string& filename, bool memoryMapped = false);
 
         virtual void listResources(std::map<std::string, File*>& out, char (*normalize_function) (char));
 
@@ -62,4 +62,9 @@ namespace VFS
         return Files::openConstrainedFileStream(mPath.c_str());
     }
 
+    std::string FileSystemArchiveFile::getPath()
+    {
+        return mPath;
+    }
+
 }
@@ -13,6 +13,8 @@ namespace VFS
 
         virtual Files::IStreamPtr open();
 
+        virtual std::string getPath();
+
     private:
         std::string mPath;
 
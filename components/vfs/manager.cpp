@@ -1,9 +1,11 @@
 #include "manager.hpp"
 
 #include <cctype>
+#include <algorithm>
 #include <stdexcept>
 
 #include <components/misc/stringops.hpp>
+#include <components/misc/hash.hpp>
 
 #include "archive.hpp"
 
@@ -26,6 +28,44 @@ namespace
         std::transform(path.begin(), path.end(), path.begin(), normalize_char);
     }
 
+    /// FNV-1a hash of the normalized form of \a name
+    size_t hashPath(const std::string& name, char (*normalize_char)(char))
+    {
+        Misc::Fnv1a<uint32_t> hash;
+        for (std::string::const_iterator it = name.begin(); it != name.end(); ++it)
+            hash.add(static_cast<unsigned char>(normalize_char(*it)));
+        return hash.get();
+    }
+
+    /// Compare a normalized name with the normalized form of \a name
+    bool equalsNormalized(const std::string& normalized, const std::string& name, char (*normalize_char)(char))
+    {
+        if (normalized.size() != name.size())
+            return false;
+        for (size_t i = 0; i < name.size(); ++i)
+        {
+            if (normalized[i] != normalize_char(name[i]))
+                return false;
+        }
+        return true;
+    }
+
+    struct CompareName
+    {
+        bool operator()(const VFS::IndexEntry& entry, const std::string& name) const
+        {
+            return entry.mName < name;
+        }
+    };
+
+    struct ComparePrefix
+    {
+        bool operator()(const std::string& prefix, const VFS::IndexEntry& entry) const
+        {
+            return entry.mName.compare(0, prefix.size(), prefix) > 0;
+        }
+    };
+
 }
 
 namespace VFS
@@ -33,6 +73,7 @@ namespace VFS
 
     Manager::Manager(bool strict)
         : mStrict(strict)
+        , mNormalize(strict ? &strict_normalize_char : &nonstrict_normalize_char)
     {
 
     }
@@ -51,39 +92,107 @@ namespace VFS
 
     void Manager::buildIndex()
     {
+        // Let the archives override each other's files in a map first, then flatten it
+        std::map<std::string, File*> files;
+        for (std::vector<Archive*>::const_iterator it = mArchives.begin(); it != mArchives.end(); ++it)
+            (*it)->listResources(files, mNormalize);
+
         mIndex.clear();
+        mIndex.reserve(files.size());
+        for (std::map<std::string, File*>::const_iterator it = files.begin(); it != files.end(); ++it)
+        {
+            IndexEntry entry;
+            entry.mName = it->first;
+            entry.mFile = it->second;
+            entry.mHash = hashPath(it->first, mNormalize);
+            mIndex.push_back(entry);
+        }
+
+        // Keep the table at most half full
+        size_t capacity = 16;
+        while (capacity < mIndex.size() * 2)
+            capacity *= 2;
+
+        mHashTable.assign(capacity, 0);
+        const size_t mask = capacity - 1;
+        for (size_t i = 0; i < mIndex.size(); ++i)
+        {
+            size_t slot = mIndex[i].mHash & mask;
+            while (mHashTable[slot] != 0)
+                slot = (slot + 1) & mask;
+            mHashTable[slot] = static_cast<unsigned int>(i + 1);
+        }
+    }
 
-        for (std::vector<Archive*>::const_iterator it = mArchives.begin(); it != mArchives.end(); ++it)
-            (*it)->listResources(mIndex, mStrict ? &strict_normalize_char : &nonstrict_normalize_char);
+    const IndexEntry* Manager::find(const std::string &name) const
+    {
+        if (mHashTable.empty())
+            return NULL;
+
+        const size_t hash = hashPath(name, mNormalize);
+        const size_t mask = mHashTable.size() - 1;
+        for (size_t slot = hash & mask; mHashTable[slot] != 0; slot = (slot + 1) & mask)
+        {
+            const IndexEntry& entry = mIndex[mHashTable[slot] - 1];
+            if (entry.mHash == hash && equalsNormalized(entry.mName, name, mNormalize))
+                return &entry;
+        }
+        return NULL;
     }
 
     Files::IStreamPtr Manager::get(const std::string &name) const
     {
-        std::string normalized = name;
-        normalize_path(normalized, mStrict);
-
-        return getNormalized(normalized);
+        const IndexEntry* entry = find(name);
+        if (!entry)
+        {
+            std::string normalized = name;
+            normalize_path(normalized, mStrict);
+            throw std::runtime_error("Resource '" + normalized + "' not found");
+        }
+        return entry->mFile->open();
     }
 
     Files::IStreamPtr Manager::getNormalized(const std::string &normalizedName) const
     {
-        std::map<std::string, File*>::const_iterator found = mIndex.find(normalizedName);
-        if (found == mIndex.end())
+        const IndexEntry* entry = find(normalizedName);
+        if (!entry)
             throw std::runtime_error("Resource '" + normalizedName + "' not found");
-        return found->second->open();
+        return entry->mFile->open();
     }
 
-    bool Manager::exists(const std::string &name) const
+    bool Manager::getMemory(const std::string &name, const char *&data, size_t &size) const
     {
-        std::string normalized = name;
-        normalize_path(normalized, mStrict);
+        const IndexEntry* entry = find(name);
+        if (!entry)
+        {
+            std::string normalized = name;
+            normalize_path(normalized, mStrict);
+            throw std::runtime_error("Resource '" + normalized + "' not found");
+        }
+        return entry->mFile->getMemory(data, size);
+    }
+
+    std::string Manager::getArchivePath(const std::string &normalizedName) const
+    {
+        const IndexEntry* entry = find(normalizedName);
+        if (!entry)
+            throw std::runtime_error("Resource '" + normalizedName + "' not found");
+        return entry->mFile->getPath();
+    }
 
-        return mIndex.find(normalized) != mIndex.end();
+    bool Manager::exists(const std::string &name) const
+    {
+        return find(name) != NULL;
     }
 
-    const std::map<std::string, File*>& Manager::getIndex() const
+    RecursiveDirectoryRange Manager::getRecursiveDirectoryIterator(const std::string &path) const
     {
-        return mIndex;
+        std::string normalized = path;
+        normalize_path(normalized, mStrict);
+
+        std::vector<IndexEntry>::const_iterator begin = std::lower_bound(mIndex.begin(), mIndex.end(), normalized, CompareName());
+        std::vector<IndexEntry>::const_iterator end = std::upper_bound(begin, mIndex.end(), normalized, ComparePrefix());
+        return RecursiveDirectoryRange(begin, end);
     }
 
     void Manager::normalizeFilename(std::string &name) const
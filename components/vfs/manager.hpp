@@ -3,6 +3,7 @@
 
 #include <components/files/constrainedfilestream.hpp>
 
+#include <string>
 #include <vector>
 #include <map>
 
@@ -12,11 +13,68 @@ namespace VFS
     class Archive;
     class File;
 
+    /// @brief An entry of the file index of a Manager.
+    struct IndexEntry
+    {
+        /// The normalized file name.
+        std::string mName;
+        File* mFile;
+        size_t mHash;
+    };
+
+    /// @brief Iterates over the normalized names of all files in a directory and its subdirectories, in sorted order.
+    class RecursiveDirectoryIterator
+    {
+    public:
+        RecursiveDirectoryIterator(std::vector<IndexEntry>::const_iterator it)
+            : mIt(it)
+        {
+        }
+
+        const std::string& operator*() const { return mIt->mName; }
+        const std::string* operator->() const { return &mIt->mName; }
+
+        File* getFile() const { return mIt->mFile; }
+
+        RecursiveDirectoryIterator& operator++()
+        {
+            ++mIt;
+            return *this;
+        }
+
+        bool operator==(const RecursiveDirectoryIterator& other) const { return mIt == other.mIt; }
+        bool operator!=(const RecursiveDirectoryIterator& other) const { return mIt != other.mIt; }
+
+    private:
+        std::vector<IndexEntry>::const_iterator mIt;
+    };
+
+    class RecursiveDirectoryRange
+    {
+    public:
+        RecursiveDirectoryRange(RecursiveDirectoryIterator begin, RecursiveDirectoryIterator end)
+            : mBegin(begin)
+            , mEnd(end)
+        {
+        }
+
+        RecursiveDirectoryIterator begin() const { return mBegin; }
+        RecursiveDirectoryIterator end() const { return mEnd; }
+
+        bool empty() const { return mBegin == mEnd; }
+
+    private:
+        RecursiveDirectoryIterator mBegin;
+        RecursiveDirectoryIterator mEnd;
+    };
+
     /// @brief The main class responsible for loading files from a virtual file system.
     /// @par Various archive types (e.g. directories on the filesystem, or compressed archives)
     /// can be registered, and will be merged into a single file tree. If the same filename is
     /// contained in multiple archives, the last added archive will have priority.
     /// @par Most of the methods in this class are considered thread-safe, see each method documentation for details.
+    /// @par The index is immutable once built, so lookups from multiple threads don't need any locking. Lookups
+    /// normalize the given name on the fly and don't allocate memory.
     class Manager
     {
     public:
@@ -37,9 +95,11 @@ namespace VFS
         /// @note May be called from any thread once the index has been built.
         bool exists(const std::string& name) const;
 
-        /// Get a complete list of files from all archives
+        /// Get the files whose normalized names start with \a path, e.g. all files in a directory and its subdirectories.
+        /// An empty \a path gives all files from all archives.
+        /// @note \a path is normalized, but no trailing slash is added.
         /// @note May be called from any thread once the index has been built.
-        const std::map<std::string, File*>& getIndex() const;
+        RecursiveDirectoryRange getRecursiveDirectoryIterator(const std::string& path) const;
 
         /// Normalize the given filename, making slashes/backslashes consistent, and lower-casing if mStrict is false.
         /// @note May be called from any thread once the index has been built.
@@ -55,12 +115,28 @@ namespace VFS
         /// @note May be called from any thread once the index has been built.
         Files::IStreamPtr getNormalized(const std::string& normalizedName) const;
 
+        /// Get the contents of a file without copying them, if they are already in memory, see File::getMemory.
+        /// @return false if the file has to be read through get().
+        /// @note Throws an exception if the file can not be found.
+        /// @note May be called from any thread once the index has been built.
+        bool getMemory(const std::string& name, const char*& data, size_t& size) const;
+
+        /// Get the path of the file on disk a resource is read from, i.e. the file itself or the archive containing it.
+        /// @note Throws an exception if the file can not be found.
+        /// @note May be called from any thread once the index has been built.
+        std::string getArchivePath(const std::string& normalizedName) const;
+
     private:
+        /// @return NULL if not found.
+        const IndexEntry* find(const std::string& name) const;
+
         bool mStrict;
+        char (*mNormalize)(char);
 
         std::vector<Archive*> mArchives;
 
-        std::map<std::string, File*> mIndex;
+        std::vector<IndexEntry> mIndex; // Sorted by name
+        std::vector<unsigned int> mHashTable; // Indices into mIndex plus one, zero for empty slots, linear probing
     };
 
 }